@@ -152,6 +152,13 @@ for peripheral in device_dict['peripheral']:
 	fd.write("_peripheral_" + peripheral['device'] + "_start = 0x" + format(peripheral['base'], "016x") + ";\n")
 	fd.write("_peripheral_" + peripheral['device'] + "_end = 0x" + format(peripheral['base'] + peripheral['range'], "016x") + ";\n")
 
+# Generate symbols from memory blocks
+fd.write("\n")
+fd.write("/* Memory blocks symbols */\n")
+for block in device_dict['memory']:
+	fd.write("_memory_" + block['device'] + "_start = 0x" + format(block['base'], "016x") + ";\n")
+	fd.write("_memory_" + block['device'] + "_end = 0x" + format(block['base'] + block['range'], "016x") + ";\n")
+
 # Generate global symbols
 fd.write("\n")
 fd.write("/* Global symbols */\n")
@@ -176,8 +183,17 @@ stack_start = device_dict['memory'][BOOT_MEMORY_BLOCK]['base'] + device_dict['me
 fd.write("_stack_start = 0x" + format(stack_start, "016x") + ";\n")
 
 # Generate sections
-# vector table and text sections are here defined.
-# data, bss and rodata can be explicitly defined by the user application if required.
+# vector table, text, rodata, data and bss sections are here defined, all in the boot memory block.
+# data and bss are aligned to 32 bytes (four 64-bit words) at both ends: startup.s copies and clears them
+# four XLEN words per iteration, with no tail to handle.
+# Each other memory block gets its data and bss sections, for the input sections named after it
+# (e.g. .data.ddr, .rodata.ddr, .bss.ddr, see sw/SoC/common/placement.h). Their data are loaded in the
+# boot memory block, right after text, and copied by startup.s through the data table: the binary file
+# only spans the boot memory block. Their bss are cleared by startup.s through the bss table.
+# When a memory block is not in the configuration, its input sections fall in the boot memory block ones.
+# The uncached section goes in the last memory block: no memory of the SoC is cacheable, but for the
+# caches of the cores in their own ranges (e.g. CVA6 CachedRegionAddrBase), it is aligned to 64-byte
+# lines so to share none with other data.
 fd.write("\n")
 fd.write("/* Sections */\n")
 fd.write("SECTIONS\n")
@@ -197,14 +213,154 @@ fd.write("\t\t. = ALIGN(32);\n")
 fd.write("\t\t_text_start = .;\n")
 fd.write("\t\t*(.text.handlers)\n")
 fd.write("\t\t*(.text.start)\n")
+fd.write("\t\t*(.text.fast)\n")
+fd.write("\t\t*(.text.fast.*)\n")
 fd.write("\t\t*(.text)\n")
 fd.write("\t\t*(.text*)\n")
 fd.write("\t\t. = ALIGN(32);\n")
 fd.write("\t\t_text_end = .;\n")
 fd.write("\t}> " + device_dict['memory'][BOOT_MEMORY_BLOCK]['device'] + "\n")
 
+# Sections of the other memory blocks, before the boot memory block ones: the first matching
+# input section pattern wins
+other_memory_blocks = [block for index, block in enumerate(device_dict['memory']) if index != BOOT_MEMORY_BLOCK]
+if len(other_memory_blocks) > 0:
+	uncached_memory_block = other_memory_blocks[-1]['device']
+else:
+	uncached_memory_block = device_dict['memory'][BOOT_MEMORY_BLOCK]['device']
+# Output data sections to copy, (load, start, end) symbols
+data_list = []
+# Output bss sections to clear, (start, end) symbols
+bss_list = []
+
+for block in other_memory_blocks:
+	device = block['device']
+	fd.write("\n")
+	fd.write("\t.data_" + device + " : ALIGN(32)\n")
+	fd.write("\t{\n")
+	fd.write("\t\t_data_" + device + "_start = .;\n")
+	fd.write("\t\t*(.rodata." + device.lower() + ")\n")
+	fd.write("\t\t*(.rodata." + device.lower() + ".*)\n")
+	fd.write("\t\t*(.data." + device.lower() + ")\n")
+	fd.write("\t\t*(.data." + device.lower() + ".*)\n")
+	fd.write("\t\t. = ALIGN(32);\n")
+	fd.write("\t\t_data_" + device + "_end = .;\n")
+	fd.write("\t}> " + device + " AT> " + device_dict['memory'][BOOT_MEMORY_BLOCK]['device'] + "\n")
+	fd.write("\t_data_" + device + "_load_start = LOADADDR(.data_" + device + ");\n")
+	data_list.append(("_data_" + device + "_load_start", "_data_" + device + "_start", "_data_" + device + "_end"))
+	fd.write("\n")
+	fd.write("\t.bss_" + device + " (NOLOAD) : ALIGN(32)\n")
+	fd.write("\t{\n")
+	fd.write("\t\t_bss_" + device + "_start = .;\n")
+	fd.write("\t\t*(.bss." + device.lower() + ")\n")
+	fd.write("\t\t*(.bss." + device.lower() + ".*)\n")
+	fd.write("\t\t. = ALIGN(32);\n")
+	fd.write("\t\t_bss_" + device + "_end = .;\n")
+	fd.write("\t}> " + device + "\n")
+	bss_list.append(("_bss_" + device + "_start", "_bss_" + device + "_end"))
+
+# Uncached section, in the boot memory block it is at the beginning of bss instead (not to leave a gap in
+# the binary file)
+uncached_lines = [
+		"\t\t. = ALIGN(64);\n",
+		"\t\t_uncached_start = .;\n",
+		"\t\t*(.bss.uncached)\n",
+		"\t\t*(.bss.uncached.*)\n",
+		"\t\t. = ALIGN(64);\n",
+		"\t\t_uncached_end = .;\n",
+	]
+if uncached_memory_block != device_dict['memory'][BOOT_MEMORY_BLOCK]['device']:
+	fd.write("\n")
+	fd.write("\t.uncached (NOLOAD) : ALIGN(64)\n")
+	fd.write("\t{\n")
+	for line in uncached_lines:
+		fd.write(line)
+	fd.write("\t}> " + uncached_memory_block + "\n")
+	bss_list.append(("_uncached_start", "_uncached_end"))
+
+# First free byte of the other memory blocks, after their sections
+for block in other_memory_blocks:
+	last_section = ".uncached" if block['device'] == uncached_memory_block else ".bss_" + block['device']
+	fd.write("\t_memory_" + block['device'] + "_free = ADDR(" + last_section + ") + SIZEOF(" + last_section + ");\n")
+
+# Read-only data section
+fd.write("\n")
+fd.write("\t.rodata :\n")
+fd.write("\t{\n")
+fd.write("\t\t. = ALIGN(8);\n")
+fd.write("\t\t*(.rodata)\n")
+fd.write("\t\t*(.rodata*)\n")
+fd.write("\t\t*(.srodata)\n")
+fd.write("\t\t*(.srodata*)\n")
+fd.write("\t}> " + device_dict['memory'][BOOT_MEMORY_BLOCK]['device'] + "\n")
+
+# Data and bss tables, for startup.s: (load, start, end) triples and (start, end) pairs, 64-bit on both XLEN
+# (RV32 reads the low words). Before data and bss, not to leave a gap in the binary file
+data_list.append(("_data_load_start", "_data_start", "_data_end"))
+fd.write("\n")
+fd.write("\t.data_table :\n")
+fd.write("\t{\n")
+fd.write("\t\t. = ALIGN(8);\n")
+fd.write("\t\t_data_table_start = .;\n")
+for load, start, end in data_list:
+	fd.write("\t\tQUAD(" + load + ")\n")
+	fd.write("\t\tQUAD(" + start + ")\n")
+	fd.write("\t\tQUAD(" + end + ")\n")
+fd.write("\t\t_data_table_end = .;\n")
+fd.write("\t}> " + device_dict['memory'][BOOT_MEMORY_BLOCK]['device'] + "\n")
+
+bss_list.append(("_bss_start", "_bss_end"))
+fd.write("\n")
+fd.write("\t.bss_table :\n")
+fd.write("\t{\n")
+fd.write("\t\t. = ALIGN(8);\n")
+fd.write("\t\t_bss_table_start = .;\n")
+for start, end in bss_list:
+	fd.write("\t\tQUAD(" + start + ")\n")
+	fd.write("\t\tQUAD(" + end + ")\n")
+fd.write("\t\t_bss_table_end = .;\n")
+fd.write("\t}> " + device_dict['memory'][BOOT_MEMORY_BLOCK]['device'] + "\n")
+
+# Data section, copied by startup.s from its load address (LMA) if not loaded in place (VMA)
+# The global pointer addresses the small data and bss (sdata, sbss) with gp-relative accesses
+fd.write("\n")
+fd.write("\t.data : ALIGN(32)\n")
+fd.write("\t{\n")
+fd.write("\t\t_data_start = .;\n")
+fd.write("\t\t*(.data)\n")
+fd.write("\t\t*(.data*)\n")
+fd.write("\t\t. = ALIGN(8);\n")
+fd.write("\t\t__global_pointer$ = . + 0x800;\n")
+fd.write("\t\t*(.sdata)\n")
+fd.write("\t\t*(.sdata*)\n")
+fd.write("\t\t. = ALIGN(32);\n")
+fd.write("\t\t_data_end = .;\n")
+fd.write("\t}> " + device_dict['memory'][BOOT_MEMORY_BLOCK]['device'] + " AT> " + device_dict['memory'][BOOT_MEMORY_BLOCK]['device'] + "\n")
+fd.write("\t_data_load_start = LOADADDR(.data);\n")
+
+# Bss section, cleared by startup.s
+fd.write("\n")
+fd.write("\t.bss (NOLOAD) : ALIGN(32)\n")
+fd.write("\t{\n")
+fd.write("\t\t_bss_start = .;\n")
+if uncached_memory_block == device_dict['memory'][BOOT_MEMORY_BLOCK]['device']:
+	for line in uncached_lines:
+		fd.write(line)
+fd.write("\t\t*(.sbss)\n")
+fd.write("\t\t*(.sbss*)\n")
+fd.write("\t\t*(.bss)\n")
+fd.write("\t\t*(.bss*)\n")
+fd.write("\t\t*(COMMON)\n")
+fd.write("\t\t. = ALIGN(32);\n")
+fd.write("\t\t_bss_end = .;\n")
+fd.write("\t}> " + device_dict['memory'][BOOT_MEMORY_BLOCK]['device'] + "\n")
+
 fd.write("}\n")
 
+# The stack grows down from _stack_start, towards the bss
+fd.write("\n")
+fd.write("ASSERT(_bss_end <= _stack_start, \"Sections overflow the stack start of the boot memory block\")\n")
+
 # Files closing
 fd.write("\n")
 fd.close()
@@ -55,6 +55,12 @@ module custom_top_wrapper import ibex_pkg::*; # (
     // Debug Interface
     input  logic                         debug_req_i,
 
+`ifdef RVFI
+    // Retired instructions (simulation only)
+    output logic                         rvfi_valid,
+    output logic [31:0]                  rvfi_pc_rdata,
+`endif
+
     ////////////////////////////
     //  Bus Array Interfaces  //
     ////////////////////////////
@@ -198,6 +204,10 @@ module custom_top_wrapper import ibex_pkg::*; # (
         .scramble_req_o         ( ),
 
         .debug_req_i            ( debug_req_i ),
+    `ifdef RVFI
+        .rvfi_valid             ( rvfi_valid ),
+        .rvfi_pc_rdata          ( rvfi_pc_rdata ),
+    `endif
         .crash_dump_o           ( ),
         .double_fault_seen_o    ( ),
 
@@ -0,0 +1,86 @@
+#!/bin/python3.10
+# Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+# Description:
+#   Decoder of the binary AXI transaction traces of the unit simulations (+axi_perf, see common/tb_axi_perf.h).
+#   Prints the transactions as CSV, optionally only those of a master and/or a slave, or the latency
+#   percentiles of each master/slave pair and direction.
+# Args:
+#   see --help, e.g. ./axi_perf.py uninasoc.prj/bin/axi_perf.bin -m RV_SOCKET_DATA -s PBUS
+
+####################
+# Import libraries #
+####################
+# Parse args
+import argparse
+# Decode records
+import struct
+import sys
+
+##############
+# Parse args #
+##############
+
+parser = argparse.ArgumentParser(description="Decode an AXI transaction trace (+axi_perf=<prefix>, <prefix>.bin)")
+parser.add_argument("trace", help="trace file")
+parser.add_argument("-m", "--master", help="only the transactions of this master (MASTER_NAMES)")
+parser.add_argument("-s", "--slave", help="only the transactions to this slave (RANGE_NAMES, or DECERR)")
+parser.add_argument("-p", "--percentiles", action="store_true", help="latency percentiles per pair, instead of the transactions")
+args = parser.parse_args()
+
+##############
+# Read trace #
+##############
+
+# uint64 issue, uint64 addr, uint32 latency, uint32 wait, uint32 bytes, uint8 bus, si, mi, flags
+RECORD = struct.Struct("<QQIIIBBBB")
+
+with open(args.trace, "rb") as fd:
+	data = fd.read()
+
+if data[:8] != b"AXIPERF1":
+	print("ERROR: " + args.trace + " is not an AXI transaction trace")
+	sys.exit(1)
+record_size, names_size = struct.unpack_from("<II", data, 8)
+if record_size != RECORD.size:
+	print("ERROR: records of " + str(record_size) + " bytes, expected " + str(RECORD.size))
+	sys.exit(1)
+
+# One line per bus: <bus>|<masters>|<slaves>
+buses = []
+for line in data[16:16 + names_size].decode().splitlines():
+	name, masters, slaves = line.split("|")
+	buses.append((name, masters.split(), slaves.split()))
+
+RESP = ["OKAY", "EXOKAY", "SLVERR", "DECERR"]
+
+records = []
+for offset in range(16 + names_size, len(data) - RECORD.size + 1, RECORD.size):
+	issue, addr, latency, wait, nbytes, bus, si, mi, flags = RECORD.unpack_from(data, offset)
+	bus_name, masters, slaves = buses[bus]
+	if args.master is not None and masters[si] != args.master:
+		continue
+	if args.slave is not None and slaves[mi] != args.slave:
+		continue
+	records.append((bus_name, masters[si], slaves[mi], "W" if flags & 1 else "R", issue, addr, nbytes, wait, latency,
+					flags >> 3, RESP[( flags >> 1 ) & 3]))
+
+##########
+# Output #
+##########
+
+if not args.percentiles:
+	print("bus,master,slave,rw,issue,addr,bytes,wait,latency,outstanding,resp")
+	for record in records:
+		print(",".join(hex(value) if index == 5 else str(value) for index, value in enumerate(record)))
+	sys.exit(0)
+
+# Latency percentiles, per pair and direction
+pairs = {}
+for record in records:
+	pairs.setdefault(record[0:4], []).append(record[8])
+print("bus,master,slave,rw,count,p50,p90,p99,max")
+for pair, latencies in sorted(pairs.items()):
+	latencies.sort()
+	def percentile ( p ):
+		return latencies[min(len(latencies) - 1, int(p * len(latencies)))]
+	print(",".join(pair) + "," + ",".join(str(value) for value in [len(latencies), percentile(0.5), percentile(0.9), percentile(0.99), latencies[-1]]))
@@ -0,0 +1,444 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Verilator testbench AXI4 and AXI-lite master driver and monitor, on a TbClock (see tb_clock.h)
+//              The ports are bound by name, as declared with the macros of hw/xilinx/rtl/uninasoc_axi.svh:
+//                  TB_AXI_PORT(port, model, name)        <name>_axi_*     signals of the model
+//                  TB_AXILITE_PORT(port, model, name)    <name>_axilite_* signals of the model
+//              declare a TbAxiPort variable called port, with the address, data, strobe and ID types of the model.
+//              Data and addresses up to 64 bits (no VlWide signals).
+//              The master queues transactions and drives one write and one read at a time, each completes
+//              with its callback. The blocking read()/write() calls run the clock until their transaction is done.
+//              AW and W are issued together, B and R are always accepted. Full AXI: INCR bursts of bus-wide beats.
+//              The monitor only observes the handshakes, on master and slave ports alike: beat counts, bytes,
+//              in-order latencies, and optionally a log of the handshakes.
+
+#ifndef TB_AXI_H__
+#define TB_AXI_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <functional>
+#include "tb_clock.h"
+
+// Default values
+#define TB_AXI_TIMEOUT      100000  // Cycles of a blocking transaction
+
+// Responses
+#define TB_AXI_RESP_OKAY    0
+#define TB_AXI_RESP_SLVERR  2
+#define TB_AXI_RESP_DECERR  3
+
+// Burst types
+#define TB_AXI_BURST_INCR   1
+
+// Model signals of an AXI4 or AXI-lite port, unused ones are NULL (the burst signals of AXI-lite)
+template <typename Addr, typename Data, typename Strb, typename Id> struct TbAxiPort {
+    typedef Addr addr_t;
+    typedef Data data_t;
+    typedef Strb strb_t;
+    typedef Id   id_t;
+
+    // AW channel
+    Id * awid; Addr * awaddr; uint8_t * awlen; uint8_t * awsize; uint8_t * awburst; uint8_t * awlock;
+    uint8_t * awcache; uint8_t * awprot; uint8_t * awqos; uint8_t * awregion; uint8_t * awvalid; uint8_t * awready;
+    // W channel
+    Data * wdata; Strb * wstrb; uint8_t * wlast; uint8_t * wvalid; uint8_t * wready;
+    // B channel
+    Id * bid; uint8_t * bresp; uint8_t * bvalid; uint8_t * bready;
+    // AR channel
+    Id * arid; Addr * araddr; uint8_t * arlen; uint8_t * arsize; uint8_t * arburst; uint8_t * arlock;
+    uint8_t * arcache; uint8_t * arprot; uint8_t * arqos; uint8_t * arregion; uint8_t * arvalid; uint8_t * arready;
+    // R channel
+    Id * rid; Data * rdata; uint8_t * rresp; uint8_t * rlast; uint8_t * rvalid; uint8_t * rready;
+
+    TbAxiPort () { memset((void *) this, 0, sizeof(*this)); }
+
+    bool lite () const { return awlen == NULL; }
+};
+
+// Port type from the signal types
+template <typename Addr, typename Data, typename Strb, typename Id>
+TbAxiPort<Addr, Data, Strb, Id> tb_axi_port_of ( Addr *, Data *, Strb *, Id * )
+{
+    return TbAxiPort<Addr, Data, Strb, Id>();
+}
+
+#define TB_AXI_PORT(port, model, name) \
+    auto port = tb_axi_port_of(&(model)->name##_axi_awaddr, &(model)->name##_axi_wdata, &(model)->name##_axi_wstrb, &(model)->name##_axi_awid); \
+    port.awid     = &(model)->name##_axi_awid;      port.awaddr   = &(model)->name##_axi_awaddr;    \
+    port.awlen    = &(model)->name##_axi_awlen;     port.awsize   = &(model)->name##_axi_awsize;    \
+    port.awburst  = &(model)->name##_axi_awburst;   port.awlock   = &(model)->name##_axi_awlock;    \
+    port.awcache  = &(model)->name##_axi_awcache;   port.awprot   = &(model)->name##_axi_awprot;    \
+    port.awqos    = &(model)->name##_axi_awqos;     port.awregion = &(model)->name##_axi_awregion;  \
+    port.awvalid  = &(model)->name##_axi_awvalid;   port.awready  = &(model)->name##_axi_awready;   \
+    port.wdata    = &(model)->name##_axi_wdata;     port.wstrb    = &(model)->name##_axi_wstrb;     \
+    port.wlast    = &(model)->name##_axi_wlast;     port.wvalid   = &(model)->name##_axi_wvalid;    \
+    port.wready   = &(model)->name##_axi_wready;                                                    \
+    port.bid      = &(model)->name##_axi_bid;       port.bresp    = &(model)->name##_axi_bresp;     \
+    port.bvalid   = &(model)->name##_axi_bvalid;    port.bready   = &(model)->name##_axi_bready;    \
+    port.arid     = &(model)->name##_axi_arid;      port.araddr   = &(model)->name##_axi_araddr;    \
+    port.arlen    = &(model)->name##_axi_arlen;     port.arsize   = &(model)->name##_axi_arsize;    \
+    port.arburst  = &(model)->name##_axi_arburst;   port.arlock   = &(model)->name##_axi_arlock;    \
+    port.arcache  = &(model)->name##_axi_arcache;   port.arprot   = &(model)->name##_axi_arprot;    \
+    port.arqos    = &(model)->name##_axi_arqos;     port.arregion = &(model)->name##_axi_arregion;  \
+    port.arvalid  = &(model)->name##_axi_arvalid;   port.arready  = &(model)->name##_axi_arready;   \
+    port.rid      = &(model)->name##_axi_rid;       port.rdata    = &(model)->name##_axi_rdata;     \
+    port.rresp    = &(model)->name##_axi_rresp;     port.rlast    = &(model)->name##_axi_rlast;     \
+    port.rvalid   = &(model)->name##_axi_rvalid;    port.rready   = &(model)->name##_axi_rready
+
+#define TB_AXILITE_PORT(port, model, name) \
+    auto port = tb_axi_port_of(&(model)->name##_axilite_awaddr, &(model)->name##_axilite_wdata, &(model)->name##_axilite_wstrb, (uint8_t *) NULL); \
+    port.awaddr   = &(model)->name##_axilite_awaddr;    port.awprot   = &(model)->name##_axilite_awprot;    \
+    port.awvalid  = &(model)->name##_axilite_awvalid;   port.awready  = &(model)->name##_axilite_awready;   \
+    port.wdata    = &(model)->name##_axilite_wdata;     port.wstrb    = &(model)->name##_axilite_wstrb;     \
+    port.wvalid   = &(model)->name##_axilite_wvalid;    port.wready   = &(model)->name##_axilite_wready;    \
+    port.bresp    = &(model)->name##_axilite_bresp;     port.bvalid   = &(model)->name##_axilite_bvalid;    \
+    port.bready   = &(model)->name##_axilite_bready;                                                        \
+    port.araddr   = &(model)->name##_axilite_araddr;    port.arprot   = &(model)->name##_axilite_arprot;    \
+    port.arvalid  = &(model)->name##_axilite_arvalid;   port.arready  = &(model)->name##_axilite_arready;   \
+    port.rdata    = &(model)->name##_axilite_rdata;     port.rresp    = &(model)->name##_axilite_rresp;     \
+    port.rvalid   = &(model)->name##_axilite_rvalid;    port.rready   = &(model)->name##_axilite_rready
+
+// A transaction of the master, one data and strobe word per beat
+struct TbAxiTxn {
+    bool     write;
+    uint64_t addr;
+    uint32_t id;
+    uint8_t  len;           // Beats - 1
+    uint8_t  size;          // log2 of the bytes per beat
+    uint8_t  burst;
+    uint8_t  prot;
+    std::vector<uint64_t> data;
+    std::vector<uint64_t> strb;
+    uint8_t  resp;          // Worst response of the beats
+    uint64_t issued;        // Cycles of the master clock
+    uint64_t completed;
+    std::function<void(const TbAxiTxn &)> done;
+};
+
+template <class Port> class TbAxiMaster {
+public:
+    typedef typename Port::data_t data_t;
+    typedef typename Port::strb_t strb_t;
+
+    TbAxiMaster ( TbClock * clock, const Port & port, uint64_t timeout = TB_AXI_TIMEOUT ) :
+        m_clock(clock), m_port(port), m_timeout(timeout), m_errors(0), m_sampling(false)
+    {
+        abort();
+        m_clock->add_sample_hook([this]() { sample(); });
+        m_clock->add_drive_hook([this]() { drive(); });
+    }
+
+    // Bus width and all byte lanes
+    static unsigned int bytes () { return sizeof(data_t); }
+    static uint64_t all_lanes () { return ( bytes() >= 64 ) ? UINT64_MAX : ( 1ULL << bytes() ) - 1; }
+
+    // Non-blocking: queue a transaction, started after the queued ones of the same direction.
+    // Between edges, an idle channel starts it right away, as the drive hooks would have done.
+    void queue ( const TbAxiTxn & txn ) {
+        ( txn.write ? m_wq : m_rq ).push_back(txn);
+        if ( !m_sampling )
+            drive();
+    }
+
+    void queue_read ( uint64_t addr, std::function<void(const TbAxiTxn &)> done, unsigned int beats = 1 ) {
+        TbAxiTxn txn = make(false, addr, beats);
+        txn.done = done;
+        queue(txn);
+    }
+
+    void queue_write ( uint64_t addr, const uint64_t * data, std::function<void(const TbAxiTxn &)> done, unsigned int beats = 1, uint64_t strb = UINT64_MAX ) {
+        TbAxiTxn txn = make(true, addr, beats);
+        for ( unsigned int i = 0; i < beats; i++ ) {
+            txn.data[i] = data[i];
+            txn.strb[i] = strb & all_lanes();
+        }
+        txn.done = done;
+        queue(txn);
+    }
+
+    bool busy () const { return !m_wq.empty() || !m_rq.empty(); }
+
+    // Blocking: run the clock until the transaction completes
+    uint64_t read ( uint64_t addr ) {
+        uint64_t data = 0;
+        read_burst(addr, 1, &data);
+        return data;
+    }
+
+    void write ( uint64_t addr, uint64_t data, uint64_t strb = UINT64_MAX ) {
+        write_burst(addr, 1, &data, strb);
+    }
+
+    // Full AXI only: beats of the bus width
+    void read_burst ( uint64_t addr, unsigned int beats, uint64_t * data ) {
+        bool done = false;
+        queue_read(addr, [&](const TbAxiTxn & txn) {
+            for ( unsigned int i = 0; i < txn.data.size(); i++ )
+                data[i] = txn.data[i];
+            done = true;
+        }, beats);
+        wait([&]() { return done; }, "read", addr);
+    }
+
+    void write_burst ( uint64_t addr, unsigned int beats, const uint64_t * data, uint64_t strb = UINT64_MAX ) {
+        bool done = false;
+        queue_write(addr, data, [&](const TbAxiTxn &) { done = true; }, beats, strb);
+        wait([&]() { return done; }, "write", addr);
+    }
+
+    // Run until all the queued transactions are done
+    void drain () {
+        wait([this]() { return !busy(); }, "drain", 0);
+    }
+
+    // Drop the queued and in-flight transactions, idle bus
+    void abort () {
+        m_wq.clear();
+        m_rq.clear();
+        m_w_active = m_r_active = false;
+        *m_port.awvalid = 0;
+        *m_port.wvalid  = 0;
+        *m_port.bready  = 0;
+        *m_port.arvalid = 0;
+        *m_port.rready  = 0;
+    }
+
+    // Error responses and timeouts
+    uint64_t errors () const { return m_errors; }
+
+private:
+    TbAxiMaster ( const TbAxiMaster & );
+    TbAxiMaster & operator= ( const TbAxiMaster & );
+
+    TbAxiTxn make ( bool write, uint64_t addr, unsigned int beats ) {
+        TbAxiTxn txn;
+        if ( beats < 1 || beats > 256 || ( beats > 1 && m_port.lite() ) ) {
+            printf("ERROR: AXI %s bursts of %u beats at 0x%lx, single beat instead\n", m_port.lite() ? "lite" : "INCR", beats, (unsigned long) addr);
+            beats = 1;
+        }
+        txn.write = write;
+        txn.addr  = addr;
+        txn.id    = 0;
+        txn.len   = beats - 1;
+        txn.size  = 0;
+        while ( ( 1U << txn.size ) < bytes() )
+            txn.size++;
+        txn.burst = TB_AXI_BURST_INCR;
+        txn.prot  = 0;
+        txn.data.assign(beats, 0);
+        txn.strb.assign(beats, all_lanes());
+        txn.resp  = TB_AXI_RESP_OKAY;
+        txn.issued = txn.completed = 0;
+        return txn;
+    }
+
+    // On timeout the master gives up: the transactions are dropped, as the slave state is unknown
+    void wait ( std::function<bool()> done, const char * what, uint64_t addr ) {
+        if ( !m_clock->run_until(done, m_timeout) ) {
+            printf("ERROR: AXI %s at 0x%lx timed out after %lu cycles\n", what, (unsigned long) addr, (unsigned long) m_timeout);
+            m_errors++;
+            abort();
+        }
+    }
+
+    void complete ( std::deque<TbAxiTxn> & fifo, bool & active ) {
+        TbAxiTxn txn = fifo.front();
+        fifo.pop_front();
+        active = false;
+        txn.completed = m_clock->cycles();
+        if ( txn.resp != TB_AXI_RESP_OKAY )
+            m_errors++;
+        if ( txn.done )
+            txn.done(txn);
+    }
+
+    // Before the edge: handshakes, the completion callbacks may queue new transactions
+    void sample () {
+        m_sampling = true;
+        if ( m_w_active ) {
+            TbAxiTxn & txn = m_wq.front();
+            if ( !m_aw_done && *m_port.awready )
+                m_aw_done = true;
+            if ( m_w_beat <= txn.len && *m_port.wready )
+                m_w_beat++;
+            if ( *m_port.bvalid ) {
+                if ( *m_port.bresp > txn.resp )
+                    txn.resp = *m_port.bresp;
+                complete(m_wq, m_w_active);
+            }
+        }
+        if ( m_r_active ) {
+            TbAxiTxn & txn = m_rq.front();
+            if ( !m_ar_done && *m_port.arready )
+                m_ar_done = true;
+            if ( *m_port.rvalid ) {
+                if ( m_r_beat <= txn.len )
+                    txn.data[m_r_beat] = (uint64_t) *m_port.rdata;
+                if ( *m_port.rresp > txn.resp )
+                    txn.resp = *m_port.rresp;
+                m_r_beat++;
+                if ( m_port.lite() || *m_port.rlast )
+                    complete(m_rq, m_r_active);
+            }
+        }
+        m_sampling = false;
+    }
+
+    // After the edge: the next transactions and beats
+    void drive () {
+        if ( !m_w_active && !m_wq.empty() ) {
+            TbAxiTxn & txn = m_wq.front();
+            m_w_active = true;
+            m_aw_done = false;
+            m_w_beat = 0;
+            txn.issued = m_clock->cycles();
+            *m_port.awaddr = txn.addr;
+            *m_port.awprot = txn.prot;
+            if ( !m_port.lite() ) {
+                *m_port.awid = txn.id;      *m_port.awlen = txn.len;    *m_port.awsize = txn.size;
+                *m_port.awburst = txn.burst; *m_port.awlock = 0;        *m_port.awcache = 0;
+                *m_port.awqos = 0;          *m_port.awregion = 0;
+            }
+        }
+        *m_port.awvalid = m_w_active && !m_aw_done;
+        *m_port.wvalid  = m_w_active && m_w_beat <= m_wq.front().len;
+        if ( *m_port.wvalid ) {
+            TbAxiTxn & txn = m_wq.front();
+            *m_port.wdata = (data_t) txn.data[m_w_beat];
+            *m_port.wstrb = (strb_t) txn.strb[m_w_beat];
+            if ( !m_port.lite() )
+                *m_port.wlast = ( m_w_beat == txn.len );
+        }
+        *m_port.bready = 1;
+
+        if ( !m_r_active && !m_rq.empty() ) {
+            TbAxiTxn & txn = m_rq.front();
+            m_r_active = true;
+            m_ar_done = false;
+            m_r_beat = 0;
+            txn.issued = m_clock->cycles();
+            *m_port.araddr = txn.addr;
+            *m_port.arprot = txn.prot;
+            if ( !m_port.lite() ) {
+                *m_port.arid = txn.id;      *m_port.arlen = txn.len;    *m_port.arsize = txn.size;
+                *m_port.arburst = txn.burst; *m_port.arlock = 0;        *m_port.arcache = 0;
+                *m_port.arqos = 0;          *m_port.arregion = 0;
+            }
+        }
+        *m_port.arvalid = m_r_active && !m_ar_done;
+        *m_port.rready  = 1;
+    }
+
+    TbClock * m_clock;
+    Port m_port;
+    uint64_t m_timeout;
+    uint64_t m_errors;
+    bool m_sampling;
+    std::deque<TbAxiTxn> m_wq;
+    std::deque<TbAxiTxn> m_rq;
+    bool m_w_active;
+    bool m_aw_done;
+    unsigned int m_w_beat;
+    bool m_r_active;
+    bool m_ar_done;
+    unsigned int m_r_beat;
+};
+
+template <class Port> class TbAxiMonitor {
+public:
+    // Handshakes are logged to log, if given
+    TbAxiMonitor ( TbClock * clock, const Port & port, const char * name, FILE * log = NULL ) :
+        m_clock(clock), m_port(port), m_name(name), m_log(log)
+    {
+        memset(&m_stats, 0, sizeof(m_stats));
+        m_clock->add_sample_hook([this]() { sample(); });
+    }
+
+    typedef struct {
+        uint64_t aw, w, b, ar, r;           // Handshakes
+        uint64_t writes, reads;             // Completed transactions (B, last R)
+        uint64_t write_bytes, read_bytes;   // Strobed bytes, full read beats
+        uint64_t write_latency, read_latency;  // Sum of AW to B, AR to last R cycles
+        uint64_t errors;                    // Error responses
+    } stats_t;
+
+    const stats_t & stats () const { return m_stats; }
+
+    void report ( FILE * file = stdout ) const {
+        fprintf(file, "[AXI] %s: %lu writes (%lu beats, %lu bytes), %lu reads (%lu beats, %lu bytes), %lu error responses\n",
+                m_name.c_str(), (unsigned long) m_stats.writes, (unsigned long) m_stats.w, (unsigned long) m_stats.write_bytes,
+                (unsigned long) m_stats.reads, (unsigned long) m_stats.r, (unsigned long) m_stats.read_bytes, (unsigned long) m_stats.errors);
+        fprintf(file, "[AXI] %s: average latency %.2f write, %.2f read cycles\n", m_name.c_str(),
+                m_stats.writes ? (double) m_stats.write_latency / m_stats.writes : 0.0,
+                m_stats.reads ? (double) m_stats.read_latency / m_stats.reads : 0.0);
+    }
+
+private:
+    TbAxiMonitor ( const TbAxiMonitor & );
+    TbAxiMonitor & operator= ( const TbAxiMonitor & );
+
+    void log ( const char * channel, uint64_t addr, uint64_t data, unsigned int extra ) {
+        if ( m_log )
+            fprintf(m_log, "[AXI] %s %12lu %s 0x%016lx 0x%016lx %u\n", m_name.c_str(), (unsigned long) m_clock->cycles(),
+                    channel, (unsigned long) addr, (unsigned long) data, extra);
+    }
+
+    // Responses are matched to the requests in order, IDs are not tracked
+    void sample () {
+        uint64_t cycle = m_clock->cycles();
+
+        if ( *m_port.awvalid && *m_port.awready ) {
+            m_stats.aw++;
+            m_aw_cycles.push_back(cycle);
+            log("AW", *m_port.awaddr, 0, m_port.lite() ? 0 : *m_port.awlen);
+        }
+        if ( *m_port.wvalid && *m_port.wready ) {
+            m_stats.w++;
+            m_stats.write_bytes += __builtin_popcountll((uint64_t) *m_port.wstrb);
+            log("W ", 0, (uint64_t) *m_port.wdata, (unsigned int) *m_port.wstrb);
+        }
+        if ( *m_port.bvalid && *m_port.bready ) {
+            m_stats.b++;
+            m_stats.writes++;
+            m_stats.errors += ( *m_port.bresp != TB_AXI_RESP_OKAY );
+            if ( !m_aw_cycles.empty() ) {
+                m_stats.write_latency += cycle - m_aw_cycles.front();
+                m_aw_cycles.pop_front();
+            }
+            log("B ", 0, 0, *m_port.bresp);
+        }
+        if ( *m_port.arvalid && *m_port.arready ) {
+            m_stats.ar++;
+            m_ar_cycles.push_back(cycle);
+            log("AR", *m_port.araddr, 0, m_port.lite() ? 0 : *m_port.arlen);
+        }
+        if ( *m_port.rvalid && *m_port.rready ) {
+            m_stats.r++;
+            m_stats.read_bytes += sizeof(typename Port::data_t);
+            m_stats.errors += ( *m_port.rresp != TB_AXI_RESP_OKAY );
+            log("R ", 0, (uint64_t) *m_port.rdata, *m_port.rresp);
+            if ( m_port.lite() || *m_port.rlast ) {
+                m_stats.reads++;
+                if ( !m_ar_cycles.empty() ) {
+                    m_stats.read_latency += cycle - m_ar_cycles.front();
+                    m_ar_cycles.pop_front();
+                }
+            }
+        }
+    }
+
+    TbClock * m_clock;
+    Port m_port;
+    std::string m_name;
+    FILE * m_log;
+    stats_t m_stats;
+    std::deque<uint64_t> m_aw_cycles;
+    std::deque<uint64_t> m_ar_cycles;
+};
+
+#endif
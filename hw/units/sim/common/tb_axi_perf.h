@@ -0,0 +1,296 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: AXI transaction performance monitor of the bus models, selected at runtime with plusargs
+//                  +axi_perf=<prefix>              write <prefix>.bin (trace) and <prefix>.txt (summary)
+//              The bus models report each transaction with event(): issue (first cycle of valid), address
+//              handshake (accept), last response (done). For each bus, master (SI) and slave (MI) pair, and
+//              direction, the summary holds count, bytes, issue-to-response latency (average, max, log2
+//              histogram), issue-to-accept wait (arbitration) and outstanding depth at the slave at issue.
+//              The trace holds one record_t per transaction, in completion order, after a header:
+//                  "AXIPERF1", uint32 record size, uint32 names size, names: one line per bus, "<bus>|<SIs>|<MIs>"
+//              Decode it with ../axi_perf.py.
+//
+//              Note: in uninasoc.prj the monitor measures the behavioural stand-ins of rtl/, not the Xilinx IPs:
+//              the crossbars serve one transaction at a time per master and per slave (no multiple outstanding
+//              transactions, no IP arbitration and register slices), the clock converters are pass-through and
+//              all the domains share the main clock (no CDC latency). The figures are functional only: they tell
+//              which pairs talk and how often, and how the model serializes them, not the latency or contention
+//              of the real crossbar or clock crossing (e.g. RV_SOCKET_DATA to PBUS).
+
+#ifndef TB_AXI_PERF_H__
+#define TB_AXI_PERF_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <sstream>
+
+// Log2 latency buckets: 0, 1, 2-3, 4-7, ..., >= 2^(TB_AXI_PERF_BUCKETS-2)
+#define TB_AXI_PERF_BUCKETS 24
+
+class TbAxiPerf {
+public:
+    // Event kinds, as reported by the bus models
+    enum { ISSUE = 0, ACCEPT = 1, DONE = 2 };
+
+    // Trace record, 32 bytes
+    struct record_t {
+        uint64_t issue;         // Cycle of the issue
+        uint64_t addr;
+        uint32_t latency;       // Cycles, issue to last response
+        uint32_t wait;          // Cycles, issue to address handshake
+        uint32_t bytes;
+        uint8_t  bus;
+        uint8_t  si;
+        uint8_t  mi;            // Past the last slave: decode error
+        uint8_t  flags;         // Bit 0: write, bits 2:1: response, bits 7:3: outstanding depth at issue (saturated)
+    };
+
+    TbAxiPerf ( int argc, char ** argv ) : m_cycle(0), m_trace(NULL), m_header(false), m_records(0) {
+        for ( int i = 1; i < argc; i++ )
+            if ( strncmp(argv[i], "+axi_perf=", 10) == 0 )
+                m_prefix = argv[i] + 10;
+        if ( !enabled() )
+            return;
+        std::string trace_file = m_prefix + ".bin";
+        m_trace = fopen(trace_file.c_str(), "wb");
+        if ( m_trace == NULL ) {
+            printf("ERROR: cannot write %s\n", trace_file.c_str());
+            m_prefix.clear();
+        }
+    }
+
+    ~TbAxiPerf () {
+        if ( m_trace )
+            fclose(m_trace);
+    }
+
+    bool enabled () const { return !m_prefix.empty(); }
+
+    // A bus and its port names, space-separated as MASTER_NAMES and RANGE_NAMES of the bus CSVs.
+    // Bus ids in registration order.
+    int add_bus ( const char * name, const char * masters, const char * slaves ) {
+        bus_t bus;
+        bus.name = name;
+        bus.masters = split(masters);
+        bus.slaves = split(slaves);
+        bus.slaves.push_back("DECERR");
+        bus.pairs.resize(bus.masters.size() * bus.slaves.size() * 2);
+        bus.inflight.resize(bus.masters.size() * 2);
+        bus.outstanding.assign(bus.slaves.size() * 2, 0);
+        m_buses.push_back(bus);
+        return m_buses.size() - 1;
+    }
+
+    // Current cycle, for the timestamps
+    void cycle ( uint64_t cycle ) { m_cycle = cycle; }
+
+    void event ( int bus_id, int kind, bool write, int si, int mi, int id, uint64_t addr, uint32_t bytes, int resp ) {
+        if ( !enabled() || bus_id < 0 || bus_id >= (int) m_buses.size() )
+            return;
+        bus_t & bus = m_buses[bus_id];
+        if ( si < 0 || si >= (int) bus.masters.size() || mi < 0 || mi >= (int) bus.slaves.size() )
+            return;
+        std::deque<txn_t> & inflight = bus.inflight[si * 2 + write];
+        int & outstanding = bus.outstanding[mi * 2 + write];
+
+        if ( kind == ISSUE ) {
+            txn_t txn = { m_cycle, m_cycle, addr, bytes, id, mi, outstanding };
+            inflight.push_back(txn);
+            outstanding++;
+            return;
+        }
+        // In order, per master and direction
+        if ( inflight.empty() )
+            return;
+        txn_t & txn = inflight.front();
+        if ( kind == ACCEPT ) {
+            txn.accept = m_cycle;
+            return;
+        }
+
+        record_t record;
+        record.issue = txn.issue;
+        record.addr = txn.addr;
+        record.latency = (uint32_t) ( m_cycle - txn.issue );
+        record.wait = (uint32_t) ( txn.accept - txn.issue );
+        record.bytes = txn.bytes;
+        record.bus = bus_id;
+        record.si = si;
+        record.mi = txn.mi;
+        record.flags = ( write ? 1 : 0 ) | ( ( resp & 3 ) << 1 ) | ( ( txn.depth < 31 ? txn.depth : 31 ) << 3 );
+        bus.outstanding[txn.mi * 2 + write]--;
+        inflight.pop_front();
+
+        pair_t & pair = bus.pairs[( si * bus.slaves.size() + record.mi ) * 2 + write];
+        pair.count++;
+        pair.bytes += record.bytes;
+        pair.latency += record.latency;
+        pair.wait += record.wait;
+        pair.depth += txn_depth(record);
+        if ( record.latency > pair.max_latency )
+            pair.max_latency = record.latency;
+        if ( txn_depth(record) > pair.max_depth )
+            pair.max_depth = txn_depth(record);
+        if ( resp != 0 )
+            pair.errors++;
+        pair.histogram[bucket(record.latency)]++;
+
+        write_header();
+        fwrite(&record, sizeof(record), 1, m_trace);
+        m_records++;
+    }
+
+    // Write the summary, and print it
+    void report () {
+        if ( !enabled() )
+            return;
+        write_header();
+        fflush(m_trace);
+
+        std::ostringstream os;
+        char line[256];
+        snprintf(line, sizeof(line), "%-6s %-18s %-10s %-2s %9s %11s %9s %7s %8s %6s %6s %6s\n", "bus", "master", "slave", "rw",
+                 "count", "bytes", "avg lat", "max lat", "avg wait", "avg os", "max os", "errors");
+        os << line;
+        for ( size_t b = 0; b < m_buses.size(); b++ ) {
+            bus_t & bus = m_buses[b];
+            for ( size_t si = 0; si < bus.masters.size(); si++ )
+                for ( size_t mi = 0; mi < bus.slaves.size(); mi++ )
+                    for ( int write = 0; write < 2; write++ ) {
+                        pair_t & pair = bus.pairs[( si * bus.slaves.size() + mi ) * 2 + write];
+                        if ( pair.count == 0 )
+                            continue;
+                        snprintf(line, sizeof(line), "%-6s %-18s %-10s %-2s %9lu %11lu %9.2f %7u %8.2f %6.2f %6u %6lu\n",
+                                 bus.name.c_str(), bus.masters[si].c_str(), bus.slaves[mi].c_str(), write ? "W" : "R",
+                                 (unsigned long) pair.count, (unsigned long) pair.bytes, (double) pair.latency / pair.count,
+                                 pair.max_latency, (double) pair.wait / pair.count, (double) pair.depth / pair.count,
+                                 pair.max_depth, (unsigned long) pair.errors);
+                        os << line;
+                    }
+        }
+        printf("\n[AXI_PERF] %lu transactions, latencies in cycles, outstanding (os) at the slave at issue\n%s",
+               (unsigned long) m_records, os.str().c_str());
+
+        // Histograms in the summary file only
+        os << "\nLatency histograms, cycles: count\n";
+        for ( size_t b = 0; b < m_buses.size(); b++ ) {
+            bus_t & bus = m_buses[b];
+            for ( size_t si = 0; si < bus.masters.size(); si++ )
+                for ( size_t mi = 0; mi < bus.slaves.size(); mi++ )
+                    for ( int write = 0; write < 2; write++ ) {
+                        pair_t & pair = bus.pairs[( si * bus.slaves.size() + mi ) * 2 + write];
+                        if ( pair.count == 0 )
+                            continue;
+                        os << bus.name << " " << bus.masters[si] << " -> " << bus.slaves[mi] << ( write ? " W" : " R" ) << "\n";
+                        for ( int k = 0; k < TB_AXI_PERF_BUCKETS; k++ ) {
+                            if ( pair.histogram[k] == 0 )
+                                continue;
+                            std::string range = ( k == 0 ) ? "0" : std::to_string(1ULL << ( k - 1 ));
+                            if ( k == TB_AXI_PERF_BUCKETS - 1 )
+                                range = ">= " + range;
+                            else if ( k > 1 )
+                                range += "-" + std::to_string(( 1ULL << k ) - 1);
+                            snprintf(line, sizeof(line), "  %-20s %10lu\n", range.c_str(), (unsigned long) pair.histogram[k]);
+                            os << line;
+                        }
+                    }
+        }
+
+        std::string summary_file = m_prefix + ".txt";
+        FILE * fp = fopen(summary_file.c_str(), "w");
+        if ( fp == NULL ) {
+            printf("ERROR: cannot write %s\n", summary_file.c_str());
+            return;
+        }
+        fputs(os.str().c_str(), fp);
+        fclose(fp);
+        printf("[AXI_PERF] Written %s and %s.bin\n", summary_file.c_str(), m_prefix.c_str());
+    }
+
+private:
+    struct txn_t {
+        uint64_t issue;
+        uint64_t accept;
+        uint64_t addr;
+        uint32_t bytes;
+        int id;
+        int mi;
+        int depth;
+    };
+
+    struct pair_t {
+        uint64_t count;
+        uint64_t bytes;
+        uint64_t latency;
+        uint64_t wait;
+        uint64_t depth;
+        uint32_t max_latency;
+        uint32_t max_depth;
+        uint64_t errors;
+        uint64_t histogram[TB_AXI_PERF_BUCKETS];
+    };
+
+    struct bus_t {
+        std::string name;
+        std::vector<std::string> masters;
+        std::vector<std::string> slaves;
+        std::vector<pair_t> pairs;                  // [si][mi][write]
+        std::vector<std::deque<txn_t> > inflight;   // [si][write]
+        std::vector<int> outstanding;               // [mi][write]
+    };
+
+    static std::vector<std::string> split ( const char * names ) {
+        std::vector<std::string> result;
+        std::istringstream is(names);
+        std::string name;
+        while ( is >> name )
+            result.push_back(name);
+        return result;
+    }
+
+    static uint32_t txn_depth ( const record_t & record ) { return record.flags >> 3; }
+
+    static int bucket ( uint32_t latency ) {
+        int k = 0;
+        while ( latency != 0 && k < TB_AXI_PERF_BUCKETS - 1 ) {
+            latency >>= 1;
+            k++;
+        }
+        return k;
+    }
+
+    void write_header () {
+        if ( m_header )
+            return;
+        m_header = true;
+        std::string names;
+        for ( size_t b = 0; b < m_buses.size(); b++ ) {
+            names += m_buses[b].name + "|";
+            for ( size_t i = 0; i < m_buses[b].masters.size(); i++ )
+                names += ( i ? " " : "" ) + m_buses[b].masters[i];
+            names += "|";
+            for ( size_t i = 0; i < m_buses[b].slaves.size(); i++ )
+                names += ( i ? " " : "" ) + m_buses[b].slaves[i];
+            names += "\n";
+        }
+        uint32_t record_size = sizeof(record_t);
+        uint32_t names_size = names.size();
+        fwrite("AXIPERF1", 8, 1, m_trace);
+        fwrite(&record_size, sizeof(record_size), 1, m_trace);
+        fwrite(&names_size, sizeof(names_size), 1, m_trace);
+        fwrite(names.data(), names.size(), 1, m_trace);
+    }
+
+    std::string m_prefix;
+    uint64_t m_cycle;
+    FILE * m_trace;
+    bool m_header;
+    uint64_t m_records;
+    std::vector<bus_t> m_buses;
+};
+
+#endif
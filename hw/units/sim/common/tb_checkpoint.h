@@ -0,0 +1,151 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Verilator model checkpoints, selected at runtime with plusargs
+//                  +checkpoint_save=<file>         save the model at the save point, then go on
+//                  +checkpoint_at=<cycle>          save point: the start of this cycle
+//                  +checkpoint_on=<marker>         save point: the start of the cycle after the testbench reports the marker (see marker())
+//                  +checkpoint_restore=<file>      restore the model before the first cycle, the run goes on from the saved cycle
+//              Needs a savable model, built with -DTB_SAVABLE and verilator --savable (SAVABLE=1 in the Makefile).
+//              The checkpoint holds the model state, inputs included, the cycle and the testbench state registered
+//              with add_state() (plain data only, e.g. counters and offsets, no pointers) or add_stream() (variable-size
+//              state, e.g. the sparse memories of tb_memory.h). Anything the testbench
+//              does after the restore, e.g. loading a different program in a memory, overrides the saved state.
+//              Traces are not saved: a restored run starts a new trace at the saved cycle.
+
+#ifndef TB_CHECKPOINT_H__
+#define TB_CHECKPOINT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include "verilated.h"
+#ifdef TB_SAVABLE
+#include "verilated_save.h"
+#endif
+
+template <class Model> class TbCheckpoint {
+public:
+    // Parse the +checkpoint plusargs
+    TbCheckpoint ( Model * model, int argc, char ** argv ) :
+        m_model(model), m_at(UINT64_MAX), m_pending(false), m_saved(false)
+    {
+        for ( int i = 1; i < argc; i++ ) {
+            const char * arg = argv[i];
+            if      ( match(arg, "+checkpoint_save=") )     m_save_path    = arg + 17;
+            else if ( match(arg, "+checkpoint_at=") )       m_at           = strtoull(arg + 15, NULL, 0);
+            else if ( match(arg, "+checkpoint_on=") )       m_marker       = arg + 15;
+            else if ( match(arg, "+checkpoint_restore=") )  m_restore_path = arg + 20;
+        }
+#ifndef TB_SAVABLE
+        if ( !m_save_path.empty() || !m_restore_path.empty() ) {
+            fprintf(stderr, "[CHECKPOINT] The model is not savable (build with SAVABLE=1), checkpoints off\n");
+            m_save_path.clear();
+            m_restore_path.clear();
+        }
+#endif
+        if ( !m_save_path.empty() && m_at == UINT64_MAX && m_marker.empty() )
+            fprintf(stderr, "[CHECKPOINT] No save point, use +checkpoint_at=<cycle> or +checkpoint_on=<marker>\n");
+    }
+
+    // Save and restore size bytes at ptr along with the model, call before restore()
+    void add_state ( void * ptr, size_t size ) {
+        m_states.push_back(std::make_pair(ptr, size));
+    }
+
+    // Save and restore variable-size state along with the model, through the given write and read functions,
+    // call before restore()
+    typedef std::function<void(const void *, size_t)> writer_t;
+    typedef std::function<void(void *, size_t)> reader_t;
+    void add_stream ( std::function<void(writer_t)> save, std::function<void(reader_t)> restore ) {
+        m_streams.push_back(std::make_pair(save, restore));
+    }
+
+    // The marker of +checkpoint_on, empty if none
+    const std::string & marker_name () const { return m_marker; }
+
+    // Restore the model, if requested: returns the cycle to go on from, 0 otherwise
+    uint64_t restore () {
+        if ( m_restore_path.empty() )
+            return 0;
+
+        uint64_t cycle = 0;
+#ifdef TB_SAVABLE
+        auto start = std::chrono::steady_clock::now();
+        VerilatedRestore is;
+        is.open(m_restore_path.c_str());
+        if ( !is.isOpen() ) {
+            printf("ERROR: cannot open checkpoint %s\n", m_restore_path.c_str());
+            exit(1);
+        }
+        is.read(&cycle, sizeof(cycle));
+        for ( size_t i = 0; i < m_states.size(); i++ )
+            is.read(m_states[i].first, m_states[i].second);
+        for ( size_t i = 0; i < m_streams.size(); i++ )
+            m_streams[i].second([&is](void * ptr, size_t size) { is.read(ptr, size); });
+        is >> *m_model;
+        is.close();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("[CHECKPOINT] Restored %s in %.3f s, %lu cycles saved\n", m_restore_path.c_str(), seconds, (unsigned long) cycle);
+#endif
+        return cycle;
+    }
+
+    // The testbench reached a marker, the save follows at the start of the next cycle
+    void marker ( const char * name ) {
+        if ( !m_marker.empty() && m_marker == name )
+            m_pending = true;
+    }
+
+    // Call once per cycle, before the cycle runs: saves at the save point
+    void cycle ( uint64_t cycle ) {
+        if ( m_save_path.empty() || m_saved )
+            return;
+        if ( cycle == m_at || m_pending )
+            save(cycle);
+    }
+
+private:
+    static bool match ( const char * arg, const char * prefix ) {
+        return strncmp(arg, prefix, strlen(prefix)) == 0;
+    }
+
+    void save ( uint64_t cycle ) {
+        m_saved = true;
+#ifdef TB_SAVABLE
+        auto start = std::chrono::steady_clock::now();
+        VerilatedSave os;
+        os.open(m_save_path.c_str());
+        if ( !os.isOpen() ) {
+            fprintf(stderr, "[CHECKPOINT] Cannot open %s, checkpoint not saved\n", m_save_path.c_str());
+            return;
+        }
+        os.write(&cycle, sizeof(cycle));
+        for ( size_t i = 0; i < m_states.size(); i++ )
+            os.write(m_states[i].first, m_states[i].second);
+        for ( size_t i = 0; i < m_streams.size(); i++ )
+            m_streams[i].first([&os](const void * ptr, size_t size) { os.write(ptr, size); });
+        os << *m_model;
+        os.close();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("[CHECKPOINT] Saved %s at cycle %lu in %.3f s\n", m_save_path.c_str(), (unsigned long) cycle, seconds);
+#else
+        (void) cycle;
+#endif
+    }
+
+    Model * m_model;
+    std::string m_save_path;
+    std::string m_restore_path;
+    std::string m_marker;
+    uint64_t m_at;
+    bool m_pending;
+    bool m_saved;
+    std::vector<std::pair<void *, size_t> > m_states;
+    std::vector<std::pair<std::function<void(writer_t)>, std::function<void(reader_t)> > > m_streams;
+};
+
+#endif
@@ -0,0 +1,326 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Verilator testbench clocks, edge scheduler and reset
+//              Each clock input of the model is a TbClock, with its frequency taken from the SoC configuration
+//              (see TbClockConfig) and testbench hooks run on its rising edges:
+//                  - sample hooks, before the edge: read the model outputs, settled since the previous edge
+//                  - drive hooks, after the edge: set the model inputs of the next cycle
+//              The scheduler jumps from edge to edge: all the clock edges due at the same time are applied
+//              together, with a single eval(). The inputs set by the drive hooks are evaluated with the next edge
+//              of any clock (the falling edge for a single clock), so that a cycle costs two evaluations and the
+//              domains of a multi-clock model only evaluate on their own edges.
+//              Times are in ps, the traces are dumped at the edges (see tb_trace.h), the trace cycles are the
+//              rising edges of the first clock.
+//              Clock frequencies, runtime plusargs:
+//                  +clock_config=<file>            SoC main bus config, e.g. config/configs/embedded/config_main_bus.csv:
+//                                                  MAIN_CLOCK_DOMAIN for the clock named MAIN, RANGE_CLOCK_DOMAINS
+//                                                  for the clocks named as in RANGE_NAMES (e.g. PBUS)
+//                  +clock=<name>:<MHz>             override a clock frequency, e.g. +clock=PBUS:250
+
+#ifndef TB_CLOCK_H__
+#define TB_CLOCK_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <fstream>
+#include <functional>
+#include "verilated.h"
+#include "tb_trace.h"
+
+// Default values
+#define TB_RESET_CYCLES     10
+
+class TbClock;
+
+// Edge scheduler, model independent part: the testbench components only see this one
+class TbSchedulerBase {
+public:
+    virtual ~TbSchedulerBase () {}
+    // Advance to the next edge(s) and evaluate the model
+    virtual void step () = 0;
+    virtual uint64_t time_ps () const = 0;
+    virtual uint64_t evals () const = 0;
+};
+
+class TbClock {
+public:
+    // The state saved with the model checkpoints (see TbScheduler::add_state())
+    typedef struct {
+        uint64_t next_ps;       // Next edge
+        uint64_t cycles;        // Rising edges so far
+        uint8_t  level;
+    } state_t;
+
+    TbClock ( TbSchedulerBase * scheduler, const char * name, uint8_t * signal, double mhz, uint64_t phase_ps ) :
+        m_scheduler(scheduler), m_name(name), m_signal(signal), m_mhz(mhz)
+    {
+        m_period_ps = (uint64_t) llround(1e6 / mhz);
+        if ( m_period_ps < 2 )
+            m_period_ps = 2;
+        // Low first: the first rising edge comes after the low phase
+        m_high_ps = m_period_ps / 2;
+        m_state.next_ps = phase_ps + ( m_period_ps - m_high_ps );
+        m_state.cycles = 0;
+        m_state.level = 0;
+        *m_signal = 0;
+    }
+
+    // Sample hooks run before each rising edge, drive hooks after it
+    void add_sample_hook ( std::function<void()> hook ) { m_sample.push_back(hook); }
+    void add_drive_hook ( std::function<void()> hook ) { m_drive.push_back(hook); }
+
+    const std::string & name () const { return m_name; }
+    double mhz () const { return m_mhz; }
+    uint64_t period_ps () const { return m_period_ps; }
+    uint64_t cycles () const { return m_state.cycles; }
+    TbSchedulerBase * scheduler () const { return m_scheduler; }
+
+    // Run for n rising edges of this clock
+    void run_cycles ( uint64_t n ) {
+        uint64_t end = m_state.cycles + n;
+        while ( m_state.cycles < end )
+            m_scheduler->step();
+    }
+
+    // Run until done() holds, checked after each edge, for at most max_cycles rising edges of this clock.
+    // Returns done().
+    bool run_until ( std::function<bool()> done, uint64_t max_cycles = UINT64_MAX ) {
+        uint64_t end = ( max_cycles > UINT64_MAX - m_state.cycles ) ? UINT64_MAX : m_state.cycles + max_cycles;
+        while ( !done() ) {
+            if ( m_state.cycles >= end )
+                return false;
+            m_scheduler->step();
+        }
+        return true;
+    }
+
+private:
+    template <class Model> friend class TbScheduler;
+
+    TbSchedulerBase * m_scheduler;
+    std::string m_name;
+    uint8_t * m_signal;
+    double m_mhz;
+    uint64_t m_period_ps;
+    uint64_t m_high_ps;
+    state_t m_state;
+    std::vector<std::function<void()> > m_sample;
+    std::vector<std::function<void()> > m_drive;
+};
+
+// Clock frequencies from the SoC config and the +clock plusargs
+class TbClockConfig {
+public:
+    TbClockConfig ( int argc, char ** argv ) {
+        for ( int i = 1; i < argc; i++ ) {
+            if ( strncmp(argv[i], "+clock_config=", 14) == 0 )
+                load(argv[i] + 14);
+            else if ( strncmp(argv[i], "+clock=", 7) == 0 )
+                set_override(argv[i] + 7);
+        }
+    }
+
+    // Frequency of the named clock domain, default_mhz if neither configured nor overridden
+    double mhz ( const char * name, double default_mhz ) const {
+        std::map<std::string, double>::const_iterator it = m_overrides.find(name);
+        if ( it != m_overrides.end() )
+            return it->second;
+        it = m_domains.find(name);
+        return ( it != m_domains.end() ) ? it->second : default_mhz;
+    }
+
+private:
+    // Property,Value lines, list values separated by spaces
+    void load ( const char * path ) {
+        std::map<std::string, std::string> props;
+        std::ifstream file(path);
+        std::string line;
+
+        if ( !file ) {
+            fprintf(stderr, "[WARNING] Cannot open clock config %s, default frequencies\n", path);
+            return;
+        }
+        while ( std::getline(file, line) ) {
+            size_t comma = line.find(',');
+            if ( !line.empty() && line[line.size() - 1] == '\r' )
+                line.erase(line.size() - 1);
+            if ( comma != std::string::npos )
+                props[line.substr(0, comma)] = line.substr(comma + 1);
+        }
+
+        if ( props.count("MAIN_CLOCK_DOMAIN") )
+            m_domains["MAIN"] = atof(props["MAIN_CLOCK_DOMAIN"].c_str());
+
+        std::vector<std::string> names = split(props["RANGE_NAMES"]);
+        std::vector<std::string> clocks = split(props["RANGE_CLOCK_DOMAINS"]);
+        if ( names.size() != clocks.size() )
+            fprintf(stderr, "[WARNING] %s: %lu RANGE_NAMES, %lu RANGE_CLOCK_DOMAINS\n", path,
+                    (unsigned long) names.size(), (unsigned long) clocks.size());
+        for ( size_t i = 0; i < names.size() && i < clocks.size(); i++ )
+            m_domains[names[i]] = atof(clocks[i].c_str());
+    }
+
+    void set_override ( const char * str ) {
+        const char * colon = strchr(str, ':');
+        if ( colon == NULL || atof(colon + 1) <= 0 ) {
+            fprintf(stderr, "[WARNING] Malformed +clock=%s, expected <name>:<MHz>\n", str);
+            return;
+        }
+        m_overrides[std::string(str, colon - str)] = atof(colon + 1);
+    }
+
+    static std::vector<std::string> split ( const std::string & str ) {
+        std::vector<std::string> tokens;
+        std::istringstream stream(str);
+        std::string token;
+        while ( stream >> token )
+            tokens.push_back(token);
+        return tokens;
+    }
+
+    std::map<std::string, double> m_domains;
+    std::map<std::string, double> m_overrides;
+};
+
+template <class Model> class TbScheduler : public TbSchedulerBase {
+public:
+    // Traces are dumped at each edge, if a tracer is given
+    TbScheduler ( Model * model, TbTrace<Model> * trace = NULL ) :
+        m_model(model), m_trace(trace), m_time_ps(0), m_evals(0), m_started(false) {}
+
+    ~TbScheduler () {
+        for ( size_t i = 0; i < m_clocks.size(); i++ )
+            delete m_clocks[i];
+    }
+
+    // Add a clock input of the model, all clocks are added before the first step
+    TbClock * add_clock ( const char * name, uint8_t * signal, double mhz, uint64_t phase_ps = 0 ) {
+        TbClock * clock = new TbClock(this, name, signal, mhz, phase_ps);
+        m_clocks.push_back(clock);
+        return clock;
+    }
+
+    // Save and restore the clocks along with the model: Checkpoint is a TbCheckpoint (see tb_checkpoint.h)
+    template <class Checkpoint> void add_state ( Checkpoint * checkpoint ) {
+        checkpoint->add_state(&m_time_ps, sizeof(m_time_ps));
+        for ( size_t i = 0; i < m_clocks.size(); i++ )
+            checkpoint->add_state(&m_clocks[i]->m_state, sizeof(TbClock::state_t));
+    }
+
+    void step () {
+        uint64_t time = UINT64_MAX;
+
+        // Initial values, with the clocks low
+        if ( !m_started ) {
+            m_started = true;
+            m_model->eval();
+            m_evals++;
+            if ( m_trace )
+                m_trace->dump(m_time_ps);
+        }
+
+        // Earliest pending edge
+        m_due.clear();
+        for ( size_t i = 0; i < m_clocks.size(); i++ ) {
+            if ( m_clocks[i]->m_state.next_ps < time ) {
+                time = m_clocks[i]->m_state.next_ps;
+                m_due.clear();
+            }
+            if ( m_clocks[i]->m_state.next_ps == time )
+                m_due.push_back(m_clocks[i]);
+        }
+        m_time_ps = time;
+
+        // Sample all the domains before any edge
+        for ( size_t i = 0; i < m_due.size(); i++ )
+            if ( !m_due[i]->m_state.level )
+                run_hooks(m_due[i]->m_sample);
+
+        for ( size_t i = 0; i < m_due.size(); i++ ) {
+            TbClock * clock = m_due[i];
+            clock->m_state.level ^= 1;
+            *clock->m_signal = clock->m_state.level;
+            clock->m_state.next_ps += clock->m_state.level ? clock->m_high_ps : clock->m_period_ps - clock->m_high_ps;
+            if ( clock->m_state.level ) {
+                // Trace cycles: rising edges of the first clock
+                if ( m_trace && clock == m_clocks[0] )
+                    m_trace->cycle(clock->m_state.cycles);
+                clock->m_state.cycles++;
+            }
+        }
+
+        m_model->eval();
+        m_evals++;
+        if ( m_trace )
+            m_trace->dump(m_time_ps);
+
+        for ( size_t i = 0; i < m_due.size(); i++ )
+            if ( m_due[i]->m_state.level )
+                run_hooks(m_due[i]->m_drive);
+    }
+
+    uint64_t time_ps () const { return m_time_ps; }
+    uint64_t evals () const { return m_evals; }
+
+    // Clock frequencies and evaluations per rising edge of the first clock
+    void report ( FILE * file = stdout ) const {
+        for ( size_t i = 0; i < m_clocks.size(); i++ )
+            fprintf(file, "[CLOCK] %-12s %8.2f MHz %12lu cycles\n", m_clocks[i]->name().c_str(), m_clocks[i]->mhz(),
+                    (unsigned long) m_clocks[i]->cycles());
+        if ( !m_clocks.empty() && m_clocks[0]->cycles() )
+            fprintf(file, "[CLOCK] %lu evaluations, %.2f per %s cycle\n", (unsigned long) m_evals,
+                    (double) m_evals / m_clocks[0]->cycles(), m_clocks[0]->name().c_str());
+    }
+
+private:
+    static void run_hooks ( std::vector<std::function<void()> > & hooks ) {
+        for ( size_t i = 0; i < hooks.size(); i++ )
+            hooks[i]();
+    }
+
+    Model * m_model;
+    TbTrace<Model> * m_trace;
+    std::vector<TbClock *> m_clocks;
+    std::vector<TbClock *> m_due;
+    uint64_t m_time_ps;
+    uint64_t m_evals;
+    bool m_started;
+};
+
+// Reset input, asserted from the start for a number of rising edges of its clock
+class TbReset {
+public:
+    TbReset ( TbClock * clock, uint8_t * signal, bool active_low = true, uint64_t cycles = TB_RESET_CYCLES ) :
+        m_clock(clock), m_signal(signal), m_active_low(active_low), m_cycles(cycles)
+    {
+        *m_signal = m_active_low ? 0 : 1;
+        m_clock->add_drive_hook([this]() {
+            if ( m_clock->cycles() >= m_cycles )
+                *m_signal = m_active_low ? 1 : 0;
+        });
+    }
+
+    bool active () const { return m_clock->cycles() < m_cycles; }
+
+    // Run until the reset is released
+    void wait () {
+        m_clock->run_until([this]() { return !active(); });
+    }
+
+private:
+    TbReset ( const TbReset & );
+    TbReset & operator= ( const TbReset & );
+
+    TbClock * m_clock;
+    uint8_t * m_signal;
+    bool m_active_low;
+    uint64_t m_cycles;
+};
+
+#endif
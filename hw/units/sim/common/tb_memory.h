@@ -0,0 +1,380 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Sparse memory model for the memory slaves of the Verilator models, e.g. the BRAM and DDR stand-ins
+//              Pages are allocated on their first non-zero write: untouched pages read as zero and cost nothing,
+//              so that the start-up time and the memory use follow what the program touches, not the memory size.
+//              Pages sit in a two-level table, the last page used is cached for the sequential accesses.
+//              Optionally, the whole memory is a host file mapped shared (map_file()): the file content is the
+//              initial one (preload) and the writes land in it (dump), the host pages it in lazily.
+//              The backdoor accesses (read(), write(), fill(), load_file(), dump()) are bulk copies, page by page.
+//              The RTL models reach their memory through DPI functions defined by the testbench on top of the
+//              registry below: the DPI handle of a memory is its index, stable across checkpoints.
+
+#ifndef TB_MEMORY_H__
+#define TB_MEMORY_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+// Page size and pages per second-level table
+#define TB_MEM_PAGE_BITS    12
+#define TB_MEM_TABLE_BITS   10
+#define TB_MEM_PAGE_SIZE    ( 1ULL << TB_MEM_PAGE_BITS )
+
+class TbSparseMemory {
+public:
+    // Checkpoint streams, see TbCheckpoint::add_stream()
+    typedef std::function<void(const void *, size_t)> writer_t;
+    typedef std::function<void(void *, size_t)> reader_t;
+
+    TbSparseMemory ( const char * name, uint64_t size ) :
+        m_name(name), m_size(size), m_pages(0), m_file(NULL), m_last_index(UINT64_MAX), m_last_page(NULL)
+    {
+        m_dir.assign(( ( size + TB_MEM_PAGE_SIZE - 1 ) >> ( TB_MEM_PAGE_BITS + TB_MEM_TABLE_BITS ) ) + 1, NULL);
+    }
+
+    ~TbSparseMemory () {
+        clear();
+        unmap();
+    }
+
+    const std::string & name () const { return m_name; }
+    uint64_t size () const { return m_size; }
+    // Allocated pages, all of them for a file-backed memory
+    uint64_t pages () const { return m_file ? ( m_size + TB_MEM_PAGE_SIZE - 1 ) >> TB_MEM_PAGE_BITS : m_pages; }
+
+    // Back the memory with a file, created or resized to the memory size. The current content is dropped.
+    bool map_file ( const char * path ) {
+        int fd = open(path, O_RDWR | O_CREAT, 0644);
+        struct stat st;
+        if ( fd == -1 || fstat(fd, &st) != 0 ) {
+            printf("ERROR: cannot open memory file %s\n", path);
+            if ( fd != -1 )
+                close(fd);
+            return false;
+        }
+        if ( (uint64_t) st.st_size != m_size && ftruncate(fd, m_size) != 0 ) {
+            printf("ERROR: cannot resize memory file %s to %lu bytes\n", path, (unsigned long) m_size);
+            close(fd);
+            return false;
+        }
+        void * file = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if ( file == MAP_FAILED ) {
+            printf("ERROR: cannot map memory file %s\n", path);
+            return false;
+        }
+        clear();
+        unmap();
+        m_file = (uint8_t *) file;
+        return true;
+    }
+
+    // Word accessors, aligned offsets: out of the memory, reads return zero and writes are dropped
+    uint32_t read32 ( uint64_t offset ) {
+        if ( offset >= m_size )
+            return 0;
+        uint8_t * p = page(offset, false);
+        return p ? *(uint32_t *) ( p + ( offset & ( TB_MEM_PAGE_SIZE - 1 ) ) ) : 0;
+    }
+
+    void write32 ( uint64_t offset, uint32_t data, uint8_t strb = 0xF ) {
+        if ( offset >= m_size || ( data == 0 && page(offset, false) == NULL ) )
+            return;
+        uint8_t * p = page(offset, true) + ( offset & ( TB_MEM_PAGE_SIZE - 1 ) );
+        if ( strb == 0xF ) {
+            *(uint32_t *) p = data;
+            return;
+        }
+        for ( int b = 0; b < 4; b++ )
+            if ( ( strb >> b ) & 1 )
+                p[b] = (uint8_t) ( data >> ( 8 * b ) );
+    }
+
+    uint64_t read64 ( uint64_t offset ) {
+        if ( offset >= m_size )
+            return 0;
+        uint8_t * p = page(offset, false);
+        return p ? *(uint64_t *) ( p + ( offset & ( TB_MEM_PAGE_SIZE - 1 ) ) ) : 0;
+    }
+
+    void write64 ( uint64_t offset, uint64_t data, uint8_t strb = 0xFF ) {
+        write32(offset, (uint32_t) data, strb & 0xF);
+        write32(offset + 4, (uint32_t) ( data >> 32 ), strb >> 4);
+    }
+
+    // Bulk backdoor, return the bytes out of the memory (not copied)
+    uint64_t read ( uint64_t offset, void * buffer, uint64_t len ) {
+        return bulk(offset, len, [&](uint64_t done, uint64_t off, uint64_t n) {
+            uint8_t * p = page(off, false);
+            if ( p )
+                memcpy((uint8_t *) buffer + done, p + ( off & ( TB_MEM_PAGE_SIZE - 1 ) ), n);
+            else
+                memset((uint8_t *) buffer + done, 0, n);
+        });
+    }
+
+    // Zeros on untouched pages do not allocate them
+    uint64_t write ( uint64_t offset, const void * buffer, uint64_t len ) {
+        return bulk(offset, len, [&](uint64_t done, uint64_t off, uint64_t n) {
+            const uint8_t * src = (const uint8_t *) buffer + done;
+            if ( page(off, false) == NULL && is_zero(src, n) )
+                return;
+            memcpy(page(off, true) + ( off & ( TB_MEM_PAGE_SIZE - 1 ) ), src, n);
+        });
+    }
+
+    uint64_t fill ( uint64_t offset, uint8_t value, uint64_t len ) {
+        return bulk(offset, len, [&](uint64_t, uint64_t off, uint64_t n) {
+            if ( value == 0 && page(off, false) == NULL )
+                return;
+            memset(page(off, true) + ( off & ( TB_MEM_PAGE_SIZE - 1 ) ), value, n);
+        });
+    }
+
+    // Copy a whole file at offset, through a read-only mapping of it. Returns the bytes out of the memory, or -1.
+    int64_t load_file ( const char * path, uint64_t offset ) {
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if ( fd == -1 || fstat(fd, &st) != 0 ) {
+            printf("ERROR: cannot open %s\n", path);
+            if ( fd != -1 )
+                close(fd);
+            return -1;
+        }
+        if ( st.st_size == 0 ) {
+            close(fd);
+            return 0;
+        }
+        void * src = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if ( src == MAP_FAILED ) {
+            printf("ERROR: cannot map %s\n", path);
+            return -1;
+        }
+        uint64_t dropped = write(offset, src, st.st_size);
+        munmap(src, st.st_size);
+        return dropped;
+    }
+
+    // Write the whole memory to a file, the zero pages are left as holes
+    bool dump ( const char * path ) {
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool ok = ( fd != -1 ) && ftruncate(fd, m_size) == 0;
+        for ( uint64_t off = 0; ok && off < m_size; off += TB_MEM_PAGE_SIZE ) {
+            uint64_t n = page_bytes(off);
+            uint8_t * p = page(off, false);
+            if ( p && !is_zero(p, n) )
+                ok = pwrite(fd, p, n, off) == (ssize_t) n;
+        }
+        if ( fd != -1 )
+            close(fd);
+        if ( !ok )
+            printf("ERROR: cannot dump %s to %s\n", m_name.c_str(), path);
+        return ok;
+    }
+
+    // Checkpoints: the non-zero pages, by index
+    void save ( writer_t write ) {
+        for ( uint64_t off = 0; off < m_size; off += TB_MEM_PAGE_SIZE ) {
+            uint8_t * p = page(off, false);
+            if ( p == NULL || is_zero(p, page_bytes(off)) )
+                continue;
+            uint64_t index = off >> TB_MEM_PAGE_BITS;
+            write(&index, sizeof(index));
+            write(p, page_bytes(off));
+        }
+        uint64_t end = UINT64_MAX;
+        write(&end, sizeof(end));
+    }
+
+    void restore ( reader_t read ) {
+        uint64_t index;
+        if ( m_file )
+            memset(m_file, 0, m_size);
+        else
+            clear();
+        for ( read(&index, sizeof(index)); index != UINT64_MAX; read(&index, sizeof(index)) ) {
+            uint64_t off = index << TB_MEM_PAGE_BITS;
+            read(page(off, true), page_bytes(off));
+        }
+    }
+
+private:
+    TbSparseMemory ( const TbSparseMemory & );
+    TbSparseMemory & operator= ( const TbSparseMemory & );
+
+    uint8_t * page ( uint64_t offset, bool alloc ) {
+        uint64_t index = offset >> TB_MEM_PAGE_BITS;
+        if ( index == m_last_index )
+            return m_last_page;
+        if ( m_file )
+            return m_file + ( index << TB_MEM_PAGE_BITS );
+
+        uint8_t ** table = m_dir[index >> TB_MEM_TABLE_BITS];
+        if ( table == NULL ) {
+            if ( !alloc )
+                return NULL;
+            table = (uint8_t **) calloc(1 << TB_MEM_TABLE_BITS, sizeof(uint8_t *));
+            m_dir[index >> TB_MEM_TABLE_BITS] = table;
+        }
+        uint8_t * p = table[index & ( ( 1 << TB_MEM_TABLE_BITS ) - 1 )];
+        if ( p == NULL ) {
+            if ( !alloc )
+                return NULL;
+            if ( posix_memalign((void **) &p, TB_MEM_PAGE_SIZE, TB_MEM_PAGE_SIZE) != 0 ) {
+                printf("ERROR: out of host memory for %s\n", m_name.c_str());
+                exit(1);
+            }
+            memset(p, 0, TB_MEM_PAGE_SIZE);
+            table[index & ( ( 1 << TB_MEM_TABLE_BITS ) - 1 )] = p;
+            m_pages++;
+        }
+        m_last_index = index;
+        m_last_page = p;
+        return p;
+    }
+
+    // Bytes of the page at offset within the memory
+    uint64_t page_bytes ( uint64_t offset ) const {
+        uint64_t n = TB_MEM_PAGE_SIZE - ( offset & ( TB_MEM_PAGE_SIZE - 1 ) );
+        return ( n < m_size - offset ) ? n : m_size - offset;
+    }
+
+    // Call copy(done, offset, bytes) on each page-bounded chunk of [offset, offset + len) within the memory
+    uint64_t bulk ( uint64_t offset, uint64_t len, std::function<void(uint64_t, uint64_t, uint64_t)> copy ) {
+        uint64_t done = 0;
+        while ( done < len && offset + done < m_size ) {
+            uint64_t off = offset + done;
+            uint64_t n = page_bytes(off);
+            if ( n > len - done )
+                n = len - done;
+            copy(done, off, n);
+            done += n;
+        }
+        return len - done;
+    }
+
+    static bool is_zero ( const uint8_t * p, uint64_t n ) {
+        return n == 0 || ( p[0] == 0 && memcmp(p, p + 1, n - 1) == 0 );
+    }
+
+    void clear () {
+        for ( size_t i = 0; i < m_dir.size(); i++ ) {
+            if ( m_dir[i] == NULL )
+                continue;
+            for ( int j = 0; j < ( 1 << TB_MEM_TABLE_BITS ); j++ )
+                free(m_dir[i][j]);
+            free(m_dir[i]);
+            m_dir[i] = NULL;
+        }
+        m_pages = 0;
+        m_last_index = UINT64_MAX;
+        m_last_page = NULL;
+    }
+
+    void unmap () {
+        if ( m_file )
+            munmap(m_file, m_size);
+        m_file = NULL;
+    }
+
+    std::string m_name;
+    uint64_t m_size;
+    uint64_t m_pages;
+    uint8_t * m_file;
+    std::vector<uint8_t **> m_dir;
+    uint64_t m_last_index;
+    uint8_t * m_last_page;
+};
+
+////////////////////////
+// Memories registry  //
+////////////////////////
+
+static inline std::vector<TbSparseMemory *> & tb_memories ()
+{
+    static std::vector<TbSparseMemory *> memories;
+    return memories;
+}
+
+// Names as reported by the RTL (%m) or the DPI scopes, with or without the TOP. prefix
+static inline std::string tb_memory_name ( const char * name )
+{
+    return ( strncmp(name, "TOP.", 4) == 0 ) ? name + 4 : name;
+}
+
+// Handle of the named memory, created if new. -1 if it exists with another size.
+static inline int tb_memory_open ( const char * name, uint64_t size )
+{
+    std::vector<TbSparseMemory *> & memories = tb_memories();
+    for ( size_t i = 0; i < memories.size(); i++ ) {
+        if ( memories[i]->name() != tb_memory_name(name) )
+            continue;
+        if ( memories[i]->size() != size ) {
+            printf("ERROR: memory %s opened with %lu and %lu bytes\n", name, (unsigned long) memories[i]->size(), (unsigned long) size);
+            return -1;
+        }
+        return i;
+    }
+    memories.push_back(new TbSparseMemory(tb_memory_name(name).c_str(), size));
+    return memories.size() - 1;
+}
+
+static inline TbSparseMemory * tb_memory ( int handle )
+{
+    return tb_memories()[handle];
+}
+
+static inline TbSparseMemory * tb_memory_find ( const char * name )
+{
+    std::vector<TbSparseMemory *> & memories = tb_memories();
+    for ( size_t i = 0; i < memories.size(); i++ )
+        if ( memories[i]->name() == tb_memory_name(name) )
+            return memories[i];
+    return NULL;
+}
+
+// All the memories in handle order, the restore recreates them with the same handles
+static inline void tb_memory_save ( TbSparseMemory::writer_t write )
+{
+    std::vector<TbSparseMemory *> & memories = tb_memories();
+    uint64_t count = memories.size();
+    write(&count, sizeof(count));
+    for ( size_t i = 0; i < memories.size(); i++ ) {
+        uint64_t size = memories[i]->size();
+        uint64_t name_len = memories[i]->name().size();
+        write(&size, sizeof(size));
+        write(&name_len, sizeof(name_len));
+        write(memories[i]->name().data(), name_len);
+        memories[i]->save(write);
+    }
+}
+
+static inline void tb_memory_restore ( TbSparseMemory::reader_t read )
+{
+    uint64_t count, size, name_len;
+    read(&count, sizeof(count));
+    for ( uint64_t i = 0; i < count; i++ ) {
+        read(&size, sizeof(size));
+        read(&name_len, sizeof(name_len));
+        std::string name(name_len, '\0');
+        read(&name[0], name_len);
+        int handle = tb_memory_open(name.c_str(), size);
+        if ( handle != (int) i ) {
+            printf("ERROR: memory %s restored with handle %d instead of %lu\n", name.c_str(), handle, (unsigned long) i);
+            exit(1);
+        }
+        tb_memory(handle)->restore(read);
+    }
+}
+
+#endif
@@ -0,0 +1,165 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Benchmark of the memory models for the memory slaves: dense array (as the RTL arrays of the models),
+//              sparse memory and file-backed memory (tb_memory.h). For each memory size: start-up time (allocation
+//              and preload of a program), time per word access on the program working set, peak host memory (RSS).
+//              Each run is a child process, so that its RSS is its own.
+//              Usage: tb_memory_bench <size MiB>... [+load=<KiB>] [+accesses=<N>] [+file=<path>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "tb_memory.h"
+
+#define LOAD_KIB        256
+#define ACCESSES        10000000
+
+struct result_t {
+    double startup_ms;
+    double access_ns;
+    uint64_t checksum;
+};
+
+static double elapsed ( std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Word addresses of the working set: a program of load_bytes, its stack at the end of the memory
+static uint64_t word_at ( uint64_t i, uint64_t load_words, uint64_t words )
+{
+    uint64_t x = i * 2654435761ULL;
+    return ( i & 7 ) ? ( x % load_words ) : words - 1 - ( x % 1024 );
+}
+
+static result_t run_dense ( uint64_t size, const std::vector<uint8_t> & program, uint64_t accesses )
+{
+    result_t result;
+    uint64_t words = size / 4;
+    auto start = std::chrono::steady_clock::now();
+    uint32_t * mem = new uint32_t[words]();
+    memcpy(mem, program.data(), program.size());
+    result.startup_ms = elapsed(start) * 1e3;
+
+    result.checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for ( uint64_t i = 0; i < accesses; i++ ) {
+        uint64_t word = word_at(i, program.size() / 4, words);
+        if ( i & 1 )
+            mem[word] += (uint32_t) i;
+        else
+            result.checksum += mem[word];
+    }
+    result.access_ns = elapsed(start) * 1e9 / accesses;
+    delete [] mem;
+    return result;
+}
+
+static result_t run_sparse ( uint64_t size, const std::vector<uint8_t> & program, uint64_t accesses, const char * file )
+{
+    result_t result;
+    uint64_t words = size / 4;
+    auto start = std::chrono::steady_clock::now();
+    TbSparseMemory * mem = new TbSparseMemory("bench", size);
+    if ( file != NULL && !mem->map_file(file) )
+        exit(1);
+    mem->write(0, program.data(), program.size());
+    result.startup_ms = elapsed(start) * 1e3;
+
+    result.checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for ( uint64_t i = 0; i < accesses; i++ ) {
+        uint64_t word = word_at(i, program.size() / 4, words);
+        if ( i & 1 )
+            mem->write32(word * 4, mem->read32(word * 4) + (uint32_t) i);
+        else
+            result.checksum += mem->read32(word * 4);
+    }
+    result.access_ns = elapsed(start) * 1e9 / accesses;
+    delete mem;
+    return result;
+}
+
+int main ( int argc, char ** argv )
+{
+    std::vector<uint64_t> sizes;
+    uint64_t load = LOAD_KIB * 1024ULL;
+    uint64_t accesses = ACCESSES;
+    const char * file = "/tmp/tb_memory_bench.img";
+    for ( int i = 1; i < argc; i++ ) {
+        if ( strncmp(argv[i], "+load=", 6) == 0 )
+            load = strtoull(argv[i] + 6, NULL, 0) * 1024;
+        else if ( strncmp(argv[i], "+accesses=", 10) == 0 )
+            accesses = strtoull(argv[i] + 10, NULL, 0);
+        else if ( strncmp(argv[i], "+file=", 6) == 0 )
+            file = argv[i] + 6;
+        else
+            sizes.push_back(strtoull(argv[i], NULL, 0) << 20);
+    }
+    if ( sizes.empty() || accesses == 0 ) {
+        printf("Usage: %s <size MiB>... [+load=<KiB>] [+accesses=<N>] [+file=<path>]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t host_memory = (uint64_t) sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE);
+    const char * kinds[] = { "dense", "sparse", "file" };
+
+    printf("%-10s %-8s %12s %12s %12s\n", "size", "model", "startup ms", "access ns", "RSS MiB");
+    for ( size_t s = 0; s < sizes.size(); s++ ) {
+        uint64_t size = sizes[s];
+        std::vector<uint8_t> program(std::min(load, size) & ~3ULL);
+        for ( size_t i = 0; i < program.size(); i++ )
+            program[i] = (uint8_t) ( i * 31 + 7 );
+        if ( program.empty() ) {
+            printf("ERROR: memory of %lu bytes too small\n", (unsigned long) size);
+            return 1;
+        }
+
+        for ( int k = 0; k < 3; k++ ) {
+            printf("%-10s %-8s ", ( std::to_string(size >> 20) + " MiB" ).c_str(), kinds[k]);
+            fflush(stdout);
+            if ( k == 0 && size > host_memory / 2 ) {
+                printf("%12s\n", "skipped");
+                continue;
+            }
+
+            int fds[2];
+            if ( pipe(fds) != 0 ) {
+                printf("ERROR: cannot create a pipe\n");
+                return 1;
+            }
+            pid_t pid = fork();
+            if ( pid == 0 ) {
+                close(fds[0]);
+                unlink(file);
+                result_t result = ( k == 0 ) ? run_dense(size, program, accesses) :
+                                               run_sparse(size, program, accesses, k == 2 ? file : NULL);
+                unlink(file);
+                if ( write(fds[1], &result, sizeof(result)) != sizeof(result) )
+                    _exit(1);
+                _exit(0);
+            }
+            close(fds[1]);
+            result_t result;
+            bool ok = read(fds[0], &result, sizeof(result)) == sizeof(result);
+            close(fds[0]);
+            int status;
+            struct rusage usage;
+            wait4(pid, &status, 0, &usage);
+            if ( !ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ) {
+                printf("%12s\n", "failed");
+                continue;
+            }
+            printf("%12.2f %12.2f %12.1f\n", result.startup_ms, result.access_ns, usage.ru_maxrss / 1024.0);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Statistical PC-sampling profiler for the programs running on the simulated cores, selected at
+//              runtime with plusargs
+//                  +profile=<prefix>               sample and write <prefix>.flat and <prefix>.folded at the end
+//                  +profile_period=<cycles>        cycles between samples (default 100)
+//                  +profile_elf=<file>             program symbols, if not the ones of the loaded ELF (e.g. on restore)
+//              The testbench reads the PC when due() and passes it to sample(): the cost is a counter per cycle
+//              and a hash map update per sample. The samples are symbolized at the end against the function
+//              symbols of the ELF (32 or 64 bits), the assembly labels (e.g. of startup.s) filling the gaps.
+//              Outputs: flat profile (samples per function, hottest PC), and folded profile with no call stacks,
+//              one "<function> <samples>" line each, for flamegraph tools (e.g. flamegraph.pl, speedscope).
+
+#ifndef TB_PROFILE_H__
+#define TB_PROFILE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <elf.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#define TB_PROFILE_PERIOD   100
+#define TB_PROFILE_TOP      10
+
+class TbProfiler {
+public:
+    TbProfiler ( int argc, char ** argv ) : m_period(TB_PROFILE_PERIOD), m_countdown(0), m_samples(0) {
+        const char * elf_file = NULL;
+        for ( int i = 1; i < argc; i++ ) {
+            if ( strncmp(argv[i], "+profile=", 9) == 0 )
+                m_prefix = argv[i] + 9;
+            else if ( strncmp(argv[i], "+profile_period=", 16) == 0 )
+                m_period = strtoull(argv[i] + 16, NULL, 0);
+            else if ( strncmp(argv[i], "+profile_elf=", 13) == 0 )
+                elf_file = argv[i] + 13;
+        }
+        if ( m_period == 0 )
+            m_period = 1;
+        m_countdown = m_period;
+        if ( elf_file != NULL )
+            add_symbols(elf_file);
+    }
+
+    bool enabled () const { return !m_prefix.empty(); }
+
+    // Call once per cycle, true when a sample is due
+    bool due () {
+        if ( --m_countdown != 0 )
+            return false;
+        m_countdown = m_period;
+        return true;
+    }
+
+    void sample ( uint64_t pc ) {
+        m_histogram[pc]++;
+        m_samples++;
+    }
+
+    // Function symbols of an ELF image, ignored if +profile_elf gave them already
+    void add_symbols ( const uint8_t * elf, size_t size, const char * name ) {
+        if ( !m_symbols.empty() )
+            return;
+        if ( size >= EI_NIDENT && elf[EI_CLASS] == ELFCLASS64 )
+            read_symbols<Elf64_Ehdr, Elf64_Shdr, Elf64_Sym>(elf, size);
+        else if ( size >= EI_NIDENT && elf[EI_CLASS] == ELFCLASS32 )
+            read_symbols<Elf32_Ehdr, Elf32_Shdr, Elf32_Sym>(elf, size);
+        if ( m_symbols.empty() )
+            fprintf(stderr, "[WARNING] No function symbols in %s, the profile reports raw PCs\n", name);
+    }
+
+    void add_symbols ( const char * file_name ) {
+        FILE * fp = fopen(file_name, "rb");
+        if ( fp == NULL ) {
+            printf("ERROR: cannot open %s\n", file_name);
+            return;
+        }
+        fseek(fp, 0, SEEK_END);
+        std::vector<uint8_t> buffer(ftell(fp));
+        fseek(fp, 0, SEEK_SET);
+        if ( fread(buffer.data(), 1, buffer.size(), fp) == buffer.size() )
+            add_symbols(buffer.data(), buffer.size(), file_name);
+        else
+            printf("ERROR: cannot read %s\n", file_name);
+        fclose(fp);
+    }
+
+    // Write the profiles and print the hottest functions
+    void report () {
+        if ( !enabled() )
+            return;
+
+        // Samples per function, and the hottest PC of each
+        struct entry_t {
+            std::string name;
+            uint64_t samples;
+            uint64_t top_pc;
+            uint64_t top_samples;
+        };
+        std::unordered_map<std::string, entry_t> functions;
+        for ( auto it = m_histogram.begin(); it != m_histogram.end(); ++it ) {
+            std::string name = symbolize(it->first);
+            entry_t & entry = functions[name];
+            entry.name = name;
+            entry.samples += it->second;
+            if ( it->second > entry.top_samples ) {
+                entry.top_pc = it->first;
+                entry.top_samples = it->second;
+            }
+        }
+        std::vector<entry_t> sorted;
+        for ( auto it = functions.begin(); it != functions.end(); ++it )
+            sorted.push_back(it->second);
+        std::sort(sorted.begin(), sorted.end(), [](const entry_t & a, const entry_t & b) {
+            return a.samples != b.samples ? a.samples > b.samples : a.name < b.name;
+        });
+
+        std::string flat_file = m_prefix + ".flat";
+        std::string folded_file = m_prefix + ".folded";
+        FILE * flat = fopen(flat_file.c_str(), "w");
+        FILE * folded = fopen(folded_file.c_str(), "w");
+        if ( flat == NULL || folded == NULL ) {
+            printf("ERROR: cannot write %s and %s\n", flat_file.c_str(), folded_file.c_str());
+            if ( flat )
+                fclose(flat);
+            if ( folded )
+                fclose(folded);
+            return;
+        }
+
+        fprintf(flat, "# %lu samples, one every %lu cycles\n", (unsigned long) m_samples, (unsigned long) m_period);
+        fprintf(flat, "# %10s %7s %7s  %-18s %s\n", "samples", "%", "cumul%", "hottest PC", "function");
+        printf("\n[PROFILE] %lu samples, one every %lu cycles, hottest functions:\n", (unsigned long) m_samples, (unsigned long) m_period);
+        uint64_t cumulative = 0;
+        for ( size_t i = 0; i < sorted.size(); i++ ) {
+            cumulative += sorted[i].samples;
+            char line[512];
+            snprintf(line, sizeof(line), "  %10lu %6.2f%% %6.2f%%  0x%016lx %s", (unsigned long) sorted[i].samples,
+                     100.0 * sorted[i].samples / m_samples, 100.0 * cumulative / m_samples,
+                     (unsigned long) sorted[i].top_pc, sorted[i].name.c_str());
+            fprintf(flat, "%s\n", line);
+            fprintf(folded, "%s %lu\n", sorted[i].name.c_str(), (unsigned long) sorted[i].samples);
+            if ( i < TB_PROFILE_TOP )
+                printf("%s\n", line);
+        }
+        fclose(flat);
+        fclose(folded);
+        printf("[PROFILE] Written %s and %s\n", flat_file.c_str(), folded_file.c_str());
+    }
+
+private:
+    struct symbol_t {
+        uint64_t start;
+        uint64_t end;
+        std::string name;
+    };
+
+    // Functions (STT_FUNC) in the executable sections, then the labels out of them (e.g. assembly routines),
+    // each up to the next symbol if unsized
+    template <class Ehdr, class Shdr, class Sym>
+    void read_symbols ( const uint8_t * elf, size_t size ) {
+        const Ehdr * ehdr = (const Ehdr *) elf;
+        if ( size < sizeof(Ehdr) || ehdr->e_shoff == 0 || ehdr->e_shoff + (uint64_t) ehdr->e_shnum * sizeof(Shdr) > size )
+            return;
+        const Shdr * shdrs = (const Shdr *) ( elf + ehdr->e_shoff );
+
+        std::vector<symbol_t> functions;
+        std::vector<symbol_t> labels;
+        for ( int s = 0; s < ehdr->e_shnum; s++ ) {
+            if ( shdrs[s].sh_type != SHT_SYMTAB || shdrs[s].sh_link >= ehdr->e_shnum )
+                continue;
+            const Shdr & strtab = shdrs[shdrs[s].sh_link];
+            if ( shdrs[s].sh_offset + shdrs[s].sh_size > size || strtab.sh_offset + strtab.sh_size > size )
+                continue;
+            const Sym * syms = (const Sym *) ( elf + shdrs[s].sh_offset );
+            for ( size_t i = 0; i < shdrs[s].sh_size / sizeof(Sym); i++ ) {
+                int type = syms[i].st_info & 0xF;
+                if ( ( type != STT_FUNC && type != STT_NOTYPE ) || syms[i].st_shndx == SHN_UNDEF ||
+                     syms[i].st_shndx >= ehdr->e_shnum || !( shdrs[syms[i].st_shndx].sh_flags & SHF_EXECINSTR ) ||
+                     syms[i].st_name >= strtab.sh_size )
+                    continue;
+                const char * name = (const char *) ( elf + strtab.sh_offset + syms[i].st_name );
+                // Compiler-local and mapping symbols
+                if ( name[0] == '\0' || name[0] == '$' || strncmp(name, ".L", 2) == 0 )
+                    continue;
+                symbol_t symbol = { syms[i].st_value, syms[i].st_value + syms[i].st_size, name };
+                ( type == STT_FUNC ? functions : labels ).push_back(symbol);
+            }
+        }
+
+        m_symbols = functions;
+        for ( size_t i = 0; i < labels.size(); i++ ) {
+            bool inside = false;
+            for ( size_t f = 0; f < functions.size() && !inside; f++ )
+                inside = labels[i].start >= functions[f].start && labels[i].start < functions[f].end;
+            if ( !inside )
+                m_symbols.push_back(labels[i]);
+        }
+        std::sort(m_symbols.begin(), m_symbols.end(), [](const symbol_t & a, const symbol_t & b) {
+            return a.start != b.start ? a.start < b.start : a.end > b.end;
+        });
+        // One symbol per address, the sized one first
+        m_symbols.erase(std::unique(m_symbols.begin(), m_symbols.end(), [](const symbol_t & a, const symbol_t & b) {
+            return a.start == b.start;
+        }), m_symbols.end());
+        for ( size_t i = 0; i < m_symbols.size(); i++ )
+            if ( m_symbols[i].end == m_symbols[i].start )
+                m_symbols[i].end = ( i + 1 < m_symbols.size() ) ? m_symbols[i + 1].start : UINT64_MAX;
+    }
+
+    std::string symbolize ( uint64_t pc ) const {
+        auto it = std::upper_bound(m_symbols.begin(), m_symbols.end(), pc, [](uint64_t value, const symbol_t & symbol) {
+            return value < symbol.start;
+        });
+        if ( it != m_symbols.begin() && pc < ( it - 1 )->end )
+            return ( it - 1 )->name;
+        if ( m_symbols.empty() ) {
+            char name[32];
+            snprintf(name, sizeof(name), "0x%016lx", (unsigned long) pc);
+            return name;
+        }
+        return "[unknown]";
+    }
+
+    std::string m_prefix;
+    uint64_t m_period;
+    uint64_t m_countdown;
+    uint64_t m_samples;
+    std::unordered_map<uint64_t, uint64_t> m_histogram;
+    std::vector<symbol_t> m_symbols;
+};
+
+#endif
@@ -0,0 +1,308 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Verilator testbench tracing, selected at runtime with plusargs
+//                  +trace=off|on|window|trigger    default off
+//                  +trace_window=<start>:<end>     trace cycles [start, end) only
+//                  +trace_trigger=<name>           trace from the first cycle the named trigger is true (see add_trigger())
+//                  +trace_pre=<cycles>             trigger only, cycles kept before the trigger, default 1000
+//                  +trace_post=<cycles>            trigger only, cycles traced after the trigger, 0 until the end, default 1000
+//                  +trace_depth=<levels>           hierarchy depth, default 99
+//                  +trace_file=<path>              default waves/trace.vcd (waves/trace.fst)
+//              The format is chosen at build time: VCD, or compressed FST with -DTB_TRACE_FST (verilator --trace-fst).
+//              Nothing is flushed per dump: VCD goes through a large stdio buffer, FST through its own writer thread.
+//              Trigger mode, VCD only: the trace is kept in memory in two segments of trace_pre cycles, each starting
+//              with a full dump of the signals (VerilatedVcdC::openNext()). On trigger, the header and the
+//              two segments are written out, then the trace goes straight to the file: as a full dump is a legal
+//              set of value changes, the result is a single VCD covering at least trace_pre cycles before the trigger.
+//              FST has no pre-trigger history, tracing starts at the trigger.
+
+#ifndef TB_TRACE_H__
+#define TB_TRACE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include "verilated.h"
+#ifdef TB_TRACE_FST
+#include "verilated_fst_c.h"
+typedef VerilatedFstC TbTraceC;
+#define TB_TRACE_DEFAULT_FILE   "waves/trace.fst"
+#else
+#include "verilated_vcd_c.h"
+typedef VerilatedVcdC TbTraceC;
+#define TB_TRACE_DEFAULT_FILE   "waves/trace.vcd"
+#endif
+
+// Default values
+#define TB_TRACE_DEFAULT_PRE    1000
+#define TB_TRACE_DEFAULT_POST   1000
+#define TB_TRACE_DEFAULT_DEPTH  99
+#define TB_TRACE_BUFFER_SIZE    ( 8 << 20 )     // stdio buffer of the VCD file
+
+typedef enum {
+    TB_TRACE_OFF,
+    TB_TRACE_ON,
+    TB_TRACE_WINDOW,
+    TB_TRACE_TRIGGER
+} tb_trace_mode_t;
+
+#ifndef TB_TRACE_FST
+// VCD output: buffered file, or in-memory segments until the trigger
+class TbTraceFile : public VerilatedVcdFile {
+public:
+    TbTraceFile ( bool in_memory ) : m_in_memory(in_memory), m_fp(NULL) {}
+    ~TbTraceFile () { close(); }
+
+    bool open ( const std::string & name ) override {
+        if ( m_in_memory ) {
+            // Next segment, the oldest one is dropped
+            m_prev.swap(m_cur);
+            m_cur.clear();
+            return true;
+        }
+        return open_file(name);
+    }
+
+    void close () override {
+        if ( m_fp )
+            fclose(m_fp);
+        m_fp = NULL;
+    }
+
+    ssize_t write ( const char * bufp, ssize_t len ) override {
+        if ( m_in_memory ) {
+            m_cur.append(bufp, len);
+            return len;
+        }
+        return m_fp ? (ssize_t) fwrite(bufp, 1, len, m_fp) : -1;
+    }
+
+    // In memory: what was written by VerilatedVcdC::open() is the header
+    void take_header () {
+        m_header.swap(m_cur);
+        m_cur.clear();
+    }
+
+    // In memory: write the header and the segments out, then go straight to the file
+    bool commit ( const std::string & name ) {
+        if ( !open_file(name) )
+            return false;
+        fwrite(m_header.data(), 1, m_header.size(), m_fp);
+        fwrite(m_prev.data(), 1, m_prev.size(), m_fp);
+        fwrite(m_cur.data(), 1, m_cur.size(), m_fp);
+        std::string().swap(m_header);
+        std::string().swap(m_prev);
+        std::string().swap(m_cur);
+        m_in_memory = false;
+        return true;
+    }
+
+private:
+    bool open_file ( const std::string & name ) {
+        m_fp = fopen(name.c_str(), "w");
+        if ( m_fp == NULL ) {
+            fprintf(stderr, "[TRACE] Cannot open %s\n", name.c_str());
+            return false;
+        }
+        setvbuf(m_fp, NULL, _IOFBF, TB_TRACE_BUFFER_SIZE);
+        return true;
+    }
+
+    bool m_in_memory;
+    FILE * m_fp;
+    std::string m_header;
+    std::string m_prev;
+    std::string m_cur;
+};
+#endif
+
+template <class Model> class TbTrace {
+public:
+    // Parse the +trace plusargs, the trace is opened on the first dump() that needs it
+    TbTrace ( Model * model, int argc, char ** argv ) :
+        m_model(model), m_mode(TB_TRACE_OFF), m_start(0), m_end(UINT64_MAX),
+        m_pre(TB_TRACE_DEFAULT_PRE), m_post(TB_TRACE_DEFAULT_POST), m_depth(TB_TRACE_DEFAULT_DEPTH),
+        m_path(TB_TRACE_DEFAULT_FILE), m_trigger(-1), m_triggered(false), m_done(false),
+        m_segment_start(0), m_tfp(NULL), m_file(NULL)
+    {
+        for ( int i = 1; i < argc; i++ ) {
+            const char * arg = argv[i];
+            if      ( match(arg, "+trace=") )         m_mode = parse_mode(arg + 7);
+            else if ( match(arg, "+trace_window=") )  { m_mode = TB_TRACE_WINDOW; parse_window(arg + 14); }
+            else if ( match(arg, "+trace_trigger=") ) { m_mode = TB_TRACE_TRIGGER; m_trigger_name = arg + 15; }
+            else if ( match(arg, "+trace_pre=") )     m_pre   = strtoull(arg + 11, NULL, 0);
+            else if ( match(arg, "+trace_post=") )    m_post  = strtoull(arg + 12, NULL, 0);
+            else if ( match(arg, "+trace_depth=") )   m_depth = atoi(arg + 13);
+            else if ( match(arg, "+trace_file=") )    m_path  = arg + 12;
+        }
+        if ( m_pre == 0 )
+            m_pre = 1;
+    }
+
+    ~TbTrace () { close(); }
+
+    // Name a trigger condition, evaluated once per cycle in trigger mode
+    void add_trigger ( const char * name, std::function<bool()> condition ) {
+        m_triggers.push_back(std::make_pair(std::string(name), condition));
+    }
+
+    tb_trace_mode_t mode () const { return m_mode; }
+
+    // Call once per cycle, before its dumps: opens/closes the window, checks the trigger
+    void cycle ( uint64_t cycle ) {
+        if ( m_mode == TB_TRACE_OFF || m_done )
+            return;
+
+        switch ( m_mode ) {
+            case TB_TRACE_ON:
+                if ( !m_tfp )
+                    open(false);
+                break;
+            case TB_TRACE_WINDOW:
+                if ( !m_tfp && cycle >= m_start && cycle < m_end )
+                    open(false);
+                else if ( m_tfp && cycle >= m_end )
+                    finish();
+                break;
+            case TB_TRACE_TRIGGER:
+                trigger_cycle(cycle);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Dump the current values at time, if tracing
+    void dump ( uint64_t time ) {
+        if ( m_tfp )
+            m_tfp->dump(time);
+    }
+
+    void close () {
+        if ( m_tfp ) {
+            m_tfp->close();
+            delete m_tfp;
+            m_tfp = NULL;
+        }
+#ifndef TB_TRACE_FST
+        delete m_file;
+        m_file = NULL;
+#endif
+    }
+
+private:
+    static bool match ( const char * arg, const char * prefix ) {
+        return strncmp(arg, prefix, strlen(prefix)) == 0;
+    }
+
+    static tb_trace_mode_t parse_mode ( const char * str ) {
+        if ( strcmp(str, "on") == 0 )       return TB_TRACE_ON;
+        if ( strcmp(str, "window") == 0 )   return TB_TRACE_WINDOW;
+        if ( strcmp(str, "trigger") == 0 )  return TB_TRACE_TRIGGER;
+        if ( strcmp(str, "off") != 0 )
+            fprintf(stderr, "[TRACE] Unknown mode %s, tracing off\n", str);
+        return TB_TRACE_OFF;
+    }
+
+    void parse_window ( const char * str ) {
+        char * end;
+        m_start = strtoull(str, &end, 0);
+        m_end = ( *end == ':' ) ? strtoull(end + 1, NULL, 0) : UINT64_MAX;
+    }
+
+    void open ( bool in_memory ) {
+        Verilated::traceEverOn(true);
+#ifdef TB_TRACE_FST
+        (void) in_memory;
+        m_tfp = new TbTraceC;
+#else
+        m_file = new TbTraceFile(in_memory);
+        m_tfp = new TbTraceC(m_file);
+#endif
+        m_model->trace(m_tfp, m_depth);
+        m_tfp->open(m_path.c_str());
+#ifndef TB_TRACE_FST
+        if ( in_memory )
+            m_file->take_header();
+#endif
+    }
+
+    // Stop tracing for good
+    void finish () {
+        close();
+        m_done = true;
+    }
+
+    void trigger_cycle ( uint64_t cycle ) {
+        // Resolve the trigger name once
+        if ( m_trigger < 0 ) {
+            for ( size_t i = 0; i < m_triggers.size(); i++ )
+                if ( m_triggers[i].first == m_trigger_name )
+                    m_trigger = i;
+            if ( m_trigger < 0 ) {
+                fprintf(stderr, "[TRACE] Unknown trigger '%s', tracing off\n", m_trigger_name.c_str());
+                m_done = true;
+                return;
+            }
+#ifndef TB_TRACE_FST
+            // Start the pre-trigger history
+            open(true);
+            m_segment_start = cycle;
+#endif
+        }
+
+        if ( m_triggered ) {
+            if ( m_post != 0 && cycle >= m_trigger_cycle + m_post )
+                finish();
+            return;
+        }
+
+        if ( m_triggers[m_trigger].second() ) {
+            m_triggered = true;
+            m_trigger_cycle = cycle;
+            printf("[TRACE] Trigger %s at cycle %lu\n", m_trigger_name.c_str(), (unsigned long) cycle);
+#ifdef TB_TRACE_FST
+            open(false);
+#else
+            if ( !m_file->commit(m_path) )
+                finish();
+#endif
+            return;
+        }
+
+#ifndef TB_TRACE_FST
+        // Roll the segments over, the next one starts with a full dump
+        if ( cycle - m_segment_start >= m_pre ) {
+            m_tfp->openNext(false);
+            m_segment_start = cycle;
+        }
+#endif
+    }
+
+    Model * m_model;
+    tb_trace_mode_t m_mode;
+    uint64_t m_start;
+    uint64_t m_end;
+    uint64_t m_pre;
+    uint64_t m_post;
+    int m_depth;
+    std::string m_path;
+    std::string m_trigger_name;
+    std::vector<std::pair<std::string, std::function<bool()> > > m_triggers;
+    int m_trigger;
+    bool m_triggered;
+    bool m_done;
+    uint64_t m_trigger_cycle;
+    uint64_t m_segment_start;
+    TbTraceC * m_tfp;
+#ifndef TB_TRACE_FST
+    TbTraceFile * m_file;
+#else
+    void * m_file;
+#endif
+};
+
+#endif
@@ -5,12 +5,13 @@
 #######################
 
 # Unit-Under-Test top module sv file name 	
-PROJECT_NAME=test.prj
-if [ $1 != "" ]; then
-	PROJECT_NAME=$1.prj
+NAME=test
+if [ "$1" != "" ]; then
+	NAME=$1
 fi
+PROJECT_NAME=${NAME}.prj
 # Directory containing the RTL module
-RTL_DIR=src/rtl
+RTL_DIR=rtl
 # Directory containing the TestBench module
 TB_DIR=tb
 # Directory containing the simulation traces (waves)
@@ -25,7 +26,7 @@ VGEN_DIR=verilator
 #######################
 
 # TestBench name for UUT
-TB=${TB_DIR}/${PROJECT_NAME}_tb
+TB=${TB_DIR}/${NAME}_tb
 
 if [ -d "${PROJECT_NAME}" ]; then 
 	echo "[Error] Project directory ${PROJECT_NAME} already exists"
@@ -36,9 +37,11 @@ else
 	mkdir ${PROJECT_NAME}/${BIN_DIR}
 	mkdir ${PROJECT_NAME}/${VGEN_DIR}
 	mkdir ${PROJECT_NAME}/${WAVES_DIR}
-	# Rename tb module
-	mv ${PROJECT_NAME}/${TB_DIR}/template_tb.cpp ${PROJECT_NAME}/${TB_DIR}/${PROJECT_NAME}_tb.cpp
-	sed -i 's/template.prj/\${PROJECT_NAME}/g' ${PROJECT_NAME}/${TB_DIR}/${PROJECT_NAME}_tb.cpp
+	# Rename RTL and tb modules, the common Makefile derives them from the directory name
+	mv ${PROJECT_NAME}/${RTL_DIR}/template.sv ${PROJECT_NAME}/${RTL_DIR}/${NAME}.sv
+	sed -i "s/module template/module ${NAME}/" ${PROJECT_NAME}/${RTL_DIR}/${NAME}.sv
+	mv ${PROJECT_NAME}/${TB_DIR}/template_tb.cpp ${PROJECT_NAME}/${TB}.cpp
+	sed -i "s/Vtemplate/V${NAME}/g" ${PROJECT_NAME}/${TB}.cpp
 fi
 
 
@@ -0,0 +1,306 @@
+#!/bin/python3.10
+# Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+# Description:
+#   Regression runner of the unit simulations (*.prj, common/Makefile).
+#   - Each model (project and build vars) is built once, and cached by the hash of its build inputs:
+#     Verilator and compiler versions, Verilator command line, compile flags (make model_info) and the
+#     content of all the files they reference (sources, -f lists, -y/-I directories, testbench).
+#     A cache hit skips verilate and compile entirely. The projects build in parallel, the models of
+#     a project one after the other (they share the project directory).
+#   - The tests and their seeds run in parallel, up to the job limit, each in its project directory,
+#     with the trace off and the output in <out dir>/<project>/<test>_s<seed>.log.
+#   - A test passes if the testbench exits with 0. The summary reports pass/fail, wall time and
+#     simulated cycles/s ("Simulated N cycles" in the testbench output) of each run, also in <out dir>/summary.csv.
+# Args:
+#   see --help, e.g. ./regress.py -j 8 -k virtual_uart
+# Exit code: 0 if all the runs pass, 1 otherwise.
+
+####################
+# Import libraries #
+####################
+# Parse args
+import argparse
+# Paths, processes
+import os
+import sys
+import shlex
+import shutil
+import subprocess
+# Hashes
+import hashlib
+# Parse the testbench output
+import re
+# Parallel jobs
+import time
+import concurrent.futures
+
+##############
+# Parse args #
+##############
+
+SIM_DIR = os.path.dirname(os.path.abspath(__file__))
+
+parser = argparse.ArgumentParser(description="Regression runner of the unit simulations")
+parser.add_argument("-l", "--list",    default=os.path.join(SIM_DIR, "regress.list"), help="regression list, default regress.list")
+parser.add_argument("-j", "--jobs",    type=int, default=os.cpu_count(), help="parallel jobs, default all the host CPUs")
+parser.add_argument("-k", "--keep",    default="", help="only the tests whose <project>/<test> contains this string")
+parser.add_argument("-t", "--timeout", type=int, default=3600, help="timeout of each run in seconds, default 3600")
+parser.add_argument("-c", "--cache",   default=os.path.join(SIM_DIR, ".model_cache"), help="model cache directory, default .model_cache")
+parser.add_argument("-o", "--out",     default=os.path.join(SIM_DIR, "regress_out"), help="output directory, default regress_out")
+parser.add_argument("-r", "--rebuild", action="store_true", help="ignore the cache, rebuild and store all the models")
+args = parser.parse_args()
+
+if args.jobs < 1:
+	print("ERROR: at least one job")
+	sys.exit(1)
+
+##############
+# Read tests #
+##############
+
+class Test:
+	def __init__ ( self, project, name, seeds, build_vars, run_args ):
+		self.project    = project
+		self.name       = name
+		self.seeds      = seeds
+		self.build_vars = build_vars
+		self.run_args   = run_args
+
+tests = []
+with open(args.list, "r") as fd:
+	for lineno, line in enumerate(fd, 1):
+		fields = shlex.split(line, comments=True)
+		if len(fields) == 0:
+			continue
+		if len(fields) < 4 or not fields[2].isdigit():
+			print("ERROR: " + args.list + ":" + str(lineno) + ": expected <project> <test> <seeds> <build vars> [run args...]")
+			sys.exit(1)
+		build_vars = () if fields[3] == "-" else tuple(sorted(fields[3].split(",")))
+		if any(var.startswith("SIM_PROFILE=pgo") for var in build_vars):
+			print("ERROR: " + args.list + ":" + str(lineno) + ": PGO models depend on their training run, they are not cached")
+			sys.exit(1)
+		test = Test(fields[0], fields[1], int(fields[2]), build_vars, fields[4:])
+		if args.keep in test.project + "/" + test.name:
+			tests.append(test)
+
+if len(tests) == 0:
+	print("ERROR: no test selected")
+	sys.exit(1)
+
+#################
+# Model hashing #
+#################
+
+VERILOG_EXT = (".sv", ".svh", ".v", ".vh")
+HEADER_EXT  = (".h", ".hpp")
+
+def make_cmd ( project, build_vars, targets ):
+	return ["make", "-s", "-C", os.path.join(SIM_DIR, project)] + targets + list(build_vars)
+
+def dir_files ( path, extensions ):
+	if not os.path.isdir(path):
+		return []
+	return [os.path.join(path, name) for name in os.listdir(path) if name.endswith(extensions)]
+
+# Files referenced by the Verilator command line, relative to the project directory
+def verilate_inputs ( project_dir, verilate_cmd ):
+	# Split the quoted -CFLAGS/-LDFLAGS too
+	tokens = [token for word in shlex.split(verilate_cmd) for token in word.split()]
+	files = []
+	lists = []
+	path = lambda name: os.path.normpath(os.path.join(project_dir, name))
+	for i, token in enumerate(tokens):
+		previous = tokens[i-1] if i > 0 else ""
+		if previous == "-f":
+			lists.append(path(token))
+		elif previous == "-y":
+			files += dir_files(path(token), VERILOG_EXT)
+		elif token.startswith("-I"):
+			files += dir_files(path(token[2:]), VERILOG_EXT + HEADER_EXT)
+		elif token.startswith("+incdir+"):
+			files += dir_files(path(token[8:]), VERILOG_EXT)
+		elif not token.startswith(("-", "+")) and token.endswith(VERILOG_EXT + (".cpp", ".c")):
+			files.append(path(token))
+	# File lists, one file per line
+	for file_list in lists:
+		files.append(file_list)
+		if os.path.isfile(file_list):
+			with open(file_list, "r") as fd:
+				files += [path(name) for name in fd.read().split() if not name.startswith(("-", "+"))]
+	return sorted(set(files))
+
+def hash_file ( file_name ):
+	sha = hashlib.sha256()
+	if os.path.isfile(file_name):
+		with open(file_name, "rb") as fd:
+			sha.update(fd.read())
+	else:
+		sha.update(b"missing")
+	return sha.hexdigest()
+
+# Return (key, model info) or (None, error output)
+def model_key ( project, build_vars ):
+	result = subprocess.run(make_cmd(project, build_vars, ["model_info"]), capture_output=True, text=True)
+	if result.returncode != 0:
+		return None, result.stdout + result.stderr
+	info = dict(line.split(" ", 1) for line in result.stdout.splitlines() if " " in line)
+	if "VERILATE" not in info:
+		return None, result.stdout + result.stderr
+
+	project_dir = os.path.join(SIM_DIR, project)
+	sha = hashlib.sha256()
+	sha.update(result.stdout.encode())
+	manifest = []
+	for file_name in verilate_inputs(project_dir, info["VERILATE"]):
+		file_hash = hash_file(file_name)
+		manifest.append(file_hash + " " + file_name)
+		sha.update((file_name + file_hash).encode())
+	info["MANIFEST"] = "\n".join(manifest) + "\n"
+	return sha.hexdigest()[:32], info
+
+###############
+# Model build #
+###############
+
+class Model:
+	def __init__ ( self, project, build_vars ):
+		self.project    = project
+		self.build_vars = build_vars
+		self.binary     = None
+		self.cached     = False
+		self.seconds    = 0.0
+		self.error      = ""
+
+def build_models ( models, build_jobs, log_dir ):
+	for model in models:
+		start = time.time()
+		key, info = model_key(model.project, model.build_vars)
+		if key is None:
+			model.error = info
+			continue
+
+		entry = os.path.join(args.cache, model.project, key)
+		binary = os.path.join(entry, os.path.basename(info["BINARY"]))
+		if os.path.isfile(binary) and not args.rebuild:
+			model.binary = binary
+			model.cached = True
+			model.seconds = time.time() - start
+			continue
+
+		# Incremental build in the project, then store the model
+		log_name = os.path.join(log_dir, "build" + "".join("_" + var for var in model.build_vars) + ".log")
+		with open(log_name, "w") as log:
+			result = subprocess.run(make_cmd(model.project, model.build_vars, ["compile", "BUILD_JOBS=" + str(build_jobs)]),
+									stdout=log, stderr=subprocess.STDOUT)
+		if result.returncode != 0:
+			model.error = "build failed, see " + log_name
+			continue
+		built = os.path.join(SIM_DIR, model.project, info["MODEL_DIR"], os.path.basename(binary))
+		tmp_entry = entry + ".tmp" + str(os.getpid())
+		os.makedirs(tmp_entry, exist_ok=True)
+		shutil.copy2(built, os.path.join(tmp_entry, os.path.basename(binary)))
+		with open(os.path.join(tmp_entry, "model_info.txt"), "w") as fd:
+			fd.write("".join(name + " " + value + "\n" for name, value in info.items() if name != "MANIFEST"))
+			fd.write(info["MANIFEST"])
+		shutil.rmtree(entry, ignore_errors=True)
+		os.rename(tmp_entry, entry)
+		model.binary = binary
+		model.seconds = time.time() - start
+
+models = {}
+for test in tests:
+	models.setdefault((test.project, test.build_vars), Model(test.project, test.build_vars))
+
+projects = sorted(set(model.project for model in models.values()))
+build_jobs = max(1, args.jobs // len(projects))
+print("Building " + str(len(models)) + " models of " + str(len(projects)) + " projects, " + str(build_jobs) + " compile jobs each")
+with concurrent.futures.ThreadPoolExecutor(max_workers=min(args.jobs, len(projects))) as pool:
+	futures = []
+	for project in projects:
+		log_dir = os.path.join(args.out, project)
+		os.makedirs(log_dir, exist_ok=True)
+		futures.append(pool.submit(build_models, [model for model in models.values() if model.project == project], build_jobs, log_dir))
+	for future in futures:
+		future.result()
+
+for model in models.values():
+	status = "cached" if model.cached else "built" if model.binary else "FAILED"
+	print("  {:<20s} {:<24s} {:<7s} {:8.1f} s".format(model.project, ",".join(model.build_vars) or "-", status, model.seconds))
+	if model.error:
+		print("    " + model.error.strip().replace("\n", "\n    "))
+
+#############
+# Run tests #
+#############
+
+class Run:
+	def __init__ ( self, test, seed ):
+		self.test    = test
+		self.seed    = seed
+		self.status  = "FAIL"
+		self.seconds = 0.0
+		self.cycles  = None
+		self.log     = os.path.join(args.out, test.project, test.name + "_s" + str(seed) + ".log")
+
+def run_test ( run ):
+	model = models[(run.test.project, run.test.build_vars)]
+	if model.binary is None:
+		run.status = "NOBUILD"
+		return run
+
+	cmd = [model.binary]
+	if not any(arg.startswith("+trace") for arg in run.test.run_args):
+		cmd.append("+trace=off")
+	if "X_INIT=1" in run.test.build_vars:
+		cmd.append("+verilator+rand+reset+2")
+	cmd += ["+verilator+seed+" + str(run.seed)] + run.test.run_args
+
+	start = time.time()
+	with open(run.log, "w") as log:
+		log.write(" ".join(cmd) + "\n")
+		log.flush()
+		try:
+			result = subprocess.run(cmd, cwd=os.path.join(SIM_DIR, run.test.project), stdout=log, stderr=subprocess.STDOUT, timeout=args.timeout)
+			run.status = "PASS" if result.returncode == 0 else "FAIL"
+		except subprocess.TimeoutExpired:
+			run.status = "TIMEOUT"
+	run.seconds = time.time() - start
+
+	with open(run.log, "r", errors="ignore") as log:
+		cycles = re.findall(r"Simulated (\d+) cycles", log.read())
+	if cycles:
+		run.cycles = sum(int(count) for count in cycles)
+	return run
+
+runs = [Run(test, seed) for test in tests for seed in range(1, test.seeds + 1)]
+print("Running " + str(len(runs)) + " runs of " + str(len(tests)) + " tests, " + str(args.jobs) + " jobs")
+start = time.time()
+with concurrent.futures.ThreadPoolExecutor(max_workers=args.jobs) as pool:
+	for run in pool.map(run_test, runs):
+		print("  {:<8s} {}/{} seed {}".format(run.status, run.test.project, run.test.name, run.seed), flush=True)
+wall = time.time() - start
+
+###########
+# Summary #
+###########
+
+header = "{:<20s} {:<20s} {:>5s} {:<8s} {:>10s} {:>14s}".format("project", "test", "seed", "status", "wall [s]", "cycles/s")
+print("")
+print(header)
+print("-" * len(header))
+with open(os.path.join(args.out, "summary.csv"), "w") as csv:
+	csv.write("project,test,seed,status,wall_s,cycles,cycles_per_s,log\n")
+	for run in runs:
+		rate = run.cycles / run.seconds if run.cycles and run.seconds > 0 else None
+		print("{:<20s} {:<20s} {:>5d} {:<8s} {:>10.2f} {:>14s}".format(run.test.project, run.test.name, run.seed, run.status,
+				run.seconds, "{:.0f}".format(rate) if rate else "-"))
+		csv.write(",".join([run.test.project, run.test.name, str(run.seed), run.status, "{:.3f}".format(run.seconds),
+				str(run.cycles or ""), "{:.0f}".format(rate) if rate else "", run.log]) + "\n")
+
+passed = sum(run.status == "PASS" for run in runs)
+print("-" * len(header))
+print("{} runs: {} passed, {} failed, {:.1f} s wall time ({:.1f} s of runs on {} jobs)".format(len(runs), passed, len(runs) - passed,
+		wall, sum(run.seconds for run in runs), args.jobs))
+print("Summary in " + os.path.join(args.out, "summary.csv"))
+
+sys.exit(0 if passed == len(runs) else 1)
@@ -1,60 +1,59 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include "Vdummy.h"
-#include "verilated_vcd_c.h"
+#include <string.h>
+#include <chrono>
+#include "Vtemplate.h"
 #include "verilated.h"
+#include "tb_trace.h"
+#include "tb_checkpoint.h"
+#include "tb_clock.h"
 
-#define CLK_NS 20
+#define CLK_MHZ 50
 #define CYCLES 1000
 
-void tick(int tickcount, Vdummy *tb, VerilatedVcdC *tfp);
-void trace_init(Vdummy *tb, VerilatedVcdC * tfp);
-
 int main(int argc, char **argv){
-	
-	Vdummy * tb = new Vdummy;
-	VerilatedVcdC * tfp = new VerilatedVcdC;
 
-	unsigned tickcount = 0;
-	trace_init(tb,tfp);
+	Verilated::commandArgs(argc, argv);
+	Vtemplate * tb = new Vtemplate;
 
-	printf("Welcome to Verilator Simulation\n\n");
+	// Tracing is selected with +trace plusargs, see tb_trace.h
+	TbTrace<Vtemplate> * trace = new TbTrace<Vtemplate>(tb, argc, argv);
+	trace->add_trigger("bit_o", [tb]() { return tb->bit_o != 0; });
 
-	for(int i = 0; i < CYCLES; i++){
+	// Clocks from the SoC config with +clock_config, see tb_clock.h
+	TbClockConfig clock_config(argc, argv);
+	TbScheduler<Vtemplate> * scheduler = new TbScheduler<Vtemplate>(tb, trace);
+	TbClock * clk = scheduler->add_clock("MAIN", &tb->clk_i, clock_config.mhz("MAIN", CLK_MHZ));
+	TbReset reset(clk, &tb->rstn_i, true, 1);
 
-		(i == 0) ? tb->rstn_i = 0 : tb->rstn_i = 1;
+	// Checkpoints are selected with +checkpoint plusargs, see tb_checkpoint.h
+	TbCheckpoint<Vtemplate> * checkpoint = new TbCheckpoint<Vtemplate>(tb, argc, argv);
+	scheduler->add_state(checkpoint);
+	uint64_t first_cycle = checkpoint->restore();
 
-		tick(++tickcount,tb,tfp);
+	// Simulated cycles, +cycles=N
+	uint64_t cycles = CYCLES;
+	for(int i = 1; i < argc; i++)
+		if(strncmp(argv[i], "+cycles=", 8) == 0)
+			cycles = strtoull(argv[i] + 8, NULL, 0);
 
-	}
+	printf("Welcome to Verilator Simulation\n\n");
 
-	delete tb;
-	delete tfp;
+	auto start = std::chrono::steady_clock::now();
+	for(uint64_t i = first_cycle; i < cycles; i++){
 
-}
+		checkpoint->cycle(i);
+		clk->run_cycles(1);
 
-void tick(int tickcount, Vdummy *tb, VerilatedVcdC *tfp){
-	tb->eval();
-	if(tfp) //dump 2ns before the tick
-		tfp->dump(tickcount*CLK_NS - 2);
-	tb->clk_i = 1;
-	tb->eval();
-	if(tfp) //Tick every CLK_NS
-		tfp->dump(tickcount*CLK_NS);
-	tb->clk_i = 0;
-	tb->eval();
-	if(tfp){ //Trailing edge dump
-		tfp->dump(tickcount*CLK_NS+5);
-		tfp->flush();
 	}
-}
-
-void trace_init(Vdummy *tb, VerilatedVcdC * tfp){
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("Simulated %lu cycles in %.3f s (%.0f cycles/s)\n", (unsigned long) ( cycles - first_cycle ), seconds, ( cycles - first_cycle ) / seconds);
+	scheduler->report();
+
+	delete checkpoint;
+	delete scheduler;
+	delete trace;
+	tb->final();
+	delete tb;
 
-	Verilated::traceEverOn(true);
-	
-	tb->trace(tfp,99);
-	tfp->open("waves/trace.vcd");
 }
-
-
@@ -0,0 +1,125 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural core of the AXI GPIO IP (PG144) stand-ins of the Verilator model of the SoC.
+//              Single channel, the inputs are sampled once per cycle.
+//              Registers:
+//                  000h - GPIO_DATA    R: inputs, W: outputs
+//                  004h - GPIO_TRI     tri-state control, read-back only
+//                  11Ch - GIER         [31] global interrupt enable
+//                  120h - IP ISR       [0] input changed, toggle on write
+//                  128h - IP IER       [0] channel interrupt enable
+
+module sim_axi_gpio # (
+    parameter int unsigned GPIO_WIDTH = 16
+) (
+    input  logic                        s_axi_aclk,
+    input  logic                        s_axi_aresetn,
+    input  logic [8 : 0]                s_axi_awaddr,
+    input  logic                        s_axi_awvalid,
+    output logic                        s_axi_awready,
+    input  logic [31 : 0]               s_axi_wdata,
+    input  logic [3 : 0]                s_axi_wstrb,
+    input  logic                        s_axi_wvalid,
+    output logic                        s_axi_wready,
+    output logic [1 : 0]                s_axi_bresp,
+    output logic                        s_axi_bvalid,
+    input  logic                        s_axi_bready,
+    input  logic [8 : 0]                s_axi_araddr,
+    input  logic                        s_axi_arvalid,
+    output logic                        s_axi_arready,
+    output logic [31 : 0]               s_axi_rdata,
+    output logic [1 : 0]                s_axi_rresp,
+    output logic                        s_axi_rvalid,
+    input  logic                        s_axi_rready,
+    input  logic [GPIO_WIDTH-1 : 0]     gpio_io_i,
+    output logic [GPIO_WIDTH-1 : 0]     gpio_io_o,
+    output logic                        ip2intc_irpt
+);
+
+    logic           wr;
+    logic [8 : 0]   wr_addr;
+    logic [31 : 0]  wr_data;
+    logic           rd;
+    logic [8 : 0]   rd_addr;
+    logic [31 : 0]  rd_data;
+
+    logic [GPIO_WIDTH-1 : 0]    gpio_in_q;
+    logic [GPIO_WIDTH-1 : 0]    gpio_tri;
+    logic                       gier;
+    logic                       isr;
+    logic                       ier;
+
+    sim_axilite_regs # (
+        .ADDR_WIDTH ( 9  ),
+        .DATA_WIDTH ( 32 )
+    ) regs_u (
+        .clk_i      ( s_axi_aclk    ),
+        .rst_ni     ( s_axi_aresetn ),
+        .awaddr_i   ( s_axi_awaddr  ),
+        .awvalid_i  ( s_axi_awvalid ),
+        .awready_o  ( s_axi_awready ),
+        .wdata_i    ( s_axi_wdata   ),
+        .wstrb_i    ( s_axi_wstrb   ),
+        .wvalid_i   ( s_axi_wvalid  ),
+        .wready_o   ( s_axi_wready  ),
+        .bresp_o    ( s_axi_bresp   ),
+        .bvalid_o   ( s_axi_bvalid  ),
+        .bready_i   ( s_axi_bready  ),
+        .araddr_i   ( s_axi_araddr  ),
+        .arvalid_i  ( s_axi_arvalid ),
+        .arready_o  ( s_axi_arready ),
+        .rdata_o    ( s_axi_rdata   ),
+        .rresp_o    ( s_axi_rresp   ),
+        .rvalid_o   ( s_axi_rvalid  ),
+        .rready_i   ( s_axi_rready  ),
+        .wr_o       ( wr            ),
+        .wr_addr_o  ( wr_addr       ),
+        .wr_data_o  ( wr_data       ),
+        .wr_strb_o  (               ),
+        .rd_o       ( rd            ),
+        .rd_addr_o  ( rd_addr       ),
+        .rd_data_i  ( rd_data       )
+    );
+
+    assign ip2intc_irpt = gier && isr && ier;
+
+    always_comb begin
+        case ( rd_addr )
+            9'h000:  rd_data = 32'(gpio_in_q);
+            9'h004:  rd_data = 32'(gpio_tri);
+            9'h11C:  rd_data = {gier, 31'b0};
+            9'h120:  rd_data = {31'b0, isr};
+            9'h128:  rd_data = {31'b0, ier};
+            default: rd_data = '0;
+        endcase
+    end
+
+    always_ff @( posedge s_axi_aclk or negedge s_axi_aresetn ) begin
+        if ( !s_axi_aresetn ) begin
+            gpio_in_q <= '0;
+            gpio_io_o <= '0;
+            gpio_tri  <= '1;
+            gier      <= 1'b0;
+            isr       <= 1'b0;
+            ier       <= 1'b0;
+        end
+        else begin
+            gpio_in_q <= gpio_io_i;
+
+            // Any input change raises the channel interrupt status
+            if ( gpio_in_q != gpio_io_i )
+                isr <= 1'b1;
+
+            if ( wr ) begin
+                case ( wr_addr )
+                    9'h000: gpio_io_o <= wr_data[GPIO_WIDTH-1:0];
+                    9'h004: gpio_tri  <= wr_data[GPIO_WIDTH-1:0];
+                    9'h11C: gier      <= wr_data[31];
+                    9'h120: isr       <= isr ^ wr_data[0];
+                    9'h128: ier       <= wr_data[0];
+                    default: ;
+                endcase
+            end
+        end
+    end
+
+endmodule : sim_axi_gpio
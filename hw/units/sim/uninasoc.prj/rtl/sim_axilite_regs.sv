@@ -0,0 +1,102 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: AXI-lite slave front-end of the behavioural peripherals of the SoC model.
+//              AW and W are accepted independently, the write is issued once both are in (wr_o),
+//              the read data is sampled from the register block on the AR handshake (rd_o).
+//              The register block decodes the addresses and implements the side effects.
+
+module sim_axilite_regs # (
+    parameter int unsigned ADDR_WIDTH = 9,
+    parameter int unsigned DATA_WIDTH = 32
+) (
+    input  logic                        clk_i,
+    input  logic                        rst_ni,
+
+    // AXI-lite slave
+    input  logic [ADDR_WIDTH-1 : 0]     awaddr_i,
+    input  logic                        awvalid_i,
+    output logic                        awready_o,
+    input  logic [DATA_WIDTH-1 : 0]     wdata_i,
+    input  logic [DATA_WIDTH/8-1 : 0]   wstrb_i,
+    input  logic                        wvalid_i,
+    output logic                        wready_o,
+    output logic [1 : 0]                bresp_o,
+    output logic                        bvalid_o,
+    input  logic                        bready_i,
+    input  logic [ADDR_WIDTH-1 : 0]     araddr_i,
+    input  logic                        arvalid_i,
+    output logic                        arready_o,
+    output logic [DATA_WIDTH-1 : 0]     rdata_o,
+    output logic [1 : 0]                rresp_o,
+    output logic                        rvalid_o,
+    input  logic                        rready_i,
+
+    // Register block
+    output logic                        wr_o,
+    output logic [ADDR_WIDTH-1 : 0]     wr_addr_o,
+    output logic [DATA_WIDTH-1 : 0]     wr_data_o,
+    output logic [DATA_WIDTH/8-1 : 0]   wr_strb_o,
+    output logic                        rd_o,
+    output logic [ADDR_WIDTH-1 : 0]     rd_addr_o,
+    input  logic [DATA_WIDTH-1 : 0]     rd_data_i
+);
+
+    logic aw_full;
+    logic w_full;
+
+    assign awready_o = !aw_full;
+    assign wready_o  = !w_full;
+    assign bresp_o   = 2'b00;
+    assign rresp_o   = 2'b00;
+    assign wr_o      = aw_full && w_full && !bvalid_o;
+
+    // Write: hold address and data until both are in and the previous response is gone
+    always_ff @( posedge clk_i or negedge rst_ni ) begin
+        if ( !rst_ni ) begin
+            aw_full   <= 1'b0;
+            w_full    <= 1'b0;
+            bvalid_o  <= 1'b0;
+            wr_addr_o <= '0;
+            wr_data_o <= '0;
+            wr_strb_o <= '0;
+        end
+        else begin
+            if ( awvalid_i && awready_o ) begin
+                aw_full   <= 1'b1;
+                wr_addr_o <= awaddr_i;
+            end
+            if ( wvalid_i && wready_o ) begin
+                w_full    <= 1'b1;
+                wr_data_o <= wdata_i;
+                wr_strb_o <= wstrb_i;
+            end
+            if ( wr_o ) begin
+                aw_full  <= 1'b0;
+                w_full   <= 1'b0;
+                bvalid_o <= 1'b1;
+            end
+            else if ( bvalid_o && bready_i ) begin
+                bvalid_o <= 1'b0;
+            end
+        end
+    end
+
+    // Read: one outstanding read, the data is sampled on the AR handshake
+    assign arready_o = !rvalid_o;
+    assign rd_o      = arvalid_i && arready_o;
+    assign rd_addr_o = araddr_i;
+
+    always_ff @( posedge clk_i or negedge rst_ni ) begin
+        if ( !rst_ni ) begin
+            rvalid_o <= 1'b0;
+            rdata_o  <= '0;
+        end
+        else if ( rd_o ) begin
+            rvalid_o <= 1'b1;
+            rdata_o  <= rd_data_i;
+        end
+        else if ( rvalid_o && rready_i ) begin
+            rvalid_o <= 1'b0;
+        end
+    end
+
+endmodule : sim_axilite_regs
@@ -0,0 +1,177 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural stand-in of the AXI4 to AXI-lite protocol converter IP for the Verilator model of the SoC.
+//              One write and one read burst in flight, split into single-beat AXI-lite transactions.
+//              INCR and FIXED bursts are supported (WRAP is treated as INCR), the write response
+//              is the worst of the beats.
+
+import uninasoc_pkg::*;
+
+`include "uninasoc_axi.svh"
+
+module xlnx_axi4_to_axilite_d32_converter (
+    input  logic                            aclk,
+    input  logic                            aresetn,
+
+    // AXI4 slave port
+    `DEFINE_AXI_SLAVE_PORTS(s, 32, MBUS_ADDR_WIDTH, MBUS_ID_WIDTH),
+
+    // AXI-lite master port
+    output logic [MBUS_ADDR_WIDTH-1 : 0]    m_axi_awaddr,
+    output logic [AXI_PROT_WIDTH-1 : 0]     m_axi_awprot,
+    output logic                            m_axi_awvalid,
+    input  logic                            m_axi_awready,
+    output logic [31 : 0]                   m_axi_wdata,
+    output logic [3 : 0]                    m_axi_wstrb,
+    output logic                            m_axi_wvalid,
+    input  logic                            m_axi_wready,
+    input  logic [AXI_RESP_WIDTH-1 : 0]     m_axi_bresp,
+    input  logic                            m_axi_bvalid,
+    output logic                            m_axi_bready,
+    output logic [MBUS_ADDR_WIDTH-1 : 0]    m_axi_araddr,
+    output logic [AXI_PROT_WIDTH-1 : 0]     m_axi_arprot,
+    output logic                            m_axi_arvalid,
+    input  logic                            m_axi_arready,
+    input  logic [31 : 0]                   m_axi_rdata,
+    input  logic [AXI_RESP_WIDTH-1 : 0]     m_axi_rresp,
+    input  logic                            m_axi_rvalid,
+    output logic                            m_axi_rready
+);
+
+    localparam logic [1:0] BURST_FIXED = 2'b00;
+
+    typedef enum logic [2:0] { IDLE, ADDR, DATA, RESP, LAST } phase_t;
+
+    // Write burst
+    phase_t                         w_phase;
+    logic [MBUS_ID_WIDTH-1 : 0]     w_id;
+    logic [MBUS_ADDR_WIDTH-1 : 0]   w_addr;
+    logic [AXI_PROT_WIDTH-1 : 0]    w_prot;
+    logic [7 : 0]                   w_beats;
+    logic [2 : 0]                   w_size;
+    logic [1 : 0]                   w_burst;
+    logic [AXI_RESP_WIDTH-1 : 0]    w_resp;
+
+    // Read burst
+    phase_t                         r_phase;
+    logic [MBUS_ID_WIDTH-1 : 0]     r_id;
+    logic [MBUS_ADDR_WIDTH-1 : 0]   r_addr;
+    logic [AXI_PROT_WIDTH-1 : 0]    r_prot;
+    logic [7 : 0]                   r_beats;
+    logic [2 : 0]                   r_size;
+    logic [1 : 0]                   r_burst;
+
+    ///////////
+    // Write //
+    ///////////
+
+    assign s_axi_awready = ( w_phase == IDLE );
+    assign m_axi_awvalid = ( w_phase == ADDR );
+    assign m_axi_awaddr  = w_addr;
+    assign m_axi_awprot  = w_prot;
+    assign m_axi_wvalid  = ( w_phase == DATA ) && s_axi_wvalid;
+    assign m_axi_wdata   = s_axi_wdata;
+    assign m_axi_wstrb   = s_axi_wstrb;
+    assign s_axi_wready  = ( w_phase == DATA ) && m_axi_wready;
+    assign m_axi_bready  = ( w_phase == RESP );
+    assign s_axi_bvalid  = ( w_phase == LAST );
+    assign s_axi_bid     = w_id;
+    assign s_axi_bresp   = w_resp;
+
+    always_ff @( posedge aclk or negedge aresetn ) begin
+        if ( !aresetn ) begin
+            w_phase <= IDLE;
+            w_id    <= '0;
+            w_addr  <= '0;
+            w_prot  <= '0;
+            w_beats <= '0;
+            w_size  <= '0;
+            w_burst <= '0;
+            w_resp  <= '0;
+        end
+        else begin
+            case ( w_phase )
+                IDLE: if ( s_axi_awvalid ) begin
+                    w_phase <= ADDR;
+                    w_id    <= s_axi_awid;
+                    w_addr  <= s_axi_awaddr;
+                    w_prot  <= s_axi_awprot;
+                    w_beats <= s_axi_awlen;
+                    w_size  <= s_axi_awsize;
+                    w_burst <= s_axi_awburst;
+                    w_resp  <= '0;
+                end
+                ADDR: if ( m_axi_awready ) w_phase <= DATA;
+                DATA: if ( s_axi_wvalid && m_axi_wready ) w_phase <= RESP;
+                RESP: if ( m_axi_bvalid ) begin
+                    if ( m_axi_bresp > w_resp )
+                        w_resp <= m_axi_bresp;
+                    if ( w_beats == 0 ) begin
+                        w_phase <= LAST;
+                    end
+                    else begin
+                        w_phase <= ADDR;
+                        w_beats <= w_beats - 1;
+                        if ( w_burst != BURST_FIXED )
+                            w_addr <= w_addr + ( 1 << w_size );
+                    end
+                end
+                LAST: if ( s_axi_bready ) w_phase <= IDLE;
+                default: w_phase <= IDLE;
+            endcase
+        end
+    end
+
+    //////////
+    // Read //
+    //////////
+
+    assign s_axi_arready = ( r_phase == IDLE );
+    assign m_axi_arvalid = ( r_phase == ADDR );
+    assign m_axi_araddr  = r_addr;
+    assign m_axi_arprot  = r_prot;
+    assign s_axi_rvalid  = ( r_phase == DATA ) && m_axi_rvalid;
+    assign s_axi_rid     = r_id;
+    assign s_axi_rdata   = m_axi_rdata;
+    assign s_axi_rresp   = m_axi_rresp;
+    assign s_axi_rlast   = ( r_beats == 0 );
+    assign m_axi_rready  = ( r_phase == DATA ) && s_axi_rready;
+
+    always_ff @( posedge aclk or negedge aresetn ) begin
+        if ( !aresetn ) begin
+            r_phase <= IDLE;
+            r_id    <= '0;
+            r_addr  <= '0;
+            r_prot  <= '0;
+            r_beats <= '0;
+            r_size  <= '0;
+            r_burst <= '0;
+        end
+        else begin
+            case ( r_phase )
+                IDLE: if ( s_axi_arvalid ) begin
+                    r_phase <= ADDR;
+                    r_id    <= s_axi_arid;
+                    r_addr  <= s_axi_araddr;
+                    r_prot  <= s_axi_arprot;
+                    r_beats <= s_axi_arlen;
+                    r_size  <= s_axi_arsize;
+                    r_burst <= s_axi_arburst;
+                end
+                ADDR: if ( m_axi_arready ) r_phase <= DATA;
+                DATA: if ( m_axi_rvalid && s_axi_rready ) begin
+                    if ( r_beats == 0 ) begin
+                        r_phase <= IDLE;
+                    end
+                    else begin
+                        r_phase <= ADDR;
+                        r_beats <= r_beats - 1;
+                        if ( r_burst != BURST_FIXED )
+                            r_addr <= r_addr + ( 1 << r_size );
+                    end
+                end
+                default: r_phase <= IDLE;
+            endcase
+        end
+    end
+
+endmodule : xlnx_axi4_to_axilite_d32_converter
@@ -0,0 +1,20 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Stand-in of the 32-bit AXI clock converter IP for the Verilator model of the SoC.
+//              All the clock domains run on the same clock in the model (see xlnx_clk_wiz.sv), the converter is a pass-through.
+
+import uninasoc_pkg::*;
+
+`include "uninasoc_axi.svh"
+
+module xlnx_axi_d32_clock_converter (
+    input  logic s_axi_aclk,
+    input  logic s_axi_aresetn,
+    input  logic m_axi_aclk,
+    input  logic m_axi_aresetn,
+    `DEFINE_AXI_SLAVE_PORTS(s, 32, MBUS_ADDR_WIDTH, MBUS_ID_WIDTH),
+    `DEFINE_AXI_MASTER_PORTS(m, 32, MBUS_ADDR_WIDTH, MBUS_ID_WIDTH)
+);
+
+    `ASSIGN_AXI_BUS(m, s)
+
+endmodule : xlnx_axi_d32_clock_converter
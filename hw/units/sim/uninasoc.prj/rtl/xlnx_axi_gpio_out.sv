@@ -0,0 +1,56 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural stand-in of the AXI GPIO IP, output, for the Verilator model of the SoC (see sim_axi_gpio.sv)
+
+import uninasoc_pkg::*;
+
+module xlnx_axi_gpio_out (
+    input  logic                         s_axi_aclk,
+    input  logic                         s_axi_aresetn,
+    input  logic [8 : 0]                 s_axi_awaddr,
+    input  logic                         s_axi_awvalid,
+    output logic                         s_axi_awready,
+    input  logic [31 : 0]                s_axi_wdata,
+    input  logic [3 : 0]                 s_axi_wstrb,
+    input  logic                         s_axi_wvalid,
+    output logic                         s_axi_wready,
+    output logic [1 : 0]                 s_axi_bresp,
+    output logic                         s_axi_bvalid,
+    input  logic                         s_axi_bready,
+    input  logic [8 : 0]                 s_axi_araddr,
+    input  logic                         s_axi_arvalid,
+    output logic                         s_axi_arready,
+    output logic [31 : 0]                s_axi_rdata,
+    output logic [1 : 0]                 s_axi_rresp,
+    output logic                         s_axi_rvalid,
+    input  logic                         s_axi_rready,
+    output logic [GPIO_OUT_WIDTH-1 : 0]  gpio_io_o
+);
+
+    sim_axi_gpio # (
+        .GPIO_WIDTH ( GPIO_OUT_WIDTH )
+    ) gpio_u (
+        .s_axi_aclk     ( s_axi_aclk     ),
+        .s_axi_aresetn  ( s_axi_aresetn  ),
+        .s_axi_awaddr   ( s_axi_awaddr   ),
+        .s_axi_awvalid  ( s_axi_awvalid  ),
+        .s_axi_awready  ( s_axi_awready  ),
+        .s_axi_wdata    ( s_axi_wdata    ),
+        .s_axi_wstrb    ( s_axi_wstrb    ),
+        .s_axi_wvalid   ( s_axi_wvalid   ),
+        .s_axi_wready   ( s_axi_wready   ),
+        .s_axi_bresp    ( s_axi_bresp    ),
+        .s_axi_bvalid   ( s_axi_bvalid   ),
+        .s_axi_bready   ( s_axi_bready   ),
+        .s_axi_araddr   ( s_axi_araddr   ),
+        .s_axi_arvalid  ( s_axi_arvalid  ),
+        .s_axi_arready  ( s_axi_arready  ),
+        .s_axi_rdata    ( s_axi_rdata    ),
+        .s_axi_rresp    ( s_axi_rresp    ),
+        .s_axi_rvalid   ( s_axi_rvalid   ),
+        .s_axi_rready   ( s_axi_rready   ),
+        .gpio_io_i      ( '0             ),
+        .gpio_io_o      ( gpio_io_o      ),
+        .ip2intc_irpt   (                )
+    );
+
+endmodule : xlnx_axi_gpio_out
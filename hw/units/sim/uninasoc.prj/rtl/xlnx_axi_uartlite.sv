@@ -0,0 +1,152 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural stand-in of the AXI UART Lite IP (PG142) for the Verilator model of the SoC.
+//              No serial line: the chars written to the TX FIFO go straight to the testbench (sim_uart_tx),
+//              the RX FIFO is filled from the testbench (sim_uart_rx), polled every RX_POLL_CYCLES cycles.
+//              The TX FIFO is always empty. The interrupt is a one-cycle pulse, as in the IP, when
+//              the RX FIFO gets data or the TX FIFO gets empty, if enabled in the control register.
+//              Registers:
+//                  00h - RX FIFO   (R)   pop a char
+//                  04h - TX FIFO   (W)   push a char
+//                  08h - Status    (R)   [0] RX valid, [1] RX full, [2] TX empty, [3] TX full, [4] interrupt enabled
+//                  0Ch - Control   (W)   [0] reset TX FIFO, [1] reset RX FIFO, [4] enable interrupt
+
+module xlnx_axi_uartlite # (
+    parameter int unsigned RX_FIFO_DEPTH  = 16,
+    parameter int unsigned RX_POLL_CYCLES = 64
+) (
+    input  logic            s_axi_aclk,
+    input  logic            s_axi_aresetn,
+    output logic            interrupt,
+    input  logic [3 : 0]    s_axi_awaddr,
+    input  logic            s_axi_awvalid,
+    output logic            s_axi_awready,
+    input  logic [31 : 0]   s_axi_wdata,
+    input  logic [3 : 0]    s_axi_wstrb,
+    input  logic            s_axi_wvalid,
+    output logic            s_axi_wready,
+    output logic [1 : 0]    s_axi_bresp,
+    output logic            s_axi_bvalid,
+    input  logic            s_axi_bready,
+    input  logic [3 : 0]    s_axi_araddr,
+    input  logic            s_axi_arvalid,
+    output logic            s_axi_arready,
+    output logic [31 : 0]   s_axi_rdata,
+    output logic [1 : 0]    s_axi_rresp,
+    output logic            s_axi_rvalid,
+    input  logic            s_axi_rready,
+    input  logic            rx,
+    output logic            tx
+);
+
+    // Testbench side, see tb/uninasoc_tb.cpp
+    import "DPI-C" function void sim_uart_tx ( input int c );
+    import "DPI-C" function int  sim_uart_rx ();
+
+    localparam int unsigned             RX_PTR_WIDTH = $clog2(RX_FIFO_DEPTH);
+    localparam logic [RX_PTR_WIDTH : 0] RX_FULL      = ( RX_PTR_WIDTH + 1 )'(RX_FIFO_DEPTH);
+
+    logic           wr;
+    logic [3 : 0]   wr_addr;
+    logic [31 : 0]  wr_data;
+    logic           rd;
+    logic [3 : 0]   rd_addr;
+    logic [31 : 0]  rd_data;
+
+    logic [7 : 0]               rx_fifo [RX_FIFO_DEPTH];
+    logic [RX_PTR_WIDTH-1 : 0]  rx_head;
+    logic [RX_PTR_WIDTH : 0]    rx_level;
+    logic [31 : 0]              rx_poll_cnt;
+    logic                       int_enable;
+    // DPI result, blocking in the clocked block
+    /* verilator lint_off BLKSEQ */
+    int                         rx_char;
+    /* verilator lint_on BLKSEQ */
+
+    sim_axilite_regs # (
+        .ADDR_WIDTH ( 4  ),
+        .DATA_WIDTH ( 32 )
+    ) regs_u (
+        .clk_i      ( s_axi_aclk    ),
+        .rst_ni     ( s_axi_aresetn ),
+        .awaddr_i   ( s_axi_awaddr  ),
+        .awvalid_i  ( s_axi_awvalid ),
+        .awready_o  ( s_axi_awready ),
+        .wdata_i    ( s_axi_wdata   ),
+        .wstrb_i    ( s_axi_wstrb   ),
+        .wvalid_i   ( s_axi_wvalid  ),
+        .wready_o   ( s_axi_wready  ),
+        .bresp_o    ( s_axi_bresp   ),
+        .bvalid_o   ( s_axi_bvalid  ),
+        .bready_i   ( s_axi_bready  ),
+        .araddr_i   ( s_axi_araddr  ),
+        .arvalid_i  ( s_axi_arvalid ),
+        .arready_o  ( s_axi_arready ),
+        .rdata_o    ( s_axi_rdata   ),
+        .rresp_o    ( s_axi_rresp   ),
+        .rvalid_o   ( s_axi_rvalid  ),
+        .rready_i   ( s_axi_rready  ),
+        .wr_o       ( wr            ),
+        .wr_addr_o  ( wr_addr       ),
+        .wr_data_o  ( wr_data       ),
+        .wr_strb_o  (               ),
+        .rd_o       ( rd            ),
+        .rd_addr_o  ( rd_addr       ),
+        .rd_data_i  ( rd_data       )
+    );
+
+    // Idle serial line
+    assign tx = 1'b1;
+
+    always_comb begin
+        case ( rd_addr[3:2] )
+            2'h0:    rd_data = ( rx_level != 0 ) ? {24'b0, rx_fifo[rx_head]} : '0;
+            2'h2:    rd_data = {27'b0, int_enable, 1'b0, 1'b1, rx_level == RX_FULL, rx_level != 0};
+            default: rd_data = '0;
+        endcase
+    end
+
+    always_ff @( posedge s_axi_aclk or negedge s_axi_aresetn ) begin
+        if ( !s_axi_aresetn ) begin
+            rx_head     <= '0;
+            rx_level    <= '0;
+            rx_poll_cnt <= '0;
+            int_enable  <= 1'b0;
+            interrupt   <= 1'b0;
+        end
+        else begin
+            interrupt <= 1'b0;
+
+            // TX: the char leaves at once, the FIFO gets empty again
+            if ( wr && wr_addr[3:2] == 2'h1 ) begin
+                sim_uart_tx({24'b0, wr_data[7:0]});
+                interrupt <= int_enable;
+            end
+
+            // Control
+            if ( wr && wr_addr[3:2] == 2'h3 ) begin
+                int_enable <= wr_data[4];
+                if ( wr_data[1] )
+                    rx_level <= '0;
+            end
+
+            // RX: pop on read, poll the testbench for a new char
+            if ( rd && rd_addr[3:2] == 2'h0 && rx_level != 0 ) begin
+                rx_head  <= rx_head + 1;
+                rx_level <= rx_level - 1;
+            end
+            else if ( rx_level != RX_FULL && !( wr && wr_addr[3:2] == 2'h3 && wr_data[1] ) ) begin
+                rx_poll_cnt <= rx_poll_cnt + 1;
+                if ( rx_poll_cnt == RX_POLL_CYCLES - 1 ) begin
+                    rx_poll_cnt <= '0;
+                    rx_char = sim_uart_rx();
+                    if ( rx_char >= 0 ) begin
+                        rx_fifo[rx_head + rx_level[RX_PTR_WIDTH-1:0]] <= rx_char[7:0];
+                        rx_level  <= rx_level + 1;
+                        interrupt <= int_enable;
+                    end
+                end
+            end
+        end
+    end
+
+endmodule : xlnx_axi_uartlite
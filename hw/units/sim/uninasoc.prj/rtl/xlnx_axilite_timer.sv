@@ -0,0 +1,152 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural stand-in of the AXI Timer IP (PG079) for the Verilator model of the SoC.
+//              Two 32-bit timers in generate mode, counting up or down once per clock cycle.
+//              Capture mode, PWM, cascade and the external pins are not modeled.
+//              Registers, timer n at n*10h:
+//                  00h - TCSR  [1] UDT, [4] ARHT, [5] LOAD, [6] ENIT, [7] ENT, [8] TINT (write 1 to clear), [10] ENALL
+//                  04h - TLR   load value
+//                  08h - TCR   counter (R)
+//              On rollover (up) or when reaching zero (down), TINT is set and the counter is reloaded
+//              if ARHT is set, or stops otherwise. The interrupt is the OR of TINT & ENIT of the timers.
+
+module xlnx_axilite_timer (
+    input  logic            s_axi_aclk,
+    input  logic            s_axi_aresetn,
+    input  logic [8 : 0]    s_axi_awaddr,
+    input  logic            s_axi_awvalid,
+    output logic            s_axi_awready,
+    input  logic [31 : 0]   s_axi_wdata,
+    input  logic [3 : 0]    s_axi_wstrb,
+    input  logic            s_axi_wvalid,
+    output logic            s_axi_wready,
+    output logic [1 : 0]    s_axi_bresp,
+    output logic            s_axi_bvalid,
+    input  logic            s_axi_bready,
+    input  logic [8 : 0]    s_axi_araddr,
+    input  logic            s_axi_arvalid,
+    output logic            s_axi_arready,
+    output logic [31 : 0]   s_axi_rdata,
+    output logic [1 : 0]    s_axi_rresp,
+    output logic            s_axi_rvalid,
+    input  logic            s_axi_rready,
+    input  logic            capturetrig0,
+    input  logic            capturetrig1,
+    input  logic            freeze,
+    output logic            generateout0,
+    output logic            generateout1,
+    output logic            interrupt,
+    output logic            pwm0
+);
+
+    // TCSR bits
+    localparam int unsigned UDT   = 1;
+    localparam int unsigned ARHT  = 4;
+    localparam int unsigned LOAD  = 5;
+    localparam int unsigned ENIT  = 6;
+    localparam int unsigned ENT   = 7;
+    localparam int unsigned TINT  = 8;
+    localparam int unsigned ENALL = 10;
+
+    logic           wr;
+    logic [8 : 0]   wr_addr;
+    logic [31 : 0]  wr_data;
+    logic           rd;
+    logic [8 : 0]   rd_addr;
+    logic [31 : 0]  rd_data;
+
+    logic [31 : 0]  tcsr [2];
+    logic [31 : 0]  tlr  [2];
+    logic [31 : 0]  tcr  [2];
+
+    sim_axilite_regs # (
+        .ADDR_WIDTH ( 9  ),
+        .DATA_WIDTH ( 32 )
+    ) regs_u (
+        .clk_i      ( s_axi_aclk    ),
+        .rst_ni     ( s_axi_aresetn ),
+        .awaddr_i   ( s_axi_awaddr  ),
+        .awvalid_i  ( s_axi_awvalid ),
+        .awready_o  ( s_axi_awready ),
+        .wdata_i    ( s_axi_wdata   ),
+        .wstrb_i    ( s_axi_wstrb   ),
+        .wvalid_i   ( s_axi_wvalid  ),
+        .wready_o   ( s_axi_wready  ),
+        .bresp_o    ( s_axi_bresp   ),
+        .bvalid_o   ( s_axi_bvalid  ),
+        .bready_i   ( s_axi_bready  ),
+        .araddr_i   ( s_axi_araddr  ),
+        .arvalid_i  ( s_axi_arvalid ),
+        .arready_o  ( s_axi_arready ),
+        .rdata_o    ( s_axi_rdata   ),
+        .rresp_o    ( s_axi_rresp   ),
+        .rvalid_o   ( s_axi_rvalid  ),
+        .rready_i   ( s_axi_rready  ),
+        .wr_o       ( wr            ),
+        .wr_addr_o  ( wr_addr       ),
+        .wr_data_o  ( wr_data       ),
+        .wr_strb_o  (               ),
+        .rd_o       ( rd            ),
+        .rd_addr_o  ( rd_addr       ),
+        .rd_data_i  ( rd_data       )
+    );
+
+    assign generateout0 = 1'b0;
+    assign generateout1 = 1'b0;
+    assign pwm0         = 1'b0;
+    assign interrupt    = ( tcsr[0][TINT] && tcsr[0][ENIT] ) || ( tcsr[1][TINT] && tcsr[1][ENIT] );
+
+    always_comb begin
+        case ( rd_addr[3:2] )
+            2'h0:    rd_data = tcsr[rd_addr[4]];
+            2'h1:    rd_data = tlr[rd_addr[4]];
+            2'h2:    rd_data = tcr[rd_addr[4]];
+            default: rd_data = '0;
+        endcase
+    end
+
+    always_ff @( posedge s_axi_aclk or negedge s_axi_aresetn ) begin
+        if ( !s_axi_aresetn ) begin
+            for ( int i = 0; i < 2; i++ ) begin
+                tcsr[i] <= '0;
+                tlr[i]  <= '0;
+                tcr[i]  <= '0;
+            end
+        end
+        else begin
+            for ( int i = 0; i < 2; i++ ) begin
+                // Count
+                if ( tcsr[i][LOAD] ) begin
+                    tcr[i] <= tlr[i];
+                end
+                else if ( tcsr[i][ENT] ) begin
+                    if ( tcsr[i][UDT] ? ( tcr[i] == '0 ) : ( tcr[i] == '1 ) ) begin
+                        tcsr[i][TINT] <= 1'b1;
+                        if ( tcsr[i][ARHT] )
+                            tcr[i] <= tlr[i];
+                        else
+                            tcsr[i][ENT] <= 1'b0;
+                    end
+                    else begin
+                        tcr[i] <= tcsr[i][UDT] ? tcr[i] - 1 : tcr[i] + 1;
+                    end
+                end
+
+                // Registers, TINT is cleared writing 1
+                if ( wr && wr_addr[4] == i[0] ) begin
+                    case ( wr_addr[3:2] )
+                        2'h0: tcsr[i] <= {21'b0, wr_data[ENALL], 1'b0, tcsr[i][TINT] & ~wr_data[TINT], wr_data[7:0]};
+                        2'h1: tlr[i]  <= wr_data;
+                        default: ;
+                    endcase
+                end
+            end
+
+            // Enable all
+            if ( wr && wr_addr[3:2] == 2'h0 && wr_data[ENALL] ) begin
+                tcsr[0][ENT] <= 1'b1;
+                tcsr[1][ENT] <= 1'b1;
+            end
+        end
+    end
+
+endmodule : xlnx_axilite_timer
@@ -0,0 +1,241 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural stand-in of the AXI BRAM IP (main memory) for the Verilator model of the SoC.
+//              DEPTH 32-bit words, addressed modulo the depth as the IP does. INCR, WRAP and FIXED bursts,
+//              byte strobes, one write and one read burst in flight, data back one beat per cycle.
+//              The testbench preloads and inspects the memory through the DPI backdoor functions below,
+//              called in the scope of this instance (TOP.uninasoc.main_memory_u).
+//              With SIM_MEM_SPARSE, the words live in the sparse memory of the testbench (tb_memory.h) instead of an
+//              array of DEPTH words, reached through the DPI functions sim_mem_*: the start-up time and the host memory
+//              follow the pages the program touches. The read data is then fetched at the address handshake and at
+//              each beat, not looked up combinationally.
+
+module xlnx_blk_mem_gen # (
+`ifdef SIM_BRAM_DEPTH
+    parameter int unsigned DEPTH = `SIM_BRAM_DEPTH
+`else
+    parameter int unsigned DEPTH = 8192
+`endif
+) (
+    output logic            rsta_busy,
+    output logic            rstb_busy,
+    input  logic            s_aclk,
+    input  logic            s_aresetn,
+    input  logic [3 : 0]    s_axi_awid,
+    input  logic [31 : 0]   s_axi_awaddr,
+    input  logic [7 : 0]    s_axi_awlen,
+    input  logic [2 : 0]    s_axi_awsize,
+    input  logic [1 : 0]    s_axi_awburst,
+    input  logic            s_axi_awvalid,
+    output logic            s_axi_awready,
+    input  logic [31 : 0]   s_axi_wdata,
+    input  logic [3 : 0]    s_axi_wstrb,
+    input  logic            s_axi_wlast,
+    input  logic            s_axi_wvalid,
+    output logic            s_axi_wready,
+    output logic [3 : 0]    s_axi_bid,
+    output logic [1 : 0]    s_axi_bresp,
+    output logic            s_axi_bvalid,
+    input  logic            s_axi_bready,
+    input  logic [3 : 0]    s_axi_arid,
+    input  logic [31 : 0]   s_axi_araddr,
+    input  logic [7 : 0]    s_axi_arlen,
+    input  logic [2 : 0]    s_axi_arsize,
+    input  logic [1 : 0]    s_axi_arburst,
+    input  logic            s_axi_arvalid,
+    output logic            s_axi_arready,
+    output logic [3 : 0]    s_axi_rid,
+    output logic [31 : 0]   s_axi_rdata,
+    output logic [1 : 0]    s_axi_rresp,
+    output logic            s_axi_rlast,
+    output logic            s_axi_rvalid,
+    input  logic            s_axi_rready
+);
+
+    localparam int unsigned IDX_WIDTH = $clog2(DEPTH);
+
+    localparam logic [1:0] BURST_FIXED = 2'b00;
+    localparam logic [1:0] BURST_WRAP  = 2'b10;
+
+`ifdef SIM_MEM_SPARSE
+    import "DPI-C" function int          sim_mem_open    ( input string name, input int unsigned words );
+    import "DPI-C" function int unsigned sim_mem_read32  ( input int handle, input int unsigned word );
+    import "DPI-C" function void         sim_mem_write32 ( input int handle, input int unsigned word, input int unsigned data, input int unsigned strb );
+
+    // Saved in the checkpoints, as the memory handles of the testbench
+    int mem_h;
+    initial mem_h = sim_mem_open($sformatf("%m"), DEPTH);
+`else
+    logic [31 : 0] mem [DEPTH];
+`endif
+
+    //////////////
+    // Backdoor //
+    //////////////
+
+    export "DPI-C" function bram_backdoor_read;
+    export "DPI-C" function bram_backdoor_write;
+    export "DPI-C" function bram_backdoor_size;
+
+    function int unsigned bram_backdoor_read ( input int unsigned word );
+`ifdef SIM_MEM_SPARSE
+        return sim_mem_read32(mem_h, 32'(word[IDX_WIDTH-1:0]));
+`else
+        return mem[word[IDX_WIDTH-1:0]];
+`endif
+    endfunction
+
+    function void bram_backdoor_write ( input int unsigned word, input int unsigned data );
+`ifdef SIM_MEM_SPARSE
+        sim_mem_write32(mem_h, 32'(word[IDX_WIDTH-1:0]), data, 32'hF);
+`else
+        mem[word[IDX_WIDTH-1:0]] = data;
+`endif
+    endfunction
+
+    function int unsigned bram_backdoor_size ();
+        return DEPTH;
+    endfunction
+
+    ////////////
+    // Bursts //
+    ////////////
+
+    function automatic logic [31:0] next_addr (
+        input logic [31:0] addr,
+        input logic [7:0]  len,
+        input logic [2:0]  size,
+        input logic [1:0]  burst
+    );
+        logic [31:0] wrap_bytes;
+        logic [31:0] wrap_base;
+        next_addr = addr + ( 32'd1 << size );
+        if ( burst == BURST_FIXED ) begin
+            next_addr = addr;
+        end
+        else if ( burst == BURST_WRAP ) begin
+            wrap_bytes = ( 32'(len) + 1 ) << size;
+            wrap_base  = addr & ~( wrap_bytes - 1 );
+            if ( next_addr >= wrap_base + wrap_bytes )
+                next_addr = wrap_base;
+        end
+    endfunction
+
+    assign rsta_busy = 1'b0;
+    assign rstb_busy = 1'b0;
+
+    // Write
+    logic           w_active;
+    logic [3 : 0]   w_id;
+    logic [31 : 0]  w_addr;
+    logic [7 : 0]   w_len;
+    logic [2 : 0]   w_size;
+    logic [1 : 0]   w_burst;
+
+    assign s_axi_awready = !w_active && !s_axi_bvalid;
+    assign s_axi_wready  = w_active;
+    assign s_axi_bid     = w_id;
+    assign s_axi_bresp   = 2'b00;
+
+    always_ff @( posedge s_aclk or negedge s_aresetn ) begin
+        if ( !s_aresetn ) begin
+            w_active     <= 1'b0;
+            w_id         <= '0;
+            w_addr       <= '0;
+            w_len        <= '0;
+            w_size       <= '0;
+            w_burst      <= '0;
+            s_axi_bvalid <= 1'b0;
+        end
+        else begin
+            if ( s_axi_awvalid && s_axi_awready ) begin
+                w_active <= 1'b1;
+                w_id     <= s_axi_awid;
+                w_addr   <= s_axi_awaddr;
+                w_len    <= s_axi_awlen;
+                w_size   <= s_axi_awsize;
+                w_burst  <= s_axi_awburst;
+            end
+
+            if ( s_axi_wvalid && s_axi_wready ) begin
+`ifdef SIM_MEM_SPARSE
+                sim_mem_write32(mem_h, 32'(w_addr[IDX_WIDTH+1:2]), s_axi_wdata, 32'(s_axi_wstrb));
+`else
+                for ( int b = 0; b < 4; b++ )
+                    if ( s_axi_wstrb[b] )
+                        mem[w_addr[IDX_WIDTH+1:2]][b*8 +: 8] <= s_axi_wdata[b*8 +: 8];
+`endif
+                w_addr <= next_addr(w_addr, w_len, w_size, w_burst);
+                if ( s_axi_wlast ) begin
+                    w_active     <= 1'b0;
+                    s_axi_bvalid <= 1'b1;
+                end
+            end
+
+            if ( s_axi_bvalid && s_axi_bready )
+                s_axi_bvalid <= 1'b0;
+        end
+    end
+
+    // Read
+    logic [31 : 0]  r_addr;
+    logic [7 : 0]   r_len;
+    logic [7 : 0]   r_beats;
+    logic [2 : 0]   r_size;
+    logic [1 : 0]   r_burst;
+
+    assign s_axi_arready = !s_axi_rvalid;
+`ifdef SIM_MEM_SPARSE
+    logic [31 : 0]  r_data;
+    logic [31 : 0]  r_next;
+    assign s_axi_rdata   = r_data;
+    assign r_next        = next_addr(r_addr, r_len, r_size, r_burst);
+`else
+    assign s_axi_rdata   = mem[r_addr[IDX_WIDTH+1:2]];
+`endif
+    assign s_axi_rresp   = 2'b00;
+    assign s_axi_rlast   = ( r_beats == 0 );
+
+    always_ff @( posedge s_aclk or negedge s_aresetn ) begin
+        if ( !s_aresetn ) begin
+            s_axi_rvalid <= 1'b0;
+            s_axi_rid    <= '0;
+            r_addr       <= '0;
+            r_len        <= '0;
+            r_beats      <= '0;
+            r_size       <= '0;
+            r_burst      <= '0;
+`ifdef SIM_MEM_SPARSE
+            r_data       <= '0;
+`endif
+        end
+        else begin
+            if ( s_axi_arvalid && s_axi_arready ) begin
+                s_axi_rvalid <= 1'b1;
+                s_axi_rid    <= s_axi_arid;
+                r_addr       <= s_axi_araddr;
+                r_len        <= s_axi_arlen;
+                r_beats      <= s_axi_arlen;
+                r_size       <= s_axi_arsize;
+                r_burst      <= s_axi_arburst;
+`ifdef SIM_MEM_SPARSE
+                r_data       <= sim_mem_read32(mem_h, 32'(s_axi_araddr[IDX_WIDTH+1:2]));
+`endif
+            end
+            else if ( s_axi_rvalid && s_axi_rready ) begin
+                if ( r_beats == 0 ) begin
+                    s_axi_rvalid <= 1'b0;
+                end
+                else begin
+                    r_beats <= r_beats - 1;
+`ifdef SIM_MEM_SPARSE
+                    r_addr  <= r_next;
+                    r_data  <= sim_mem_read32(mem_h, 32'(r_next[IDX_WIDTH+1:2]));
+`else
+                    r_addr  <= next_addr(r_addr, r_len, r_size, r_burst);
+`endif
+                end
+            end
+        end
+    end
+
+endmodule : xlnx_blk_mem_gen
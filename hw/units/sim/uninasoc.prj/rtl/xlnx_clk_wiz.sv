@@ -0,0 +1,29 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Stand-in of the Clocking Wizard IP for the Verilator model of the SoC.
+//              The model runs on a single clock: all the outputs are the input clock, so that
+//              one testbench cycle is one cycle of every clock domain (e.g. the PBUS timers count
+//              main clock cycles). Locked rises on the first clock edge out of reset.
+
+module xlnx_clk_wiz (
+    input  logic clk_in1,
+    input  logic resetn,
+    output logic locked,
+    output logic clk_100,
+    output logic clk_50,
+    output logic clk_20,
+    output logic clk_10
+);
+
+    assign clk_100 = clk_in1;
+    assign clk_50  = clk_in1;
+    assign clk_20  = clk_in1;
+    assign clk_10  = clk_in1;
+
+    always_ff @( posedge clk_in1 or negedge resetn ) begin
+        if ( !resetn )
+            locked <= 1'b0;
+        else
+            locked <= 1'b1;
+    end
+
+endmodule : xlnx_clk_wiz
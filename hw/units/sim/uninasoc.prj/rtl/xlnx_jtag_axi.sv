@@ -0,0 +1,17 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Stand-in of the JTAG-to-AXI master IP for the Verilator model of the SoC.
+//              There is no JTAG in simulation, the testbench loads the memory through the backdoor: the master is idle.
+
+import uninasoc_pkg::*;
+
+`include "uninasoc_axi.svh"
+
+module xlnx_jtag_axi (
+    input  logic aclk,
+    input  logic aresetn,
+    `DEFINE_AXI_MASTER_PORTS(m, 32, MBUS_ADDR_WIDTH, MBUS_ID_WIDTH)
+);
+
+    `SINK_AXI_MASTER_INTERFACE(m)
+
+endmodule : xlnx_jtag_axi
@@ -0,0 +1,402 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural stand-in of the main AXI crossbar IP for the Verilator model of the SoC.
+//              The address map comes from the main bus CSV configuration (gen/uninasoc_sim_map.svh).
+//              Each slave interface (SI) has at most one write and one read in flight, each master
+//              interface (MI) serves one write and one read at a time: the MI is granted round-robin
+//              among the SIs addressing it, then the channels of the transaction are passed through
+//              until the last response beat. IDs are passed through unchanged.
+//              Unmapped addresses get a DECERR response from an internal error slave.
+//              The bus arrays are flat, interface i at [i*WIDTH +: WIDTH] (see uninasoc_axi.svh).
+//              Each transaction is reported to the AXI performance monitor of the testbench (sim_axi_perf(),
+//              see tb_axi_perf.h): issue (first cycle of valid), address handshake, last response.
+
+import uninasoc_pkg::*;
+
+`include "uninasoc_axi.svh"
+
+module xlnx_main_crossbar # (
+    parameter int unsigned NUM_SI     = MBUS_NUM_SI,
+    parameter int unsigned NUM_MI     = MBUS_NUM_MI,
+    parameter int unsigned DATA_WIDTH = MBUS_DATA_WIDTH,
+    parameter int unsigned ADDR_WIDTH = MBUS_ADDR_WIDTH,
+    parameter int unsigned ID_WIDTH   = MBUS_ID_WIDTH
+) (
+    input  logic                                        aclk,
+    input  logic                                        aresetn,
+
+    // Slave interfaces, from the masters
+    input  logic [NUM_SI*ID_WIDTH-1 : 0]                s_axi_awid,
+    input  logic [NUM_SI*ADDR_WIDTH-1 : 0]              s_axi_awaddr,
+    input  logic [NUM_SI*AXI_LEN_WIDTH-1 : 0]           s_axi_awlen,
+    input  logic [NUM_SI*AXI_SIZE_WIDTH-1 : 0]          s_axi_awsize,
+    input  logic [NUM_SI*AXI_BURST_WIDTH-1 : 0]         s_axi_awburst,
+    input  logic [NUM_SI*AXI_LOCK_WIDTH-1 : 0]          s_axi_awlock,
+    input  logic [NUM_SI*AXI_CACHE_WIDTH-1 : 0]         s_axi_awcache,
+    input  logic [NUM_SI*AXI_PROT_WIDTH-1 : 0]          s_axi_awprot,
+    input  logic [NUM_SI*AXI_QOS_WIDTH-1 : 0]           s_axi_awqos,
+    input  logic [NUM_SI-1 : 0]                         s_axi_awvalid,
+    output logic [NUM_SI-1 : 0]                         s_axi_awready,
+    input  logic [NUM_SI*DATA_WIDTH-1 : 0]              s_axi_wdata,
+    input  logic [NUM_SI*DATA_WIDTH/8-1 : 0]            s_axi_wstrb,
+    input  logic [NUM_SI-1 : 0]                         s_axi_wlast,
+    input  logic [NUM_SI-1 : 0]                         s_axi_wvalid,
+    output logic [NUM_SI-1 : 0]                         s_axi_wready,
+    output logic [NUM_SI*ID_WIDTH-1 : 0]                s_axi_bid,
+    output logic [NUM_SI*AXI_RESP_WIDTH-1 : 0]          s_axi_bresp,
+    output logic [NUM_SI-1 : 0]                         s_axi_bvalid,
+    input  logic [NUM_SI-1 : 0]                         s_axi_bready,
+    input  logic [NUM_SI*ID_WIDTH-1 : 0]                s_axi_arid,
+    input  logic [NUM_SI*ADDR_WIDTH-1 : 0]              s_axi_araddr,
+    input  logic [NUM_SI*AXI_LEN_WIDTH-1 : 0]           s_axi_arlen,
+    input  logic [NUM_SI*AXI_SIZE_WIDTH-1 : 0]          s_axi_arsize,
+    input  logic [NUM_SI*AXI_BURST_WIDTH-1 : 0]         s_axi_arburst,
+    input  logic [NUM_SI*AXI_LOCK_WIDTH-1 : 0]          s_axi_arlock,
+    input  logic [NUM_SI*AXI_CACHE_WIDTH-1 : 0]         s_axi_arcache,
+    input  logic [NUM_SI*AXI_PROT_WIDTH-1 : 0]          s_axi_arprot,
+    input  logic [NUM_SI*AXI_QOS_WIDTH-1 : 0]           s_axi_arqos,
+    input  logic [NUM_SI-1 : 0]                         s_axi_arvalid,
+    output logic [NUM_SI-1 : 0]                         s_axi_arready,
+    output logic [NUM_SI*ID_WIDTH-1 : 0]                s_axi_rid,
+    output logic [NUM_SI*DATA_WIDTH-1 : 0]              s_axi_rdata,
+    output logic [NUM_SI*AXI_RESP_WIDTH-1 : 0]          s_axi_rresp,
+    output logic [NUM_SI-1 : 0]                         s_axi_rlast,
+    output logic [NUM_SI-1 : 0]                         s_axi_rvalid,
+    input  logic [NUM_SI-1 : 0]                         s_axi_rready,
+
+    // Master interfaces, to the slaves
+    output logic [NUM_MI*ID_WIDTH-1 : 0]                m_axi_awid,
+    output logic [NUM_MI*ADDR_WIDTH-1 : 0]              m_axi_awaddr,
+    output logic [NUM_MI*AXI_LEN_WIDTH-1 : 0]           m_axi_awlen,
+    output logic [NUM_MI*AXI_SIZE_WIDTH-1 : 0]          m_axi_awsize,
+    output logic [NUM_MI*AXI_BURST_WIDTH-1 : 0]         m_axi_awburst,
+    output logic [NUM_MI*AXI_LOCK_WIDTH-1 : 0]          m_axi_awlock,
+    output logic [NUM_MI*AXI_CACHE_WIDTH-1 : 0]         m_axi_awcache,
+    output logic [NUM_MI*AXI_PROT_WIDTH-1 : 0]          m_axi_awprot,
+    output logic [NUM_MI*AXI_REGION_WIDTH-1 : 0]        m_axi_awregion,
+    output logic [NUM_MI*AXI_QOS_WIDTH-1 : 0]           m_axi_awqos,
+    output logic [NUM_MI-1 : 0]                         m_axi_awvalid,
+    input  logic [NUM_MI-1 : 0]                         m_axi_awready,
+    output logic [NUM_MI*DATA_WIDTH-1 : 0]              m_axi_wdata,
+    output logic [NUM_MI*DATA_WIDTH/8-1 : 0]            m_axi_wstrb,
+    output logic [NUM_MI-1 : 0]                         m_axi_wlast,
+    output logic [NUM_MI-1 : 0]                         m_axi_wvalid,
+    input  logic [NUM_MI-1 : 0]                         m_axi_wready,
+    input  logic [NUM_MI*ID_WIDTH-1 : 0]                m_axi_bid,
+    input  logic [NUM_MI*AXI_RESP_WIDTH-1 : 0]          m_axi_bresp,
+    input  logic [NUM_MI-1 : 0]                         m_axi_bvalid,
+    output logic [NUM_MI-1 : 0]                         m_axi_bready,
+    output logic [NUM_MI*ID_WIDTH-1 : 0]                m_axi_arid,
+    output logic [NUM_MI*ADDR_WIDTH-1 : 0]              m_axi_araddr,
+    output logic [NUM_MI*AXI_LEN_WIDTH-1 : 0]           m_axi_arlen,
+    output logic [NUM_MI*AXI_SIZE_WIDTH-1 : 0]          m_axi_arsize,
+    output logic [NUM_MI*AXI_BURST_WIDTH-1 : 0]         m_axi_arburst,
+    output logic [NUM_MI*AXI_LOCK_WIDTH-1 : 0]          m_axi_arlock,
+    output logic [NUM_MI*AXI_CACHE_WIDTH-1 : 0]         m_axi_arcache,
+    output logic [NUM_MI*AXI_PROT_WIDTH-1 : 0]          m_axi_arprot,
+    output logic [NUM_MI*AXI_REGION_WIDTH-1 : 0]        m_axi_arregion,
+    output logic [NUM_MI*AXI_QOS_WIDTH-1 : 0]           m_axi_arqos,
+    output logic [NUM_MI-1 : 0]                         m_axi_arvalid,
+    input  logic [NUM_MI-1 : 0]                         m_axi_arready,
+    input  logic [NUM_MI*ID_WIDTH-1 : 0]                m_axi_rid,
+    input  logic [NUM_MI*DATA_WIDTH-1 : 0]              m_axi_rdata,
+    input  logic [NUM_MI*AXI_RESP_WIDTH-1 : 0]          m_axi_rresp,
+    input  logic [NUM_MI-1 : 0]                         m_axi_rlast,
+    input  logic [NUM_MI-1 : 0]                         m_axi_rvalid,
+    output logic [NUM_MI-1 : 0]                         m_axi_rready
+);
+
+    // Address map of the main bus
+    `include "uninasoc_sim_map.svh"
+
+    // Target MI NUM_MI is the error slave
+    localparam int unsigned ERR_MI = NUM_MI;
+    localparam logic [1:0]  DECERR = 2'b11;
+
+    // Performance monitor, bus 0 (see tb_axi_perf.h)
+    import "DPI-C" function void sim_axi_perf ( input int bus, input int kind, input int write, input int si, input int mi,
+                                                input int id, input longint unsigned addr, input int unsigned bytes, input int resp );
+    localparam int PERF_BUS    = 0;
+    localparam int PERF_ISSUE  = 0;
+    localparam int PERF_ACCEPT = 1;
+    localparam int PERF_DONE   = 2;
+
+    // Transaction phases of a SI
+    typedef enum logic [1:0] { IDLE, ADDR, DATA, RESP } phase_t;
+
+    function automatic int unsigned decode ( input logic [ADDR_WIDTH-1 : 0] addr );
+        decode = ERR_MI;
+        for ( int unsigned i = 0; i < NUM_MI; i++ )
+            if ( 64'(addr) >= SIM_MBUS_RANGE_BASE[i] && 64'(addr) - SIM_MBUS_RANGE_BASE[i] < ( 64'd1 << SIM_MBUS_RANGE_ADDR_WIDTH[i] ) )
+                decode = i;
+    endfunction
+
+    // Write channel state, per SI
+    phase_t                     w_phase  [NUM_SI];
+    int unsigned                w_target [NUM_SI];
+    logic [ID_WIDTH-1 : 0]      w_err_id [NUM_SI];
+    // Read channel state, per SI
+    phase_t                     r_phase  [NUM_SI];
+    int unsigned                r_target [NUM_SI];
+    logic [ID_WIDTH-1 : 0]      r_err_id [NUM_SI];
+    logic [AXI_LEN_WIDTH-1 : 0] r_err_cnt[NUM_SI];
+    // Transaction reported to the performance monitor, until its last response
+    logic                       w_issued [NUM_SI];
+    logic                       r_issued [NUM_SI];
+    // MI ownership
+    logic [NUM_MI-1 : 0]        w_busy;
+    logic [NUM_MI-1 : 0]        r_busy;
+    // Round-robin pointers
+    int unsigned                w_rr;
+    int unsigned                r_rr;
+    // Arbitration temporaries, blocking in the clocked block
+    /* verilator lint_off BLKSEQ */
+    logic [NUM_MI-1 : 0]        w_taken;
+    logic [NUM_MI-1 : 0]        r_taken;
+    int unsigned                si;
+    int unsigned                target;
+    /* verilator lint_on BLKSEQ */
+
+    //////////////////////////
+    // Channel pass-through //
+    //////////////////////////
+
+    always_comb begin
+        // MI defaults
+        m_axi_awid      = '0;
+        m_axi_awaddr    = '0;
+        m_axi_awlen     = '0;
+        m_axi_awsize    = '0;
+        m_axi_awburst   = '0;
+        m_axi_awlock    = '0;
+        m_axi_awcache   = '0;
+        m_axi_awprot    = '0;
+        m_axi_awregion  = '0;
+        m_axi_awqos     = '0;
+        m_axi_awvalid   = '0;
+        m_axi_wdata     = '0;
+        m_axi_wstrb     = '0;
+        m_axi_wlast     = '0;
+        m_axi_wvalid    = '0;
+        m_axi_bready    = '0;
+        m_axi_arid      = '0;
+        m_axi_araddr    = '0;
+        m_axi_arlen     = '0;
+        m_axi_arsize    = '0;
+        m_axi_arburst   = '0;
+        m_axi_arlock    = '0;
+        m_axi_arcache   = '0;
+        m_axi_arprot    = '0;
+        m_axi_arregion  = '0;
+        m_axi_arqos     = '0;
+        m_axi_arvalid   = '0;
+        m_axi_rready    = '0;
+        // SI defaults
+        s_axi_awready   = '0;
+        s_axi_wready    = '0;
+        s_axi_bid       = '0;
+        s_axi_bresp     = '0;
+        s_axi_bvalid    = '0;
+        s_axi_arready   = '0;
+        s_axi_rid       = '0;
+        s_axi_rdata     = '0;
+        s_axi_rresp     = '0;
+        s_axi_rlast     = '0;
+        s_axi_rvalid    = '0;
+
+        for ( int s = 0; s < NUM_SI; s++ ) begin
+
+            // Write
+            if ( w_target[s] == ERR_MI ) begin
+                case ( w_phase[s] )
+                    ADDR: s_axi_awready[s] = 1'b1;
+                    DATA: s_axi_wready[s]  = 1'b1;
+                    RESP: begin
+                        s_axi_bvalid[s] = 1'b1;
+                        s_axi_bresp[s*AXI_RESP_WIDTH +: AXI_RESP_WIDTH] = DECERR;
+                        s_axi_bid[s*ID_WIDTH +: ID_WIDTH] = w_err_id[s];
+                    end
+                    default: ;
+                endcase
+            end
+            else begin
+                case ( w_phase[s] )
+                    ADDR: begin
+                        m_axi_awvalid [w_target[s]] = s_axi_awvalid[s];
+                        m_axi_awid    [w_target[s]*ID_WIDTH         +: ID_WIDTH        ] = s_axi_awid    [s*ID_WIDTH         +: ID_WIDTH        ];
+                        m_axi_awaddr  [w_target[s]*ADDR_WIDTH       +: ADDR_WIDTH      ] = s_axi_awaddr  [s*ADDR_WIDTH       +: ADDR_WIDTH      ];
+                        m_axi_awlen   [w_target[s]*AXI_LEN_WIDTH    +: AXI_LEN_WIDTH   ] = s_axi_awlen   [s*AXI_LEN_WIDTH    +: AXI_LEN_WIDTH   ];
+                        m_axi_awsize  [w_target[s]*AXI_SIZE_WIDTH   +: AXI_SIZE_WIDTH  ] = s_axi_awsize  [s*AXI_SIZE_WIDTH   +: AXI_SIZE_WIDTH  ];
+                        m_axi_awburst [w_target[s]*AXI_BURST_WIDTH  +: AXI_BURST_WIDTH ] = s_axi_awburst [s*AXI_BURST_WIDTH  +: AXI_BURST_WIDTH ];
+                        m_axi_awlock  [w_target[s]*AXI_LOCK_WIDTH   +: AXI_LOCK_WIDTH  ] = s_axi_awlock  [s*AXI_LOCK_WIDTH   +: AXI_LOCK_WIDTH  ];
+                        m_axi_awcache [w_target[s]*AXI_CACHE_WIDTH  +: AXI_CACHE_WIDTH ] = s_axi_awcache [s*AXI_CACHE_WIDTH  +: AXI_CACHE_WIDTH ];
+                        m_axi_awprot  [w_target[s]*AXI_PROT_WIDTH   +: AXI_PROT_WIDTH  ] = s_axi_awprot  [s*AXI_PROT_WIDTH   +: AXI_PROT_WIDTH  ];
+                        m_axi_awqos   [w_target[s]*AXI_QOS_WIDTH    +: AXI_QOS_WIDTH   ] = s_axi_awqos   [s*AXI_QOS_WIDTH    +: AXI_QOS_WIDTH   ];
+                        s_axi_awready [s] = m_axi_awready[w_target[s]];
+                    end
+                    DATA: begin
+                        m_axi_wvalid  [w_target[s]] = s_axi_wvalid[s];
+                        m_axi_wlast   [w_target[s]] = s_axi_wlast[s];
+                        m_axi_wdata   [w_target[s]*DATA_WIDTH       +: DATA_WIDTH      ] = s_axi_wdata   [s*DATA_WIDTH       +: DATA_WIDTH      ];
+                        m_axi_wstrb   [w_target[s]*DATA_WIDTH/8     +: DATA_WIDTH/8    ] = s_axi_wstrb   [s*DATA_WIDTH/8     +: DATA_WIDTH/8    ];
+                        s_axi_wready  [s] = m_axi_wready[w_target[s]];
+                    end
+                    RESP: begin
+                        s_axi_bvalid  [s] = m_axi_bvalid[w_target[s]];
+                        s_axi_bid     [s*ID_WIDTH       +: ID_WIDTH      ] = m_axi_bid   [w_target[s]*ID_WIDTH       +: ID_WIDTH      ];
+                        s_axi_bresp   [s*AXI_RESP_WIDTH +: AXI_RESP_WIDTH] = m_axi_bresp [w_target[s]*AXI_RESP_WIDTH +: AXI_RESP_WIDTH];
+                        m_axi_bready  [w_target[s]] = s_axi_bready[s];
+                    end
+                    default: ;
+                endcase
+            end
+
+            // Read
+            if ( r_target[s] == ERR_MI ) begin
+                case ( r_phase[s] )
+                    ADDR: s_axi_arready[s] = 1'b1;
+                    DATA: begin
+                        s_axi_rvalid[s] = 1'b1;
+                        s_axi_rlast[s]  = ( r_err_cnt[s] == '0 );
+                        s_axi_rresp[s*AXI_RESP_WIDTH +: AXI_RESP_WIDTH] = DECERR;
+                        s_axi_rid[s*ID_WIDTH +: ID_WIDTH] = r_err_id[s];
+                    end
+                    default: ;
+                endcase
+            end
+            else begin
+                case ( r_phase[s] )
+                    ADDR: begin
+                        m_axi_arvalid [r_target[s]] = s_axi_arvalid[s];
+                        m_axi_arid    [r_target[s]*ID_WIDTH         +: ID_WIDTH        ] = s_axi_arid    [s*ID_WIDTH         +: ID_WIDTH        ];
+                        m_axi_araddr  [r_target[s]*ADDR_WIDTH       +: ADDR_WIDTH      ] = s_axi_araddr  [s*ADDR_WIDTH       +: ADDR_WIDTH      ];
+                        m_axi_arlen   [r_target[s]*AXI_LEN_WIDTH    +: AXI_LEN_WIDTH   ] = s_axi_arlen   [s*AXI_LEN_WIDTH    +: AXI_LEN_WIDTH   ];
+                        m_axi_arsize  [r_target[s]*AXI_SIZE_WIDTH   +: AXI_SIZE_WIDTH  ] = s_axi_arsize  [s*AXI_SIZE_WIDTH   +: AXI_SIZE_WIDTH  ];
+                        m_axi_arburst [r_target[s]*AXI_BURST_WIDTH  +: AXI_BURST_WIDTH ] = s_axi_arburst [s*AXI_BURST_WIDTH  +: AXI_BURST_WIDTH ];
+                        m_axi_arlock  [r_target[s]*AXI_LOCK_WIDTH   +: AXI_LOCK_WIDTH  ] = s_axi_arlock  [s*AXI_LOCK_WIDTH   +: AXI_LOCK_WIDTH  ];
+                        m_axi_arcache [r_target[s]*AXI_CACHE_WIDTH  +: AXI_CACHE_WIDTH ] = s_axi_arcache [s*AXI_CACHE_WIDTH  +: AXI_CACHE_WIDTH ];
+                        m_axi_arprot  [r_target[s]*AXI_PROT_WIDTH   +: AXI_PROT_WIDTH  ] = s_axi_arprot  [s*AXI_PROT_WIDTH   +: AXI_PROT_WIDTH  ];
+                        m_axi_arqos   [r_target[s]*AXI_QOS_WIDTH    +: AXI_QOS_WIDTH   ] = s_axi_arqos   [s*AXI_QOS_WIDTH    +: AXI_QOS_WIDTH   ];
+                        s_axi_arready [s] = m_axi_arready[r_target[s]];
+                    end
+                    DATA: begin
+                        s_axi_rvalid  [s] = m_axi_rvalid[r_target[s]];
+                        s_axi_rlast   [s] = m_axi_rlast[r_target[s]];
+                        s_axi_rid     [s*ID_WIDTH       +: ID_WIDTH      ] = m_axi_rid   [r_target[s]*ID_WIDTH       +: ID_WIDTH      ];
+                        s_axi_rdata   [s*DATA_WIDTH     +: DATA_WIDTH    ] = m_axi_rdata [r_target[s]*DATA_WIDTH     +: DATA_WIDTH    ];
+                        s_axi_rresp   [s*AXI_RESP_WIDTH +: AXI_RESP_WIDTH] = m_axi_rresp [r_target[s]*AXI_RESP_WIDTH +: AXI_RESP_WIDTH];
+                        m_axi_rready  [r_target[s]] = s_axi_rready[s];
+                    end
+                    default: ;
+                endcase
+            end
+        end
+    end
+
+    ///////////////////////////////
+    // Arbitration and SI phases //
+    ///////////////////////////////
+
+    always_ff @( posedge aclk or negedge aresetn ) begin
+        if ( !aresetn ) begin
+            for ( int s = 0; s < NUM_SI; s++ ) begin
+                w_phase[s]   <= IDLE;
+                w_target[s]  <= '0;
+                w_err_id[s]  <= '0;
+                r_phase[s]   <= IDLE;
+                r_target[s]  <= '0;
+                r_err_id[s]  <= '0;
+                r_err_cnt[s] <= '0;
+                w_issued[s]  <= 1'b0;
+                r_issued[s]  <= 1'b0;
+            end
+            w_busy <= '0;
+            r_busy <= '0;
+            w_rr   <= '0;
+            r_rr   <= '0;
+        end
+        else begin
+            // Grants: scan the SIs round-robin, an idle SI gets its target if free (the error slave always is)
+            w_taken = w_busy;
+            r_taken = r_busy;
+            for ( int k = 0; k < NUM_SI; k++ ) begin
+                si = ( w_rr + k ) % NUM_SI;
+                target = decode(s_axi_awaddr[si*ADDR_WIDTH +: ADDR_WIDTH]);
+                if ( w_phase[si] == IDLE && s_axi_awvalid[si] && ( target == ERR_MI || !w_taken[target] ) ) begin
+                    w_phase[si]  <= ADDR;
+                    w_target[si] <= target;
+                    if ( target != ERR_MI )
+                        w_taken[target] = 1'b1;
+                    w_rr <= ( si + 1 ) % NUM_SI;
+                end
+            end
+            for ( int k = 0; k < NUM_SI; k++ ) begin
+                si = ( r_rr + k ) % NUM_SI;
+                target = decode(s_axi_araddr[si*ADDR_WIDTH +: ADDR_WIDTH]);
+                if ( r_phase[si] == IDLE && s_axi_arvalid[si] && ( target == ERR_MI || !r_taken[target] ) ) begin
+                    r_phase[si]  <= ADDR;
+                    r_target[si] <= target;
+                    if ( target != ERR_MI )
+                        r_taken[target] = 1'b1;
+                    r_rr <= ( si + 1 ) % NUM_SI;
+                end
+            end
+
+            // Phases, on the handshakes
+            for ( int s = 0; s < NUM_SI; s++ ) begin
+                if ( w_phase[s] == IDLE && s_axi_awvalid[s] && !w_issued[s] ) begin
+                    w_issued[s] <= 1'b1;
+                    sim_axi_perf(PERF_BUS, PERF_ISSUE, 1, s, int'(decode(s_axi_awaddr[s*ADDR_WIDTH +: ADDR_WIDTH])),
+                                 int'(s_axi_awid[s*ID_WIDTH +: ID_WIDTH]), 64'(s_axi_awaddr[s*ADDR_WIDTH +: ADDR_WIDTH]),
+                                 ( 32'(s_axi_awlen[s*AXI_LEN_WIDTH +: AXI_LEN_WIDTH]) + 1 ) << s_axi_awsize[s*AXI_SIZE_WIDTH +: AXI_SIZE_WIDTH], 0);
+                end
+                case ( w_phase[s] )
+                    ADDR: if ( s_axi_awvalid[s] && s_axi_awready[s] ) begin
+                        w_phase[s]  <= DATA;
+                        w_err_id[s] <= s_axi_awid[s*ID_WIDTH +: ID_WIDTH];
+                        sim_axi_perf(PERF_BUS, PERF_ACCEPT, 1, s, int'(w_target[s]), 0, 0, 0, 0);
+                    end
+                    DATA: if ( s_axi_wvalid[s] && s_axi_wready[s] && s_axi_wlast[s] )
+                        w_phase[s] <= RESP;
+                    RESP: if ( s_axi_bvalid[s] && s_axi_bready[s] ) begin
+                        w_phase[s]  <= IDLE;
+                        w_issued[s] <= 1'b0;
+                        sim_axi_perf(PERF_BUS, PERF_DONE, 1, s, int'(w_target[s]), 0, 0, 0, int'(s_axi_bresp[s*AXI_RESP_WIDTH +: AXI_RESP_WIDTH]));
+                        if ( w_target[s] != ERR_MI )
+                            w_taken[w_target[s]] = 1'b0;
+                    end
+                    default: ;
+                endcase
+
+                if ( r_phase[s] == IDLE && s_axi_arvalid[s] && !r_issued[s] ) begin
+                    r_issued[s] <= 1'b1;
+                    sim_axi_perf(PERF_BUS, PERF_ISSUE, 0, s, int'(decode(s_axi_araddr[s*ADDR_WIDTH +: ADDR_WIDTH])),
+                                 int'(s_axi_arid[s*ID_WIDTH +: ID_WIDTH]), 64'(s_axi_araddr[s*ADDR_WIDTH +: ADDR_WIDTH]),
+                                 ( 32'(s_axi_arlen[s*AXI_LEN_WIDTH +: AXI_LEN_WIDTH]) + 1 ) << s_axi_arsize[s*AXI_SIZE_WIDTH +: AXI_SIZE_WIDTH], 0);
+                end
+                case ( r_phase[s] )
+                    ADDR: if ( s_axi_arvalid[s] && s_axi_arready[s] ) begin
+                        r_phase[s]   <= DATA;
+                        r_err_id[s]  <= s_axi_arid[s*ID_WIDTH +: ID_WIDTH];
+                        r_err_cnt[s] <= s_axi_arlen[s*AXI_LEN_WIDTH +: AXI_LEN_WIDTH];
+                        sim_axi_perf(PERF_BUS, PERF_ACCEPT, 0, s, int'(r_target[s]), 0, 0, 0, 0);
+                    end
+                    DATA: if ( s_axi_rvalid[s] && s_axi_rready[s] ) begin
+                        r_err_cnt[s] <= r_err_cnt[s] - 1;
+                        if ( s_axi_rlast[s] ) begin
+                            r_phase[s]  <= IDLE;
+                            r_issued[s] <= 1'b0;
+                            sim_axi_perf(PERF_BUS, PERF_DONE, 0, s, int'(r_target[s]), 0, 0, 0, int'(s_axi_rresp[s*AXI_RESP_WIDTH +: AXI_RESP_WIDTH]));
+                            if ( r_target[s] != ERR_MI )
+                                r_taken[r_target[s]] = 1'b0;
+                        end
+                    end
+                    default: ;
+                endcase
+            end
+
+            w_busy <= w_taken;
+            r_busy <= r_taken;
+        end
+    end
+
+endmodule : xlnx_main_crossbar
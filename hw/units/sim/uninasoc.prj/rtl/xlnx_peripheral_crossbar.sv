@@ -0,0 +1,210 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural stand-in of the peripheral AXI-lite crossbar IP for the Verilator model of the SoC.
+//              Single slave interface (the AXI4 to AXI-lite converter), one write and one read in flight,
+//              decoded on the peripheral bus CSV configuration (gen/uninasoc_sim_map.svh).
+//              Unmapped addresses get a DECERR response.
+//              Each transaction is reported to the AXI performance monitor of the testbench, as bus 1
+//              (see xlnx_main_crossbar.sv).
+
+import uninasoc_pkg::*;
+
+`include "uninasoc_axi.svh"
+
+module xlnx_peripheral_crossbar # (
+    parameter int unsigned NUM_MI     = PBUS_NUM_MI,
+    parameter int unsigned DATA_WIDTH = PBUS_DATA_WIDTH,
+    parameter int unsigned ADDR_WIDTH = PBUS_ADDR_WIDTH
+) (
+    input  logic                                    aclk,
+    input  logic                                    aresetn,
+
+    // Slave interface
+    input  logic [ADDR_WIDTH-1 : 0]                 s_axi_awaddr,
+    input  logic [AXI_PROT_WIDTH-1 : 0]             s_axi_awprot,
+    input  logic                                    s_axi_awvalid,
+    output logic                                    s_axi_awready,
+    input  logic [DATA_WIDTH-1 : 0]                 s_axi_wdata,
+    input  logic [DATA_WIDTH/8-1 : 0]               s_axi_wstrb,
+    input  logic                                    s_axi_wvalid,
+    output logic                                    s_axi_wready,
+    output logic [AXI_RESP_WIDTH-1 : 0]             s_axi_bresp,
+    output logic                                    s_axi_bvalid,
+    input  logic                                    s_axi_bready,
+    input  logic [ADDR_WIDTH-1 : 0]                 s_axi_araddr,
+    input  logic [AXI_PROT_WIDTH-1 : 0]             s_axi_arprot,
+    input  logic                                    s_axi_arvalid,
+    output logic                                    s_axi_arready,
+    output logic [DATA_WIDTH-1 : 0]                 s_axi_rdata,
+    output logic [AXI_RESP_WIDTH-1 : 0]             s_axi_rresp,
+    output logic                                    s_axi_rvalid,
+    input  logic                                    s_axi_rready,
+
+    // Master interfaces, to the peripherals
+    output logic [NUM_MI*ADDR_WIDTH-1 : 0]          m_axi_awaddr,
+    output logic [NUM_MI*AXI_PROT_WIDTH-1 : 0]      m_axi_awprot,
+    output logic [NUM_MI-1 : 0]                     m_axi_awvalid,
+    input  logic [NUM_MI-1 : 0]                     m_axi_awready,
+    output logic [NUM_MI*DATA_WIDTH-1 : 0]          m_axi_wdata,
+    output logic [NUM_MI*DATA_WIDTH/8-1 : 0]        m_axi_wstrb,
+    output logic [NUM_MI-1 : 0]                     m_axi_wvalid,
+    input  logic [NUM_MI-1 : 0]                     m_axi_wready,
+    input  logic [NUM_MI*AXI_RESP_WIDTH-1 : 0]      m_axi_bresp,
+    input  logic [NUM_MI-1 : 0]                     m_axi_bvalid,
+    output logic [NUM_MI-1 : 0]                     m_axi_bready,
+    output logic [NUM_MI*ADDR_WIDTH-1 : 0]          m_axi_araddr,
+    output logic [NUM_MI*AXI_PROT_WIDTH-1 : 0]      m_axi_arprot,
+    output logic [NUM_MI-1 : 0]                     m_axi_arvalid,
+    input  logic [NUM_MI-1 : 0]                     m_axi_arready,
+    input  logic [NUM_MI*DATA_WIDTH-1 : 0]          m_axi_rdata,
+    input  logic [NUM_MI*AXI_RESP_WIDTH-1 : 0]      m_axi_rresp,
+    input  logic [NUM_MI-1 : 0]                     m_axi_rvalid,
+    output logic [NUM_MI-1 : 0]                     m_axi_rready
+);
+
+    // Address map of the peripheral bus
+    `include "uninasoc_sim_map.svh"
+
+    localparam int unsigned ERR_MI = NUM_MI;
+    localparam logic [1:0]  DECERR = 2'b11;
+
+    typedef enum logic [1:0] { IDLE, ADDR, DATA, RESP } phase_t;
+
+    // Performance monitor, bus 1 (see tb_axi_perf.h)
+    import "DPI-C" function void sim_axi_perf ( input int bus, input int kind, input int write, input int si, input int mi,
+                                                input int id, input longint unsigned addr, input int unsigned bytes, input int resp );
+    localparam int PERF_BUS    = 1;
+    localparam int PERF_ISSUE  = 0;
+    localparam int PERF_ACCEPT = 1;
+    localparam int PERF_DONE   = 2;
+
+    function automatic int unsigned decode ( input logic [ADDR_WIDTH-1 : 0] addr );
+        decode = ERR_MI;
+        for ( int unsigned i = 0; i < NUM_MI; i++ )
+            if ( 64'(addr) >= SIM_PBUS_RANGE_BASE[i] && 64'(addr) - SIM_PBUS_RANGE_BASE[i] < ( 64'd1 << SIM_PBUS_RANGE_ADDR_WIDTH[i] ) )
+                decode = i;
+    endfunction
+
+    phase_t         w_phase;
+    int unsigned    w_target;
+    phase_t         r_phase;
+    int unsigned    r_target;
+
+    // Channel pass-through, to the target of the transaction
+    always_comb begin
+        m_axi_awaddr  = '0;
+        m_axi_awprot  = '0;
+        m_axi_awvalid = '0;
+        m_axi_wdata   = '0;
+        m_axi_wstrb   = '0;
+        m_axi_wvalid  = '0;
+        m_axi_bready  = '0;
+        m_axi_araddr  = '0;
+        m_axi_arprot  = '0;
+        m_axi_arvalid = '0;
+        m_axi_rready  = '0;
+        s_axi_awready = 1'b0;
+        s_axi_wready  = 1'b0;
+        s_axi_bresp   = DECERR;
+        s_axi_bvalid  = 1'b0;
+        s_axi_arready = 1'b0;
+        s_axi_rdata   = '0;
+        s_axi_rresp   = DECERR;
+        s_axi_rvalid  = 1'b0;
+
+        if ( w_target == ERR_MI ) begin
+            s_axi_awready = ( w_phase == ADDR );
+            s_axi_wready  = ( w_phase == DATA );
+            s_axi_bvalid  = ( w_phase == RESP );
+        end
+        else begin
+            case ( w_phase )
+                ADDR: begin
+                    m_axi_awvalid[w_target] = s_axi_awvalid;
+                    m_axi_awaddr [w_target*ADDR_WIDTH     +: ADDR_WIDTH    ] = s_axi_awaddr;
+                    m_axi_awprot [w_target*AXI_PROT_WIDTH +: AXI_PROT_WIDTH] = s_axi_awprot;
+                    s_axi_awready = m_axi_awready[w_target];
+                end
+                DATA: begin
+                    m_axi_wvalid[w_target] = s_axi_wvalid;
+                    m_axi_wdata [w_target*DATA_WIDTH   +: DATA_WIDTH  ] = s_axi_wdata;
+                    m_axi_wstrb [w_target*DATA_WIDTH/8 +: DATA_WIDTH/8] = s_axi_wstrb;
+                    s_axi_wready = m_axi_wready[w_target];
+                end
+                RESP: begin
+                    s_axi_bvalid = m_axi_bvalid[w_target];
+                    s_axi_bresp  = m_axi_bresp[w_target*AXI_RESP_WIDTH +: AXI_RESP_WIDTH];
+                    m_axi_bready[w_target] = s_axi_bready;
+                end
+                default: ;
+            endcase
+        end
+
+        if ( r_target == ERR_MI ) begin
+            s_axi_arready = ( r_phase == ADDR );
+            s_axi_rvalid  = ( r_phase == DATA );
+        end
+        else begin
+            case ( r_phase )
+                ADDR: begin
+                    m_axi_arvalid[r_target] = s_axi_arvalid;
+                    m_axi_araddr [r_target*ADDR_WIDTH     +: ADDR_WIDTH    ] = s_axi_araddr;
+                    m_axi_arprot [r_target*AXI_PROT_WIDTH +: AXI_PROT_WIDTH] = s_axi_arprot;
+                    s_axi_arready = m_axi_arready[r_target];
+                end
+                DATA: begin
+                    s_axi_rvalid = m_axi_rvalid[r_target];
+                    s_axi_rdata  = m_axi_rdata[r_target*DATA_WIDTH     +: DATA_WIDTH    ];
+                    s_axi_rresp  = m_axi_rresp[r_target*AXI_RESP_WIDTH +: AXI_RESP_WIDTH];
+                    m_axi_rready[r_target] = s_axi_rready;
+                end
+                default: ;
+            endcase
+        end
+    end
+
+    // Phases, on the handshakes
+    always_ff @( posedge aclk or negedge aresetn ) begin
+        if ( !aresetn ) begin
+            w_phase  <= IDLE;
+            w_target <= '0;
+            r_phase  <= IDLE;
+            r_target <= '0;
+        end
+        else begin
+            case ( w_phase )
+                IDLE: if ( s_axi_awvalid ) begin
+                    w_phase  <= ADDR;
+                    w_target <= decode(s_axi_awaddr);
+                    sim_axi_perf(PERF_BUS, PERF_ISSUE, 1, 0, int'(decode(s_axi_awaddr)), 0, 64'(s_axi_awaddr), DATA_WIDTH/8, 0);
+                end
+                ADDR: if ( s_axi_awvalid && s_axi_awready ) begin
+                    w_phase <= DATA;
+                    sim_axi_perf(PERF_BUS, PERF_ACCEPT, 1, 0, int'(w_target), 0, 0, 0, 0);
+                end
+                DATA: if ( s_axi_wvalid  && s_axi_wready  ) w_phase <= RESP;
+                RESP: if ( s_axi_bvalid  && s_axi_bready  ) begin
+                    w_phase <= IDLE;
+                    sim_axi_perf(PERF_BUS, PERF_DONE, 1, 0, int'(w_target), 0, 0, 0, int'(s_axi_bresp));
+                end
+            endcase
+
+            case ( r_phase )
+                IDLE: if ( s_axi_arvalid ) begin
+                    r_phase  <= ADDR;
+                    r_target <= decode(s_axi_araddr);
+                    sim_axi_perf(PERF_BUS, PERF_ISSUE, 0, 0, int'(decode(s_axi_araddr)), 0, 64'(s_axi_araddr), DATA_WIDTH/8, 0);
+                end
+                ADDR: if ( s_axi_arvalid && s_axi_arready ) begin
+                    r_phase <= DATA;
+                    sim_axi_perf(PERF_BUS, PERF_ACCEPT, 0, 0, int'(r_target), 0, 0, 0, 0);
+                end
+                DATA: if ( s_axi_rvalid  && s_axi_rready  ) begin
+                    r_phase <= IDLE;
+                    sim_axi_perf(PERF_BUS, PERF_DONE, 0, 0, int'(r_target), 0, 0, 0, int'(s_axi_rresp));
+                end
+                default: r_phase <= IDLE;
+            endcase
+        end
+    end
+
+endmodule : xlnx_peripheral_crossbar
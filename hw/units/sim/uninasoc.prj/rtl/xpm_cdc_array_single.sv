@@ -0,0 +1,32 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural model of the XPM single-bit array synchronizer for the Verilator model of the SoC
+
+module xpm_cdc_array_single # (
+    parameter int DEST_SYNC_FF   = 4,
+    parameter int INIT_SYNC_FF   = 0,
+    parameter int SIM_ASSERT_CHK = 0,
+    parameter int SRC_INPUT_REG  = 1,
+    parameter int WIDTH          = 2
+) (
+    output logic [WIDTH-1 : 0]  dest_out,
+    input  logic                dest_clk,
+    input  logic                src_clk,
+    input  logic [WIDTH-1 : 0]  src_in
+);
+
+    logic [WIDTH-1 : 0] src_q;
+    logic [WIDTH-1 : 0] sync_q [DEST_SYNC_FF];
+
+    always_ff @( posedge src_clk ) begin
+        src_q <= src_in;
+    end
+
+    always_ff @( posedge dest_clk ) begin
+        sync_q[0] <= ( SRC_INPUT_REG != 0 ) ? src_q : src_in;
+        for ( int i = 1; i < DEST_SYNC_FF; i++ )
+            sync_q[i] <= sync_q[i-1];
+    end
+
+    assign dest_out = sync_q[DEST_SYNC_FF-1];
+
+endmodule : xpm_cdc_array_single
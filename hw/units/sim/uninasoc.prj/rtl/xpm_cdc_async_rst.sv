@@ -0,0 +1,30 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Behavioural model of the XPM asynchronous reset synchronizer for the Verilator model of the SoC.
+//              Asynchronous assertion, release after DEST_SYNC_FF destination clock edges.
+
+module xpm_cdc_async_rst # (
+    parameter int DEST_SYNC_FF    = 4,
+    parameter int INIT_SYNC_FF    = 0,
+    parameter int RST_ACTIVE_HIGH = 0
+) (
+    input  logic src_arst,
+    input  logic dest_clk,
+    output logic dest_arst
+);
+
+    localparam logic ACTIVE = RST_ACTIVE_HIGH[0];
+
+    logic                       src_active;
+    logic [DEST_SYNC_FF-1 : 0]  sync_q;
+
+    assign src_active = ( src_arst == ACTIVE );
+    assign dest_arst  = sync_q[DEST_SYNC_FF-1];
+
+    always_ff @( posedge dest_clk or posedge src_active ) begin
+        if ( src_active )
+            sync_q <= {DEST_SYNC_FF{ACTIVE}};
+        else
+            sync_q <= {sync_q[DEST_SYNC_FF-2:0], ~ACTIVE};
+    end
+
+endmodule : xpm_cdc_async_rst
@@ -0,0 +1,273 @@
+#!/bin/python3.10
+# Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+# Description:
+#   Generate the SoC-dependent sources of the Verilator model of the SoC (uninasoc.prj):
+#   - uninasoc_sim_map.svh:   address map of the main and peripheral bus, for the behavioural crossbars
+#   - uninasoc_sim_map.h:     memory map of the BRAM, for the testbench ELF loader, and bus port names,
+#                             for the AXI performance monitor
+#   - custom_<unit>.sv:       the custom units in use, from their custom_top_wrapper.sv (as the IP packaging does)
+#   - custom_<unit>.sv:       port-only stand-ins of the custom units not in use (and of the debug module, no JTAG)
+#   - xlnx_<ip>.sv:           port-only stand-ins of the Xilinx IPs without a behavioural model in rtl/,
+#                             only instantiated in the generate branches not taken in this configuration
+#   - packages.f:             the packages of the custom units in use, in dependency order
+#   - lint.vlt:               lint waivers of the third-party sources and of the stand-ins, the SoC RTL is
+#                             linted with -Wall
+# Args:
+#   1: Main bus CSV configuration
+#   2: Peripheral bus CSV configuration
+#   3: Core selector (e.g. CORE_PICORV32)
+#   4: Output directory
+
+####################
+# Import libraries #
+####################
+# Parse args
+import sys
+# File names
+import os
+# Parse RTL
+import re
+# Manipulate CSV
+import pandas as pd
+
+##############
+# Parse args #
+##############
+
+if len(sys.argv) != 5:
+	print("Usage: " + sys.argv[0] + " <main bus csv> <peripheral bus csv> <core selector> <output dir>")
+	sys.exit(1)
+
+mbus_config_name = sys.argv[1]
+pbus_config_name = sys.argv[2]
+core_selector    = sys.argv[3]
+gen_dir          = sys.argv[4]
+
+# Repository paths, relative to this script
+SCRIPT_DIR      = os.path.dirname(os.path.abspath(__file__))
+PRJ_RTL_DIR     = os.path.join(SCRIPT_DIR, "..", "rtl")
+HW_UNITS_ROOT   = os.path.join(SCRIPT_DIR, "..", "..", "..")
+XILINX_RTL_DIR  = os.path.join(HW_UNITS_ROOT, "..", "xilinx", "rtl")
+
+# Custom units in use, for each supported core (see rv_socket.sv)
+# The debug module is never in use: the model has no JTAG
+UNITS_IN_USE = {
+	"CORE_PICORV32" : ["custom_picorv32", "custom_axi_from_mem", "custom_rv_plic"],
+	"CORE_CV32E40P" : ["custom_cv32e40p", "custom_axi_from_mem", "custom_rv_plic"],
+	"CORE_IBEX"     : ["custom_ibex",     "custom_axi_from_mem", "custom_rv_plic"],
+}
+
+if core_selector not in UNITS_IN_USE:
+	print("ERROR: " + core_selector + " is not supported by the Verilator model, supported cores: " + " ".join(UNITS_IN_USE.keys()))
+	sys.exit(1)
+
+os.makedirs(gen_dir, exist_ok=True)
+
+###############
+# Read config #
+###############
+
+def read_ranges ( config_file_name ):
+	config_df = pd.read_csv(config_file_name, sep=",", index_col=0)
+	names  = config_df.loc["RANGE_NAMES"]["Value"].split()
+	bases  = [int(addr, 16) for addr in config_df.loc["RANGE_BASE_ADDR"]["Value"].split()]
+	widths = [int(width) for width in config_df.loc["RANGE_ADDR_WIDTH"]["Value"].split()]
+	assert len(names) == len(bases) == len(widths), "Mismatch in lenght of configurations in " + config_file_name
+	masters = config_df.loc["MASTER_NAMES"]["Value"].split()
+	return names, bases, widths, masters
+
+mbus_names, mbus_bases, mbus_widths, mbus_masters = read_ranges(mbus_config_name)
+pbus_names, pbus_bases, pbus_widths, pbus_masters = read_ranges(pbus_config_name)
+
+if "BRAM" not in mbus_names:
+	print("ERROR: no BRAM in " + mbus_config_name)
+	sys.exit(1)
+bram_index = mbus_names.index("BRAM")
+
+# Write a generated file, only if the content changed (keeps the model up to date)
+def write_if_changed ( file_name, content ):
+	path = os.path.join(gen_dir, file_name)
+	if os.path.exists(path):
+		with open(path, "r") as fd:
+			if fd.read() == content:
+				return
+	with open(path, "w") as fd:
+		fd.write(content)
+
+##################
+# Address map(s) #
+##################
+
+def sv_array ( name, values, width ):
+	items = ", ".join(str(width) + "'h" + format(value, "x") for value in values)
+	return "localparam logic [" + str(width-1) + ":0] " + name + " [" + str(len(values)) + "] = '{" + items + "};\n"
+
+svh = "// This file is auto-generated with " + os.path.basename(__file__) + "\n"
+svh += "// Included in the crossbar modules, no include guard\n"
+svh += "\n"
+svh += "// Main bus: " + " ".join(mbus_names) + "\n"
+svh += sv_array("SIM_MBUS_RANGE_BASE", mbus_bases, 64)
+svh += sv_array("SIM_MBUS_RANGE_ADDR_WIDTH", mbus_widths, 8)
+svh += "\n"
+svh += "// Peripheral bus: " + " ".join(pbus_names) + "\n"
+svh += sv_array("SIM_PBUS_RANGE_BASE", pbus_bases, 64)
+svh += sv_array("SIM_PBUS_RANGE_ADDR_WIDTH", pbus_widths, 8)
+write_if_changed("uninasoc_sim_map.svh", svh)
+
+h = "// This file is auto-generated with " + os.path.basename(__file__) + "\n"
+h += "#pragma once\n"
+h += "\n"
+h += "#define SIM_BRAM_BASE  0x" + format(mbus_bases[bram_index], "x") + "UL\n"
+h += "#define SIM_BRAM_RANGE 0x" + format(1 << mbus_widths[bram_index], "x") + "UL\n"
+h += "\n"
+h += "// Bus ports, as the crossbar interfaces: masters (SI) and slaves (MI)\n"
+h += "#define SIM_MBUS_MASTER_NAMES \"" + " ".join(mbus_masters) + "\"\n"
+h += "#define SIM_MBUS_RANGE_NAMES  \"" + " ".join(mbus_names) + "\"\n"
+h += "#define SIM_PBUS_MASTER_NAMES \"" + " ".join(pbus_masters) + "\"\n"
+h += "#define SIM_PBUS_RANGE_NAMES  \"" + " ".join(pbus_names) + "\"\n"
+write_if_changed("uninasoc_sim_map.h", h)
+
+################
+# Custom units #
+################
+
+# Header of the wrapper, from the module keyword to the end of the port list
+def wrapper_header ( wrapper_text ):
+	match = re.search(r"^module\s+custom_top_wrapper.*?^\s*\);", wrapper_text, re.MULTILINE | re.DOTALL)
+	if match is None:
+		return None
+	return match.group(0)
+
+custom_units = sorted(set(re.findall(r"^\s*(custom_\w+)\s+\w+\s*\(",
+	"".join(open(os.path.join(XILINX_RTL_DIR, name)).read() for name in os.listdir(XILINX_RTL_DIR) if name.endswith(".sv")),
+	re.MULTILINE)))
+
+unit_rtl_dirs = []
+stand_in_files = []
+for unit in custom_units:
+	with open(os.path.join(HW_UNITS_ROOT, unit, "custom_top_wrapper.sv"), "r") as fd:
+		wrapper_text = fd.read()
+
+	if unit in UNITS_IN_USE[core_selector]:
+		# The unit itself, as packaged by custom_config.tcl
+		unit_rtl_dir = os.path.join(HW_UNITS_ROOT, unit, "rtl")
+		if not os.path.isdir(unit_rtl_dir):
+			print("ERROR: " + unit_rtl_dir + " not found, fetch the units sources first (make units)")
+			sys.exit(1)
+		unit_rtl_dirs.append(unit_rtl_dir)
+		content = "// This file is auto-generated with " + os.path.basename(__file__) + " from " + unit + "/custom_top_wrapper.sv\n"
+		content += re.sub(r"^module\s+custom_top_wrapper\b", "module " + unit, wrapper_text, count=1, flags=re.MULTILINE)
+	else:
+		# Port list only, outputs are left undriven
+		header = wrapper_header(wrapper_text)
+		if header is None:
+			print("ERROR: cannot parse the port list of " + unit + "/custom_top_wrapper.sv")
+			sys.exit(1)
+		header = re.sub(r"^module\s+custom_top_wrapper(\s+import\s+[\w:*,\s]+;)?", "module " + unit, header, count=1)
+		content = "// This file is auto-generated with " + os.path.basename(__file__) + "\n"
+		content += "// Port-only stand-in of " + unit + ", not in use in the Verilator model of the SoC\n"
+		content += "\n"
+		content += "import uninasoc_pkg::*;\n"
+		content += "\n"
+		content += "`include \"uninasoc_axi.svh\"\n"
+		content += "`include \"uninasoc_mem.svh\"\n"
+		content += "\n"
+		content += header + "\n"
+		content += "\n"
+		content += "endmodule : " + unit + "\n"
+		stand_in_files.append(unit + ".sv")
+
+	write_if_changed(unit + ".sv", content)
+
+##############
+# Xilinx IPs #
+##############
+
+# Instance ports of the Xilinx IPs without a model, for all the instances in the SoC RTL
+stub_ports = {}
+for name in sorted(os.listdir(XILINX_RTL_DIR)):
+	if not name.endswith(".sv"):
+		continue
+	with open(os.path.join(XILINX_RTL_DIR, name), "r") as fd:
+		rtl_text = re.sub(r"//.*", "", fd.read())
+	for match in re.finditer(r"^\s*(xlnx_\w+)\s+\w+\s*\((.*?)\);", rtl_text, re.MULTILINE | re.DOTALL):
+		ip = match.group(1)
+		if os.path.exists(os.path.join(PRJ_RTL_DIR, ip + ".sv")):
+			continue
+		ports = stub_ports.setdefault(ip, [])
+		for port in re.findall(r"\.(\w+)\s*\(", match.group(2)):
+			if port not in ports:
+				ports.append(port)
+
+for ip, ports in stub_ports.items():
+	content = "// This file is auto-generated with " + os.path.basename(__file__) + "\n"
+	content += "// Port-only stand-in of " + ip + ", not modeled in the Verilator model of the SoC\n"
+	content += "\n"
+	content += "module " + ip + " (\n"
+	content += ",\n".join("    input logic [1023:0] " + port for port in ports) + "\n"
+	content += ");\n"
+	content += "\n"
+	content += "    initial $fatal(1, \"" + ip + " is not modeled in the Verilator model of the SoC\");\n"
+	content += "\n"
+	content += "endmodule : " + ip + "\n"
+	stand_in_files.append(ip + ".sv")
+	write_if_changed(ip + ".sv", content)
+
+############
+# Packages #
+############
+
+# Packages of the units in use: package name -> (file, referenced packages)
+packages = {}
+for unit_rtl_dir in unit_rtl_dirs:
+	for name in sorted(os.listdir(unit_rtl_dir)):
+		if not name.endswith(".sv"):
+			continue
+		with open(os.path.join(unit_rtl_dir, name), "r", errors="ignore") as fd:
+			rtl_text = re.sub(r"//.*", "", fd.read())
+		match = re.search(r"^\s*package\s+(\w+)\s*;", rtl_text, re.MULTILINE)
+		if match is None:
+			continue
+		packages[match.group(1)] = (os.path.abspath(os.path.join(unit_rtl_dir, name)), set(re.findall(r"\b(\w+)::", rtl_text)))
+
+# Dependency order
+package_files = []
+visited = set()
+def visit ( package ):
+	if package in visited or package not in packages:
+		return
+	visited.add(package)
+	for dependency in sorted(packages[package][1]):
+		if dependency != package:
+			visit(dependency)
+	package_files.append(packages[package][0])
+
+for package in sorted(packages):
+	visit(package)
+
+write_if_changed("packages.f", "".join(path + "\n" for path in package_files))
+
+################
+# Lint waivers #
+################
+
+# Warnings of -Wall outside of the lint group (lint_off without a rule), for the third-party sources
+THIRD_PARTY_RULES = ["UNUSED", "UNDRIVEN", "DECLFILENAME", "VARHIDDEN", "BLKSEQ", "ASSIGNDLY", "DEFPARAM",
+					 "PINCONNECTEMPTY", "PINNOCONNECT", "SYNCASYNCNET", "IMPORTSTAR", "GENUNNAMED", "EOFNEWLINE",
+					 "MULTIDRIVEN", "UNOPTFLAT"]
+
+vlt = "`verilator_config\n"
+vlt += "// This file is auto-generated with " + os.path.basename(__file__) + "\n"
+vlt += "\n"
+vlt += "// Third-party sources of the custom units in use, and their wrappers (custom_top_wrapper.sv)\n"
+for unit in UNITS_IN_USE[core_selector]:
+	for pattern in ["*/" + unit + "/rtl/*", "*" + unit + ".sv"]:
+		vlt += "lint_off -file \"" + pattern + "\"\n"
+		for rule in THIRD_PARTY_RULES:
+			vlt += "lint_off -rule " + rule + " -file \"" + pattern + "\"\n"
+vlt += "\n"
+vlt += "// Port-only stand-ins: undriven outputs, unused inputs\n"
+for name in sorted(stand_in_files):
+	vlt += "lint_off -rule UNDRIVEN -file \"*" + name + "\"\n"
+	vlt += "lint_off -rule UNUSED -file \"*" + name + "\"\n"
+write_if_changed("lint.vlt", vlt)
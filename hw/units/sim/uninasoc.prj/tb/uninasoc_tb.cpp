@@ -0,0 +1,386 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Full-SoC testbench of the embedded uninasoc, for software bring-up without the board.
+//              The program is preloaded in the main memory through the DPI backdoor of the BRAM model
+//              (rtl/xlnx_blk_mem_gen.sv), then the SoC is released from reset and runs until
+//              +cycles or until the UART prints the +finish_on string.
+//              The UART model (rtl/xlnx_axi_uartlite.sv) sends its chars to stdout and reads +uart_in.
+//              Checkpoints (SAVABLE=1 model, see tb_checkpoint.h): +checkpoint_on=<string> saves the model when the
+//              UART prints the string, e.g. at the end of the boot; a run restored with +checkpoint_restore can
+//              load a different program with +elf/+bin, that must share the code run up to the checkpoint.
+//              Usage: uninasoc_run +elf=<file> | +bin=<file> [+bin_addr=<addr>]
+//                                  [+cycles=N] [+finish_on=<string>] [+uart_in=<string>]
+//                                  [+trace plusargs, see tb_trace.h] [+checkpoint plusargs, see tb_checkpoint.h]
+//                                  [+mem_file=<file>] [+mem_dump=<file>] [+profile plusargs, see tb_profile.h]
+//                                  [+axi_perf=<prefix>, see tb_axi_perf.h]
+//              Sparse main memory (SIM_MEM=sparse, see tb_memory.h): the BRAM model keeps its words in a sparse
+//              memory defined here, the preload is a bulk copy. +mem_file backs it with a host file (preload and
+//              writes land in it), +mem_dump writes it to a file at the end of the run.
+//              Profiling: every +profile_period cycles, the PC last retired (Ibex) or fetched by the core (sim_pc_sample() of
+//              hw/xilinx/rtl/rv_socket.sv) is sampled, and symbolized against the ELF at the end.
+//              AXI performance: the crossbar models report their transactions (sim_axi_perf()), bus 0 is the
+//              main bus, bus 1 the peripheral bus, the ports are named after the bus CSVs.
+//              Exit code: 0, or 1 if +finish_on is given and the string was never printed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <elf.h>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include "Vuninasoc.h"
+#include "Vuninasoc__Dpi.h"
+#include "verilated.h"
+#include "svdpi.h"
+#include "tb_trace.h"
+#include "tb_checkpoint.h"
+#include "tb_profile.h"
+#include "tb_axi_perf.h"
+#ifdef TB_MEM_SPARSE
+#include "tb_memory.h"
+#endif
+#include "uninasoc_sim_map.h"
+
+#define CLK_NS          50      // Main clock, 20 MHz (all domains run on it, see rtl/xlnx_clk_wiz.sv)
+#define RESET_CYCLES    10
+#define CYCLES          10000000
+
+// Scope of the BRAM backdoor functions
+#define BRAM_SCOPE      "TOP.uninasoc.main_memory_u"
+// Scope of the PC sampling function
+#define SOCKET_SCOPE    "TOP.uninasoc.rv_socket_u"
+
+static Vuninasoc * tb;
+static TbTrace<Vuninasoc> * trace = NULL;
+static TbCheckpoint<Vuninasoc> * checkpoint = NULL;
+static TbProfiler * profiler = NULL;
+static TbAxiPerf * axi_perf = NULL;
+#ifdef TB_MEM_SPARSE
+static TbSparseMemory * bram = NULL;
+#endif
+
+// UART
+static std::string uart_tail;           // Last chars of the output, as long as the longest string to match
+static size_t uart_tail_len = 0;
+static const char * uart_in = "";
+static size_t uart_in_pos = 0;          // Saved in the checkpoints
+static std::string finish_on;
+static bool uart_tx_event = false;
+static bool finished = false;
+
+static bool uart_ends_with ( const std::string & str )
+{
+    return !str.empty() && uart_tail.size() >= str.size() &&
+           uart_tail.compare(uart_tail.size() - str.size(), str.size(), str) == 0;
+}
+
+///////////////////
+// DPI functions //
+///////////////////
+
+void sim_uart_tx ( int c )
+{
+    putchar(c);
+    fflush(stdout);
+    uart_tx_event = true;
+
+    if ( uart_tail_len != 0 ) {
+        uart_tail.push_back((char) c);
+        if ( uart_tail.size() > uart_tail_len )
+            uart_tail.erase(0, 1);
+        if ( uart_ends_with(finish_on) )
+            finished = true;
+        if ( uart_ends_with(checkpoint->marker_name()) )
+            checkpoint->marker(checkpoint->marker_name().c_str());
+    }
+}
+
+int sim_uart_rx ( void )
+{
+    if ( uart_in[uart_in_pos] == '\0' )
+        return -1;
+    return (unsigned char) uart_in[uart_in_pos++];
+}
+
+void sim_axi_perf ( int bus, int kind, int write, int si, int mi, int id, unsigned long long addr, unsigned int bytes, int resp )
+{
+    axi_perf->event(bus, kind, write != 0, si, mi, id, addr, bytes, resp);
+}
+
+#ifdef TB_MEM_SPARSE
+// Sparse memories of the memory models, see tb_memory.h
+int sim_mem_open ( const char * name, unsigned int words )
+{
+    return tb_memory_open(name, (uint64_t) words * 4);
+}
+
+unsigned int sim_mem_read32 ( int handle, unsigned int word )
+{
+    return tb_memory(handle)->read32((uint64_t) word * 4);
+}
+
+void sim_mem_write32 ( int handle, unsigned int word, unsigned int data, unsigned int strb )
+{
+    tb_memory(handle)->write32((uint64_t) word * 4, data, strb);
+}
+#endif
+
+///////////////
+// Preloader //
+///////////////
+
+#ifndef TB_MEM_SPARSE
+// Write a byte in the BRAM, false if out of the memory
+static bool bram_write_byte ( uint64_t addr, uint8_t byte )
+{
+    uint64_t offset = addr - SIM_BRAM_BASE;
+    if ( offset >= (uint64_t) bram_backdoor_size() * 4 )    // Wraps below the base
+        return false;
+
+    uint32_t word = bram_backdoor_read(offset / 4);
+    uint32_t shift = ( offset % 4 ) * 8;
+    word = ( word & ~( 0xFFu << shift ) ) | ( (uint32_t) byte << shift );
+    bram_backdoor_write(offset / 4, word);
+    return true;
+}
+#endif
+
+// Load size bytes from buffer (zeros if NULL) at addr, returns the bytes out of the BRAM
+static uint64_t bram_load ( uint64_t addr, const uint8_t * buffer, uint64_t size )
+{
+#ifdef TB_MEM_SPARSE
+    // Bulk copy, skip the bytes below the base
+    uint64_t below = ( addr < SIM_BRAM_BASE ) ? std::min(size, (uint64_t) SIM_BRAM_BASE - addr) : 0;
+    uint64_t offset = addr + below - SIM_BRAM_BASE;
+    if ( buffer == NULL )
+        return below + bram->fill(offset, 0, size - below);
+    return below + bram->write(offset, buffer + below, size - below);
+#else
+    uint64_t dropped = 0;
+    for ( uint64_t i = 0; i < size; i++ )
+        if ( !bram_write_byte(addr + i, buffer ? buffer[i] : 0) )
+            dropped++;
+    return dropped;
+#endif
+}
+
+static uint8_t * read_file ( const char * file_name, size_t * size )
+{
+    FILE * fp = fopen(file_name, "rb");
+    if ( fp == NULL ) {
+        printf("ERROR: cannot open %s\n", file_name);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t * buffer = (uint8_t *) malloc(*size);
+    if ( fread(buffer, 1, *size, fp) != *size ) {
+        printf("ERROR: cannot read %s\n", file_name);
+        free(buffer);
+        buffer = NULL;
+    }
+    fclose(fp);
+    return buffer;
+}
+
+// Load the PT_LOAD segments of a 32-bit RISC-V ELF, zero-filling up to p_memsz (.bss)
+static int load_elf ( const char * file_name )
+{
+    size_t size;
+    uint8_t * buffer = read_file(file_name, &size);
+    if ( buffer == NULL )
+        return -1;
+
+    Elf32_Ehdr * ehdr = (Elf32_Ehdr *) buffer;
+    if ( size < sizeof(Elf32_Ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+         ehdr->e_ident[EI_CLASS] != ELFCLASS32 || ehdr->e_machine != EM_RISCV ) {
+        printf("ERROR: %s is not a 32-bit RISC-V ELF\n", file_name);
+        free(buffer);
+        return -1;
+    }
+
+    for ( int i = 0; i < ehdr->e_phnum; i++ ) {
+        Elf32_Phdr * phdr = (Elf32_Phdr *) ( buffer + ehdr->e_phoff + i * ehdr->e_phentsize );
+        if ( phdr->p_type != PT_LOAD || phdr->p_memsz == 0 )
+            continue;
+        if ( phdr->p_offset + phdr->p_filesz > size ) {
+            printf("ERROR: segment %d out of %s\n", i, file_name);
+            free(buffer);
+            return -1;
+        }
+
+        uint64_t dropped = bram_load(phdr->p_paddr, buffer + phdr->p_offset, phdr->p_filesz);
+        dropped += bram_load(phdr->p_paddr + phdr->p_filesz, NULL, phdr->p_memsz - phdr->p_filesz);
+        printf("Loaded segment 0x%08x, %u bytes (%u zero-filled)\n",
+                phdr->p_paddr, phdr->p_memsz, phdr->p_memsz - phdr->p_filesz);
+        if ( dropped )
+            fprintf(stderr, "[WARNING] %lu bytes of the segment at 0x%08x are out of the BRAM (0x%lx + %u bytes), not loaded\n",
+                    (unsigned long) dropped, phdr->p_paddr, (unsigned long) SIM_BRAM_BASE, bram_backdoor_size() * 4);
+    }
+
+    printf("Entry point 0x%08x\n", ehdr->e_entry);
+    profiler->add_symbols(buffer, size, file_name);
+    free(buffer);
+    return 0;
+}
+
+static int load_bin ( const char * file_name, uint64_t addr )
+{
+    size_t size;
+    uint8_t * buffer = read_file(file_name, &size);
+    if ( buffer == NULL )
+        return -1;
+
+    uint64_t dropped = bram_load(addr, buffer, size);
+    printf("Loaded %s at 0x%08lx, %lu bytes\n", file_name, (unsigned long) addr, (unsigned long) size);
+    if ( dropped )
+        fprintf(stderr, "[WARNING] %lu bytes are out of the BRAM, not loaded\n", (unsigned long) dropped);
+    free(buffer);
+    return 0;
+}
+
+////////////////
+// Simulation //
+////////////////
+
+void tick ( uint64_t cycle )
+{
+    // The triggers see the events of the previous cycle
+    trace->cycle(cycle);
+    uart_tx_event = false;
+    tb->eval();
+    trace->dump(cycle * CLK_NS);                // Inputs of this cycle
+    tb->sys_clock_i = 1;
+    tb->eval();
+    trace->dump(cycle * CLK_NS + CLK_NS / 2);   // Rising edge
+    tb->sys_clock_i = 0;
+}
+
+int main ( int argc, char ** argv )
+{
+    Verilated::commandArgs(argc, argv);
+    tb = new Vuninasoc;
+
+    // Tracing is selected with +trace plusargs, see tb_trace.h
+    trace = new TbTrace<Vuninasoc>(tb, argc, argv);
+    trace->add_trigger("uart_tx", []() { return uart_tx_event; });
+
+    // Checkpoints are selected with +checkpoint plusargs, see tb_checkpoint.h
+    checkpoint = new TbCheckpoint<Vuninasoc>(tb, argc, argv);
+    checkpoint->add_state(&uart_in_pos, sizeof(uart_in_pos));
+
+    // Profiling is selected with +profile plusargs, see tb_profile.h
+    profiler = new TbProfiler(argc, argv);
+
+    // AXI performance monitor, +axi_perf=<prefix>, see tb_axi_perf.h
+    axi_perf = new TbAxiPerf(argc, argv);
+    axi_perf->add_bus("MBUS", SIM_MBUS_MASTER_NAMES, SIM_MBUS_RANGE_NAMES);
+    axi_perf->add_bus("PBUS", SIM_PBUS_MASTER_NAMES, SIM_PBUS_RANGE_NAMES);
+#ifdef TB_MEM_SPARSE
+    checkpoint->add_stream(tb_memory_save, tb_memory_restore);
+#endif
+
+    const char * elf_file = NULL;
+    const char * bin_file = NULL;
+    uint64_t bin_addr = SIM_BRAM_BASE;
+    const char * mem_file = NULL;
+    const char * mem_dump = NULL;
+    uint64_t cycles = CYCLES;
+    for ( int i = 1; i < argc; i++ ) {
+        if ( strncmp(argv[i], "+elf=", 5) == 0 )
+            elf_file = argv[i] + 5;
+        else if ( strncmp(argv[i], "+bin=", 5) == 0 )
+            bin_file = argv[i] + 5;
+        else if ( strncmp(argv[i], "+bin_addr=", 10) == 0 )
+            bin_addr = strtoull(argv[i] + 10, NULL, 0);
+        else if ( strncmp(argv[i], "+cycles=", 8) == 0 )
+            cycles = strtoull(argv[i] + 8, NULL, 0);
+        else if ( strncmp(argv[i], "+finish_on=", 11) == 0 )
+            finish_on = argv[i] + 11;
+        else if ( strncmp(argv[i], "+uart_in=", 9) == 0 )
+            uart_in = argv[i] + 9;
+        else if ( strncmp(argv[i], "+mem_file=", 10) == 0 )
+            mem_file = argv[i] + 10;
+        else if ( strncmp(argv[i], "+mem_dump=", 10) == 0 )
+            mem_dump = argv[i] + 10;
+    }
+
+    uart_tail_len = std::max(finish_on.size(), checkpoint->marker_name().size());
+
+    // Restore, or start from reset
+    uint64_t first_cycle = checkpoint->restore();
+    if ( first_cycle == 0 ) {
+        tb->sys_reset_i = 1;
+        tb->eval();
+    }
+
+#ifdef TB_MEM_SPARSE
+    // Opened by the BRAM model at the first eval, or by the restore
+    bram = tb_memory_find(BRAM_SCOPE);
+    if ( bram == NULL ) {
+        printf("ERROR: no sparse memory for %s\n", BRAM_SCOPE);
+        return 1;
+    }
+    if ( mem_file != NULL && first_cycle != 0 )
+        fprintf(stderr, "[WARNING] +mem_file ignored on restore, the memory comes from the checkpoint\n");
+    else if ( mem_file != NULL && !bram->map_file(mem_file) )
+        return 1;
+#else
+    if ( mem_file != NULL || mem_dump != NULL )
+        fprintf(stderr, "[WARNING] +mem_file and +mem_dump need the sparse memory (SIM_MEM=sparse), ignored\n");
+#endif
+
+    // Preload, through the backdoor of the BRAM model, over the restored memory if any
+    svSetScope(svGetScopeFromName(BRAM_SCOPE));
+    if ( elf_file != NULL && load_elf(elf_file) != 0 )
+        return 1;
+    if ( bin_file != NULL && load_bin(bin_file, bin_addr) != 0 )
+        return 1;
+    if ( elf_file == NULL && bin_file == NULL && first_cycle == 0 )
+        fprintf(stderr, "[WARNING] No program to load, use +elf=<file> or +bin=<file>\n");
+
+    svScope socket_scope = svGetScopeFromName(SOCKET_SCOPE);
+
+    printf("Welcome to Verilator Simulation\n\n");
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t cycle;
+    for ( cycle = first_cycle; cycle < cycles && !finished; cycle++ ) {
+        checkpoint->cycle(cycle);
+        tb->sys_reset_i = ( cycle < RESET_CYCLES );
+        axi_perf->cycle(cycle);
+        tick(cycle);
+        if ( profiler->enabled() && profiler->due() ) {
+            svSetScope(socket_scope);
+            profiler->sample(sim_pc_sample());
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("\nSimulated %lu cycles in %.3f s (%.0f cycles/s)\n", (unsigned long) ( cycle - first_cycle ), seconds, ( cycle - first_cycle ) / seconds);
+    if ( first_cycle != 0 )
+        printf("Restored at cycle %lu, ended at cycle %lu\n", (unsigned long) first_cycle, (unsigned long) cycle);
+
+    if ( !finish_on.empty() && !finished )
+        printf("ERROR: \"%s\" not printed in %lu cycles\n", finish_on.c_str(), (unsigned long) cycles);
+
+#ifdef TB_MEM_SPARSE
+    printf("Main memory: %lu of %lu pages touched\n", (unsigned long) bram->pages(),
+            (unsigned long) ( ( bram->size() + TB_MEM_PAGE_SIZE - 1 ) / TB_MEM_PAGE_SIZE ));
+    if ( mem_dump != NULL && bram->dump(mem_dump) )
+        printf("Main memory dumped to %s\n", mem_dump);
+#endif
+
+    profiler->report();
+    axi_perf->report();
+
+    delete axi_perf;
+    delete profiler;
+    delete checkpoint;
+    delete trace;
+    tb->final();
+    delete tb;
+
+    return ( !finish_on.empty() && !finished ) ? 1 : 0;
+}
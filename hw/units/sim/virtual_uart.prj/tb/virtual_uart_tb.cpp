@@ -0,0 +1,624 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart testbench - one char per access vs FIFO burst access
+//              The host and the core share the same AXI-lite slave port, as behind the PBUS.
+//              For each direction (print: core to host, sink: host to core) it moves num_chars
+//              chars of a known pattern, first with the single-char protocol of the original
+//              driver (status read + data access per char), then with the FIFO level and burst
+//              registers, and checks the data.
+//              On the board, each host access is a PCIe round trip (~1 us for reads), far longer
+//              than the cycles spent in the peripheral: the host throughput is estimated from the
+//              number of host accesses and a per-access latency.
+//              Usage: virtual_uart_run [num_chars] [pcie_read_ns] [pcie_write_ns] [+trace plusargs, see tb_trace.h]
+//                                      [+clock plusargs, see tb_clock.h] [+axi_log=<file>]
+//              The AXI-lite accesses go through the master of tb_axi.h, +axi_log logs their handshakes.
+//              Co-simulation: with +cosim=<shm_name>, the testbench serves the host application instead
+//              (bin/virtual_uart -c <shm_name>, see sw/host/virtual_uart/src/cosim.h) and plays the core:
+//                  +cosim=<shm_name>       POSIX shared memory object of the transport, e.g. /vu_cosim
+//                  +cosim_legacy           single-register protocol: FIFO depth reads 0 to the host, the status
+//                                          reports a full register for any char in the FIFO, one char in flight
+//                  +cosim_print=N          the core prints N chars of the pattern, then echoes (default: echo only)
+//                  +cosim_chars=N          stop once the core sent N chars and the host read them all (default: Ctrl-C)
+//              The clock only runs while an access is in flight, so the figures count the bus cycles per char,
+//              not the host idle time. The host accesses are served in batches, as many as queued on all the ports.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <chrono>
+#include "Vvirtual_uart.h"
+#include "verilated.h"
+#include "tb_trace.h"
+#include "tb_clock.h"
+#include "tb_axi.h"
+#include "cosim.h"
+
+#define CLK_MHZ             100     // PBUS clock, unless configured
+#define RESET_CYCLES        10
+
+// Default values
+#define NUM_CHARS           4096
+#define PCIE_READ_NS        1000    // Non-posted, full round trip
+#define PCIE_WRITE_NS       200     // Posted
+
+// Registers, see virtual_uart.sv
+#define RX_REG_OFFSET           0x00
+#define TX_REG_OFFSET           0x04
+#define STS_REG_OFFSET          0x08
+#define CTRL_REG_OFFSET         0x0C
+#define INT_ACK_REG_OFFSET      0x10
+#define FIFO_LEVEL_REG_OFFSET   0x14
+#define FIFO_DEPTH_REG_OFFSET   0x18
+#define RX_BURST_W_OFFSET       0x20
+#define TX_BURST_W_OFFSET       0x24
+#define RX_BURST_R_OFFSET(n)    ( 0x40 + 4 * ( (n) - 1 ) )
+#define TX_BURST_R_OFFSET(n)    ( 0x60 + 4 * ( (n) - 1 ) )
+#define BURST_LEN               4
+
+#define RX_VALID_BIT_MASK   0x01
+#define RX_FULL_BIT_MASK    0x02
+#define TX_EMPTY_BIT_MASK   0x04
+#define TX_FULL_BIT_MASK    0x08
+#define CTRL_RST_TX_BIT_MASK 0x01
+#define CTRL_RST_RX_BIT_MASK 0x02
+
+// Access accounting
+typedef struct {
+    uint64_t host_reads;
+    uint64_t host_writes;
+    uint64_t core_accesses;
+    uint64_t cycles;
+} cost_t;
+
+typedef TbAxiPort<IData, IData, CData, CData> axil_port_t;
+
+static Vvirtual_uart * tb;
+static TbTrace<Vvirtual_uart> * trace = NULL;
+static TbClock * pbus_clk = NULL;
+static TbAxiMaster<axil_port_t> * axil = NULL;
+static cost_t cost;
+
+// Blocking AXI-lite accesses, the clock runs until they complete
+uint32_t axil_read ( uint32_t addr )
+{
+    return axil->read(addr);
+}
+
+void axil_write ( uint32_t addr, uint32_t data, uint8_t strb )
+{
+    axil->write(addr, data, strb);
+}
+
+// Host and core side accessors
+uint32_t host_read ( uint32_t addr )
+{
+    cost.host_reads++;
+    return axil_read(addr);
+}
+
+void host_write ( uint32_t addr, uint32_t data, uint8_t strb )
+{
+    cost.host_writes++;
+    axil_write(addr, data, strb);
+}
+
+uint32_t core_read ( uint32_t addr )
+{
+    cost.core_accesses++;
+    return axil_read(addr);
+}
+
+void core_write ( uint32_t addr, uint32_t data, uint8_t strb )
+{
+    cost.core_accesses++;
+    axil_write(addr, data, strb);
+}
+
+static inline uint8_t pattern ( uint64_t i )
+{
+    return (uint8_t) ( ' ' + ( i % 95 ) );
+}
+
+// Pack k chars of the pattern from i
+static uint32_t pack ( uint64_t i, unsigned int k )
+{
+    uint32_t word = 0;
+    for ( unsigned int j = 0; j < k; j++ )
+        word |= (uint32_t) pattern(i + j) << ( 8 * j );
+    return word;
+}
+
+// Check k chars of the pattern from i, return the mismatches
+static int check ( uint32_t word, uint64_t i, unsigned int k )
+{
+    int errors = 0;
+    for ( unsigned int j = 0; j < k; j++ )
+        errors += ( ( ( word >> ( 8 * j ) ) & 0xFF ) != pattern(i + j) );
+    return errors;
+}
+
+// Print: the core pushes, the host pops. The two sides take turns.
+int run_print ( unsigned int num_chars, int burst, unsigned int depth )
+{
+    uint64_t sent = 0, received = 0;
+    unsigned int level, n, k;
+    uint32_t word;
+    int errors = 0;
+
+    while ( received < num_chars ) {
+        // Core side
+        if ( !burst ) {
+            // One char, once the host got the previous one
+            if ( sent < num_chars && ( core_read(STS_REG_OFFSET) & TX_EMPTY_BIT_MASK ) ) {
+                core_write(TX_REG_OFFSET, pattern(sent), 0x1);
+                sent++;
+            }
+        }
+        else if ( sent < num_chars ) {
+            // Fill up the free space
+            n = depth - ( core_read(FIFO_LEVEL_REG_OFFSET) >> 16 );
+            if ( n > num_chars - sent )
+                n = num_chars - sent;
+            for ( ; n > 0; n -= k, sent += k ) {
+                k = n < BURST_LEN ? n : BURST_LEN;
+                core_write(TX_BURST_W_OFFSET, pack(sent, k), ( 1 << k ) - 1);
+            }
+        }
+
+        // Host side
+        if ( !burst ) {
+            if ( ( host_read(STS_REG_OFFSET) & TX_EMPTY_BIT_MASK ) == 0 ) {
+                errors += check(host_read(TX_REG_OFFSET), received, 1);
+                received++;
+            }
+        }
+        else {
+            // One level read, then drain
+            level = host_read(FIFO_LEVEL_REG_OFFSET) >> 16;
+            for ( ; level > 0; level -= k, received += k ) {
+                k = level < BURST_LEN ? level : BURST_LEN;
+                word = host_read(TX_BURST_R_OFFSET(k));
+                errors += check(word, received, k);
+            }
+        }
+    }
+
+    return errors;
+}
+
+// Sink: the host pushes, the core pops
+int run_sink ( unsigned int num_chars, int burst, unsigned int depth )
+{
+    uint64_t sent = 0, received = 0;
+    unsigned int level, n, k;
+    int errors = 0;
+
+    while ( received < num_chars ) {
+        // Host side
+        if ( !burst ) {
+            if ( sent < num_chars && ( host_read(STS_REG_OFFSET) & RX_FULL_BIT_MASK ) == 0 ) {
+                host_write(RX_REG_OFFSET, pattern(sent), 0x1);
+                sent++;
+            }
+        }
+        else if ( sent < num_chars ) {
+            // One level read, then fill with 4, 2 or 1 lanes per store
+            n = depth - ( host_read(FIFO_LEVEL_REG_OFFSET) & 0xFFFF );
+            if ( n > num_chars - sent )
+                n = num_chars - sent;
+            for ( ; n > 0; n -= k, sent += k ) {
+                k = n >= 4 ? 4 : n >= 2 ? 2 : 1;
+                host_write(RX_BURST_W_OFFSET, pack(sent, k), ( 1 << k ) - 1);
+            }
+        }
+
+        // Core side
+        if ( !burst ) {
+            if ( core_read(STS_REG_OFFSET) & RX_VALID_BIT_MASK ) {
+                errors += check(core_read(RX_REG_OFFSET), received, 1);
+                received++;
+            }
+        }
+        else {
+            level = core_read(FIFO_LEVEL_REG_OFFSET) & 0xFFFF;
+            for ( ; level > 0; level -= k, received += k ) {
+                k = level < BURST_LEN ? level : BURST_LEN;
+                errors += check(core_read(RX_BURST_R_OFFSET(k)), received, k);
+            }
+        }
+    }
+
+    return errors;
+}
+
+// Directed checks: reset values, interrupt, FIFO full and control reset
+int run_directed ( unsigned int depth )
+{
+    int errors = 0;
+
+    errors += ( axil_read(STS_REG_OFFSET) != TX_EMPTY_BIT_MASK );
+    errors += ( axil_read(FIFO_LEVEL_REG_OFFSET) != 0 );
+
+    // A TX push raises the interrupt to the XDMA, the ACK lowers it
+    axil_write(TX_REG_OFFSET, 'a', 0x1);
+    pbus_clk->run_cycles(1);
+    errors += ( tb->int_xdma_o != 1 );
+    axil_write(INT_ACK_REG_OFFSET, 0xFF, 0xF);
+    pbus_clk->run_cycles(1);
+    errors += ( tb->int_xdma_o != 0 );
+    errors += ( ( axil_read(TX_REG_OFFSET) & 0xFF ) != 'a' );
+
+    // Pushes beyond the depth are dropped, pops beyond the level read zero
+    for ( unsigned int i = 0; i < depth + 2; i++ )
+        axil_write(RX_REG_OFFSET, pattern(i), 0x1);
+    errors += ( axil_read(FIFO_LEVEL_REG_OFFSET) != depth );
+    errors += ( ( axil_read(STS_REG_OFFSET) & RX_FULL_BIT_MASK ) == 0 );
+    for ( unsigned int i = 0; i < depth; i += BURST_LEN )
+        errors += check(axil_read(RX_BURST_R_OFFSET(BURST_LEN)), i, BURST_LEN);
+    errors += ( axil_read(RX_BURST_R_OFFSET(BURST_LEN)) != 0 );
+
+    // Control resets, one FIFO at a time
+    axil_write(RX_BURST_W_OFFSET, pack(0, 3), 0x7);
+    axil_write(TX_BURST_W_OFFSET, pack(0, 2), 0x3);
+    errors += ( axil_read(FIFO_LEVEL_REG_OFFSET) != ( 3 | ( 2 << 16 ) ) );
+    axil_write(CTRL_REG_OFFSET, CTRL_RST_RX_BIT_MASK, 0xF);
+    axil_write(CTRL_REG_OFFSET, 0, 0xF);
+    errors += ( axil_read(FIFO_LEVEL_REG_OFFSET) != ( 2 << 16 ) );
+    axil_write(CTRL_REG_OFFSET, CTRL_RST_TX_BIT_MASK, 0xF);
+    axil_write(CTRL_REG_OFFSET, 0, 0xF);
+    errors += ( axil_read(FIFO_LEVEL_REG_OFFSET) != 0 );
+
+    return errors;
+}
+
+///////////////////
+// Co-simulation //
+///////////////////
+
+typedef struct {
+    uint64_t host_reads;
+    uint64_t host_writes;
+    uint64_t batches;
+    uint64_t host_cycles;
+    uint64_t core_cycles;
+    uint64_t to_host;       // Chars pushed by the core
+    uint64_t to_core;       // Chars popped by the core
+} cosim_stats_t;
+
+static volatile sig_atomic_t cosim_stop = 0;
+
+static void cosim_stop_handler ( int sig )
+{
+    (void) sig;
+    cosim_stop = 1;
+}
+
+// Host view of the single-register peripheral: no FIFO depth, a register is full with one char
+static uint32_t cosim_legacy_read ( uint32_t addr, uint32_t data )
+{
+    if ( addr == FIFO_DEPTH_REG_OFFSET )
+        return 0;
+    if ( addr == STS_REG_OFFSET ) {
+        data &= ~( RX_FULL_BIT_MASK | TX_FULL_BIT_MASK );
+        if ( data & RX_VALID_BIT_MASK )
+            data |= RX_FULL_BIT_MASK;
+        if ( ( data & TX_EMPTY_BIT_MASK ) == 0 )
+            data |= TX_FULL_BIT_MASK;
+    }
+    return data;
+}
+
+// Serve the accesses queued on all the ports, in one batch, return their number
+static unsigned int cosim_serve ( cosim_shm_t * shm, int legacy, cosim_stats_t * stats )
+{
+    uint64_t start = pbus_clk->cycles();
+    unsigned int served = 0;
+
+    for ( int i = 0; i < COSIM_NUM_PORTS; i++ ) {
+        cosim_port_t * port = &shm->port[i];
+        uint32_t tail = __atomic_load_n(&port->tail, __ATOMIC_RELAXED);
+        uint32_t head = __atomic_load_n(&port->head, __ATOMIC_ACQUIRE);
+
+        for ( ; tail != head; tail++, served++ ) {
+            cosim_req_t * req = &port->req[tail % COSIM_QUEUE_LEN];
+            if ( req->op == COSIM_OP_WRITE ) {
+                axil_write(req->offset, req->data, req->strb);
+                stats->host_writes++;
+            }
+            else {
+                uint32_t data = axil_read(req->offset);
+                port->rdata = legacy ? cosim_legacy_read(req->offset, data) : data;
+                __atomic_store_n(&port->reads, port->reads + 1, __ATOMIC_RELEASE);
+                stats->host_reads++;
+            }
+        }
+        __atomic_store_n(&port->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    stats->host_cycles += pbus_clk->cycles() - start;
+    return served;
+}
+
+// One poll round of the core: print the pattern first, then echo the received chars.
+// Return the chars moved, tx_level gets the chars left in the TX FIFO.
+static unsigned int cosim_core ( int legacy, unsigned int depth, uint64_t * print_left, cosim_stats_t * stats, unsigned int * tx_level )
+{
+    uint64_t start = pbus_clk->cycles();
+    unsigned int moved = 0;
+    unsigned int rx, space, n, k;
+    uint32_t status, level;
+
+    if ( legacy ) {
+        // One char in flight, once the host got the previous one
+        status = core_read(STS_REG_OFFSET);
+        if ( status & TX_EMPTY_BIT_MASK ) {
+            if ( *print_left > 0 ) {
+                core_write(TX_REG_OFFSET, pattern(stats->to_host), 0x1);
+                (*print_left)--;
+                stats->to_host++;
+                moved++;
+            }
+            else if ( status & RX_VALID_BIT_MASK ) {
+                core_write(TX_REG_OFFSET, core_read(RX_REG_OFFSET) & 0xFF, 0x1);
+                stats->to_core++;
+                stats->to_host++;
+                moved += 2;
+            }
+        }
+        *tx_level = ( ( status & TX_EMPTY_BIT_MASK ) == 0 || moved ) ? 1 : 0;
+    }
+    else {
+        // One level read, then bursts
+        level = core_read(FIFO_LEVEL_REG_OFFSET);
+        rx    = level & 0xFFFF;
+        space = depth - ( level >> 16 );
+
+        n = *print_left < space ? *print_left : space;
+        for ( ; n > 0; n -= k ) {
+            k = n < BURST_LEN ? n : BURST_LEN;
+            core_write(TX_BURST_W_OFFSET, pack(stats->to_host, k), ( 1 << k ) - 1);
+            *print_left -= k;
+            stats->to_host += k;
+            space -= k;
+            moved += k;
+        }
+
+        n = ( *print_left > 0 ) ? 0 : ( rx < space ) ? rx : space;
+        for ( ; n > 0; n -= k ) {
+            k = n < BURST_LEN ? n : BURST_LEN;
+            core_write(TX_BURST_W_OFFSET, core_read(RX_BURST_R_OFFSET(k)), ( 1 << k ) - 1);
+            stats->to_core += k;
+            stats->to_host += k;
+            space -= k;
+            moved += 2 * k;
+        }
+        *tx_level = depth - space;
+    }
+
+    stats->core_cycles += pbus_clk->cycles() - start;
+    return moved;
+}
+
+static void cosim_report ( const cosim_stats_t * stats, int legacy )
+{
+    uint64_t chars = stats->to_host + stats->to_core;
+
+    printf("Co-simulation, %s protocol: %lu chars to the host, %lu chars to the core\n", legacy ? "single-register" : "FIFO burst",
+            (unsigned long) stats->to_host, (unsigned long) stats->to_core);
+    printf("Host accesses: %lu reads, %lu writes, in %lu batches (%.1f accesses/batch)\n",
+            (unsigned long) stats->host_reads, (unsigned long) stats->host_writes, (unsigned long) stats->batches,
+            stats->batches ? (double) ( stats->host_reads + stats->host_writes ) / stats->batches : 0.0);
+    printf("Cycles: %lu host, %lu core, %lu total\n", (unsigned long) stats->host_cycles, (unsigned long) stats->core_cycles,
+            (unsigned long) ( stats->host_cycles + stats->core_cycles ));
+    if ( chars == 0 )
+        return;
+    printf("Per char (either direction): %.2f host reads, %.2f host writes, %.2f host cycles, %.2f core cycles, %.2f cycles\n",
+            (double) stats->host_reads / chars, (double) stats->host_writes / chars,
+            (double) stats->host_cycles / chars, (double) stats->core_cycles / chars,
+            (double) ( stats->host_cycles + stats->core_cycles ) / chars);
+}
+
+// Serve the host application until Ctrl-C, or until stop_chars reached the host
+int run_cosim ( const char * shm_name, int legacy, uint64_t print_chars, uint64_t stop_chars, unsigned int depth )
+{
+    cosim_stats_t stats;
+    cosim_shm_t * shm;
+    uint64_t print_left = print_chars;
+    unsigned int tx_level = 0;
+    unsigned int served, moved = 1;
+    unsigned int idle = 0;
+    int fd;
+
+    fd = shm_open(shm_name, O_CREAT | O_RDWR, 0600);
+    if ( fd == -1 || ftruncate(fd, sizeof(cosim_shm_t)) != 0 ) {
+        printf("ERROR: cannot create shared memory %s\n", shm_name);
+        return 1;
+    }
+    shm = (cosim_shm_t *) mmap(NULL, sizeof(cosim_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if ( shm == MAP_FAILED ) {
+        printf("ERROR: cannot map shared memory %s\n", shm_name);
+        shm_unlink(shm_name);
+        return 1;
+    }
+
+    // Publish the transport, magic last
+    memset(shm, 0, sizeof(cosim_shm_t));
+    memset(&stats, 0, sizeof(stats));
+    shm->running = 1;
+    __atomic_store_n(&shm->magic, COSIM_MAGIC, __ATOMIC_RELEASE);
+
+    signal(SIGINT, cosim_stop_handler);
+    signal(SIGTERM, cosim_stop_handler);
+    printf("Co-simulation on %s, %s protocol, run the host application with -c %s\n", shm_name, legacy ? "single-register" : "FIFO burst", shm_name);
+    fflush(stdout);
+
+    while ( !cosim_stop ) {
+        served = cosim_serve(shm, legacy, &stats);
+        stats.batches += ( served != 0 );
+
+        // The core polls after the host accesses, and again as long as it makes progress
+        if ( served || moved )
+            moved = cosim_core(legacy, depth, &print_left, &stats, &tx_level);
+        __atomic_store_n(&shm->cycles, pbus_clk->cycles(), __ATOMIC_RELAXED);
+
+        if ( stop_chars && stats.to_host >= stop_chars && tx_level == 0 )
+            break;
+
+        // Nothing to simulate: wait for the host, the clock stands still
+        if ( served == 0 && moved == 0 ) {
+            if ( ++idle > 1024 )
+                sched_yield();
+        }
+        else
+            idle = 0;
+    }
+
+    __atomic_store_n(&shm->running, 0, __ATOMIC_RELEASE);
+    cosim_report(&stats, legacy);
+    munmap(shm, sizeof(cosim_shm_t));
+    shm_unlink(shm_name);
+    return 0;
+}
+
+void report ( const char * name, const char * mode, unsigned int num_chars, unsigned int read_ns, unsigned int write_ns, double * host_ns, int errors )
+{
+    *host_ns = (double) cost.host_reads * read_ns + (double) cost.host_writes * write_ns;
+    printf("%-6s %-6s %10.2f %10.2f %10.2f %10.2f %12.1f %7d\n", name, mode,
+            (double) cost.host_reads / num_chars,
+            (double) cost.host_writes / num_chars,
+            (double) cost.core_accesses / num_chars,
+            (double) cost.cycles / num_chars,
+            num_chars / ( *host_ns / 1e9 ) / 1e3,
+            errors
+        );
+}
+
+static void close_monitor ( TbAxiMonitor<axil_port_t> * monitor, FILE * log )
+{
+    if ( monitor == NULL )
+        return;
+    monitor->report();
+    delete monitor;
+    fclose(log);
+}
+
+int main ( int argc, char **argv )
+{
+    const char * args [3];
+    int nargs = 0;
+    unsigned int num_chars;
+    unsigned int read_ns;
+    unsigned int write_ns;
+    const char * names [] = { "print", "sink" };
+    double host_ns [2][2];
+    const char * cosim_shm = NULL;
+    const char * axi_log = NULL;
+    FILE * axi_log_file = NULL;
+    int cosim_legacy = 0;
+    uint64_t cosim_print = 0;
+    uint64_t cosim_chars = 0;
+    unsigned int depth;
+    uint64_t start;
+    int errors = 0;
+    int ret;
+
+    // Positional arguments, the plusargs are for the tracer and the co-simulation
+    for ( int i = 1; i < argc; i++ ) {
+        if ( argv[i][0] != '+' ) {
+            if ( nargs < 3 )
+                args[nargs++] = argv[i];
+        }
+        else if ( strncmp(argv[i], "+cosim=", 7) == 0 )
+            cosim_shm = argv[i] + 7;
+        else if ( strcmp(argv[i], "+cosim_legacy") == 0 )
+            cosim_legacy = 1;
+        else if ( strncmp(argv[i], "+cosim_print=", 13) == 0 )
+            cosim_print = strtoull(argv[i] + 13, NULL, 0);
+        else if ( strncmp(argv[i], "+cosim_chars=", 13) == 0 )
+            cosim_chars = strtoull(argv[i] + 13, NULL, 0);
+        else if ( strncmp(argv[i], "+axi_log=", 9) == 0 )
+            axi_log = argv[i] + 9;
+    }
+    num_chars = ( nargs > 0 ) ? atoi(args[0]) : NUM_CHARS;
+    read_ns   = ( nargs > 1 ) ? atoi(args[1]) : PCIE_READ_NS;
+    write_ns  = ( nargs > 2 ) ? atoi(args[2]) : PCIE_WRITE_NS;
+
+    Verilated::commandArgs(argc, argv);
+    tb = new Vvirtual_uart;
+    trace = new TbTrace<Vvirtual_uart>(tb, argc, argv);
+    trace->add_trigger("int_core", []() { return tb->int_core_o != 0; });
+    trace->add_trigger("rx_full", []() { return tb->s_axilite_rvalid && tb->s_axilite_araddr == STS_REG_OFFSET && ( tb->s_axilite_rdata & RX_FULL_BIT_MASK ); });
+
+    // PBUS clock, idle bus and reset
+    TbClockConfig clock_config(argc, argv);
+    TbScheduler<Vvirtual_uart> scheduler(tb, trace);
+    pbus_clk = scheduler.add_clock("PBUS", &tb->clock_i, clock_config.mhz("PBUS", CLK_MHZ));
+    TB_AXILITE_PORT(port, tb, s);
+    axil = new TbAxiMaster<axil_port_t>(pbus_clk, port);
+    TbAxiMonitor<axil_port_t> * monitor = NULL;
+    if ( axi_log != NULL ) {
+        axi_log_file = fopen(axi_log, "w");
+        if ( axi_log_file == NULL )
+            fprintf(stderr, "[WARNING] Cannot open %s, no AXI log\n", axi_log);
+        else
+            monitor = new TbAxiMonitor<axil_port_t>(pbus_clk, port, "s_axilite", axi_log_file);
+    }
+    tb->int_ack_i = 0;
+    TbReset reset(pbus_clk, &tb->reset_ni, true, RESET_CYCLES);
+    auto t_start = std::chrono::steady_clock::now();
+    reset.wait();
+
+    depth = axil_read(FIFO_DEPTH_REG_OFFSET);
+
+    // Co-simulation with the host application instead of the benchmark
+    if ( cosim_shm != NULL ) {
+        errors = run_cosim(cosim_shm, cosim_legacy, cosim_print, cosim_chars, depth);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        printf("Simulated %lu cycles in %.3f s\n", (unsigned long) pbus_clk->cycles(), seconds);
+        close_monitor(monitor, axi_log_file);
+        delete axil;
+        delete trace;
+        tb->final();
+        delete tb;
+        return errors;
+    }
+
+    printf("Virtual uart: FIFO depth %u, %u chars, host read %u ns, host write %u ns\n", depth, num_chars, read_ns, write_ns);
+
+    ret = run_directed(depth);
+    printf("Directed checks: %d errors\n", ret);
+    errors += ret;
+
+    printf("%-6s %-6s %10s %10s %10s %10s %12s %7s\n", "", "access", "host rd/c", "host wr/c", "core acc/c", "cycles/c", "host KB/s", "errors");
+    for ( int dir = 0; dir < 2; dir++ ) {
+        for ( int burst = 0; burst <= 1; burst++ ) {
+            memset(&cost, 0, sizeof(cost));
+            start = pbus_clk->cycles();
+            ret = ( dir == 0 ) ? run_print(num_chars, burst, depth) : run_sink(num_chars, burst, depth);
+            cost.cycles = pbus_clk->cycles() - start;
+            report(names[dir], burst ? "burst" : "char", num_chars, read_ns, write_ns, &host_ns[dir][burst], ret);
+            errors += ret;
+        }
+    }
+    printf("Estimated host speedup: print %.1fx, sink %.1fx\n", host_ns[0][0] / host_ns[0][1], host_ns[1][0] / host_ns[1][1]);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    printf("Simulated %lu cycles in %.3f s (%.0f cycles/s)\n", (unsigned long) pbus_clk->cycles(), seconds, pbus_clk->cycles() / seconds);
+    scheduler.report();
+    errors += axil->errors();
+
+    close_monitor(monitor, axi_log_file);
+    delete axil;
+    delete trace;
+    tb->final();
+    delete tb;
+
+    printf(errors ? "Test failed :(\n" : "Test passed\n");
+    return errors ? 1 : 0;
+}
@@ -17,6 +17,7 @@ set_property -dict [list \
   CONFIG.pl_link_cap_max_link_width {X8} \
   CONFIG.ref_clk_freq {100_MHz} \
   CONFIG.pciebar2axibar_0 {0x000000000000000} \
+  CONFIG.xdma_num_usr_irq {1} \
 ] [get_ips $::env(IP_NAME)]
 
 # NOTE: The safe (and adopted) maximum BAR size is 32 MB on the MSI Z590 PLUS (MS-7D11) motherboard,
@@ -16,25 +16,102 @@ XILINX_SCRIPTS_LOAD_ROOT := ${XILINX_SCRIPT_ROOT}/load_binary
 
 # Path to target binary
 BIN_PATH ?= ${SW_ROOT}/SoC/examples/blinky/bin/blinky.bin
+# Path to target elf (load_elf_hpc and the debugger flows)
+ELF_PATH ?= ${SW_ROOT}/SoC/examples/blinky/bin/blinky.elf
 # BRAM base address
 BASE_ADDRESS ?= 0x00000000
 # Whether to readback and check the loaded binary or not
 LOAD_BINARY_READBACK ?= false
+# Delta reload: only write the 4 KiB pages changed since the last binary loaded on this board at BASE_ADDRESS.
+# The page hashes are cached in LOAD_BINARY_CACHE_DIR, programming the bitstream clears the cache.
+LOAD_BINARY_DELTA ?= false
+LOAD_BINARY_CACHE_DIR ?= ${XILINX_PROJECT_BUILD_DIR}/load_binary_cache
+# Delta reload only: check the skipped pages on the device, as the SoC may have written them since the last load.
+# Full read-back for hpc, one word every LOAD_BINARY_VERIFY_STRIDE bytes for embedded.
+LOAD_BINARY_VERIFY ?= false
+LOAD_BINARY_VERIFY_STRIDE ?= 256
+
+# XDMA loader host application, also plans the delta reloads of the embedded flow
+XDMA_LOADER_PATH ?= ${SW_HOST_ROOT}/xdma_loader
+XDMA_LOADER      ?= ${XDMA_LOADER_PATH}/bin/xdma_loader
+# Delta reload flags
+LOAD_BINARY_DELTA_FLAGS ?= -k ${LOAD_BINARY_CACHE_DIR} -K ${BOARD}
+LOAD_BINARY_PLAN ?= ${LOAD_BINARY_CACHE_DIR}/plan.txt
 
 # Load the binary into SoC memory (BRAM for now)
 # Call the specific load script based on the SOC_CONFIG (HPC or EMBEDDED)
 load_binary: load_binary_${SOC_CONFIG}
 
 # Write the binary to BRAM through jtag2axi
+ifeq (${LOAD_BINARY_DELTA},true)
+# Plan the ranges to write, load them, then trust the new cache
+ifeq (${LOAD_BINARY_VERIFY},true)
+JTAG2AXI_VERIFY_STRIDE = ${LOAD_BINARY_VERIFY_STRIDE}
+else
+JTAG2AXI_VERIFY_STRIDE = 0
+endif
+load_binary_embedded: ${BIN_PATH} ${XDMA_LOADER}
+	${XDMA_LOADER} ${LOAD_BINARY_DELTA_FLAGS} -p ${LOAD_BINARY_PLAN} ${BIN_PATH} ${BASE_ADDRESS}
+	${XILINX_VIVADO} \
+		-source ${XILINX_SCRIPT_ROOT}/utils/open_hw_manager.tcl \
+		-source ${XILINX_SCRIPTS_LOAD_ROOT}/jtag2axi_load_binary.tcl \
+		-tclargs ${BIN_PATH} ${BASE_ADDRESS} ${LOAD_BINARY_READBACK} ${LOAD_BINARY_PLAN} ${JTAG2AXI_VERIFY_STRIDE}
+	${XDMA_LOADER} ${LOAD_BINARY_DELTA_FLAGS} -C ${BIN_PATH} ${BASE_ADDRESS}
+else
 load_binary_embedded: ${BIN_PATH}
 	${XILINX_VIVADO} \
 		-source ${XILINX_SCRIPT_ROOT}/utils/open_hw_manager.tcl \
 		-source ${XILINX_SCRIPTS_LOAD_ROOT}/jtag2axi_load_binary.tcl \
 		-tclargs ${BIN_PATH} ${BASE_ADDRESS} ${LOAD_BINARY_READBACK}
+endif
+# Host physical address of the XDMA BAR, i.e. of SoC address 0x0
+XDMA_BAR_ADDRESS ?= 0x0
+# Optional XDMA H2C/C2H character devices (e.g. /dev/xdma0_h2c_0), the BAR is mapped if empty
+XDMA_H2C_DEV     ?=
+XDMA_C2H_DEV     ?=
+# Loader flags
+XDMA_LOADER_FLAGS ?= -b ${XDMA_BAR_ADDRESS}
+ifneq (${XDMA_H2C_DEV},)
+XDMA_LOADER_FLAGS += -x ${XDMA_H2C_DEV}
+endif
+ifneq (${XDMA_C2H_DEV},)
+XDMA_LOADER_FLAGS += -X ${XDMA_C2H_DEV}
+endif
+ifeq (${LOAD_BINARY_READBACK},true)
+XDMA_LOADER_FLAGS += -r
+endif
+ifeq (${LOAD_BINARY_DELTA},true)
+XDMA_LOADER_FLAGS += ${LOAD_BINARY_DELTA_FLAGS}
+ifeq (${LOAD_BINARY_VERIFY},true)
+XDMA_LOADER_FLAGS += -v
+endif
+endif
+
+${XDMA_LOADER}:
+	${MAKE} -C ${XDMA_LOADER_PATH}
 
 # Write the binary to BRAM/DDR through XDMA
-load_binary_hpc: ${BIN_PATH}
-	@bash -c "source ${XILINX_SCRIPTS_LOAD_ROOT}/xdma_load_binary.sh ${BIN_PATH} ${BASE_ADDRESS} ${LOAD_BINARY_READBACK}"
+load_binary_hpc: ${BIN_PATH} ${XDMA_LOADER}
+	sudo ${XDMA_LOADER} ${XDMA_LOADER_FLAGS} ${BIN_PATH} ${BASE_ADDRESS}
+
+# Write the PT_LOAD segments of ELF_PATH at their physical address through XDMA, with no flat image in between.
+# Additional H2C channels (e.g. /dev/xdma0_h2c_1) write independent segments in parallel.
+XDMA_H2C_EXTRA_DEVS ?=
+# Whether to clear the zero-filled tail of the segments (.bss), or leave it to the C runtime
+LOAD_ELF_CLEAR_BSS ?= true
+LOAD_ELF_FLAGS ?= -b ${XDMA_BAR_ADDRESS} $(addprefix -x ,${XDMA_H2C_DEV} ${XDMA_H2C_EXTRA_DEVS})
+ifneq (${XDMA_C2H_DEV},)
+LOAD_ELF_FLAGS += -X ${XDMA_C2H_DEV}
+endif
+ifeq (${LOAD_BINARY_READBACK},true)
+LOAD_ELF_FLAGS += -r
+endif
+ifneq (${LOAD_ELF_CLEAR_BSS},true)
+LOAD_ELF_FLAGS += -z
+endif
+
+load_elf_hpc: ${ELF_PATH} ${XDMA_LOADER}
+	sudo ${XDMA_LOADER} ${LOAD_ELF_FLAGS} ${ELF_PATH}
 
 ######################
 # Load ELF - Backend #
@@ -43,9 +120,6 @@ load_binary_hpc: ${BIN_PATH}
 # To load a program as an .elf, a Debug Module must be available
 # Depending on the selected CPU, two backends flows are supported
 
-# Path to target elf
-ELF_PATH ?= ${SW_ROOT}/SoC/examples/blinky/bin/blinky.elf
-
 # Use XSDB as a backend
 XSDB ?= xsdb
 # 32-bit RISC-V port exposed by Vivado HW Server is 3004, while it is 3005 for 64_bit
@@ -76,4 +150,4 @@ gdb_run:
 # PHONIES #
 ###########
 
-.PHONY: load_binary load_binary_embedded load_binary_hpc xsdb_run openocd_run gdb_run
+.PHONY: load_binary load_binary_embedded load_binary_hpc load_elf_hpc xsdb_run openocd_run gdb_run
@@ -13,6 +13,13 @@ ${XILINX_IPS_ROOT}/%/questa/compile.do: ${XILINX_SIM_IP_ROOT}
 ${XILINX_SIM_IP_ROOT}/ips:
 	mkdir -p $@
 
+# Verilator model of the embedded SoC, see hw/units/sim/uninasoc.prj
+# e.g. make sim_verilator ELF=<file>
+sim_verilator:
+	${MAKE} -C ${HW_UNITS_ROOT}/sim/uninasoc.prj
+
+sim_verilator_clean:
+	${MAKE} -C ${HW_UNITS_ROOT}/sim/uninasoc.prj clean clean_gen
 
 # PHONIES
-.PHONY: sim_compile_simlib
+.PHONY: sim_compile_simlib sim_verilator sim_verilator_clean
@@ -50,7 +50,9 @@ vio_%:
 program_bitstream: program_bitstream_${SOC_CONFIG}
 
 # Program bitstream for embedded profile
+# The memory content is lost, so is the delta reload cache
 program_bitstream_embedded:
+	rm -rf ${LOAD_BINARY_CACHE_DIR}
 	${XILINX_VIVADO} \
 		-source ${XILINX_SCRIPTS_UTILS_ROOT}/open_hw_manager.tcl \
 		-source ${XILINX_SCRIPTS_UTILS_ROOT}/program_bitstream.tcl
@@ -61,6 +63,8 @@ program_bitstream_hpc:
 #	Kill pending virtual_uart instances (if any)
 #	TODO: This might be overkill, as only that one instance should cause problems 
 	-killall virtual_uart 
+#	The memory content is lost, so is the delta reload cache
+	rm -rf ${LOAD_BINARY_CACHE_DIR}
 #	Program
 	${XILINX_VIVADO} \
 		-source ${XILINX_SCRIPTS_UTILS_ROOT}/open_hw_manager.tcl \
@@ -62,7 +62,11 @@ module peripheral_bus #(
     output logic [GPIO_OUT_WIDTH -1 : 0]  gpio_out_o,
 
     // Interrupts
-    output logic [NUM_IRQ - 1 : 0]      int_o
+    output logic [NUM_IRQ - 1 : 0]      int_o,
+
+    // HPC ONLY
+    // Virtual UART interrupt to the XDMA (PBUS clock domain)
+    output logic                        int_xdma_o
 
 );
 
@@ -455,7 +459,7 @@ module peripheral_bus #(
         .clock_i        ( PBUS_clock_i              ), // input wire s_axi_aclk
         .reset_ni       ( PBUS_reset_ni             ), // input wire s_axi_aresetn
         .int_core_o     ( uart_int                  ), // Output interrupt
-        .int_xdma_o     (                           ), // TBD
+        .int_xdma_o     ( int_xdma_o                ), // Output interrupt to the host (HPC only)
         .int_ack_i      ( '0                        ), // TBD
 
         // EMBEDDED ONLY
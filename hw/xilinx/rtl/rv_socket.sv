@@ -230,6 +230,12 @@ module rv_socket # (
             //      Ibex        //
             //////////////////////
 
+        `ifdef RVFI
+            // Retired instructions, for the PC-sampling profiler (simulation only)
+            logic        sim_retire_valid;
+            logic [31:0] sim_retire_pc;
+        `endif
+
             custom_ibex ibex_core (
                 // Clock and Reset
                 .clk_i                  ( clk_i ),
@@ -266,6 +272,11 @@ module rv_socket # (
                 .irq_fast_i             ( '0 ),
                 .irq_nm_i               ( '0 ),
 
+            `ifdef RVFI
+                .rvfi_valid             ( sim_retire_valid ),
+                .rvfi_pc_rdata          ( sim_retire_pc    ),
+            `endif
+
                 .debug_req_i            ( debug_req_core )
 
             );
@@ -694,6 +705,68 @@ module rv_socket # (
         );
     end
 
+`ifdef VERILATOR
+    //////////////////////////////////
+    // Simulation-only PC sampling  //
+    //////////////////////////////////
+
+    // PC read by the PC-sampling profiler of the Verilator testbench (hw/units/sim/uninasoc.prj) every few cycles.
+    // Ibex (with RVFI, defined by the SoC model): PC of the last retired instruction, from its RVFI port.
+    // The other cores: PC of the last instruction returned by the fetch port, as a fallback. It is exact on PicoRV32
+    // (no pipeline, no speculative fetch), while on CV32E40P it leads the retired PC by the instructions in the
+    // pipeline and includes the fetches discarded after taken branches (v1.8.3 has no retire port on its top).
+    localparam int unsigned SIM_FETCH_DEPTH = 4;
+    logic [LOCAL_ADDR_WIDTH-1:0]        sim_fetch_addr [SIM_FETCH_DEPTH];
+    logic [$clog2(SIM_FETCH_DEPTH)-1:0] sim_fetch_wptr;
+    logic [$clog2(SIM_FETCH_DEPTH)-1:0] sim_fetch_rptr;
+    logic [LOCAL_ADDR_WIDTH-1:0]        sim_pc;
+    logic                               sim_retire_valid;
+    logic [31:0]                        sim_retire_pc;
+
+`ifdef RVFI
+    localparam bit SIM_RETIRE = ( CORE_SELECTOR == CORE_IBEX );
+`else
+    localparam bit SIM_RETIRE = 1'b0;
+`endif
+
+    if ( SIM_RETIRE ) begin : sim_retire_rvfi
+        assign sim_retire_valid = core_ibex.sim_retire_valid;
+        assign sim_retire_pc    = core_ibex.sim_retire_pc;
+    end
+    else begin : sim_retire_none
+        assign sim_retire_valid = 1'b0;
+        assign sim_retire_pc    = '0;
+    end
+
+    always_ff @(posedge clk_i or negedge core_resetn_internal) begin
+        if ( !core_resetn_internal ) begin
+            sim_fetch_wptr <= '0;
+            sim_fetch_rptr <= '0;
+            sim_pc         <= '0;
+        end
+        else begin
+            // Addresses of the fetches in flight, in order
+            if ( core_instr_mem_req && core_instr_mem_gnt ) begin
+                sim_fetch_addr[sim_fetch_wptr] <= core_instr_mem_addr;
+                sim_fetch_wptr                 <= sim_fetch_wptr + 1;
+            end
+            if ( core_instr_mem_valid ) begin
+                sim_fetch_rptr <= sim_fetch_rptr + 1;
+                if ( !SIM_RETIRE )
+                    sim_pc     <= sim_fetch_addr[sim_fetch_rptr];
+            end
+            if ( SIM_RETIRE && sim_retire_valid )
+                sim_pc         <= LOCAL_ADDR_WIDTH'(sim_retire_pc);
+        end
+    end
+
+    export "DPI-C" function sim_pc_sample;
+
+    function longint unsigned sim_pc_sample ();
+        return 64'(sim_pc);
+    endfunction
+`endif
+
     ///////////////////////////////////
     //    ___  ___ ___ _   _  ___    //
     //   |   \| __| _ ) | | |/ __|   //
@@ -58,6 +58,8 @@ module sys_master # (
     input logic pcie_resetn_i,
     // PCIe interface
     `DEFINE_PCIE_PORTS,
+    // User interrupt to the host (any clock domain)
+    input logic xdma_usr_irq_i,
 
     // Output clks
     output logic clk_10MHz_o,
@@ -205,6 +207,19 @@ module sys_master # (
         .clk_10   ( clk_10MHz_o  )
     );
 
+    // User interrupt synchronizer to the XDMA clock domain
+    logic xdma_usr_irq_sync;
+
+    xpm_cdc_single #(
+        .DEST_SYNC_FF   ( 4 ),  // Number of sync flip-flops
+        .SRC_INPUT_REG  ( 0 )   // The source is already a register
+    ) xpm_cdc_usr_irq_u (
+        .src_clk        ( 1'b0              ),
+        .src_in         ( xdma_usr_irq_i    ),
+        .dest_clk       ( axi_aclk          ),
+        .dest_out       ( xdma_usr_irq_sync )
+    );
+
     // XDMA Master
     xlnx_xdma xlnx_xdma_u (
         // Input clock and reset
@@ -223,7 +238,8 @@ module sys_master # (
         .pci_exp_txp  ( pci_exp_txp_o ),
 
         // Interrupts interface
-        .usr_irq_req    ( 0      ),
+        .usr_irq_req    ( xdma_usr_irq_sync ),
+        .usr_irq_ack    (                   ),
 
         // AXI Master
         .m_axib_awid     ( xdma_to_axi_dwidth_converter_axi_awid    ),
@@ -121,6 +121,9 @@ module uninasoc (
     // Peripheral bus interrupts
     logic [peripherals_interrupts_num-1:0] pbus_int_line;
 
+    // Virtual UART interrupt to the host (HPC ONLY)
+    logic uart_int_xdma;
+
     /////////////////////////////////////////
     // Buses declaration and concatenation //
     /////////////////////////////////////////
@@ -253,6 +256,8 @@ module uninasoc (
         .pci_exp_rxp_i(pci_exp_rxp_i),
         .pci_exp_txn_o(pci_exp_txn_o),
         .pci_exp_txp_o(pci_exp_txp_o),
+        // User interrupt to the host
+        .xdma_usr_irq_i(uart_int_xdma),
 
         // Output clocks
         .clk_10MHz_o(clk_10MHz),
@@ -629,6 +634,7 @@ module uninasoc (
         .gpio_in_i      ( gpio_in_i      ),
 
         .int_o          ( pbus_int_line  ),
+        .int_xdma_o     ( uart_int_xdma  ),
 
         .s_axi_awid     ( MBUS_to_PBUS_axi_awid     ),
         .s_axi_awaddr   ( MBUS_to_PBUS_axi_awaddr   ),
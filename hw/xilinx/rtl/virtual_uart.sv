@@ -1,5 +1,9 @@
 // Author: Manuel Maddaluno <manuel.maddaluno@unina.it>
 // Description: Virtual Uart - This module simulates the physical uart connected to XDMA through AXI lite
+//              The RX (host to core) and TX (core to host) registers are backed by FIFO_DEPTH-deep FIFOs.
+//              Besides the single-char uartlite-like registers, burst registers move up to
+//              LOCAL_DATA_WIDTH/8 chars per access, so that each side can drain or fill the FIFOs
+//              with one level read and few data accesses, instead of a status read and a data access per char.
 
 
 // Import packages
@@ -12,7 +16,8 @@ import uninasoc_pkg::*;
 module virtual_uart # (
     parameter int unsigned    LOCAL_DATA_WIDTH  = 32,
     parameter int unsigned    LOCAL_ADDR_WIDTH  = 32,
-    parameter int unsigned    LOCAL_ID_WIDTH    = 32
+    parameter int unsigned    LOCAL_ID_WIDTH    = 32,
+    parameter int unsigned    FIFO_DEPTH        = 32    // Chars per FIFO, power of 2
 ) (
     input logic clock_i,
     input logic reset_ni,
@@ -30,27 +35,53 @@ module virtual_uart # (
 
 
     // Uart CSR - for more details see PG142
-    // 0 - 00h - RX register
-    // 1 - 04h - TX register
-    // 2 - 08h - Status register
-    // 3 - 0Ch - Control register
-    // 4 - 10h - ACK from the host interrupt
+    // 00h - RX register            - W: host pushes a char, R: core pops a char
+    // 04h - TX register            - W: core pushes a char, R: host pops a char
+    // 08h - Status register
+    // 0Ch - Control register
+    // 10h - ACK from the host interrupt
+    // 14h - FIFO level register    - RO: [15:0] RX FIFO level, [31:16] TX FIFO level
+    // 18h - FIFO depth register    - RO: FIFO_DEPTH
+    // 20h - RX burst write         - W: host pushes the chars in the enabled byte lanes (contiguous, from lane 0)
+    // 24h - TX burst write         - W: core pushes the chars in the enabled byte lanes (contiguous, from lane 0)
+    // 40h + 4*(n-1) - RX burst read - R: core pops n chars, packed from byte 0, n = 1..BURST_LEN
+    // 60h + 4*(n-1) - TX burst read - R: host pops n chars, packed from byte 0, n = 1..BURST_LEN
     localparam RX_REG           = 0;
     localparam TX_REG           = 1;
     localparam STATUS_REG       = 2;
     localparam CONTROL_REG      = 3;
     localparam HOST_INT_ACK_REG = 4;
+    localparam FIFO_LEVEL_REG   = 5;
+    localparam FIFO_DEPTH_REG   = 6;
+    localparam RX_BURST_W_REG   = 8;
+    localparam TX_BURST_W_REG   = 9;
+    localparam RX_BURST_R_REG   = 16;   // Up to 8 registers
+    localparam TX_BURST_R_REG   = 24;   // Up to 8 registers
 
     // Control/status register bit position
-    localparam CTRL_RST_TX_BIT  = 0;     // Control - Reset TX register
-    localparam CTRL_RST_RX_BIT  = 0;     // Control - Reset RX register
+    localparam CTRL_RST_TX_BIT  = 0;     // Control - Reset TX FIFO
+    localparam CTRL_RST_RX_BIT  = 1;     // Control - Reset RX FIFO
     localparam CTRL_STS_INT_BIT = 4;     // Control and status - Interrupt enable
-    localparam STS_RX_VALID_BIT = 0;     // Status  - RX register valid
-    localparam STS_RX_FULL_BIT  = 1;     // Status  - RX register full
-    localparam STS_TX_EMPTY_BIT = 2;     // Status  - TX register empty
-    localparam STS_TX_FULL_BIT  = 3;     // Status  - TX register full
+    localparam STS_RX_VALID_BIT = 0;     // Status  - RX FIFO not empty
+    localparam STS_RX_FULL_BIT  = 1;     // Status  - RX FIFO full
+    localparam STS_TX_EMPTY_BIT = 2;     // Status  - TX FIFO empty
+    localparam STS_TX_FULL_BIT  = 3;     // Status  - TX FIFO full
 
-    logic [LOCAL_DATA_WIDTH-1:0] uart_csr [0:4];
+    // Chars per burst access
+    localparam int unsigned BURST_LEN   = LOCAL_DATA_WIDTH / 8;
+    localparam int unsigned PTR_WIDTH   = $clog2(FIFO_DEPTH);
+    localparam int unsigned CNT_WIDTH   = PTR_WIDTH + 1;
+    localparam int unsigned BURST_WIDTH = $clog2(BURST_LEN + 1);
+
+    // Register index (word address), as wide as the register localparams
+    int unsigned wr_reg, rd_reg;
+    assign wr_reg = 32'(s_axilite_awaddr[6:2]);
+    assign rd_reg = 32'(s_axilite_araddr[6:2]);
+
+    // Handshakes
+    logic wr_en, rd_en;
+    assign wr_en = s_axilite_wvalid && s_axilite_wready && s_axilite_awvalid && s_axilite_awready;
+    assign rd_en = s_axilite_arvalid && s_axilite_arready;
 
 
     /* AXILITE Write logic */
@@ -70,7 +101,7 @@ module virtual_uart # (
             s_axilite_bresp  <= 2'b00;
         end
         else begin
-            if ( s_axilite_wvalid && s_axilite_wready && s_axilite_awvalid && s_axilite_awready ) begin
+            if ( wr_en ) begin
                 s_axilite_bvalid <= 1'b1;
                 s_axilite_bresp  <= 2'b00;
 
@@ -84,12 +115,187 @@ module virtual_uart # (
     end
 
 
+    //////////////////
+    // FIFOs        //
+    //////////////////
+
+    // Storage and pointers
+    logic [7:0]             rx_fifo [FIFO_DEPTH];
+    logic [7:0]             tx_fifo [FIFO_DEPTH];
+    logic [PTR_WIDTH-1:0]   rx_wr_ptr, rx_rd_ptr;
+    logic [PTR_WIDTH-1:0]   tx_wr_ptr, tx_rd_ptr;
+    logic [CNT_WIDTH-1:0]   rx_count,  tx_count;
+
+    // Chars pushed/popped in this cycle
+    logic [BURST_WIDTH-1:0] rx_push_n, rx_pop_n;
+    logic [BURST_WIDTH-1:0] tx_push_n, tx_pop_n;
+    logic [LOCAL_DATA_WIDTH-1:0] push_data;
+
+    // Control register
+    logic [LOCAL_DATA_WIDTH-1:0] ctrl_reg;
+    logic rst_rx, rst_tx;
+
+    // Number of enabled byte lanes
+    function automatic logic [BURST_WIDTH-1:0] count_lanes ( input logic [BURST_LEN-1:0] strb );
+        count_lanes = '0;
+        for ( int i = 0; i < BURST_LEN; i++ )
+            count_lanes += BURST_WIDTH'(strb[i]);
+    endfunction
+
+    // Chars available for a pop of n (never pop more than the level)
+    function automatic logic [BURST_WIDTH-1:0] clip_pop ( input logic [BURST_WIDTH-1:0] n, input logic [CNT_WIDTH-1:0] count );
+        clip_pop = ( CNT_WIDTH'(n) > count ) ? BURST_WIDTH'(count) : n;
+    endfunction
+
+    // Chars that fit for a push of n (drop the exceeding ones)
+    function automatic logic [BURST_WIDTH-1:0] clip_push ( input logic [BURST_WIDTH-1:0] n, input logic [CNT_WIDTH-1:0] count );
+        clip_push = ( CNT_WIDTH'(n) > CNT_WIDTH'(FIFO_DEPTH) - count ) ? BURST_WIDTH'(CNT_WIDTH'(FIFO_DEPTH) - count) : n;
+    endfunction
+
+    always_comb begin
+        rx_push_n = '0;
+        tx_push_n = '0;
+        rx_pop_n  = '0;
+        tx_pop_n  = '0;
+        push_data = s_axilite_wdata;
+        rst_rx    = 1'b0;
+        rst_tx    = 1'b0;
+
+        // Pushes
+        if ( wr_en ) begin
+            case ( wr_reg )
+                RX_REG         : rx_push_n = clip_push(BURST_WIDTH'(1), rx_count);
+                TX_REG         : tx_push_n = clip_push(BURST_WIDTH'(1), tx_count);
+                RX_BURST_W_REG : rx_push_n = clip_push(count_lanes(s_axilite_wstrb[BURST_LEN-1:0]), rx_count);
+                TX_BURST_W_REG : tx_push_n = clip_push(count_lanes(s_axilite_wstrb[BURST_LEN-1:0]), tx_count);
+                CONTROL_REG    : begin
+                    rst_tx = s_axilite_wdata[CTRL_RST_TX_BIT];
+                    rst_rx = s_axilite_wdata[CTRL_RST_RX_BIT];
+                end
+                default        : ;
+            endcase
+        end
+
+        // Pops
+        if ( rd_en ) begin
+            if ( rd_reg == RX_REG )
+                rx_pop_n = clip_pop(BURST_WIDTH'(1), rx_count);
+            else if ( rd_reg == TX_REG )
+                tx_pop_n = clip_pop(BURST_WIDTH'(1), tx_count);
+            else if ( rd_reg >= RX_BURST_R_REG && rd_reg < RX_BURST_R_REG + BURST_LEN )
+                rx_pop_n = clip_pop(BURST_WIDTH'(rd_reg - RX_BURST_R_REG + 1), rx_count);
+            else if ( rd_reg >= TX_BURST_R_REG && rd_reg < TX_BURST_R_REG + BURST_LEN )
+                tx_pop_n = clip_pop(BURST_WIDTH'(rd_reg - TX_BURST_R_REG + 1), tx_count);
+        end
+    end
+
+    // RX FIFO
+    always_ff @( posedge clock_i or negedge reset_ni ) begin
+        if ( !reset_ni ) begin
+            rx_wr_ptr <= '0;
+            rx_rd_ptr <= '0;
+            rx_count  <= '0;
+        end
+        else if ( rst_rx ) begin
+            rx_wr_ptr <= '0;
+            rx_rd_ptr <= '0;
+            rx_count  <= '0;
+        end
+        else begin
+            for ( int i = 0; i < BURST_LEN; i++ )
+                if ( i < 32'(rx_push_n) )
+                    rx_fifo[rx_wr_ptr + PTR_WIDTH'(i)] <= push_data[i*8 +: 8];
+            rx_wr_ptr <= rx_wr_ptr + PTR_WIDTH'(rx_push_n);
+            rx_rd_ptr <= rx_rd_ptr + PTR_WIDTH'(rx_pop_n);
+            rx_count  <= rx_count + CNT_WIDTH'(rx_push_n) - CNT_WIDTH'(rx_pop_n);
+        end
+    end
+
+    // TX FIFO
+    always_ff @( posedge clock_i or negedge reset_ni ) begin
+        if ( !reset_ni ) begin
+            tx_wr_ptr <= '0;
+            tx_rd_ptr <= '0;
+            tx_count  <= '0;
+        end
+        else if ( rst_tx ) begin
+            tx_wr_ptr <= '0;
+            tx_rd_ptr <= '0;
+            tx_count  <= '0;
+        end
+        else begin
+            for ( int i = 0; i < BURST_LEN; i++ )
+                if ( i < 32'(tx_push_n) )
+                    tx_fifo[tx_wr_ptr + PTR_WIDTH'(i)] <= push_data[i*8 +: 8];
+            tx_wr_ptr <= tx_wr_ptr + PTR_WIDTH'(tx_push_n);
+            tx_rd_ptr <= tx_rd_ptr + PTR_WIDTH'(tx_pop_n);
+            tx_count  <= tx_count + CNT_WIDTH'(tx_push_n) - CNT_WIDTH'(tx_pop_n);
+        end
+    end
+
+    // Control register
+    always_ff @( posedge clock_i or negedge reset_ni ) begin
+        if ( !reset_ni ) begin
+            ctrl_reg <= '0;
+        end
+        else if ( wr_en && wr_reg == CONTROL_REG ) begin
+            ctrl_reg <= s_axilite_wdata;
+        end
+    end
+
+
     /* AXILITE Read logic */
+    logic [LOCAL_DATA_WIDTH-1:0] status_reg;
+    logic [LOCAL_DATA_WIDTH-1:0] rx_head, tx_head;   // Up to BURST_LEN chars at the FIFO heads
+    logic [LOCAL_DATA_WIDTH-1:0] read_data;
+
+    always_comb begin
+        status_reg = '0;
+        status_reg[STS_RX_VALID_BIT] = ( rx_count != '0 );
+        status_reg[STS_RX_FULL_BIT]  = ( rx_count == CNT_WIDTH'(FIFO_DEPTH) );
+        status_reg[STS_TX_EMPTY_BIT] = ( tx_count == '0 );
+        status_reg[STS_TX_FULL_BIT]  = ( tx_count == CNT_WIDTH'(FIFO_DEPTH) );
+        // Propagate the interrupt enable/disable on the status register
+        status_reg[CTRL_STS_INT_BIT] = ctrl_reg[CTRL_STS_INT_BIT];
+
+        for ( int i = 0; i < BURST_LEN; i++ ) begin
+            rx_head[i*8 +: 8] = rx_fifo[rx_rd_ptr + PTR_WIDTH'(i)];
+            tx_head[i*8 +: 8] = tx_fifo[tx_rd_ptr + PTR_WIDTH'(i)];
+        end
+
+        read_data = '0;
+        if ( rd_reg == RX_REG )
+            read_data[7:0] = rx_head[7:0];
+        else if ( rd_reg == TX_REG )
+            read_data[7:0] = tx_head[7:0];
+        else if ( rd_reg == STATUS_REG )
+            read_data = status_reg;
+        else if ( rd_reg == CONTROL_REG )
+            read_data = ctrl_reg;
+        else if ( rd_reg == FIFO_LEVEL_REG ) begin
+            read_data[15:0]  = 16'(rx_count);
+            read_data[31:16] = 16'(tx_count);
+        end
+        else if ( rd_reg == FIFO_DEPTH_REG )
+            read_data = LOCAL_DATA_WIDTH'(FIFO_DEPTH);
+        // Bursts: the chars beyond the popped ones read as zero
+        else if ( rd_reg >= RX_BURST_R_REG && rd_reg < RX_BURST_R_REG + BURST_LEN ) begin
+            for ( int i = 0; i < BURST_LEN; i++ )
+                if ( i < 32'(rx_pop_n) )
+                    read_data[i*8 +: 8] = rx_head[i*8 +: 8];
+        end
+        else if ( rd_reg >= TX_BURST_R_REG && rd_reg < TX_BURST_R_REG + BURST_LEN ) begin
+            for ( int i = 0; i < BURST_LEN; i++ )
+                if ( i < 32'(tx_pop_n) )
+                    read_data[i*8 +: 8] = tx_head[i*8 +: 8];
+        end
+    end
+
     always_ff @( posedge clock_i or negedge reset_ni ) begin
         if ( !reset_ni ) begin
             s_axilite_arready <= 1'b0;
             s_axilite_rvalid  <= 1'b0;
-            s_axilite_rdata   <= 0;
+            s_axilite_rdata   <= '0;
             s_axilite_rresp   <= 2'b00;
         end else begin
 
@@ -99,8 +305,8 @@ module virtual_uart # (
                 s_axilite_arready <= 1'b0;
             end
 
-            if (s_axilite_arvalid && s_axilite_arready) begin
-                s_axilite_rdata <= uart_csr[s_axilite_araddr[4:2]];
+            if ( rd_en ) begin
+                s_axilite_rdata <= read_data;
                 s_axilite_rvalid <= 1'b1;
                 s_axilite_rresp  <= 2'b00;
             end
@@ -110,106 +316,35 @@ module virtual_uart # (
         end
     end
 
-    // Control/Status register logic
-    always_ff @( posedge clock_i or negedge reset_ni ) begin
-        if ( !reset_ni ) begin
-            foreach(uart_csr[i]) uart_csr[i] <= 0;
-        end
-        else begin
-            if ( s_axilite_wvalid && s_axilite_wready && s_axilite_awvalid && s_axilite_awready ) begin
-                // If there is a write on the control register
-                if ( s_axilite_awaddr[4:2] == CONTROL_REG /*&& s_axilite_wstrb[0]*/ ) begin
-
-                    // RST TX register
-                    if (s_axilite_wdata[CTRL_RST_TX_BIT]) begin
-                        uart_csr[TX_REG] <= 0;
-                        // TX register empty
-                        uart_csr[STATUS_REG][STS_TX_EMPTY_BIT] <= 1'b1;
-                        // TX register full
-                        uart_csr[STATUS_REG][STS_TX_FULL_BIT] <= 1'b0;
-                    end
-
-                    // RST RX register
-                    if (s_axilite_wdata[CTRL_RST_RX_BIT]) begin
-                        uart_csr[RX_REG] <= 0;
-                        // RX register valid
-                        uart_csr[STATUS_REG][STS_RX_VALID_BIT] <= 1'b0;
-                        // RX register full
-                        uart_csr[STATUS_REG][STS_RX_FULL_BIT] <= 1'b0;
-                    end
-
-                    // Propagate the interrupt enable/disable on the status register
-                    uart_csr[STATUS_REG][CTRL_STS_INT_BIT] <= s_axilite_wdata[CTRL_STS_INT_BIT];
-                end
-
-                // There is a write on the RX register
-                else if ( s_axilite_awaddr[4:2] == RX_REG /*&& s_axilite_wstrb[0]*/ ) begin
-                    // save data
-                    uart_csr[RX_REG][7:0] <= s_axilite_wdata[7:0];
-                    // RX register valid
-                    uart_csr[STATUS_REG][STS_RX_VALID_BIT] <= 1'b1;
-                    // RX register full
-                    uart_csr[STATUS_REG][STS_RX_FULL_BIT] <= 1'b1;
-                end
-
-                // There is a write on the TX register
-                else if ( s_axilite_awaddr[4:2] == TX_REG /*&& s_axilite_wstrb[0]*/ ) begin
-                    // save data
-                    uart_csr[TX_REG][7:0] <= s_axilite_wdata[7:0];
-                    // TX register empty
-                    uart_csr[STATUS_REG][STS_TX_EMPTY_BIT] <= 1'b0;
-                    // TX register full
-                    uart_csr[STATUS_REG][STS_TX_FULL_BIT] <= 1'b1;
-                end
-
-            end
-
-            if ( s_axilite_arvalid && s_axilite_arready ) begin
-
-                // There is a read on the RX register
-                if ( s_axilite_araddr[4:2] == RX_REG ) begin
-                    // RX register valid
-                    uart_csr[STATUS_REG][STS_RX_VALID_BIT] <= 1'b0;
-                    // RX register full
-                    uart_csr[STATUS_REG][STS_RX_FULL_BIT] <= 1'b0;
-                end
-
-                // There is a read on the TX register
-                else if ( s_axilite_araddr[4:2] == TX_REG ) begin
-                    // TX register empty
-                    uart_csr[STATUS_REG][STS_TX_EMPTY_BIT] <= 1'b1;
-                    // TX register full
-                    uart_csr[STATUS_REG][STS_TX_FULL_BIT] <= 1'b0;
-                end
-            end
-
-
-        end
-    end
-
     // Interrupts logic
-    // THIS IS A STUB - TO DO
+    // Core: one-cycle pulse when the interrupts are enabled and the RX FIFO becomes non-empty
+    // or the TX FIFO becomes empty, as the AXI uartlite (PG142). int_ack_i is not used.
+    logic rx_valid_q, tx_empty_q;
+
     always_ff @( posedge clock_i or negedge reset_ni ) begin
         if ( !reset_ni ) begin
             int_core_o <= '0;
             int_xdma_o <= '0;
+            rx_valid_q <= 1'b0;
+            tx_empty_q <= 1'b1;
         end
         else begin
-            if ( s_axilite_wvalid && s_axilite_wready && s_axilite_awvalid && s_axilite_awready ) begin
-
-                // There is a write on TX reg, need to interrupt the XDMA
-                if ( s_axilite_awaddr[4:2] == TX_REG /*&& s_axilite_wstrb[0]*/ ) begin
-                    int_xdma_o <= 1'b1;
-                end
-
-                // There is a write on HOST ACK register reset the interrupt to the XDMA
-                else if ( s_axilite_awaddr[4:2] == HOST_INT_ACK_REG /*&& s_axilite_wstrb[0]*/ ) begin
-                    int_xdma_o <= 1'b0;
-                end
-
+            rx_valid_q <= status_reg[STS_RX_VALID_BIT];
+            tx_empty_q <= status_reg[STS_TX_EMPTY_BIT];
+            int_core_o <= ctrl_reg[CTRL_STS_INT_BIT] && (
+                            ( status_reg[STS_RX_VALID_BIT] && !rx_valid_q ) ||
+                            ( status_reg[STS_TX_EMPTY_BIT] && !tx_empty_q ) );
+
+            // There is a write on TX reg, need to interrupt the XDMA
+            if ( tx_push_n != '0 ) begin
+                int_xdma_o <= 1'b1;
+            end
 
+            // There is a write on HOST ACK register reset the interrupt to the XDMA
+            else if ( wr_en && wr_reg == HOST_INT_ACK_REG ) begin
+                int_xdma_o <= 1'b0;
             end
         end
     end
 
-endmodule
\ No newline at end of file
+endmodule
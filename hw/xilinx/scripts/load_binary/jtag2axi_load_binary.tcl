@@ -5,6 +5,10 @@
 #    -argv0: absolute path to bin file to transfer
 #    -argv1: base address of BRAM
 #    -argv2: whether to read-back data after writing
+#    -argv3: (optional) delta reload plan, one "<offset> <length>" range to write per line (see xdma_loader -p),
+#            the rest of the binary is skipped
+#    -argv4: (optional) delta reload only, read back one word every verify_stride bytes of the skipped ranges,
+#            and write the pages that drifted anyway. 0 to disable.
 
 #########
 # Utils #
@@ -28,19 +32,69 @@ proc read_file_to_words {filename fsize} {
     return $file_data
 }
 
+# Write bursts [first, last) of data_list
+proc write_bursts {first last} {
+    global data_list burst_size base_address gpio_wr_txn
+    for {set i $first} {$i < $last} {incr i} {
+        # Select $burst_size-wide segment to read
+        set segment [string range $data_list [expr {$i * $burst_size}] [expr {($i + 1) * $burst_size} -1]]
+
+        # Invert endiannes from string (0x01234567 -> 0x67543201)
+        set str_tmp ""
+        for {set j 0} {$j < $burst_size} {incr j} {
+            set str_tmp [string index $segment $j]$str_tmp
+        }
+        set segment $str_tmp
+
+        # Convert to binary
+        binary scan $segment H* Memword
+
+        # Calculate address
+        set address [format 0x%x [expr {$base_address + $i * $burst_size}]]
+
+        # Create and run transaction
+        create_hw_axi_txn $gpio_wr_txn [get_hw_axis hw_axi_1] -type write -force -address $address -data $Memword -len $burst_size
+        run_hw_axi [get_hw_axi_txns $gpio_wr_txn]
+
+        # Debug
+        # puts "Writing to address $address"
+    }
+}
+
+# Read burst i back and compare it against data_list, return 1 if they match
+proc check_burst {i} {
+    global data_list burst_size base_address gpio_rd_txn
+    set address [format 0x%x [expr {$base_address + $i * $burst_size}]]
+    create_hw_axi_txn $gpio_rd_txn [get_hw_axis hw_axi_1] -type read -force -address $address
+    run_hw_axi -quiet [get_hw_axi_txns $gpio_rd_txn]
+    set read_data [get_property DATA [get_hw_axi_txns $gpio_rd_txn]]
+
+    # Expected word, same endianness swap as the writes
+    set segment [string range $data_list [expr {$i * $burst_size}] [expr {($i + 1) * $burst_size} -1]]
+    binary scan [string reverse $segment] H* expected
+    return [string equal -nocase $read_data $expected]
+}
+
 ##############
 # Parse args #
 ##############
-if { $argc != 3 } {
-    puts "Usage <filename> <base_address> <read_back>"
+if { $argc < 3 || $argc > 5 } {
+    puts "Usage <filename> <base_address> <read_back> \[plan_file\] \[verify_stride\]"
     puts "filename      : path to bin file to transfer"
     puts "base_address  : base address of BRAM"
     puts "read_back     : whether to read-back data after writing"
+    puts "plan_file     : delta reload, ranges to write, the rest is skipped"
+    puts "verify_stride : delta reload, bytes between two checked words of the skipped ranges, 0 to disable"
     return
 } else {
     set filename        [lindex $argv 0]
     set base_address    [lindex $argv 1]
     set read_back       [lindex $argv 2]
+    set plan_file       [lindex $argv 3]
+    set verify_stride   [lindex $argv 4]
+    if { $verify_stride == "" } {
+        set verify_stride 0
+    }
 }
 
 ########
@@ -89,30 +143,57 @@ if { $remaining_bytes != 0 } {
 ###################
 # Write to memory #
 ###################
-# Run burst-based transactions
-for {set i 0} {$i < $num_bursts} {incr i} {
-    # Select $burst_size-wide segment to read
-    set segment [string range $data_list [expr {$i * $burst_size}] [expr {($i + 1) * $burst_size} -1]]
 
-    # Invert endiannes from string (0x01234567 -> 0x67543201)
-    set str_tmp ""
-    for {set j 0} {$j < $burst_size} {incr j} {
-        set str_tmp [string index $segment $j]$str_tmp
+# Bursts to write, as a list of {first last} ranges
+if { $plan_file == "" } {
+    set ranges [list [list 0 $num_bursts]]
+} else {
+    # Page-aligned byte ranges from the plan, clipped to the padded binary
+    set ranges {}
+    set fp [open $plan_file r]
+    foreach line [split [read $fp] "\n"] {
+        if { [llength $line] != 2 } {
+            continue
+        }
+        set first [expr {[lindex $line 0] / $burst_size}]
+        set last  [expr {min(([lindex $line 0] + [lindex $line 1] + $burst_size - 1) / $burst_size, $num_bursts)}]
+        lappend ranges [list $first $last]
     }
-    set segment $str_tmp
-
-    # Convert to binary
-    binary scan $segment H* Memword
-
-    # Calculate address
-    set address [format 0x%x [expr {$base_address + $i * $burst_size}]]
+    close $fp
 
-    # Create and run transaction
-    create_hw_axi_txn $gpio_wr_txn [get_hw_axis hw_axi_1] -type write -force -address $address -data $Memword -len $burst_size
-    run_hw_axi [get_hw_axi_txns $gpio_wr_txn]
+    # Check the skipped ranges, a page that drifted is written whole
+    if { $verify_stride > 0 } {
+        set page_bursts [expr {4096 / $burst_size}]
+        set stride_bursts [expr {max($verify_stride / $burst_size, 1)}]
+        set skipped_first 0
+        set num_checked 0
+        set drifted {}
+        foreach range [concat $ranges [list [list $num_bursts $num_bursts]]] {
+            for {set i $skipped_first} {$i < [lindex $range 0]} {incr i $stride_bursts} {
+                incr num_checked
+                if { ![check_burst $i] } {
+                    set page_first [expr {$i / $page_bursts * $page_bursts}]
+                    lappend drifted [list $page_first [expr {min($page_first + $page_bursts, $num_bursts)}]]
+                    # Skip to the next page
+                    set i [expr {$page_first + $page_bursts - $stride_bursts}]
+                }
+            }
+            set skipped_first [lindex $range 1]
+        }
+        puts "\[INFO\] Verify: checked $num_checked words, [llength $drifted] pages drifted"
+        set ranges [concat $ranges $drifted]
+    }
+}
 
-    # Debug
-    # puts "Writing to address $address"
+# Run burst-based transactions
+set num_written 0
+foreach range $ranges {
+    write_bursts [lindex $range 0] [lindex $range 1]
+    incr num_written [expr {[lindex $range 1] - [lindex $range 0]}]
+}
+if { $plan_file != "" } {
+    set num_skipped [expr {$num_bursts - $num_written}]
+    puts "\[INFO\] Delta: [expr {$num_written * $burst_size}] bytes written, [expr {$num_skipped * $burst_size}] bytes skipped"
 }
 
 #########################
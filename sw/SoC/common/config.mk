@@ -1,17 +1,20 @@
 # Author: Stefano Mercogliano <stefano.mercogliano@unina.it>
 # Description:
 # 	It assigns the correct toolchain size depending on XLEN config parameter.
-#	XLEN is overwritten by `config/scripts/config_sw.sh`
+#	XLEN and CORE_SELECTOR are overwritten by `config/scripts/config_sw.sh`
+#	BUILD_PROFILE selects the compiler flags: debug (-O0 -g, default) or optimized (-O2)
 
 #############
 # Toolchain #
 #############
 
 XLEN ?= 32
+CORE_SELECTOR ?= CORE_CV32E40P
 RV_PREFIX ?= riscv${XLEN}-unknown-elf-
 
 CC          = $(RV_PREFIX)gcc
 LD          = $(RV_PREFIX)ld
+AR          = $(RV_PREFIX)ar
 OBJDUMP     = $(RV_PREFIX)objdump
 OBJCOPY     = $(RV_PREFIX)objcopy
 
@@ -27,7 +30,20 @@ else
 $(error Unsupported XLEN value: $(XLEN))
 endif
 
+# Build profile
+BUILD_PROFILE ?= debug
+ifeq ($(BUILD_PROFILE), debug)
+OFLAG ?= -O0
 DFLAG ?= -g
-CFLAGS ?= -march=rv${XLEN}imac_zicsr_zifencei -mabi=${ABI} -O0 $(DFLAG) -c
-LDFLAGS ?= $(LIB_OBJ_LIST) -nostdlib -T$(LD_SCRIPT)
+else ifeq ($(BUILD_PROFILE), optimized)
+# No libc to call: keep loops as loops instead of memcpy/memset calls
+OFLAG ?= -O2 -fno-tree-loop-distribute-patterns
+DFLAG ?=
+else
+$(error Unsupported BUILD_PROFILE value: $(BUILD_PROFILE))
+endif
+
+CFLAGS ?= -march=rv${XLEN}imac_zicsr_zifencei -mabi=${ABI} $(OFLAG) $(DFLAG) -c
+# Report the usage of each memory block
+LDFLAGS ?= $(LIB_OBJ_LIST) -nostdlib -T$(LD_SCRIPT) --print-memory-usage
 
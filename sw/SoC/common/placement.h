@@ -0,0 +1,39 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description:
+//      Placement of code and data in the memory blocks of the SoC, with the sections of UninaSoC.ld
+//      (config/scripts/create_linker_script.py):
+//          fast        the boot memory block (BRAM): latency-critical code (e.g. interrupt handlers) and data
+//          ddr, hbm    the DDR and HBM memory blocks: bulk data, copied from the boot memory block and bss cleared by startup.s
+//          uncached    zero-initialized buffers shared with other masters, aligned to 64-byte lines
+//      The memory blocks not in the configuration fall back to the boot memory block.
+//
+//      Usage:
+//          PLACE_FAST_TEXT void tim_handler();
+//          PLACE_DDR_BSS uint32_t samples[16384];
+//          PLACE_DDR_RODATA const uint32_t table[4096] = { ... };
+//
+//      Note: the link reports the usage of each memory block (--print-memory-usage, common/config.mk),
+//      _memory_<block>_free is the first byte not used by the sections in the DDR and HBM blocks.
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+// Boot memory block
+#define PLACE_FAST_TEXT     __attribute__((section(".text.fast")))
+#define PLACE_FAST_DATA     __attribute__((section(".data.fast")))
+#define PLACE_FAST_BSS      __attribute__((section(".bss.fast")))
+
+// DDR memory block
+#define PLACE_DDR_RODATA    __attribute__((section(".rodata.ddr")))
+#define PLACE_DDR_DATA      __attribute__((section(".data.ddr")))
+#define PLACE_DDR_BSS       __attribute__((section(".bss.ddr")))
+
+// HBM memory block
+#define PLACE_HBM_RODATA    __attribute__((section(".rodata.hbm")))
+#define PLACE_HBM_DATA      __attribute__((section(".data.hbm")))
+#define PLACE_HBM_BSS       __attribute__((section(".bss.hbm")))
+
+// Uncached, zero-initialized
+#define PLACE_UNCACHED      __attribute__((section(".bss.uncached"), aligned(64)))
+
+#endif
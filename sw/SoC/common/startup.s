@@ -1,6 +1,30 @@
 # Author: Stefano Mercogliano <stefano.mercogliano@unina.it>
 # Author: Valerio Di Domenico <valer.didomenico@studenti.unina.it>
 # Description: startup code for uninasoc
+#   The C runtime initialization copies the data sections from their load address and clears the bss sections of
+#   the memory blocks (UninaSoC.ld), four XLEN words per iteration. The cycles it takes are stored in _startup_cycles.
+#   XLEN and the CORE_SELECTOR core are defined by the assembler command line (common/Makefile).
+
+.ifndef XLEN
+  .error "XLEN is not defined, assemble with --defsym XLEN=<32|64>"
+.endif
+
+# XLEN-wide loads and stores
+.equ REGBYTES, XLEN / 8
+.macro LREG rd, offset, rs
+  .if XLEN == 64
+    ld \rd, \offset(\rs)
+  .else
+    lw \rd, \offset(\rs)
+  .endif
+.endm
+.macro SREG rs2, offset, rs1
+  .if XLEN == 64
+    sd \rs2, \offset(\rs1)
+  .else
+    sw \rs2, \offset(\rs1)
+  .endif
+.endm
 
 .section .vector_table, "ax"
 .option norvc;
@@ -55,6 +79,91 @@ _reset_handler:
   mv t5, zero
   mv t6, zero
 
+  ##################
+  # C Runtime Init #
+  ##################
+
+  # Global pointer, for the gp-relative accesses to sdata and sbss
+  .option push
+  .option norelax
+  la gp, __global_pointer$
+  .option pop
+
+  # Start the cycle counter (inhibited at reset on some cores), no machine counters on PicoRV32
+.ifndef CORE_PICORV32
+  csrw 0x320, zero            # mcountinhibit
+.endif
+  rdcycle s0
+
+  # Copy the data sections of each memory block from their load address, unless loaded in place,
+  # listed in the data table as 64-bit (load, start, end) triples (the low words on RV32)
+  # Both ends are aligned to four 64-bit words (UninaSoC.ld)
+  la t3, _data_table_start
+  la t4, _data_table_end
+  bgeu t3, t4, _data_done
+_data_table_loop:
+  LREG t0, 0, t3
+  LREG t1, 8, t3
+  LREG t2, 16, t3
+  beq t0, t1, _data_next
+  bgeu t1, t2, _data_next
+_data_loop:
+  LREG a0, 0*REGBYTES, t0
+  LREG a1, 1*REGBYTES, t0
+  LREG a2, 2*REGBYTES, t0
+  LREG a3, 3*REGBYTES, t0
+  SREG a0, 0*REGBYTES, t1
+  SREG a1, 1*REGBYTES, t1
+  SREG a2, 2*REGBYTES, t1
+  SREG a3, 3*REGBYTES, t1
+  addi t0, t0, 4*REGBYTES
+  addi t1, t1, 4*REGBYTES
+  bltu t1, t2, _data_loop
+_data_next:
+  addi t3, t3, 24
+  bltu t3, t4, _data_table_loop
+_data_done:
+
+  # Clear the bss sections of each memory block, listed in the bss table as 64-bit (start, end) pairs
+  # (the low words on RV32), same alignment
+  la t2, _bss_table_start
+  la t3, _bss_table_end
+  bgeu t2, t3, _bss_done
+_bss_table_loop:
+  LREG t0, 0, t2
+  LREG t1, 8, t2
+  bgeu t0, t1, _bss_next
+_bss_loop:
+  SREG zero, 0*REGBYTES, t0
+  SREG zero, 1*REGBYTES, t0
+  SREG zero, 2*REGBYTES, t0
+  SREG zero, 3*REGBYTES, t0
+  addi t0, t0, 4*REGBYTES
+  bltu t0, t1, _bss_loop
+_bss_next:
+  addi t2, t2, 16
+  bltu t2, t3, _bss_table_loop
+_bss_done:
+
+  # Store the initialization cycles, in .bss: after the clear
+  rdcycle s1
+  sub s1, s1, s0
+  la t0, _startup_cycles
+  SREG s1, 0, t0
+
+  # Back to the reset values
+  mv s0, zero
+  mv s1, zero
+  mv t0, zero
+  mv t1, zero
+  mv t2, zero
+  mv t3, zero
+  mv t4, zero
+  mv a0, zero
+  mv a1, zero
+  mv a2, zero
+  mv a3, zero
+
   #####################
   # Enable Interrupts #
   #####################
@@ -97,7 +206,10 @@ _start:
 
   jal ra, main
 
+.section .bss
 
-
-
-
+# Cycles of the C runtime initialization (low 32 bits on RV32)
+.balign 8
+_startup_cycles:
+  .global _startup_cycles
+  .zero 8
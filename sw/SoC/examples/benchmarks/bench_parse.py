@@ -0,0 +1,67 @@
+#!/bin/python3.10
+# Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+# Description:
+#   Parser of the benchmarks results, from UART logs (e.g. captured with a serial terminal) to CSV.
+#   Reads the "BENCH key=value ..." lines of one or more logs, and prints one CSV row per result,
+#   with a column per key (empty if a result has not it). The "info" lines are skipped.
+#   Logs of different cores and profiles can be merged, the core and profile columns tell them apart.
+# Args:
+#   see --help, e.g. ./bench_parse.py cv32e40p_debug.log cv32e40p_optimized.log -g kernel > kernels.csv
+
+####################
+# Import libraries #
+####################
+# Parse args
+import argparse
+import sys
+
+##############
+# Parse args #
+##############
+
+parser = argparse.ArgumentParser(description="Turn the benchmarks UART logs into CSV")
+parser.add_argument("logs", nargs="+", help="UART logs")
+parser.add_argument("-g", "--group", help="only the results of this group (kernel, memcpy, mmio, irq)")
+args = parser.parse_args()
+
+#############
+# Read logs #
+#############
+
+# Leading columns, in this order, then the others as first seen
+columns = ["group", "name", "core", "profile"]
+results = []
+for log in args.logs:
+	with open(log, "r", errors="replace") as fd:
+		for line in fd:
+			# Terminals may add chars before the marker
+			start = line.find("BENCH ")
+			if start < 0:
+				continue
+			result = {}
+			# Keys can repeat (event in the info lines), keep the values
+			for field in line[start + len("BENCH "):].split():
+				if "=" not in field:
+					continue
+				key, value = field.split("=", 1)
+				result[key] = value if key not in result else result[key] + ";" + value
+			if result.get("group") is None or result.get("group") == "info":
+				continue
+			if args.group is not None and result["group"] != args.group:
+				continue
+			for key in result:
+				if key not in columns:
+					columns.append(key)
+			results.append(result)
+
+if len(results) == 0:
+	print("ERROR: no results in " + " ".join(args.logs), file=sys.stderr)
+	sys.exit(1)
+
+##########
+# Output #
+##########
+
+print(",".join(columns))
+for result in results:
+	print(",".join(result.get(column, "") for column in columns))
@@ -0,0 +1,59 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include "perf.h"
+
+#ifndef BENCH_PROFILE
+#define BENCH_PROFILE "unknown"
+#endif
+
+// Runs of each measure, the fastest one is reported (warm caches and predictors)
+#define BENCH_RUNS          3
+
+// Longest result line
+#define BENCH_LINE_SIZE     512
+
+// Import linker script symbols, weak: the peripherals and memories of the configuration only
+extern const volatile uint32_t _vector_table_start;
+extern const volatile uint32_t _peripheral_PLIC_start;
+extern const volatile uint32_t _peripheral_UART_start;
+extern const volatile uint32_t _peripheral_GPIO_in_start    __attribute__((weak));
+extern const volatile uint32_t _peripheral_GPIO_out_start   __attribute__((weak));
+extern const volatile uint32_t _peripheral_TIM0_start       __attribute__((weak));
+extern const volatile uint32_t _peripheral_TIM1_start       __attribute__((weak));
+extern const volatile uint32_t _peripheral_TIM1_end         __attribute__((weak));
+extern const volatile uint32_t _peripheral_GPIO_in_end      __attribute__((weak));
+extern const volatile uint32_t _peripheral_GPIO_out_end     __attribute__((weak));
+extern const volatile uint32_t _peripheral_TIM0_end         __attribute__((weak));
+extern uint8_t _memory_DDR_free[]                           __attribute__((weak));
+extern uint8_t _memory_DDR_end[]                            __attribute__((weak));
+extern uint8_t _memory_HBM_free[]                           __attribute__((weak));
+extern uint8_t _memory_HBM_end[]                            __attribute__((weak));
+
+// C runtime initialization (common/startup.s): cycles, and the sections it copies and clears
+extern uintptr_t _startup_cycles;
+extern uint8_t _data_start[];
+extern uint8_t _data_end[];
+extern uint8_t _bss_start[];
+extern uint8_t _bss_end[];
+
+// Results, one line each:
+//      BENCH group=<group> name=<name> core=<core> profile=<profile> <key>=<value> ...
+// e.g. BENCH group=kernel name=crc32 core=cv32e40p profile=debug iters=1024 check=<crc> cycles=<n> instret=<n> imiss=<n>
+void bench_line_start(const char * group, const char * name);
+void bench_line_u64(const char * key, uint64_t value);
+void bench_line_str(const char * key, const char * value);
+void bench_line_counters(const perf_counters_t * counters);
+void bench_line_end();
+
+// Copy counters into best if faster (field by field: no memcpy to call)
+void bench_keep_best(perf_counters_t * best, const perf_counters_t * counters);
+
+// Groups
+void bench_kernels();
+void bench_memcpy();
+void bench_mmio();
+void bench_irq();
+
+#endif
@@ -0,0 +1,58 @@
+#include "bench.h"
+#include "uart.h"
+
+static char bench_line[BENCH_LINE_SIZE];
+static int bench_line_len;
+
+static void bench_append(const char * str){
+    while (*str != '\0' && bench_line_len < BENCH_LINE_SIZE - 3)
+        bench_line[bench_line_len++] = *str++;
+}
+
+void bench_line_start(const char * group, const char * name){
+    bench_line_len = 0;
+    bench_append("BENCH group=");
+    bench_append(group);
+    bench_append(" name=");
+    bench_append(name);
+    bench_line_str("core", perf_core_name());
+    bench_line_str("profile", BENCH_PROFILE);
+}
+
+void bench_line_str(const char * key, const char * value){
+    bench_append(" ");
+    bench_append(key);
+    bench_append("=");
+    bench_append(value);
+}
+
+void bench_line_u64(const char * key, uint64_t value){
+    char digits[21];
+    perf_u64_to_str(value, digits);
+    bench_line_str(key, digits);
+}
+
+void bench_line_counters(const perf_counters_t * counters){
+    char buf[BENCH_LINE_SIZE];
+    perf_format(buf, sizeof(buf), counters);
+    bench_append(" ");
+    bench_append(buf);
+}
+
+void bench_keep_best(perf_counters_t * best, const perf_counters_t * counters){
+    if (counters->cycles >= best->cycles)
+        return;
+    best->cycles = counters->cycles;
+    best->instret = counters->instret;
+    for (int i = 0; i < PERF_HPM_MAX; i++)
+        best->hpm[i] = counters->hpm[i];
+}
+
+void bench_line_end(){
+    bench_line[bench_line_len++] = '\n';
+    bench_line[bench_line_len++] = '\r';
+
+    // The interrupts are disabled: flush polls the UART, out of the measures
+    uart_write(bench_line, bench_line_len);
+    uart_flush();
+}
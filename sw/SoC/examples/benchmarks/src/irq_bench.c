@@ -0,0 +1,382 @@
+#include "bench.h"
+#include "placement.h"
+#include "irq.h"
+
+// Measures, the first one is dropped (cold caches)
+#define IRQ_ITERATIONS      17
+// TIM1 ticks before the interrupt
+#define IRQ_TIM_TICKS       100
+// mip polls before giving up on the interrupt
+#define IRQ_TIMEOUT         100000
+
+// PLIC source of TIM1 (PLIC_TIM1_INTERRUPT in hw/xilinx/rtl/uninasoc_pkg.sv)
+#define IRQ_TIM1_SOURCE     3
+
+// Interrupt rate: measure window, in cycles, and TIM1 periods, in ticks
+#define IRQ_RATE_WINDOW     500000
+#define IRQ_RATE_PERIODS    { 5000, 2000, 1000, 500, 200, 100, 50 }
+
+// Registers offsets
+#define PLIC_ENABLE_OFFSET  0x2000
+#define PLIC_CLAIM_OFFSET   0x200004
+#define TIM_TCSR_OFFSET     0x0
+#define TIM_TLR_OFFSET      0x4
+
+// TCSR values
+#define TIM_TCSR_LOAD       0x20
+#define TIM_TCSR_START      0xC2    // ENT, ENIT, UDT: one-shot down count
+#define TIM_TCSR_CLEAR      0x100   // TINT, and stop
+#define TIM_TCSR_PERIODIC   0xD2    // ENT, ENIT, ARHT, UDT: auto reload down count
+
+#define IRQ_MIP_MEIP        0x800
+
+#if __riscv_xlen == 64
+#define IRQ_STORE "sd"
+#define IRQ_LOAD  "ld"
+#else
+#define IRQ_STORE "sw"
+#define IRQ_LOAD  "lw"
+#endif
+
+// mcycle, 32 bits are enough for the latencies
+#define IRQ_MCYCLE(x) __asm__ volatile("csrr %0, mcycle" : "=r"(x))
+
+// Timestamps of the interrupt
+volatile uint32_t bench_irq_stub_cycle;
+volatile uint32_t bench_irq_handler_cycle;
+volatile uint32_t bench_irq_exit_cycle;
+volatile uint32_t bench_irq_claimed;
+
+static void bench_irq_skipped(const char * name, const char * reason){
+    bench_line_start("irq", name);
+    bench_line_str("skipped", reason);
+    bench_line_end();
+}
+
+#ifndef CORE_PICORV32
+
+// In the boot memory block, with the vector table
+void bench_irq_handler() __attribute__((interrupt("machine"))) PLACE_FAST_TEXT;
+
+// Vector table target: timestamp with t0 and t1 only, then jump to the C handler,
+// which saves its own registers and returns with mret
+__asm__ (
+    "   .pushsection .text.fast, \"ax\"\n"
+    "   .align 2\n"
+    "   .global bench_irq_stub\n"
+    "bench_irq_stub:\n"
+    "   addi sp, sp, -16\n"
+    "   " IRQ_STORE " t0, 0(sp)\n"
+    "   " IRQ_STORE " t1, 8(sp)\n"
+    "   csrr t0, mcycle\n"
+    "   la t1, bench_irq_stub_cycle\n"
+    "   sw t0, 0(t1)\n"
+    "   " IRQ_LOAD " t0, 0(sp)\n"
+    "   " IRQ_LOAD " t1, 8(sp)\n"
+    "   addi sp, sp, 16\n"
+    "   j bench_irq_handler\n"
+    "   .popsection\n"
+);
+
+void bench_irq_stub();
+
+void bench_irq_handler(){
+
+    uint32_t cycle;
+    IRQ_MCYCLE(cycle);
+    bench_irq_handler_cycle = cycle;
+
+    volatile uint32_t * claim = (volatile uint32_t *) ((uintptr_t) &_peripheral_PLIC_start + PLIC_CLAIM_OFFSET);
+    volatile uint32_t * tcsr = (volatile uint32_t *) ((uintptr_t) &_peripheral_TIM1_start + TIM_TCSR_OFFSET);
+
+    // Claim, clear the timer and complete
+    uint32_t id = *claim;
+    *tcsr = TIM_TCSR_CLEAR;
+    *claim = id;
+    bench_irq_claimed = id;
+
+    IRQ_MCYCLE(cycle);
+    bench_irq_exit_cycle = cycle;
+}
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint32_t sum;
+} irq_range_t;
+
+static void irq_range_add(irq_range_t * range, uint32_t value){
+    if (value < range->min)
+        range->min = value;
+    if (value > range->max)
+        range->max = value;
+    range->sum += value;
+}
+
+static void irq_range_print(const char * key, const irq_range_t * range, uint32_t count){
+
+    char name[32];
+    int len = 0;
+    const char * suffixes[3] = { "_min", "_avg", "_max" };
+    uint32_t values[3] = { range->min, count ? range->sum / count : 0, range->max };
+
+    for (int i = 0; i < 3; i++) {
+        len = 0;
+        for (const char * c = key; *c != '\0' && len < 24; c++)
+            name[len++] = *c;
+        for (const char * c = suffixes[i]; *c != '\0'; c++)
+            name[len++] = *c;
+        name[len] = '\0';
+        bench_line_u64(name, values[i]);
+    }
+}
+
+// One-shot TIM1 interrupt, pending with MIE clear. Return 0 if it does not come.
+static int irq_fire(volatile uint32_t * tim){
+
+    *(tim + TIM_TLR_OFFSET / sizeof(uint32_t)) = IRQ_TIM_TICKS;
+    *(tim + TIM_TCSR_OFFSET / sizeof(uint32_t)) = TIM_TCSR_LOAD;
+    *(tim + TIM_TCSR_OFFSET / sizeof(uint32_t)) = TIM_TCSR_START;
+
+    uint32_t mip = 0;
+    for (int polls = 0; polls < IRQ_TIMEOUT && !(mip & IRQ_MIP_MEIP); polls++)
+        __asm__ volatile("csrr %0, mip" : "=r"(mip));
+    if (!(mip & IRQ_MIP_MEIP)) {
+        *(tim + TIM_TCSR_OFFSET / sizeof(uint32_t)) = TIM_TCSR_CLEAR;
+        return 0;
+    }
+    return 1;
+}
+
+// Take the pending interrupt: the trap is right after the csrs
+static void irq_take(uint32_t * t_enable, uint32_t * t_back){
+    uint32_t t0;
+    uint32_t t1;
+    IRQ_MCYCLE(t0);
+    __asm__ volatile("csrs mstatus, 0x8");
+    IRQ_MCYCLE(t1);
+    __asm__ volatile("csrc mstatus, 0x8");
+    *t_enable = t0;
+    *t_back = t1;
+}
+
+// Interrupt attribute handler behind a timestamping stub, with the PLIC programmed here
+static void bench_irq_raw(){
+
+    volatile uint32_t * plic = (volatile uint32_t *) &_peripheral_PLIC_start;
+    volatile uint32_t * tim = (volatile uint32_t *) &_peripheral_TIM1_start;
+
+    if (irq_install_vector(IRQ_VECTOR_EXT, bench_irq_stub)) {
+        bench_irq_skipped("tim1", "install_failed");
+        return;
+    }
+
+    // TIM1 only
+    *(plic + IRQ_TIM1_SOURCE) = 1;
+    *(plic + PLIC_ENABLE_OFFSET / sizeof(uint32_t)) = 1 << IRQ_TIM1_SOURCE;
+
+    irq_range_t entry = { 0xffffffff, 0, 0 };
+    irq_range_t handler = { 0xffffffff, 0, 0 };
+    irq_range_t back = { 0xffffffff, 0, 0 };
+    uint32_t count = 0;
+    uint32_t timeouts = 0;
+
+    for (int i = 0; i < IRQ_ITERATIONS; i++) {
+        uint32_t t_enable;
+        uint32_t t_back;
+
+        if (!irq_fire(tim)) {
+            timeouts++;
+            continue;
+        }
+        irq_take(&t_enable, &t_back);
+
+        if (i == 0)
+            continue;
+
+        irq_range_add(&entry, bench_irq_stub_cycle - t_enable);
+        irq_range_add(&handler, bench_irq_exit_cycle - bench_irq_handler_cycle);
+        irq_range_add(&back, t_back - bench_irq_exit_cycle);
+        count++;
+    }
+
+    // Back to no sources
+    *(plic + PLIC_ENABLE_OFFSET / sizeof(uint32_t)) = 0;
+
+    if (count == 0) {
+        bench_irq_skipped("tim1", "no_interrupt");
+        return;
+    }
+
+    bench_line_start("irq", "tim1");
+    bench_line_u64("iters", count);
+    bench_line_u64("timeouts", timeouts);
+    bench_line_u64("source", bench_irq_claimed);
+    irq_range_print("entry_cycles", &entry, count);
+    irq_range_print("handler_cycles", &handler, count);
+    irq_range_print("return_cycles", &back, count);
+    bench_line_end();
+}
+
+// lib/irq handlers: plain functions
+static volatile uint32_t bench_irq_rate_count;
+
+PLACE_FAST_TEXT static void bench_dispatch_handler(){
+    uint32_t cycle;
+    IRQ_MCYCLE(cycle);
+    bench_irq_handler_cycle = cycle;
+
+    // Clear and stop
+    *((volatile uint32_t *) &_peripheral_TIM1_start + TIM_TCSR_OFFSET / sizeof(uint32_t)) = TIM_TCSR_CLEAR;
+
+    IRQ_MCYCLE(cycle);
+    bench_irq_exit_cycle = cycle;
+}
+
+PLACE_FAST_TEXT static void bench_rate_handler(){
+    bench_irq_rate_count++;
+
+    // Clear, the timer goes on
+    *((volatile uint32_t *) &_peripheral_TIM1_start + TIM_TCSR_OFFSET / sizeof(uint32_t)) = TIM_TCSR_CLEAR | TIM_TCSR_PERIODIC;
+}
+
+// lib/irq dispatch: trap to the first handler instruction, and handler return to the interrupted code
+static void bench_irq_dispatch_latency(int nesting){
+
+    volatile uint32_t * tim = (volatile uint32_t *) &_peripheral_TIM1_start;
+    const char * name = nesting ? "dispatch_nested" : "dispatch";
+
+    irq_init((uintptr_t) &_peripheral_PLIC_start);
+    irq_set_nesting(nesting);
+    irq_register(IRQ_TIM1_SOURCE, bench_dispatch_handler, 1);
+
+    irq_range_t entry = { 0xffffffff, 0, 0 };
+    irq_range_t back = { 0xffffffff, 0, 0 };
+    uint32_t count = 0;
+    uint32_t timeouts = 0;
+
+    for (int i = 0; i < IRQ_ITERATIONS; i++) {
+        uint32_t t_enable;
+        uint32_t t_back;
+
+        if (!irq_fire(tim)) {
+            timeouts++;
+            continue;
+        }
+        irq_take(&t_enable, &t_back);
+
+        if (i == 0)
+            continue;
+
+        irq_range_add(&entry, bench_irq_handler_cycle - t_enable);
+        irq_range_add(&back, t_back - bench_irq_exit_cycle);
+        count++;
+    }
+
+    irq_unregister(IRQ_TIM1_SOURCE);
+
+    if (count == 0) {
+        bench_irq_skipped(name, "no_interrupt");
+        return;
+    }
+
+    const irq_counters_t * counters = irq_get_counters();
+    bench_line_start("irq", name);
+    bench_line_u64("iters", count);
+    bench_line_u64("timeouts", timeouts);
+    bench_line_u64("traps", counters->traps);
+    bench_line_u64("claims", counters->claims);
+    irq_range_print("entry_cycles", &entry, count);
+    irq_range_print("return_cycles", &back, count);
+    bench_line_end();
+}
+
+// Busy loop for a window, return its iterations: the time left to the application
+static uint32_t irq_window(){
+    uint32_t start;
+    uint32_t now;
+    uint32_t iters = 0;
+
+    IRQ_MCYCLE(start);
+    do {
+        iters++;
+        IRQ_MCYCLE(now);
+    } while (now - start < IRQ_RATE_WINDOW);
+
+    return iters;
+}
+
+// lib/irq dispatch: sustained interrupt rate, with TIM1 periods shorter and shorter.
+// When the period gets shorter than the dispatch, the interrupts are back to back and
+// cycles_per_irq stops decreasing: that is the highest rate.
+static void bench_irq_dispatch_rate(){
+
+    volatile uint32_t * tim = (volatile uint32_t *) &_peripheral_TIM1_start;
+    const uint32_t periods[] = IRQ_RATE_PERIODS;
+
+    // No interrupts, as reference
+    uint32_t idle_iters = irq_window();
+
+    irq_init((uintptr_t) &_peripheral_PLIC_start);
+
+    for (unsigned int p = 0; p < sizeof(periods) / sizeof(periods[0]); p++) {
+
+        bench_irq_rate_count = 0;
+        irq_register(IRQ_TIM1_SOURCE, bench_rate_handler, 1);
+
+        *(tim + TIM_TLR_OFFSET / sizeof(uint32_t)) = periods[p];
+        *(tim + TIM_TCSR_OFFSET / sizeof(uint32_t)) = TIM_TCSR_LOAD;
+        *(tim + TIM_TCSR_OFFSET / sizeof(uint32_t)) = TIM_TCSR_PERIODIC;
+
+        irq_enable();
+        uint32_t iters = irq_window();
+        irq_disable();
+
+        // Stop, and drop the interrupt left pending
+        *(tim + TIM_TCSR_OFFSET / sizeof(uint32_t)) = TIM_TCSR_CLEAR;
+        irq_unregister(IRQ_TIM1_SOURCE);
+        uint32_t irqs = bench_irq_rate_count;
+
+        bench_line_start("irq", "dispatch_rate");
+        bench_line_u64("period_ticks", periods[p]);
+        bench_line_u64("window_cycles", IRQ_RATE_WINDOW);
+        bench_line_u64("irqs", irqs);
+        bench_line_u64("cycles_per_irq", irqs ? IRQ_RATE_WINDOW / irqs : 0);
+        bench_line_u64("app_left_pct", idle_iters ? (iters * 100) / idle_iters : 0);
+        bench_line_end();
+    }
+
+    // Dispatch counters, over all the periods
+    const irq_counters_t * counters = irq_get_counters();
+    bench_line_start("irq", "dispatch_rate");
+    bench_line_u64("traps", counters->traps);
+    bench_line_u64("claims", counters->claims);
+    bench_line_u64("spurious", counters->spurious);
+    bench_line_u64("unhandled", counters->unhandled);
+    bench_line_end();
+}
+
+void bench_irq(){
+
+    if (&_peripheral_TIM1_end == 0) {
+        bench_irq_skipped("tim1", "no_TIM1");
+        return;
+    }
+
+    bench_irq_raw();
+    bench_irq_dispatch_latency(0);
+    bench_irq_dispatch_latency(1);
+    bench_irq_dispatch_rate();
+
+    // Back to no sources
+    irq_init((uintptr_t) &_peripheral_PLIC_start);
+}
+
+#else
+
+// No mtvec nor PLIC interface on PicoRV32 (IRQ lines and its own q registers)
+void bench_irq(){
+    bench_irq_skipped("tim1", "picorv32");
+}
+
+#endif
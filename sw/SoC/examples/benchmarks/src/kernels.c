@@ -0,0 +1,145 @@
+#include "bench.h"
+
+// Sizes, small enough for the BRAM
+#define CRC_BYTES       1024
+#define MAT_N           16
+#define SORT_N          256
+#define DIV_ITERS       1024
+#define COLLATZ_N       256
+
+static uint8_t crc_buf[CRC_BYTES];
+static int32_t mat_a[MAT_N][MAT_N];
+static int32_t mat_b[MAT_N][MAT_N];
+static int32_t mat_c[MAT_N][MAT_N];
+static uint32_t sort_buf[SORT_N];
+
+// Pseudo-random inputs, the same on every core
+static uint32_t lcg_state;
+
+static uint32_t lcg(){
+    lcg_state = lcg_state * 1664525 + 1013904223;
+    return lcg_state;
+}
+
+// Bitwise CRC32: shifts, xors and data-dependent branches
+static uint32_t kernel_crc32(){
+    uint32_t crc = 0xFFFFFFFF;
+    for (int i = 0; i < CRC_BYTES; i++) {
+        crc ^= crc_buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            if (crc & 1)
+                crc = (crc >> 1) ^ 0xEDB88320;
+            else
+                crc >>= 1;
+        }
+    }
+    return ~crc;
+}
+
+// Matrix multiplication: multiplications and loads
+static uint32_t kernel_matmul(){
+    uint32_t check = 0;
+    for (int i = 0; i < MAT_N; i++) {
+        for (int j = 0; j < MAT_N; j++) {
+            int32_t sum = 0;
+            for (int k = 0; k < MAT_N; k++)
+                sum += mat_a[i][k] * mat_b[k][j];
+            mat_c[i][j] = sum;
+            check += (uint32_t) sum;
+        }
+    }
+    return check;
+}
+
+// Insertion sort: loads, stores and unpredictable branches
+static uint32_t kernel_sort(){
+    uint32_t check = 0;
+    lcg_state = 3;
+    for (int i = 0; i < SORT_N; i++)
+        sort_buf[i] = lcg();
+    for (int i = 1; i < SORT_N; i++) {
+        uint32_t key = sort_buf[i];
+        int j = i - 1;
+        while (j >= 0 && sort_buf[j] > key) {
+            sort_buf[j + 1] = sort_buf[j];
+            j--;
+        }
+        sort_buf[j + 1] = key;
+    }
+    for (int i = 0; i < SORT_N; i++)
+        check += sort_buf[i] * (uint32_t) i;
+    return check;
+}
+
+// Divisions and remainders: the divider latency
+static uint32_t kernel_div(){
+    uint32_t check = 0;
+    uint32_t x = 0xFFFFFFF1;
+    for (int i = 1; i <= DIV_ITERS; i++) {
+        check += x / (uint32_t) i + x % (uint32_t) (i + 7);
+        x -= check;
+    }
+    return check;
+}
+
+// Collatz sequences: short dependent operations and branches
+static uint32_t kernel_collatz(){
+    uint32_t steps = 0;
+    for (uint32_t n = 1; n <= COLLATZ_N; n++) {
+        uint32_t x = n;
+        while (x != 1) {
+            x = (x & 1) ? 3 * x + 1 : x >> 1;
+            steps++;
+        }
+    }
+    return steps;
+}
+
+typedef struct {
+    const char * name;
+    uint32_t (*kernel)();
+    uint32_t iters;         // Inner iterations, for the per-iteration figures
+} kernel_t;
+
+static const kernel_t kernels[] = {
+    { "crc32",      kernel_crc32,   CRC_BYTES           },
+    { "matmul",     kernel_matmul,  MAT_N * MAT_N * MAT_N },
+    { "sort",       kernel_sort,    SORT_N              },
+    { "div",        kernel_div,     DIV_ITERS           },
+    { "collatz",    kernel_collatz, COLLATZ_N           },
+};
+
+void bench_kernels(){
+
+    // Inputs
+    lcg_state = 1;
+    for (int i = 0; i < CRC_BYTES; i++)
+        crc_buf[i] = (uint8_t) lcg();
+    for (int i = 0; i < MAT_N; i++) {
+        for (int j = 0; j < MAT_N; j++) {
+            mat_a[i][j] = (int32_t) (lcg() >> 20) - 2048;
+            mat_b[i][j] = (int32_t) (lcg() >> 20) - 2048;
+        }
+    }
+
+    for (unsigned int k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        perf_counters_t best;
+        perf_counters_t counters;
+        uint32_t check = 0;
+
+        best.cycles = ~(uint64_t) 0;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            perf_start(&counters);
+            check = kernels[k].kernel();
+            perf_stop(&counters);
+            bench_keep_best(&best, &counters);
+        }
+
+        // The check values must match across cores and profiles
+        bench_line_start("kernel", kernels[k].name);
+        bench_line_u64("iters", kernels[k].iters);
+        bench_line_u64("check", check);
+        bench_line_counters(&best);
+        bench_line_end();
+    }
+}
@@ -0,0 +1,54 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description:
+//      Bare-metal benchmark suite, to compare the cores (CORE_SELECTOR) and the build profiles:
+//      - kernel:   integer kernels (CRC32, matrix multiplication, sort, division, Collatz)
+//      - memcpy:   copy bandwidth per memory (BRAM, and DDR/HBM when in the configuration), per access width
+//      - mmio:     round-trip of reads and writes to the PBUS peripherals and to the PLIC
+//      - irq:      interrupt entry and return latency, through the PLIC, and the lib/irq dispatch latency and
+//                  sustained rate
+//      Each measure reads the performance counters of the core (lib/perf), and prints one line on the UART,
+//      after the "config" and "startup" lines and before a "done" one (see bench.h). bench_parse.py turns the logs into CSV.
+//
+//      Note: the interrupts are disabled but for the irq measures, so that the UART (lib/uart) is polled
+//      between the measures, never during them.
+
+#include <stdint.h>
+
+#include "bench.h"
+#include "uart.h"
+
+int main(){
+
+    // No interrupts out of the irq measures
+    __asm__ volatile("csrc mstatus, 0x8");
+
+    uart_init((uintptr_t) &_peripheral_UART_start);
+    int hpm_num = perf_init();
+
+    // Configuration
+    bench_line_start("info", "config");
+    bench_line_u64("xlen", __riscv_xlen);
+    bench_line_u64("hpm", hpm_num);
+    for (int i = 0; i < hpm_num; i++)
+        bench_line_str("event", perf_hpm_name(i));
+    bench_line_end();
+
+    // Startup, .data copy and .bss clear
+    bench_line_start("info", "startup");
+    bench_line_u64("cycles", _startup_cycles);
+    bench_line_u64("data_bytes", _data_end - _data_start);
+    bench_line_u64("bss_bytes", _bss_end - _bss_start);
+    bench_line_end();
+
+    bench_kernels();
+    bench_memcpy();
+    bench_mmio();
+    bench_irq();
+
+    bench_line_start("info", "done");
+    bench_line_end();
+
+    while(1);
+
+    return 0;
+}
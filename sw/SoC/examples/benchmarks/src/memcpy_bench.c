@@ -0,0 +1,91 @@
+#include "bench.h"
+
+// Bytes per copy
+#define COPY_BYTES      2048
+
+// BRAM buffers, word aligned
+static uintptr_t bram_src[COPY_BYTES / sizeof(uintptr_t)];
+static uintptr_t bram_dst[COPY_BYTES / sizeof(uintptr_t)];
+
+// Copy loops, one per access width
+static void copy_bytes(uint8_t * dst, const uint8_t * src, uint32_t bytes){
+    for (uint32_t i = 0; i < bytes; i++)
+        dst[i] = src[i];
+}
+
+static void copy_words(uintptr_t * dst, const uintptr_t * src, uint32_t bytes){
+    uint32_t words = bytes / sizeof(uintptr_t);
+    for (uint32_t i = 0; i < words; i++)
+        dst[i] = src[i];
+}
+
+// Four words per iteration, the loads before the stores
+static void copy_words_unrolled(uintptr_t * dst, const uintptr_t * src, uint32_t bytes){
+    uint32_t words = bytes / sizeof(uintptr_t);
+    for (uint32_t i = 0; i < words; i += 4) {
+        uintptr_t w0 = src[i];
+        uintptr_t w1 = src[i + 1];
+        uintptr_t w2 = src[i + 2];
+        uintptr_t w3 = src[i + 3];
+        dst[i] = w0;
+        dst[i + 1] = w1;
+        dst[i + 2] = w2;
+        dst[i + 3] = w3;
+    }
+}
+
+static void bench_memcpy_memory(const char * memory, uint8_t * dst, const uint8_t * src){
+
+    const char * names[3] = { "byte", "word", "word_x4" };
+
+    // Source pattern
+    for (uint32_t i = 0; i < COPY_BYTES; i++)
+        ((volatile uint8_t *) src)[i] = (uint8_t) i;
+
+    for (int variant = 0; variant < 3; variant++) {
+        perf_counters_t best;
+        perf_counters_t counters;
+
+        best.cycles = ~(uint64_t) 0;
+        for (int run = 0; run < BENCH_RUNS; run++) {
+            perf_start(&counters);
+            if (variant == 0)
+                copy_bytes(dst, src, COPY_BYTES);
+            else if (variant == 1)
+                copy_words((uintptr_t *) dst, (const uintptr_t *) src, COPY_BYTES);
+            else
+                copy_words_unrolled((uintptr_t *) dst, (const uintptr_t *) src, COPY_BYTES);
+            perf_stop(&counters);
+            bench_keep_best(&best, &counters);
+        }
+
+        // Check the copy
+        uint32_t errors = 0;
+        for (uint32_t i = 0; i < COPY_BYTES; i++)
+            errors += ((volatile uint8_t *) dst)[i] != (uint8_t) i;
+
+        // Bandwidth as bytes per 1000 cycles, 32-bit arithmetic
+        uint32_t cycles = (uint32_t) best.cycles;
+        uint32_t bytes_per_kcycle = cycles ? (COPY_BYTES * 1000) / cycles : 0;
+
+        bench_line_start("memcpy", names[variant]);
+        bench_line_str("memory", memory);
+        bench_line_u64("bytes", COPY_BYTES);
+        bench_line_u64("bytes_per_kcycle", bytes_per_kcycle);
+        bench_line_u64("errors", errors);
+        bench_line_counters(&best);
+        bench_line_end();
+    }
+}
+
+void bench_memcpy(){
+
+    // The boot memory holds the program: static buffers
+    bench_memcpy_memory("BRAM", (uint8_t *) bram_dst, (const uint8_t *) bram_src);
+
+    // The others, when in the configuration: past the sections placed there (placement.h)
+    if (_memory_DDR_end != 0 && _memory_DDR_free + 2 * COPY_BYTES <= _memory_DDR_end)
+        bench_memcpy_memory("DDR", _memory_DDR_free + COPY_BYTES, _memory_DDR_free);
+    if (_memory_HBM_end != 0 && _memory_HBM_free + 2 * COPY_BYTES <= _memory_HBM_end)
+        bench_memcpy_memory("HBM", _memory_HBM_free + COPY_BYTES, _memory_HBM_free);
+}
@@ -0,0 +1,83 @@
+#include "bench.h"
+
+// Accesses per measure
+#define MMIO_ACCESSES   64
+
+// Registers offsets
+#define UART_STAT_OFFSET    0x8
+#define GPIO_DATA_OFFSET    0x0
+#define TIM_TLR_OFFSET      0x4
+#define TIM_TCR_OFFSET      0x8
+#define PLIC_PRIO_OFFSET    0x4     // Priority of source 1
+
+static void bench_mmio_read(const char * name, volatile uint32_t * reg){
+
+    perf_counters_t best;
+    perf_counters_t counters;
+
+    best.cycles = ~(uint64_t) 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        perf_start(&counters);
+        for (int i = 0; i < MMIO_ACCESSES; i++)
+            (void) *reg;
+        perf_stop(&counters);
+        bench_keep_best(&best, &counters);
+    }
+
+    bench_line_start("mmio", name);
+    bench_line_str("access", "read");
+    bench_line_u64("accesses", MMIO_ACCESSES);
+    bench_line_u64("cycles_per_access", (uint32_t) best.cycles / MMIO_ACCESSES);
+    bench_line_counters(&best);
+    bench_line_end();
+}
+
+// Write back the current value: no side effects on the peripheral
+static void bench_mmio_write(const char * name, volatile uint32_t * reg){
+
+    perf_counters_t best;
+    perf_counters_t counters;
+    uint32_t value = *reg;
+
+    best.cycles = ~(uint64_t) 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        perf_start(&counters);
+        for (int i = 0; i < MMIO_ACCESSES; i++)
+            *reg = value;
+        perf_stop(&counters);
+        bench_keep_best(&best, &counters);
+    }
+
+    bench_line_start("mmio", name);
+    bench_line_str("access", "write");
+    bench_line_u64("accesses", MMIO_ACCESSES);
+    bench_line_u64("cycles_per_access", (uint32_t) best.cycles / MMIO_ACCESSES);
+    bench_line_counters(&best);
+    bench_line_end();
+}
+
+static volatile uint32_t * mmio_reg(const volatile uint32_t * base, uint32_t offset){
+    return (volatile uint32_t *) ((uintptr_t) base + offset);
+}
+
+void bench_mmio(){
+
+    // PBUS peripherals, the ones in the configuration
+    bench_mmio_read("UART_STAT", mmio_reg(&_peripheral_UART_start, UART_STAT_OFFSET));
+    if (&_peripheral_GPIO_in_end != 0)
+        bench_mmio_read("GPIO_in_DATA", mmio_reg(&_peripheral_GPIO_in_start, GPIO_DATA_OFFSET));
+    if (&_peripheral_GPIO_out_end != 0) {
+        bench_mmio_read("GPIO_out_DATA", mmio_reg(&_peripheral_GPIO_out_start, GPIO_DATA_OFFSET));
+        bench_mmio_write("GPIO_out_DATA", mmio_reg(&_peripheral_GPIO_out_start, GPIO_DATA_OFFSET));
+    }
+    if (&_peripheral_TIM0_end != 0)
+        bench_mmio_read("TIM0_TCR", mmio_reg(&_peripheral_TIM0_start, TIM_TCR_OFFSET));
+    if (&_peripheral_TIM1_end != 0) {
+        bench_mmio_read("TIM1_TCR", mmio_reg(&_peripheral_TIM1_start, TIM_TCR_OFFSET));
+        bench_mmio_write("TIM1_TLR", mmio_reg(&_peripheral_TIM1_start, TIM_TLR_OFFSET));
+    }
+
+    // The PLIC, on the main bus
+    bench_mmio_read("PLIC_PRIO", mmio_reg(&_peripheral_PLIC_start, PLIC_PRIO_OFFSET));
+    bench_mmio_write("PLIC_PRIO", mmio_reg(&_peripheral_PLIC_start, PLIC_PRIO_OFFSET));
+}
@@ -0,0 +1,37 @@
+#ifndef IRQ_STATS_H
+#define IRQ_STATS_H
+
+#include <stdint.h>
+#include "plic.h"
+
+// Min, max and sum of a measure, in the handlers
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t sum;       // Wraps after 2^32, reset the statistics for long runs
+} irq_stat_t;
+
+// Latency of the TIM1 probe, in timer ticks (see xlnx_tim.h)
+extern volatile irq_stat_t probe_latency;
+// Duration of the external interrupt handling per PLIC source, in core cycles:
+// from the handler call to its return, the dispatch excluded (see interrupts.c)
+extern volatile irq_stat_t isr_cycles[SOURCE_NUM];
+
+// Core cycles, low XLEN bits
+static inline uint32_t irq_cycles(){
+    uintptr_t cycles;
+    __asm__ volatile("rdcycle %0" : "=r"(cycles));
+    return (uint32_t) cycles;
+}
+
+// Functions
+void irq_stats_init();
+void irq_stat_add(volatile irq_stat_t * stat, uint32_t value);
+
+// Print the statistics from the main loop (not from handlers), one line:
+// [IRQ] tim0=<count> probe_latency_ticks=<count>/<min>/<avg>/<max> isr_cycles_<source>=<count>/<min>/<avg>/<max> ...
+//       traps=<count> claims=<count> nested=<count>
+void irq_stats_print();
+
+#endif
@@ -3,14 +3,21 @@
 
 #include <stdint.h>
 
-#define INT_ENABLE_OFFSET 0x2000
-#define SOURCE_NUM 4
+// PLIC sources (PLIC_*_INTERRUPT in hw/xilinx/rtl/uninasoc_pkg.sv), source 0 is reserved
+#define GPIO_IN_SOURCE  1
+#define TIM0_SOURCE     2
+#define TIM1_SOURCE     3
+#define UART_SOURCE     4
+#define SOURCE_NUM      5
+
+// Priorities, 1 is the lowest. With NESTING=1 (Makefile), a handler is preempted by the
+// sources with a higher priority only: the latency probe preempts all the others.
+#define GPIO_IN_PRIORITY    1
+#define TIM0_PRIORITY       1
+#define UART_PRIORITY       2
+#define TIM1_PRIORITY       3
 
 // Import linker script symbol
 extern const volatile uint32_t _peripheral_PLIC_start;
 
-// Functions
-void plic_configure();
-void plic_enable();
-
-#endif
\ No newline at end of file
+#endif
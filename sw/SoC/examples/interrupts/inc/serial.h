@@ -1,7 +1,24 @@
 #ifndef PRINT_H
 #define PRINT_H
 
-#include "tinyIO.h"
+#include <stdint.h>
+
+// Serial driver, selected with SERIAL in the Makefile:
+//  - irq (default): interrupt-driven, ring-buffered UART driver (lib/uart). The handlers defer their prints
+//    to the main loop, that calls serial_poll().
+//  - polled: tinyIO, the handlers print and wait for each char to leave the UART.
+
+#ifdef SERIAL_POLLED
+    #include "tinyIO.h"
+    #define serial_printf       printf
+    #define serial_printf_isr   printf
+    #define serial_poll()
+#else
+    #include "uart.h"
+    #define serial_printf       uart_printf
+    #define serial_printf_isr   uart_defer
+    #define serial_poll()       uart_defer_process()
+#endif
 
 // Import linker script symbol
 extern const volatile uint32_t _peripheral_UART_start;
@@ -9,4 +26,4 @@ extern const volatile uint32_t _peripheral_UART_start;
 void serial_init();
 
 
-#endif
\ No newline at end of file
+#endif
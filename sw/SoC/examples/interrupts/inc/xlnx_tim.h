@@ -3,15 +3,33 @@
 
 #include <stdint.h>
 
+// Registers of timer 0 of the IP
+#define TIM_TCSR    0x0     // Control and status
+#define TIM_TLR     0x4     // Load
+#define TIM_TCR     0x8     // Counter
+
+// Periods, in timer ticks
+#define TIM0_PERIOD 0x1312D00   // That is 20000000 to count one second at 20 MHz
+#define TIM1_PERIOD 2000000     // 100 ms at 20 MHz, longer than a handler printing on the polled UART
+
 // Import linker script symbol
 extern const volatile uint32_t _peripheral_TIM0_start;
+extern const volatile uint32_t _peripheral_TIM1_start;
 
 // Functions
-void tim_configure();
-void tim_enable_int();
-void tim_enable();
+void tim_configure(uint32_t * tim_addr, uint32_t period);
+void tim_enable_int(uint32_t * tim_addr);
+void tim_enable(uint32_t * tim_addr);
 
+// Ticks since the timer expired (down counter, auto reload), i.e. the interrupt latency if read first in the handler
+uint32_t tim_elapsed(uint32_t * tim_addr);
+
+// TIM0: message on the serial device
 void tim_handler();
 
+// TIM1: latency probe, it only records its latency.
+// It fires independently of TIM0, so its latency grows when the handlers of the other sources are slow.
+void tim1_handler();
+
 
-#endif
\ No newline at end of file
+#endif
@@ -1,43 +1,58 @@
 #include "interrupts.h"
 #include "plic.h"
 #include "xlnx_tim.h"
+#include "serial.h"
+#include "irq_stats.h"
 
 #ifdef IS_EMBEDDED
     #include "xlnx_gpio.h"
 #endif
 
+// The handlers duration, per source: from the call to the return, the dispatch excluded
+#define TIMED_HANDLER(name, source, handler)                        \
+    static void name(void) {                                        \
+        uint32_t start = irq_cycles();                              \
+        handler();                                                  \
+        irq_stat_add(&isr_cycles[source], irq_cycles() - start);    \
+    }
 
-// This function is based on low risc demo system hal
-int install_exception_handler(uint32_t vector_num, void (*handler_fn)(void)) {
-
-    if (vector_num >= 32) return 1;
-
-    volatile uint32_t* vector_table_entry = (uint32_t *)(&_vector_table_start) + vector_num;
-
-    // Compute the relative jump stride
-    int32_t offset = (uint32_t)handler_fn - (uint32_t)vector_table_entry;
+#ifdef IS_EMBEDDED
+// GPIO_in (Switch) interrupts (embedded config only)
+TIMED_HANDLER(gpio_isr, GPIO_IN_SOURCE, gpio_handler)
+#endif
+// Timer interrupt
+TIMED_HANDLER(tim0_isr, TIM0_SOURCE, tim_handler)
+// Latency probe
+TIMED_HANDLER(tim1_isr, TIM1_SOURCE, tim1_handler)
+#ifndef SERIAL_POLLED
+// UART interrupt, feeds and drains the serial rings
+TIMED_HANDLER(uart_irq_isr, UART_SOURCE, uart_isr)
+#endif
 
-    // Build the jump instruction
-    if ((offset >= (1 << 19)) || (offset < -(1 << 19))) {
-      return 2;
-    }
+void interrupts_init(){
 
-    uint32_t offset_uimm = offset;
-    uint32_t jmp_ins = ((offset_uimm & 0x7fe) << 20) |     // imm[10:1] -> 21
-                       ((offset_uimm & 0x800) << 9) |      // imm[11] -> 20
-                       (offset_uimm & 0xff000) |           // imm[19:12] -> 12
-                       ((offset_uimm & 0x100000) << 11) |  // imm[20] -> 31
-                       0x6f;                               // J opcode
+    // In this example, the core is connected to PLIC target 0, through the EXT line.
+    // The dispatcher claims the sources until none is pending, and calls their handlers.
+    irq_init((uintptr_t) &_peripheral_PLIC_start);
 
-    // Overwrite vector table entry with the jump instruction
-    *vector_table_entry = jmp_ins;
+    #ifdef IRQ_NESTING
+        irq_set_nesting(1);
+    #endif
 
-    //__asm__ volatile("fence.i;");
+    #ifdef IS_EMBEDDED
+        irq_register(GPIO_IN_SOURCE, gpio_isr, GPIO_IN_PRIORITY);
+    #endif
+    irq_register(TIM0_SOURCE, tim0_isr, TIM0_PRIORITY);
+    irq_register(TIM1_SOURCE, tim1_isr, TIM1_PRIORITY);
+    #ifndef SERIAL_POLLED
+        irq_register(UART_SOURCE, uart_irq_isr, UART_PRIORITY);
+    #endif
 
-    return 0;
+    // The other lines (only the EXT line is actually used)
+    irq_install_vector(IRQ_VECTOR_SW, _sw_handler);
+    irq_install_vector(IRQ_VECTOR_TIM, _timer_handler);
 }
 
-
 void _sw_handler(void) {
     // Unused for this example
 }
@@ -45,42 +60,3 @@ void _sw_handler(void) {
 void _timer_handler(void) {
     // Unused for this example
 }
-
-void _ext_handler(void) {
-
-    // Interrupts are automatically disabled by the microarchitecture (uarch).
-    // Nested interrupts can be enabled manually by setting the IE bit in the mstatus register,
-    // but this requires careful handling of registers.
-    // Interrupts are automatically re-enabled by the microarchitecture when the MRET instruction is executed.
-
-    // Since this code calls other functions, the compiler will likely save ALL registers,
-    // including floating-point and vector registers. To ensure compatibility with most processors,
-    // we compile using only the IMA extensions.
-
-    // In this example, the core is connected to PLIC target 1 line.
-    // Therefore, we need to access the PLIC claim/complete register 1 (base_addr + 0x200004).
-    // The interrupt source ID is obtained from the claim register.
-    uint32_t * plic_addr = (uint32_t *) &_peripheral_PLIC_start;
-    uint32_t interrupt_id = *(plic_addr + 0x200004/sizeof(uint32_t));
-
-    switch(interrupt_id){
-        case 0x0: // unused
-            break;
-        case 0x1:
-        #ifdef IS_EMBEDDED
-            // GPIO_in (Switch) interrupts (embedded config only)
-            gpio_handler();
-        #endif
-        break;
-        case 0x2:
-            // Timer interrupt
-            tim_handler();
-            break;
-        default:
-            break;
-    }
-
-    // To notify the handler completion, a write-back on the claim/complete register is required.
-    *(plic_addr + 0x200004/sizeof(uint32_t)) = interrupt_id;
-
-}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "irq_stats.h"
+#include "serial.h"
+#include "irq.h"
+
+volatile irq_stat_t probe_latency;
+volatile irq_stat_t isr_cycles[SOURCE_NUM];
+
+static const char * source_names[SOURCE_NUM] = { "none", "gpio_in", "tim0", "tim1", "uart" };
+
+static void irq_stat_clear(volatile irq_stat_t * stat){
+    stat->count = 0;
+    stat->min = 0xFFFFFFFF;
+    stat->max = 0;
+    stat->sum = 0;
+}
+
+void irq_stats_init(){
+
+    // The counters may be inhibited at reset (e.g. on CV32E40P): enable them all
+    __asm__ volatile("csrw 0x320, zero");  // mcountinhibit
+
+    irq_stat_clear(&probe_latency);
+    for (int i = 0; i < SOURCE_NUM; i++)
+        irq_stat_clear(&isr_cycles[i]);
+}
+
+void irq_stat_add(volatile irq_stat_t * stat, uint32_t value){
+    stat->count++;
+    stat->sum += value;
+    if (value < stat->min) stat->min = value;
+    if (value > stat->max) stat->max = value;
+}
+
+void irq_stats_print(){
+
+    irq_stat_t snapshot[SOURCE_NUM + 1];
+    const irq_counters_t * counters = irq_get_counters();
+    uint32_t traps;
+    uint32_t claims;
+    uint32_t nested;
+
+    // Consistent copy, with the interrupts disabled
+    __asm__ volatile("csrc mstatus, 0x8");
+    for (int i = 0; i < SOURCE_NUM + 1; i++) {
+        volatile irq_stat_t * stat = (i == 0) ? &probe_latency : &isr_cycles[i - 1];
+        snapshot[i].count = stat->count;
+        snapshot[i].min = stat->min;
+        snapshot[i].max = stat->max;
+        snapshot[i].sum = stat->sum;
+    }
+    traps = counters->traps;
+    claims = counters->claims;
+    nested = counters->nested;
+    __asm__ volatile("csrs mstatus, 0x8");
+
+    serial_printf("[IRQ] tim0=%u", snapshot[3].count);
+    for (int i = 0; i < SOURCE_NUM + 1; i++) {
+        if (snapshot[i].count == 0)
+            continue;
+        if (i == 0)
+            serial_printf(" probe_latency_ticks=");
+        else
+            serial_printf(" isr_cycles_%s=", source_names[i - 1]);
+        serial_printf("%u/%u/%u/%u", snapshot[i].count, snapshot[i].min,
+                      snapshot[i].sum / snapshot[i].count, snapshot[i].max);
+    }
+    // Dispatch: more claims than traps when the sources come in bursts
+    serial_printf(" traps=%u claims=%u nested=%u\n\r", traps, claims, nested);
+}
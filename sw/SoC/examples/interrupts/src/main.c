@@ -7,9 +7,18 @@
 //      The timer sends a message on the serial device every second, while gpio_in enables
 //      the LED corresponding to a specific switch (only applicable in embedded configurations).
 //
+//      The handler timing is measured too: a second timer (TIM1) is a latency probe, and the
+//      main loop prints the statistics after each message (see irq_stats.h). With the default
+//      interrupt-driven serial driver, the UART is a third source, and the timer handler defers
+//      its message to the main loop; with SERIAL=polled (make clean first), the timer handler
+//      prints it and the probe waits for it.
+//
 //      Note 1: The PLIC is connected to the core via the EXT line. Both the timer and gpio_in are expected
 //      to be connected to the PLIC. The timer must NOT be connected directly to the core's TIM line in this example.
 //
+//      The PLIC sources are dispatched by lib/irq: a handler table, filled in interrupts_init(). With NESTING=1
+//      (make clean first), the handlers are preempted by the sources with a higher priority (see plic.h).
+//
 //      Note 2: The IS_EMBEDDED macro is automatically defined in this example's Makefile depending on
 //      vesuvius configuration (according to the SOC_CONFIG envvar set in settings.sh)
 //
@@ -20,6 +29,7 @@
 #include "plic.h"
 #include "interrupts.h"
 #include "serial.h"
+#include "irq_stats.h"
 
 #ifdef IS_EMBEDDED
     #include "xlnx_gpio.h"
@@ -27,19 +37,14 @@
 
 int main(){
 
-    // Define vector table entries for handlers (only the EXT line is actually used).
-    install_exception_handler(SW_ENTRY, _sw_handler);
-    install_exception_handler(TIM_ENTRY, _timer_handler);
-    install_exception_handler(EXT_ENTRY, _ext_handler);
-
-    // Initialize the serial device (using tinyIO)
+    // Initialize the serial device and the statistics
     serial_init();
+    irq_stats_init();
 
-    printf("Interrupts Example\n\r");
+    // Register the handlers, and configure the PLIC
+    interrupts_init();
 
-    // Configure the PLIC
-    plic_configure();
-    plic_enable();
+    serial_printf("Interrupts Example\n\r");
 
     #ifdef IS_EMBEDDED
     // Configure the GPIO (embedded only)
@@ -49,11 +54,28 @@ int main(){
     #endif
 
     // Configure the timer
-    tim_configure();
-    tim_enable_int();
-    tim_enable();
+    uint32_t * tim0_addr = (uint32_t *) &_peripheral_TIM0_start;
+    tim_configure(tim0_addr, TIM0_PERIOD);
+    tim_enable_int(tim0_addr);
+    tim_enable(tim0_addr);
+
+    // Configure the latency probe
+    uint32_t * tim1_addr = (uint32_t *) &_peripheral_TIM1_start;
+    tim_configure(tim1_addr, TIM1_PERIOD);
+    tim_enable_int(tim1_addr);
+    tim_enable(tim1_addr);
+
+    uint32_t tim0_count = 0;
+    while(1) {
+        // Deferred prints of the handlers
+        serial_poll();
 
-    while(1);
+        // Statistics, after each timer message
+        if (isr_cycles[TIM0_SOURCE].count != tim0_count) {
+            tim0_count = isr_cycles[TIM0_SOURCE].count;
+            irq_stats_print();
+        }
+    }
 
     return 0;
 }
@@ -4,5 +4,10 @@ void serial_init(){
 
     uint32_t* uart_base_address = (uint32_t*) &_peripheral_UART_start;
 
+#ifdef SERIAL_POLLED
     tinyIO_init((uint32_t) uart_base_address);
-}
\ No newline at end of file
+#else
+    // The UART source must be enabled in the PLIC too
+    uart_init((uintptr_t) uart_base_address);
+#endif
+}
@@ -1,12 +1,11 @@
 #include "xlnx_tim.h"
 #include "serial.h"
+#include "irq_stats.h"
 
-void tim_configure(){
-
-    uint32_t * tim_addr = (uint32_t *) &_peripheral_TIM0_start;
+void tim_configure(uint32_t * tim_addr, uint32_t period){
 
     // Configure timer prescaler
-    *(tim_addr + ( 0x4 )/ sizeof(uint32_t)) = 0x1312D00;  // That is 20000000 to count one second at 20 MHz
+    *(tim_addr + ( TIM_TLR )/ sizeof(uint32_t)) = period;
 
     // Set the LOAD0 bit to transfer the value to TCR0
     *(tim_addr) = 0x00000020;  // LOAD0 = 1 (bit 5), all others set to 0
@@ -19,28 +18,31 @@ void tim_configure(){
     *(tim_addr) |= 0x02;  // UDT0 = 1 (bit 1), enable down counting
 }
 
-void tim_enable_int(){
-
-    uint32_t * tim_addr = (uint32_t *) &_peripheral_TIM0_start;
+void tim_enable_int(uint32_t * tim_addr){
 
     // Enable the interrupt
     *(tim_addr) |= 0x40;   // ENIT0 = 1 (bit 6), interrupt enabled
 }
 
-void tim_enable(){
-
-    uint32_t * tim_addr = (uint32_t *) &_peripheral_TIM0_start;
+void tim_enable(uint32_t * tim_addr){
 
     // Enable the timer
     *(tim_addr) |= 0x80;  // ENT0 = 1 (bit 7), timer enabled
 }
 
+uint32_t tim_elapsed(uint32_t * tim_addr){
+
+    // Counting down from TLR0 since the reload
+    return *(tim_addr + TIM_TLR / sizeof(uint32_t)) - *(tim_addr + TIM_TCR / sizeof(uint32_t));
+}
+
 void tim_handler(){
 
     uint32_t * tim_addr = (uint32_t *) &_peripheral_TIM0_start;
 
-    // Print
-    printf("\n\r******* Timer Interrupt! *******\n\r\n\r");
+    // Print: deferred to the main loop with the interrupt-driven driver,
+    // here until the last char leaves with the polled one
+    serial_printf_isr("\n\r******* Timer Interrupt! *******\n\r\n\r");
 
     // Clear timer interrupt by setting TCSR0.T0INT
     *tim_addr = 0x100;
@@ -48,4 +50,14 @@ void tim_handler(){
     // Restart the timer
     *tim_addr = 0xD2;
 
-}
\ No newline at end of file
+}
+
+void tim1_handler(){
+
+    uint32_t * tim_addr = (uint32_t *) &_peripheral_TIM1_start;
+
+    irq_stat_add(&probe_latency, tim_elapsed(tim_addr));
+
+    // Clear timer interrupt by setting TCSR0.T0INT, leaving the timer running
+    *tim_addr = 0x1D2;
+}
@@ -0,0 +1,89 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description:
+//      Table-driven dispatch of the PLIC interrupts (machine external interrupt, target 0).
+//      irq_init() installs irq_ext_entry in the vector table: a trap stub that saves only the registers
+//      not preserved by the calling convention, and calls irq_dispatch(). The dispatcher claims the
+//      PLIC sources until none is pending, and calls the handler registered for each one: a burst of
+//      interrupts takes one trap.
+//      The handlers are plain C functions (no interrupt attribute): the stub does the save and the mret.
+//
+//      Nesting (irq_set_nesting()): the dispatcher raises the PLIC threshold to the priority of the source
+//      being handled and enables the interrupts around its handler, so that only the sources with a higher
+//      priority preempt it. mepc and mstatus are saved on the stack in that case only.
+//
+//      Usage:
+//          irq_init((uintptr_t) &_peripheral_PLIC_start);
+//          irq_register(PLIC_TIM0_SOURCE, tim_handler, 1);
+//          irq_enable();
+//
+//      Note: the stub and the dispatcher are in the boot memory block (PLACE_FAST_TEXT, placement.h).
+
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdint.h>
+
+// Sources of the PLIC (SOURCE_NUM in hw/units/custom_rv_plic), source 0 is reserved
+#ifndef IRQ_MAX_SOURCES
+#define IRQ_MAX_SOURCES     32
+#endif
+
+// Vector table entries
+#define IRQ_VECTOR_SW       3
+#define IRQ_VECTOR_TIM      7
+#define IRQ_VECTOR_EXT      11
+
+// PLIC registers offsets, target 0
+#define IRQ_PLIC_PRIORITY   0x0         // + 4 * source
+#define IRQ_PLIC_PENDING    0x1000
+#define IRQ_PLIC_ENABLE     0x2000
+#define IRQ_PLIC_THRESHOLD  0x200000
+#define IRQ_PLIC_CLAIM      0x200004
+
+typedef void (*irq_handler_t)(void);
+
+typedef struct {
+    uint32_t traps;         // irq_dispatch() calls
+    uint32_t claims;        // Sources handled, more than traps when they come in bursts
+    uint32_t spurious;      // Traps with nothing to claim
+    uint32_t unhandled;     // Claims of a source without handler, which is then disabled
+    uint32_t nested;        // Handlers preempting another one
+} irq_counters_t;
+
+// Disable all the sources, set the PLIC threshold to 0 and install irq_ext_entry.
+// The machine interrupts (mstatus.MIE) are left as they are.
+void irq_init(uintptr_t plic_base);
+
+// Write a jump to handler_fn in a vector table entry, and synchronize the instruction fetch.
+// Return 1 if vector_num is out of the table, 2 if handler_fn is out of the jump range.
+int irq_install_vector(uint32_t vector_num, void (*handler_fn)(void));
+
+// Set the handler and the priority (1 is the lowest) of a source, and enable it.
+// Return 1 if the source is out of range, 2 if the priority is 0 (the source would never fire).
+int irq_register(uint32_t source, irq_handler_t handler, uint32_t priority);
+
+// Disable a source, and remove its handler
+void irq_unregister(uint32_t source);
+
+// Allow handlers to be preempted by sources with a higher priority (0 to disable, default)
+void irq_set_nesting(int enable);
+
+// Source being handled, 0 out of the handlers
+uint32_t irq_current_source();
+
+const irq_counters_t * irq_get_counters();
+
+// Trap stub, for irq_install_vector() and the vector table, and its dispatcher
+void irq_ext_entry();
+void irq_dispatch();
+
+// Machine interrupts enable (mstatus.MIE)
+static inline void irq_enable(){
+    __asm__ volatile("csrs mstatus, 0x8" : : : "memory");
+}
+
+static inline void irq_disable(){
+    __asm__ volatile("csrc mstatus, 0x8" : : : "memory");
+}
+
+#endif
@@ -0,0 +1,261 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description:
+//      PLIC interrupt dispatch, see irq.h.
+//      irq_ext_entry saves the caller-saved registers (ra, t0-t6, a0-a7): irq_dispatch() and the handlers
+//      are compiled as regular functions, which preserve the others. An interrupt attribute handler
+//      calling functions saves the same registers, plus the ones its own body uses, and at -O0 the
+//      frame pointer: the stub is the least any C dispatcher needs.
+
+#include "irq.h"
+#include "placement.h"
+
+#if __riscv_xlen == 64
+#define IRQ_STORE   "sd"
+#define IRQ_LOAD    "ld"
+#define IRQ_REGB    "8"
+#else
+#define IRQ_STORE   "sw"
+#define IRQ_LOAD    "lw"
+#define IRQ_REGB    "4"
+#endif
+
+#define IRQ_SAVE(reg, slot)     "   " IRQ_STORE " " #reg ", " #slot "*" IRQ_REGB "(sp)\n"
+#define IRQ_RESTORE(reg, slot)  "   " IRQ_LOAD " " #reg ", " #slot "*" IRQ_REGB "(sp)\n"
+
+// Trap stub, 16 registers frame (16-byte aligned on both XLEN)
+__asm__ (
+    "   .pushsection .text.fast, \"ax\"\n"
+    "   .align 2\n"
+    "   .global irq_ext_entry\n"
+    "irq_ext_entry:\n"
+    "   addi sp, sp, -16*" IRQ_REGB "\n"
+    IRQ_SAVE(ra, 0)
+    IRQ_SAVE(t0, 1)
+    IRQ_SAVE(t1, 2)
+    IRQ_SAVE(t2, 3)
+    IRQ_SAVE(a0, 4)
+    IRQ_SAVE(a1, 5)
+    IRQ_SAVE(a2, 6)
+    IRQ_SAVE(a3, 7)
+    IRQ_SAVE(a4, 8)
+    IRQ_SAVE(a5, 9)
+    IRQ_SAVE(a6, 10)
+    IRQ_SAVE(a7, 11)
+    IRQ_SAVE(t3, 12)
+    IRQ_SAVE(t4, 13)
+    IRQ_SAVE(t5, 14)
+    IRQ_SAVE(t6, 15)
+    "   call irq_dispatch\n"
+    IRQ_RESTORE(ra, 0)
+    IRQ_RESTORE(t0, 1)
+    IRQ_RESTORE(t1, 2)
+    IRQ_RESTORE(t2, 3)
+    IRQ_RESTORE(a0, 4)
+    IRQ_RESTORE(a1, 5)
+    IRQ_RESTORE(a2, 6)
+    IRQ_RESTORE(a3, 7)
+    IRQ_RESTORE(a4, 8)
+    IRQ_RESTORE(a5, 9)
+    IRQ_RESTORE(a6, 10)
+    IRQ_RESTORE(a7, 11)
+    IRQ_RESTORE(t3, 12)
+    IRQ_RESTORE(t4, 13)
+    IRQ_RESTORE(t5, 14)
+    IRQ_RESTORE(t6, 15)
+    "   addi sp, sp, 16*" IRQ_REGB "\n"
+    "   mret\n"
+    "   .popsection\n"
+);
+
+static volatile uint32_t * irq_plic;
+
+static irq_handler_t irq_table[IRQ_MAX_SOURCES];
+static uint32_t irq_priority[IRQ_MAX_SOURCES];
+static int irq_nesting;
+static volatile uint32_t irq_source;
+static uint32_t irq_depth;
+static irq_counters_t irq_counters;
+
+static inline volatile uint32_t * irq_plic_reg(uint32_t offset){
+    return irq_plic + offset / sizeof(uint32_t);
+}
+
+static void irq_source_enable(uint32_t source, int enable){
+    volatile uint32_t * reg = irq_plic_reg(IRQ_PLIC_ENABLE) + source / 32;
+    if ( enable )
+        *reg |= 1u << ( source % 32 );
+    else
+        *reg &= ~( 1u << ( source % 32 ) );
+}
+
+/////////////////////////
+// Setup               //
+/////////////////////////
+
+void irq_init(uintptr_t plic_base){
+
+    irq_plic = (volatile uint32_t *) plic_base;
+
+    // The state is not in an initialized section
+    for ( int i = 0; i < IRQ_MAX_SOURCES; i++ ) {
+        irq_table[i] = 0;
+        irq_priority[i] = 0;
+    }
+    irq_nesting = 0;
+    irq_source = 0;
+    irq_depth = 0;
+    irq_counters.traps = 0;
+    irq_counters.claims = 0;
+    irq_counters.spurious = 0;
+    irq_counters.unhandled = 0;
+    irq_counters.nested = 0;
+
+    // All the sources disabled, with priority 0, and any priority above the threshold
+    for ( int i = 0; i < ( IRQ_MAX_SOURCES + 31 ) / 32; i++ )
+        *(irq_plic_reg(IRQ_PLIC_ENABLE) + i) = 0;
+    for ( int i = 1; i < IRQ_MAX_SOURCES; i++ )
+        *(irq_plic_reg(IRQ_PLIC_PRIORITY) + i) = 0;
+    *irq_plic_reg(IRQ_PLIC_THRESHOLD) = 0;
+
+    irq_install_vector(IRQ_VECTOR_EXT, irq_ext_entry);
+
+    // Machine external interrupt line (startup.s enables it too)
+    __asm__ volatile("csrs mie, %0" : : "r"(0x800));
+}
+
+int irq_install_vector(uint32_t vector_num, void (*handler_fn)(void)){
+
+    if ( vector_num >= 32 )
+        return 1;
+
+    extern const volatile uint32_t _vector_table_start;
+    volatile uint32_t * vector_table_entry = (volatile uint32_t *) &_vector_table_start + vector_num;
+
+    // Relative jump, within +-1 MiB
+    intptr_t offset = (intptr_t) handler_fn - (intptr_t) vector_table_entry;
+    if ( ( offset >= ( 1 << 20 ) ) || ( offset < -( 1 << 20 ) ) )
+        return 2;
+
+    uint32_t offset_uimm = offset;
+    uint32_t jmp_ins = ( ( offset_uimm & 0x7fe ) << 20 ) |     // imm[10:1] -> 21
+                       ( ( offset_uimm & 0x800 ) << 9 ) |      // imm[11] -> 20
+                       ( offset_uimm & 0xff000 ) |             // imm[19:12] -> 12
+                       ( ( offset_uimm & 0x100000 ) << 11 ) |  // imm[20] -> 31
+                       0x6f;                                   // J opcode
+
+    *vector_table_entry = jmp_ins;
+
+    // The old entry may be in the instruction cache or in the fetch pipeline
+    __asm__ volatile("fence.i" : : : "memory");
+
+    return 0;
+}
+
+int irq_register(uint32_t source, irq_handler_t handler, uint32_t priority){
+
+    if ( source == 0 || source >= IRQ_MAX_SOURCES )
+        return 1;
+    if ( priority == 0 )
+        return 2;
+
+    irq_table[source] = handler;
+    irq_priority[source] = priority;
+    *(irq_plic_reg(IRQ_PLIC_PRIORITY) + source) = priority;
+    irq_source_enable(source, 1);
+
+    return 0;
+}
+
+void irq_unregister(uint32_t source){
+
+    if ( source == 0 || source >= IRQ_MAX_SOURCES )
+        return;
+
+    irq_source_enable(source, 0);
+    *(irq_plic_reg(IRQ_PLIC_PRIORITY) + source) = 0;
+    irq_table[source] = 0;
+    irq_priority[source] = 0;
+}
+
+void irq_set_nesting(int enable){
+    irq_nesting = enable;
+}
+
+uint32_t irq_current_source(){
+    return irq_source;
+}
+
+const irq_counters_t * irq_get_counters(){
+    return &irq_counters;
+}
+
+/////////////////////////
+// Dispatch            //
+/////////////////////////
+
+// Run a handler with the interrupts enabled, above its priority
+PLACE_FAST_TEXT static void irq_call_nested(uint32_t source, irq_handler_t handler){
+
+    volatile uint32_t * threshold = irq_plic_reg(IRQ_PLIC_THRESHOLD);
+    uint32_t saved_threshold = *threshold;
+    uint32_t saved_source = irq_source;
+    uintptr_t mepc;
+    uintptr_t mstatus;
+
+    // A nested trap overwrites them
+    __asm__ volatile("csrr %0, mepc" : "=r"(mepc));
+    __asm__ volatile("csrr %0, mstatus" : "=r"(mstatus));
+
+    if ( irq_depth != 0 )
+        irq_counters.nested++;
+    irq_depth++;
+    irq_source = source;
+    *threshold = irq_priority[source];
+
+    __asm__ volatile("csrs mstatus, 0x8" : : : "memory");
+    handler();
+    __asm__ volatile("csrc mstatus, 0x8" : : : "memory");
+
+    *threshold = saved_threshold;
+    irq_source = saved_source;
+    irq_depth--;
+
+    __asm__ volatile("csrw mepc, %0" : : "r"(mepc));
+    __asm__ volatile("csrw mstatus, %0" : : "r"(mstatus));
+}
+
+PLACE_FAST_TEXT void irq_dispatch(){
+
+    volatile uint32_t * claim = irq_plic_reg(IRQ_PLIC_CLAIM);
+    uint32_t source = *claim;
+
+    irq_counters.traps++;
+    if ( source == 0 ) {
+        irq_counters.spurious++;
+        return;
+    }
+
+    // Claim until nothing is pending
+    do {
+        irq_handler_t handler = ( source < IRQ_MAX_SOURCES ) ? irq_table[source] : 0;
+
+        irq_counters.claims++;
+        if ( handler == 0 ) {
+            // Would fire again at once
+            irq_counters.unhandled++;
+            irq_source_enable(source, 0);
+        }
+        else if ( irq_nesting ) {
+            irq_call_nested(source, handler);
+        }
+        else {
+            irq_source = source;
+            handler();
+            irq_source = 0;
+        }
+
+        // Complete, and claim the next one
+        *claim = source;
+        source = *claim;
+    } while ( source != 0 );
+}
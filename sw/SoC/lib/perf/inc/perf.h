@@ -0,0 +1,63 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description:
+//      Portable access to the hardware performance counters of the supported cores: cycles, retired
+//      instructions and the available mhpmcounters, as 64-bit values on both XLEN.
+//      The core is selected at build time with CORE_SELECTOR (sw/SoC/common/config.mk):
+//          CORE_CV32E40P   mcycle, minstret, mhpmcounter3.. (NUM_MHPMCOUNTERS, programmable events)
+//          CORE_IBEX       mcycle, minstret, mhpmcounter3..12 (MHPMCounterNum, fixed events)
+//          CORE_CV64A6     mcycle, minstret, mhpmcounter3..8 (programmable events)
+//          CORE_PICORV32   cycle, instret (ENABLE_COUNTERS), no mhpmcounters
+//      perf_init() enables the counters, programs the events and finds the implemented mhpmcounters
+//      (the others are hardwired to zero).
+//
+//      Usage:
+//          perf_counters_t c;
+//          perf_start(&c);
+//          kernel();
+//          perf_stop(&c);      // c holds the counts of kernel(), the measurement overhead subtracted
+//          perf_format(line, sizeof(line), &c);
+//
+//      Note: machine mode only, the counters are read with the machine CSRs (but on PicoRV32).
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+
+// Most mhpmcounters handled, from mhpmcounter3
+#define PERF_HPM_MAX    10
+
+typedef struct {
+    uint64_t cycles;
+    uint64_t instret;
+    uint64_t hpm[PERF_HPM_MAX];     // The first perf_hpm_num() ones
+} perf_counters_t;
+
+// Enable the counters and program the events. Return the number of mhpmcounters available.
+int perf_init();
+
+// Core name, as CORE_SELECTOR without prefix (e.g. "cv32e40p")
+const char * perf_core_name();
+
+uint64_t perf_cycles();
+uint64_t perf_instret();
+
+// Available mhpmcounters, their event names and values
+int perf_hpm_num();
+const char * perf_hpm_name(int index);
+uint64_t perf_hpm_read(int index);
+
+// Snapshot of all the counters
+void perf_read(perf_counters_t * counters);
+
+// Start a measure, and stop it: counters becomes the difference, without the measurement overhead
+void perf_start(perf_counters_t * counters);
+void perf_stop(perf_counters_t * counters);
+
+// Write "cycles=<n> instret=<n> <event>=<n> ..." into buf (terminated), return the length
+int perf_format(char * buf, int size, const perf_counters_t * counters);
+
+// Decimal digits of a 64-bit value, with 32-bit arithmetic only (no libgcc). Return the length.
+int perf_u64_to_str(uint64_t value, char * buf);
+
+#endif
@@ -0,0 +1,330 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description:
+//      Performance counters of the supported cores, see perf.h.
+//      CSR numbers must be immediates: the counters are read through a switch on the counter number.
+
+#include "perf.h"
+
+/////////////////////////
+// Core configuration  //
+/////////////////////////
+
+// Counters CSRs: cycles, instret (low and high halves)
+#define CSR_MCYCLE          0xB00
+#define CSR_MCYCLEH         0xB80
+#define CSR_MINSTRET        0xB02
+#define CSR_MINSTRETH       0xB82
+#define CSR_CYCLE           0xC00
+#define CSR_CYCLEH          0xC80
+#define CSR_INSTRET         0xC02
+#define CSR_INSTRETH        0xC82
+#define CSR_MCOUNTINHIBIT   0x320
+
+#if defined(CORE_PICORV32)
+    // Only the user counters, with ENABLE_COUNTERS (and ENABLE_COUNTERS64)
+    #define PERF_CORE_NAME      "picorv32"
+    #define PERF_USER_COUNTERS
+    #define PERF_HPM_CANDIDATES 0
+    static const char * perf_event_names[1] = { "" };
+#elif defined(CORE_IBEX)
+    // Fixed events of mhpmcounter3..12, implemented with MHPMCounterNum
+    #define PERF_CORE_NAME      "ibex"
+    #define PERF_HPM_CANDIDATES 10
+    static const char * perf_event_names[PERF_HPM_CANDIDATES] = {
+        "lsu_wait", "if_wait", "load", "store", "jump", "branch", "branch_taken", "compressed", "mul_wait", "div_wait"
+    };
+#elif defined(CORE_CV32E40P)
+    // Programmable events (one-hot mhpmevent), implemented with NUM_MHPMCOUNTERS
+    #define PERF_CORE_NAME      "cv32e40p"
+    #define PERF_HPM_CANDIDATES 6
+    static const char * perf_event_names[PERF_HPM_CANDIDATES] = {
+        "imiss", "ld_stall", "jmp_stall", "load", "store", "branch_taken"
+    };
+    static const uint32_t perf_events[PERF_HPM_CANDIDATES] = {
+        1 << 4, 1 << 2, 1 << 3, 1 << 5, 1 << 6, 1 << 9
+    };
+#elif defined(CORE_CV64A6)
+    // Programmable events (event id in mhpmevent), mhpmcounter3..8 with PerfCounterEn
+    #define PERF_CORE_NAME      "cv64a6"
+    #define PERF_HPM_CANDIDATES 6
+    static const char * perf_event_names[PERF_HPM_CANDIDATES] = {
+        "icache_miss", "dcache_miss", "load", "store", "mispredict", "if_empty"
+    };
+    static const uint32_t perf_events[PERF_HPM_CANDIDATES] = {
+        1, 2, 5, 6, 12, 14
+    };
+#else
+    // Unknown core: the standard machine counters only
+    #define PERF_CORE_NAME      "unknown"
+    #define PERF_HPM_CANDIDATES 0
+    static const char * perf_event_names[1] = { "" };
+#endif
+
+#if PERF_HPM_CANDIDATES > PERF_HPM_MAX
+#error "PERF_HPM_MAX is too small for this core"
+#endif
+
+/////////////////////////
+// CSR access          //
+/////////////////////////
+
+#define PERF_STR_(x) #x
+#define PERF_STR(x) PERF_STR_(x)
+
+// 64-bit read, the high half read twice on RV32 in case the low one wraps in between
+#if __riscv_xlen == 32
+#define PERF_CSR_READ64(value, lo, hi) do {                                     \
+        uint32_t hi_, lo_, hi2_;                                                \
+        do {                                                                    \
+            __asm__ volatile("csrr %0, " PERF_STR(hi) : "=r"(hi_));             \
+            __asm__ volatile("csrr %0, " PERF_STR(lo) : "=r"(lo_));             \
+            __asm__ volatile("csrr %0, " PERF_STR(hi) : "=r"(hi2_));            \
+        } while ( hi_ != hi2_ );                                                \
+        value = ( (uint64_t) hi_ << 32 ) | lo_;                                 \
+    } while ( 0 )
+#else
+#define PERF_CSR_READ64(value, lo, hi) do {                                     \
+        uint64_t lo_;                                                           \
+        __asm__ volatile("csrr %0, " PERF_STR(lo) : "=r"(lo_));                 \
+        value = lo_;                                                            \
+    } while ( 0 )
+#endif
+
+#define PERF_CSR_WRITE(csr, value) __asm__ volatile("csrw " PERF_STR(csr) ", %0" : : "r"(value))
+
+// Counter n: mhpmcounter<n> (0xB00 + n), mhpmcounter<n>h (0xB80 + n), mhpmevent<n> (0x320 + n)
+#define PERF_HPM_CASE_READ(n, lo, hi)       case n: PERF_CSR_READ64(value, lo, hi); break
+#define PERF_HPM_CASE_WRITE(n, csr)         case n: PERF_CSR_WRITE(csr, value); break
+
+#if PERF_HPM_CANDIDATES > 0
+static uint64_t perf_hpm_csr_read(int counter){
+    uint64_t value = 0;
+    switch ( counter ) {
+        PERF_HPM_CASE_READ(3, 0xB03, 0xB83);
+        PERF_HPM_CASE_READ(4, 0xB04, 0xB84);
+        PERF_HPM_CASE_READ(5, 0xB05, 0xB85);
+        PERF_HPM_CASE_READ(6, 0xB06, 0xB86);
+        PERF_HPM_CASE_READ(7, 0xB07, 0xB87);
+        PERF_HPM_CASE_READ(8, 0xB08, 0xB88);
+        PERF_HPM_CASE_READ(9, 0xB09, 0xB89);
+        PERF_HPM_CASE_READ(10, 0xB0A, 0xB8A);
+        PERF_HPM_CASE_READ(11, 0xB0B, 0xB8B);
+        PERF_HPM_CASE_READ(12, 0xB0C, 0xB8C);
+        default: break;
+    }
+    return value;
+}
+
+static void perf_hpm_csr_write(int counter, uintptr_t value){
+    switch ( counter ) {
+        PERF_HPM_CASE_WRITE(3, 0xB03);
+        PERF_HPM_CASE_WRITE(4, 0xB04);
+        PERF_HPM_CASE_WRITE(5, 0xB05);
+        PERF_HPM_CASE_WRITE(6, 0xB06);
+        PERF_HPM_CASE_WRITE(7, 0xB07);
+        PERF_HPM_CASE_WRITE(8, 0xB08);
+        PERF_HPM_CASE_WRITE(9, 0xB09);
+        PERF_HPM_CASE_WRITE(10, 0xB0A);
+        PERF_HPM_CASE_WRITE(11, 0xB0B);
+        PERF_HPM_CASE_WRITE(12, 0xB0C);
+        default: break;
+    }
+}
+
+#if defined(CORE_CV32E40P) || defined(CORE_CV64A6)
+static void perf_hpm_event_write(int counter, uintptr_t value){
+    switch ( counter ) {
+        PERF_HPM_CASE_WRITE(3, 0x323);
+        PERF_HPM_CASE_WRITE(4, 0x324);
+        PERF_HPM_CASE_WRITE(5, 0x325);
+        PERF_HPM_CASE_WRITE(6, 0x326);
+        PERF_HPM_CASE_WRITE(7, 0x327);
+        PERF_HPM_CASE_WRITE(8, 0x328);
+        default: break;
+    }
+}
+#endif
+#endif
+
+/////////////////////////
+// API                 //
+/////////////////////////
+
+// Implemented mhpmcounters
+static int perf_hpm_count;
+// Cost of perf_start() and perf_stop() with nothing in between
+static uint64_t perf_overhead_cycles;
+static uint64_t perf_overhead_instret;
+
+int perf_init(){
+
+    perf_hpm_count = 0;
+    perf_overhead_cycles = 0;
+    perf_overhead_instret = 0;
+
+#ifndef PERF_USER_COUNTERS
+    // Some cores inhibit the counters at reset (e.g. CV32E40P)
+    PERF_CSR_WRITE(CSR_MCOUNTINHIBIT, 0);
+#endif
+
+#if PERF_HPM_CANDIDATES > 0
+    // The implemented counters keep a value, the others are hardwired to zero
+    for ( int i = 0; i < PERF_HPM_CANDIDATES; i++ ) {
+    #if defined(CORE_CV32E40P) || defined(CORE_CV64A6)
+        perf_hpm_event_write(3 + i, perf_events[i]);
+    #endif
+        perf_hpm_csr_write(3 + i, 1);
+        if ( perf_hpm_csr_read(3 + i) == 0 )
+            break;
+        perf_hpm_count++;
+    }
+#endif
+
+    // Measurement overhead, the minimum of a few runs
+    perf_counters_t counters;
+    uint64_t min_cycles = ~(uint64_t) 0;
+    uint64_t min_instret = ~(uint64_t) 0;
+    for ( int i = 0; i < 4; i++ ) {
+        perf_start(&counters);
+        perf_stop(&counters);
+        if ( counters.cycles < min_cycles )
+            min_cycles = counters.cycles;
+        if ( counters.instret < min_instret )
+            min_instret = counters.instret;
+    }
+    perf_overhead_cycles = min_cycles;
+    perf_overhead_instret = min_instret;
+
+    return perf_hpm_count;
+}
+
+const char * perf_core_name(){
+    return PERF_CORE_NAME;
+}
+
+uint64_t perf_cycles(){
+    uint64_t value;
+#ifdef PERF_USER_COUNTERS
+    PERF_CSR_READ64(value, CSR_CYCLE, CSR_CYCLEH);
+#else
+    PERF_CSR_READ64(value, CSR_MCYCLE, CSR_MCYCLEH);
+#endif
+    return value;
+}
+
+uint64_t perf_instret(){
+    uint64_t value;
+#ifdef PERF_USER_COUNTERS
+    PERF_CSR_READ64(value, CSR_INSTRET, CSR_INSTRETH);
+#else
+    PERF_CSR_READ64(value, CSR_MINSTRET, CSR_MINSTRETH);
+#endif
+    return value;
+}
+
+int perf_hpm_num(){
+    return perf_hpm_count;
+}
+
+const char * perf_hpm_name(int index){
+    if ( index < 0 || index >= perf_hpm_count )
+        return "";
+    return perf_event_names[index];
+}
+
+uint64_t perf_hpm_read(int index){
+#if PERF_HPM_CANDIDATES > 0
+    if ( index >= 0 && index < perf_hpm_count )
+        return perf_hpm_csr_read(3 + index);
+#else
+    (void) index;
+#endif
+    return 0;
+}
+
+void perf_read(perf_counters_t * counters){
+    counters->cycles = perf_cycles();
+    counters->instret = perf_instret();
+    for ( int i = 0; i < perf_hpm_count; i++ )
+        counters->hpm[i] = perf_hpm_read(i);
+}
+
+void perf_start(perf_counters_t * counters){
+    perf_read(counters);
+}
+
+void perf_stop(perf_counters_t * counters){
+    perf_counters_t now;
+    perf_read(&now);
+
+    counters->cycles = now.cycles - counters->cycles;
+    counters->instret = now.instret - counters->instret;
+    for ( int i = 0; i < perf_hpm_count; i++ )
+        counters->hpm[i] = now.hpm[i] - counters->hpm[i];
+
+    // Saturated at zero
+    counters->cycles = ( counters->cycles > perf_overhead_cycles ) ? counters->cycles - perf_overhead_cycles : 0;
+    counters->instret = ( counters->instret > perf_overhead_instret ) ? counters->instret - perf_overhead_instret : 0;
+}
+
+int perf_u64_to_str(uint64_t value, char * buf){
+    // Four 16-bit digits, divided by 10 with 32-bit divisions
+    uint32_t parts[4];
+    char digits[20];
+    int n = 0;
+    uint32_t nonzero;
+
+    parts[0] = (uint32_t) ( value >> 48 ) & 0xFFFF;
+    parts[1] = (uint32_t) ( value >> 32 ) & 0xFFFF;
+    parts[2] = (uint32_t) ( value >> 16 ) & 0xFFFF;
+    parts[3] = (uint32_t) value & 0xFFFF;
+    do {
+        uint32_t rem = 0;
+        nonzero = 0;
+        for ( int i = 0; i < 4; i++ ) {
+            uint32_t current = ( rem << 16 ) | parts[i];
+            parts[i] = current / 10;
+            rem = current % 10;
+            nonzero |= parts[i];
+        }
+        digits[n++] = '0' + rem;
+    } while ( nonzero != 0 );
+
+    for ( int i = 0; i < n; i++ )
+        buf[i] = digits[n - 1 - i];
+    buf[n] = '\0';
+    return n;
+}
+
+// Append " <name>=<value>" if it fits
+static int perf_append(char * buf, int size, int len, const char * name, uint64_t value){
+    char digits[21];
+    int name_len = 0;
+    int digits_len = perf_u64_to_str(value, digits);
+    while ( name[name_len] != '\0' )
+        name_len++;
+    if ( len + ( len != 0 ) + name_len + 1 + digits_len >= size )
+        return len;
+
+    if ( len != 0 )
+        buf[len++] = ' ';
+    for ( int i = 0; i < name_len; i++ )
+        buf[len++] = name[i];
+    buf[len++] = '=';
+    for ( int i = 0; i < digits_len; i++ )
+        buf[len++] = digits[i];
+    buf[len] = '\0';
+    return len;
+}
+
+int perf_format(char * buf, int size, const perf_counters_t * counters){
+    int len = 0;
+    if ( size <= 0 )
+        return 0;
+    buf[0] = '\0';
+    len = perf_append(buf, size, len, "cycles", counters->cycles);
+    len = perf_append(buf, size, len, "instret", counters->instret);
+    for ( int i = 0; i < perf_hpm_count; i++ )
+        len = perf_append(buf, size, len, perf_event_names[i], counters->hpm[i]);
+    return len;
+}
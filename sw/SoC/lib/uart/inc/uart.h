@@ -0,0 +1,107 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description:
+//      Interrupt-driven driver of the AXI UART Lite, with TX and RX ring buffers.
+//      The UART interrupt, routed through the PLIC, drains the TX ring into the UART FIFO (16 chars per
+//      interrupt) and fills the RX ring: writes and reads never wait for the serial line.
+//      The application calls uart_isr() from its external interrupt handler when the PLIC claims the UART
+//      source (PLIC_UART_INTERRUPT in hw/xilinx/rtl/uninasoc_pkg.sv).
+//
+//      Interrupt handlers must not format text: uart_defer() only records the format string and its arguments,
+//      and uart_defer_process(), called from the main loop, prints them. Arguments of %s must still be valid
+//      at that point (e.g. string literals).
+//
+//      Formats: %c %s %d %i %u %x %X %p %%, with the '-' and '0' flags, a width and the 'l' modifier.
+//
+//      UART_BURST (set by the library Makefile for the hpc SoC): the UART is the virtual uart
+//      (hw/xilinx/rtl/virtual_uart.sv). Its FIFOs are drained and filled with one level read and up to
+//      4 chars per access, through the burst registers, instead of a status read and an access per char.
+//
+//      Note: the rings are statically allocated, uart_init() must be called before any other function.
+
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+
+// Ring sizes, powers of two (set them when building the library)
+#ifndef UART_TX_RING_SIZE
+#define UART_TX_RING_SIZE   1024
+#endif
+#ifndef UART_RX_RING_SIZE
+#define UART_RX_RING_SIZE   64
+#endif
+// Pending uart_defer() prints, power of two
+#ifndef UART_DEFER_DEPTH
+#define UART_DEFER_DEPTH    16
+#endif
+// Arguments recorded per uart_defer(), the others are printed as 0
+#define UART_DEFER_ARGS     4
+// Arguments of uart_printf()
+#define UART_PRINTF_ARGS    8
+// Longest line of uart_printf() and uart_defer(), longer ones are truncated
+#define UART_LINE_SIZE      128
+
+// Registers offsets
+#define UART_RX_FIFO        0x0
+#define UART_TX_FIFO        0x4
+#define UART_STAT_REG       0x8
+#define UART_CTRL_REG       0xC
+
+// Virtual uart only (UART_BURST)
+#define UART_FIFO_LEVEL     0x14        // [15:0] RX FIFO level, [31:16] TX FIFO level
+#define UART_FIFO_DEPTH_REG 0x18
+#define UART_TX_BURST_W     0x24        // Pushes the chars in the written byte lanes, from lane 0
+#define UART_RX_BURST_R(n)  ( 0x40 + 4 * ( (n) - 1 ) )  // Pops n chars, packed from byte 0
+#define UART_BURST_LEN      4
+
+// Status register bits
+#define UART_STAT_RX_VALID  0x01
+#define UART_STAT_RX_FULL   0x02
+#define UART_STAT_TX_EMPTY  0x04
+#define UART_STAT_TX_FULL   0x08
+
+// Control register bits
+#define UART_CTRL_RST_TX    0x01
+#define UART_CTRL_RST_RX    0x02
+#define UART_CTRL_INT_EN    0x10
+
+// TX FIFO depth of the IP (the virtual uart reports its own)
+#define UART_FIFO_DEPTH     16
+
+typedef struct {
+    uint32_t irqs;          // Calls of uart_isr()
+    uint32_t tx_dropped;    // Chars of uart_printf() not queued, TX ring full
+    uint32_t rx_dropped;    // Chars received with the RX ring full
+    uint32_t defer_dropped; // uart_defer() with all the records pending
+} uart_stats_t;
+
+// Reset the FIFOs and the rings, enable the UART interrupt.
+// The UART source must be enabled in the PLIC by the application.
+void uart_init(uintptr_t base_address);
+
+// To be called by the external interrupt handler for the UART source
+void uart_isr();
+
+// Non-blocking: queue up to len chars, return the number of chars queued
+int uart_write(const char * buf, int len);
+
+// Non-blocking: copy up to len received chars, return the number of chars copied
+int uart_read(char * buf, int len);
+
+// Non-blocking formatted write, not for interrupt handlers.
+// Return the number of chars queued, the ones not fitting the TX ring are dropped.
+int uart_printf(const char * fmt, ...);
+
+// Safe from interrupt handlers: record a print for uart_defer_process().
+// Return 0 on success, -1 if all the records are pending (the print is dropped).
+int uart_defer(const char * fmt, ...);
+
+// Print the deferred records, as long as they fit the TX ring. Return the number of records printed.
+int uart_defer_process();
+
+// Wait for the TX ring and FIFO to drain, polling the UART if the interrupts are disabled or do not come
+void uart_flush();
+
+const uart_stats_t * uart_get_stats();
+
+#endif
@@ -0,0 +1,460 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description:
+//      Interrupt-driven AXI UART Lite driver, see uart.h.
+//      The rings are shared between the application and the UART interrupt: the application side
+//      updates them with the interrupts disabled (MIE cleared in mstatus), for a few instructions.
+//      The UART Lite interrupt fires when the RX FIFO gets data and when the TX FIFO gets empty:
+//      the TX side is started by the writes and goes on from the interrupt until the TX ring is empty.
+//      The writes, uart_defer_process() and uart_flush() also refill the TX FIFO when they find it empty:
+//      the output goes on, slower, when no interrupt comes (e.g. the UART source not enabled in the PLIC,
+//      or a bitstream whose virtual uart does not drive int_core_o).
+
+#include <stdarg.h>
+#include "uart.h"
+
+#define MSTATUS_MIE 0x8
+
+#define TX_MASK     ( UART_TX_RING_SIZE - 1 )
+#define RX_MASK     ( UART_RX_RING_SIZE - 1 )
+#define DEFER_MASK  ( UART_DEFER_DEPTH - 1 )
+
+#if ( UART_TX_RING_SIZE & TX_MASK ) || ( UART_RX_RING_SIZE & RX_MASK ) || ( UART_DEFER_DEPTH & DEFER_MASK )
+#error "UART ring sizes must be powers of two"
+#endif
+#if UART_TX_RING_SIZE < UART_LINE_SIZE
+#error "UART_TX_RING_SIZE must hold at least a line"
+#endif
+
+static volatile uint32_t * uart_base;
+static uint32_t uart_fifo_depth;
+
+// Free-running indices, the ring position is the index masked
+static char tx_ring[UART_TX_RING_SIZE];
+static volatile uint32_t tx_head;
+static volatile uint32_t tx_tail;
+static volatile int tx_busy;            // Chars in the UART FIFO, a TX interrupt is expected
+
+static char rx_ring[UART_RX_RING_SIZE];
+static volatile uint32_t rx_head;
+static volatile uint32_t rx_tail;
+
+// Deferred prints
+static const char * defer_fmt[UART_DEFER_DEPTH];
+static uintptr_t defer_args[UART_DEFER_DEPTH][UART_DEFER_ARGS];
+static volatile uint32_t defer_head;
+static volatile uint32_t defer_tail;
+
+static uart_stats_t uart_stats;
+
+/////////////////////////
+// Critical sections   //
+/////////////////////////
+
+static inline uintptr_t uart_irq_save(){
+    uintptr_t mstatus;
+    __asm__ volatile("csrrci %0, mstatus, 0x8" : "=r"(mstatus) : : "memory");
+    return mstatus;
+}
+
+static inline void uart_irq_restore(uintptr_t mstatus){
+    __asm__ volatile("csrs mstatus, %0" : : "r"(mstatus & MSTATUS_MIE) : "memory");
+}
+
+/////////////////////////
+// TX and RX           //
+/////////////////////////
+
+// Move up to a FIFO of chars from the TX ring to the UART, the FIFO must be empty
+static void uart_tx_refill(){
+    uint32_t n = tx_head - tx_tail;
+    if ( n > uart_fifo_depth )
+        n = uart_fifo_depth;
+    tx_busy = ( n != 0 );
+
+#ifdef UART_BURST
+    // 4 chars per store, then a halfword and a byte store for the remaining ones
+    volatile uint8_t * burst = (volatile uint8_t *) uart_base + UART_TX_BURST_W;
+    for ( ; n >= UART_BURST_LEN; n -= UART_BURST_LEN ) {
+        uint32_t word = 0;
+        for ( int i = 0; i < UART_BURST_LEN; i++ )
+            word |= (uint32_t) (uint8_t) tx_ring[tx_tail++ & TX_MASK] << ( 8 * i );
+        *(volatile uint32_t *) burst = word;
+    }
+    if ( n >= 2 ) {
+        uint16_t half = (uint8_t) tx_ring[tx_tail++ & TX_MASK];
+        half |= (uint16_t) (uint8_t) tx_ring[tx_tail++ & TX_MASK] << 8;
+        *(volatile uint16_t *) burst = half;
+        n -= 2;
+    }
+    if ( n == 1 )
+        *burst = tx_ring[tx_tail++ & TX_MASK];
+#else
+    for ( ; n > 0; n-- ) {
+        *(uart_base + UART_TX_FIFO / sizeof(uint32_t)) = tx_ring[tx_tail & TX_MASK];
+        tx_tail++;
+    }
+#endif
+}
+
+// Start the TX side, or go on without the interrupt, with the interrupts disabled
+static void uart_tx_kick(){
+    if ( !tx_busy || ( *(uart_base + UART_STAT_REG / sizeof(uint32_t)) & UART_STAT_TX_EMPTY ) )
+        uart_tx_refill();
+}
+
+// Queue up to len chars and start the TX side, with the interrupts disabled
+static int uart_tx_queue(const char * buf, int len){
+    int n = 0;
+    while ( n < len && tx_head - tx_tail < UART_TX_RING_SIZE ) {
+        tx_ring[tx_head & TX_MASK] = buf[n++];
+        tx_head++;
+    }
+    uart_tx_kick();
+    return n;
+}
+
+static void uart_rx_push(char c){
+    if ( rx_head - rx_tail < UART_RX_RING_SIZE ) {
+        rx_ring[rx_head & RX_MASK] = c;
+        rx_head++;
+    }
+    else {
+        uart_stats.rx_dropped++;
+    }
+}
+
+// Interrupt (or polling) service, with the interrupts disabled
+static void uart_service(){
+    uint32_t status;
+
+    // Drain the RX FIFO
+#ifdef UART_BURST
+    uint32_t level;
+    while ( ( level = *(uart_base + UART_FIFO_LEVEL / sizeof(uint32_t)) & 0xffff ) != 0 ) {
+        while ( level != 0 ) {
+            uint32_t n = ( level < UART_BURST_LEN ) ? level : UART_BURST_LEN;
+            uint32_t word = *(uart_base + UART_RX_BURST_R(n) / sizeof(uint32_t));
+            for ( uint32_t i = 0; i < n; i++ )
+                uart_rx_push((char) ( word >> ( 8 * i ) ));
+            level -= n;
+        }
+    }
+    status = *(uart_base + UART_STAT_REG / sizeof(uint32_t));
+#else
+    status = *(uart_base + UART_STAT_REG / sizeof(uint32_t));
+    while ( status & UART_STAT_RX_VALID ) {
+        uart_rx_push(*(uart_base + UART_RX_FIFO / sizeof(uint32_t)));
+        status = *(uart_base + UART_STAT_REG / sizeof(uint32_t));
+    }
+#endif
+
+    // Refill the TX FIFO, if it got empty (otherwise this was an RX interrupt)
+    if ( status & UART_STAT_TX_EMPTY )
+        uart_tx_refill();
+}
+
+void uart_init(uintptr_t base_address){
+
+    uart_base = (volatile uint32_t *) base_address;
+
+    // The state is not in an initialized section
+    tx_head = tx_tail = 0;
+    tx_busy = 0;
+    rx_head = rx_tail = 0;
+    defer_head = defer_tail = 0;
+    uart_stats.irqs = 0;
+    uart_stats.tx_dropped = 0;
+    uart_stats.rx_dropped = 0;
+    uart_stats.defer_dropped = 0;
+
+#ifdef UART_BURST
+    uart_fifo_depth = *(uart_base + UART_FIFO_DEPTH_REG / sizeof(uint32_t));
+#else
+    uart_fifo_depth = UART_FIFO_DEPTH;
+#endif
+
+    // Reset the FIFOs, enable the interrupt
+    *(uart_base + UART_CTRL_REG / sizeof(uint32_t)) = UART_CTRL_RST_TX | UART_CTRL_RST_RX | UART_CTRL_INT_EN;
+}
+
+void uart_isr(){
+    uart_stats.irqs++;
+    uart_service();
+}
+
+int uart_write(const char * buf, int len){
+    uintptr_t mstatus = uart_irq_save();
+    int n = uart_tx_queue(buf, len);
+    uart_irq_restore(mstatus);
+    return n;
+}
+
+int uart_read(char * buf, int len){
+    int n = 0;
+    uintptr_t mstatus = uart_irq_save();
+
+    while ( n < len && rx_tail != rx_head ) {
+        buf[n++] = rx_ring[rx_tail & RX_MASK];
+        rx_tail++;
+    }
+
+    uart_irq_restore(mstatus);
+    return n;
+}
+
+void uart_flush(){
+    int done = 0;
+    while ( !done ) {
+        uintptr_t mstatus = uart_irq_save();
+        // No interrupts to rely on
+        if ( !( mstatus & MSTATUS_MIE ) )
+            uart_service();
+        else
+            uart_tx_kick();
+        done = tx_tail == tx_head && ( *(uart_base + UART_STAT_REG / sizeof(uint32_t)) & UART_STAT_TX_EMPTY );
+        uart_irq_restore(mstatus);
+    }
+}
+
+const uart_stats_t * uart_get_stats(){
+    return &uart_stats;
+}
+
+/////////////////////////
+// Formatting          //
+/////////////////////////
+
+// Parse a conversion after '%': flags, width, modifier. Return the pointer to the conversion char.
+static const char * uart_parse_spec(const char * fmt, int * left, int * zero, int * width, int * is_long){
+    *left = *zero = *width = *is_long = 0;
+    for ( ; *fmt == '-' || *fmt == '0'; fmt++ ) {
+        if ( *fmt == '-' )
+            *left = 1;
+        else
+            *zero = 1;
+    }
+    for ( ; *fmt >= '0' && *fmt <= '9'; fmt++ )
+        *width = *width * 10 + ( *fmt - '0' );
+    if ( *fmt == 'l' ) {
+        *is_long = 1;
+        fmt++;
+    }
+    return fmt;
+}
+
+static int uart_conv_has_arg(char conv){
+    return conv == 'c' || conv == 's' || conv == 'd' || conv == 'i' || conv == 'u' ||
+           conv == 'x' || conv == 'X' || conv == 'p';
+}
+
+// Read the arguments of fmt, as machine words: the signed ones sign-extended
+static void uart_collect_args(const char * fmt, va_list * ap, uintptr_t * args, int nargs){
+    int n = 0;
+    int left, zero, width, is_long;
+
+    for ( ; *fmt != '\0' && n < nargs; fmt++ ) {
+        if ( *fmt != '%' )
+            continue;
+        fmt = uart_parse_spec(fmt + 1, &left, &zero, &width, &is_long);
+        if ( *fmt == '\0' )
+            break;
+        if ( !uart_conv_has_arg(*fmt) )
+            continue;
+
+        switch ( *fmt ) {
+            case 'd':
+            case 'i':
+                args[n++] = is_long ? (uintptr_t) va_arg(*ap, long) : (uintptr_t) (intptr_t) va_arg(*ap, int);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+                args[n++] = is_long ? (uintptr_t) va_arg(*ap, unsigned long) : (uintptr_t) va_arg(*ap, unsigned int);
+                break;
+            case 'c':
+                args[n++] = (uintptr_t) va_arg(*ap, int);
+                break;
+            default: // s, p
+                args[n++] = (uintptr_t) va_arg(*ap, void *);
+                break;
+        }
+    }
+    // Missing ones
+    for ( ; n < nargs; n++ )
+        args[n] = 0;
+}
+
+// Digits of value, written backwards from end. Return the number of digits.
+static int uart_utoa(uintptr_t value, unsigned int base, int upper, char * end){
+    char * p = end;
+    do {
+        unsigned int digit = value % base;
+        *--p = ( digit < 10 ) ? '0' + digit : ( upper ? 'A' : 'a' ) + digit - 10;
+        value /= base;
+    } while ( value != 0 );
+    return end - p;
+}
+
+// Format into line (UART_LINE_SIZE chars, not terminated), return the length
+static int uart_format(char * line, const char * fmt, const uintptr_t * args, int nargs){
+    int len = 0;
+    int n = 0;
+    int left, zero, width, is_long;
+
+    #define PUT(c) do { if ( len < UART_LINE_SIZE ) line[len++] = ( c ); } while ( 0 )
+
+    for ( ; *fmt != '\0'; fmt++ ) {
+        if ( *fmt != '%' ) {
+            PUT(*fmt);
+            continue;
+        }
+        fmt = uart_parse_spec(fmt + 1, &left, &zero, &width, &is_long);
+        if ( *fmt == '\0' )
+            break;
+        if ( !uart_conv_has_arg(*fmt) ) {
+            // %% and the unsupported ones, as they are
+            if ( *fmt != '%' )
+                PUT('%');
+            PUT(*fmt);
+            continue;
+        }
+
+        uintptr_t arg = ( n < nargs ) ? args[n] : 0;
+        n++;
+
+        // Text of the conversion, and its prefix (sign or 0x)
+        char digits[3 * sizeof(uintptr_t)];
+        char * end = digits + sizeof(digits);
+        const char * text = digits;
+        int text_len = 0;
+        const char * prefix = "";
+        int prefix_len = 0;
+
+        switch ( *fmt ) {
+            case 'c':
+                digits[0] = (char) arg;
+                text = digits;
+                text_len = 1;
+                zero = 0;
+                break;
+            case 's':
+                text = arg ? (const char *) arg : "(null)";
+                while ( text[text_len] != '\0' )
+                    text_len++;
+                zero = 0;
+                break;
+            case 'd':
+            case 'i':
+                if ( (intptr_t) arg < 0 ) {
+                    prefix = "-";
+                    prefix_len = 1;
+                    arg = -arg;
+                }
+                text_len = uart_utoa(arg, 10, 0, end);
+                text = end - text_len;
+                break;
+            case 'u':
+                text_len = uart_utoa(arg, 10, 0, end);
+                text = end - text_len;
+                break;
+            case 'p':
+                prefix = "0x";
+                prefix_len = 2;
+                text_len = uart_utoa(arg, 16, 0, end);
+                text = end - text_len;
+                break;
+            default: // x, X
+                text_len = uart_utoa(arg, 16, *fmt == 'X', end);
+                text = end - text_len;
+                break;
+        }
+
+        // Padding: spaces before the prefix, zeros after it, or spaces at the end if left-aligned
+        int pad = width - prefix_len - text_len;
+        if ( !left && !zero )
+            for ( ; pad > 0; pad-- )
+                PUT(' ');
+        for ( int i = 0; i < prefix_len; i++ )
+            PUT(prefix[i]);
+        if ( !left && zero )
+            for ( ; pad > 0; pad-- )
+                PUT('0');
+        for ( int i = 0; i < text_len; i++ )
+            PUT(text[i]);
+        for ( ; pad > 0; pad-- )
+            PUT(' ');
+    }
+
+    #undef PUT
+    return len;
+}
+
+/////////////////////////
+// Printing            //
+/////////////////////////
+
+int uart_printf(const char * fmt, ...){
+    uintptr_t args[UART_PRINTF_ARGS];
+    char line[UART_LINE_SIZE];
+    va_list ap;
+
+    va_start(ap, fmt);
+    uart_collect_args(fmt, &ap, args, UART_PRINTF_ARGS);
+    va_end(ap);
+
+    int len = uart_format(line, fmt, args, UART_PRINTF_ARGS);
+    uintptr_t mstatus = uart_irq_save();
+    int n = uart_tx_queue(line, len);
+    uart_stats.tx_dropped += len - n;
+    uart_irq_restore(mstatus);
+    return n;
+}
+
+int uart_defer(const char * fmt, ...){
+    va_list ap;
+    uintptr_t mstatus = uart_irq_save();
+
+    // Reserve a record
+    if ( defer_head - defer_tail == UART_DEFER_DEPTH ) {
+        uart_stats.defer_dropped++;
+        uart_irq_restore(mstatus);
+        return -1;
+    }
+    uint32_t slot = defer_head & DEFER_MASK;
+
+    va_start(ap, fmt);
+    uart_collect_args(fmt, &ap, defer_args[slot], UART_DEFER_ARGS);
+    va_end(ap);
+    defer_fmt[slot] = fmt;
+    defer_head++;
+
+    uart_irq_restore(mstatus);
+    return 0;
+}
+
+int uart_defer_process(){
+    char line[UART_LINE_SIZE];
+    int count = 0;
+
+    // The TX side may be waiting for an interrupt that never comes
+    uintptr_t mstatus = uart_irq_save();
+    uart_tx_kick();
+    uart_irq_restore(mstatus);
+
+    while ( defer_tail != defer_head ) {
+        uint32_t slot = defer_tail & DEFER_MASK;
+        int len = uart_format(line, defer_fmt[slot], defer_args[slot], UART_DEFER_ARGS);
+
+        // Non-blocking: retry at the next call if the line does not fit
+        mstatus = uart_irq_save();
+        int space = UART_TX_RING_SIZE - ( tx_head - tx_tail );
+        uart_irq_restore(mstatus);
+        if ( space < len )
+            break;
+
+        uart_write(line, len);
+        defer_tail++;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,174 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart RX benchmark - polling policies vs interrupt-driven
+//              A stand-in SoC thread writes chars into the software model of the virtual uart (SHM backend)
+//              and raises an eventfd standing in for the XDMA user interrupt.
+//              For each RX mode, it measures the char latency (SoC write to host return) and the CPU time
+//              burnt by the host reader thread while waiting.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "virtual_uart.h"
+
+/* Default values */
+#define BENCH_NUM_CHARS   2000      /* Chars per mode */
+#define BENCH_GAP_US      500       /* SoC idle time between two chars */
+
+/* Shared state */
+typedef struct {
+    virtual_uart_t * uart;
+    irq_source_t irq;
+    int use_irq;
+    unsigned int num_chars;
+    unsigned int gap_us;
+    _Atomic uint64_t t_write;       /* Timestamp of the last SoC write */
+    sem_t received;                 /* Posted by the reader for each char, the SoC sleeps on it */
+    uint64_t * latency;             /* Per-char latency in ns */
+} bench_t;
+
+static uint64_t now_ns ( clockid_t clk )
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+static int cmp_u64 ( const void * a, const void * b )
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return ( x > y ) - ( x < y );
+}
+
+/* Emulated SoC: wait for the host to receive the previous char, idle, then send the next char.
+ * It blocks instead of polling the TX FIFO: on few CPUs a spinning SoC would take the CPU from the
+ * poller being measured. */
+static void * soc_thread_function ( void * arg )
+{
+    bench_t * bench = (bench_t *) arg;
+
+    for ( unsigned int i = 0; i < bench->num_chars; i++ ) {
+        if ( i > 0 )
+            while ( sem_wait(&bench->received) != 0 );
+        usleep(bench->gap_us);
+
+        atomic_store(&bench->t_write, now_ns(CLOCK_MONOTONIC));
+        vu_model_soc_putc(bench->uart->mmio.model, 'a' + ( i % 26 ));
+        if ( bench->use_irq )
+            irq_source_notify(&bench->irq);
+    }
+
+    return NULL;
+}
+
+/* Run one mode (interrupt-driven if policy == NULL), return the reader CPU time in ns */
+static uint64_t run_mode ( bench_t * bench, const poll_policy_t * policy )
+{
+    pthread_t soc_thread;
+    uint64_t cpu_start;
+    uint64_t cpu_time;
+
+    vu_model_reset(bench->uart->mmio.model);
+    sem_init(&bench->received, 0, 0);
+    bench->use_irq = policy == NULL;
+    if ( pthread_create(&soc_thread, NULL, soc_thread_function, (void *) bench) != 0 ) {
+        printf("ERROR: pthread_create failed\n");
+        exit(-1);
+    }
+
+    cpu_start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+    for ( unsigned int i = 0; i < bench->num_chars; i++ ) {
+        if ( bench->use_irq )
+            virtual_uart_rx_char_irq(bench->uart, &bench->irq, NULL);
+        else
+            virtual_uart_rx_char(bench->uart, policy, NULL);
+        bench->latency[i] = now_ns(CLOCK_MONOTONIC) - atomic_load(&bench->t_write);
+        sem_post(&bench->received);
+    }
+    cpu_time = now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+
+    pthread_join(soc_thread, NULL);
+    sem_destroy(&bench->received);
+    return cpu_time;
+}
+
+static void print_stats ( const char * mode, bench_t * bench, uint64_t cpu_time )
+{
+    uint64_t sum = 0;
+    unsigned int n = bench->num_chars;
+
+    for ( unsigned int i = 0; i < n; i++ )
+        sum += bench->latency[i];
+    qsort(bench->latency, n, sizeof(uint64_t), cmp_u64);
+
+    printf("%-16s %10.2f %10.2f %10.2f %12.2f\n",
+            mode,
+            sum / (double) n / 1000.0,
+            bench->latency[n / 2] / 1000.0,
+            bench->latency[( n * 99 ) / 100] / 1000.0,
+            cpu_time / (double) n / 1000.0
+        );
+}
+
+int main ( int argc, char *argv[] )
+{
+    static const struct {
+        poll_policy_type_t type;
+        unsigned int sleep_us;
+    } policies [] = {
+        { POLL_POLICY_SLEEP,    10   },
+        { POLL_POLICY_SLEEP,    100  },
+        { POLL_POLICY_SPIN,     0    },
+        { POLL_POLICY_ADAPTIVE, 1000 },
+    };
+    static const char * policy_names [] = { "sleep", "spin", "adaptive" };
+    poll_policy_t policy;
+    virtual_uart_t uart;
+    bench_t bench;
+    char mode [32];
+
+    if ( virtual_uart_open(&uart, MMIO_BACKEND_SHM, NULL, 0, 0) != 0 )
+        return -1;
+    bench.uart      = &uart;
+    bench.num_chars = ( argc >= 2 ) ? atoi(argv[1]) : BENCH_NUM_CHARS;
+    bench.gap_us    = ( argc >= 3 ) ? atoi(argv[2]) : BENCH_GAP_US;
+    bench.latency   = (uint64_t *) malloc(bench.num_chars * sizeof(uint64_t));
+    if ( bench.num_chars == 0 || bench.latency == NULL ) {
+        printf("Usage: %s [num_chars] [gap_us]\n", argv[0]);
+        return -1;
+    }
+
+    if ( irq_source_open(&bench.irq, IRQ_SOURCE_EVENTFD, NULL) != 0 )
+        return -1;
+
+    printf("%u chars, %u us between chars\n", bench.num_chars, bench.gap_us);
+    printf("%-16s %10s %10s %10s %12s\n", "mode", "avg[us]", "p50[us]", "p99[us]", "cpu/char[us]");
+
+    poll_policy_thread_init();
+
+    /* Polling */
+    for ( unsigned int i = 0; i < sizeof(policies) / sizeof(policies[0]); i++ ) {
+        poll_policy_init(&policy, policies[i].type, policies[i].sleep_us);
+        /* Spin never sleeps, sleep_us is only the default period there */
+        if ( policy.type == POLL_POLICY_SPIN )
+            snprintf(mode, sizeof(mode), "%s", policy_names[policy.type]);
+        else
+            snprintf(mode, sizeof(mode), "%s %uus", policy_names[policy.type], policy.sleep_us);
+        print_stats(mode, &bench, run_mode(&bench, &policy));
+    }
+
+    /* Interrupt */
+    print_stats("irq", &bench, run_mode(&bench, NULL));
+
+    irq_source_close(&bench.irq);
+    free(bench.latency);
+    virtual_uart_close(&uart);
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart host driver benchmark suite
+//              Run the host driver against the software model of the CSR block (SHM backend), with
+//              the stand-in SoC in a thread or, with -P, in a separate process. Workloads:
+//              - echo:  round-trip latency percentiles, one char at a time
+//              - print: sustained bytes/s from the SoC to the host
+//              - sink:  sustained bytes/s from the host to the SoC
+//              print and sink run twice: one char per access, then through the FIFO burst registers.
+//              All of them check the data, the exit status is non-zero on mismatches.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "virtual_uart.h"
+#include "vu_soc.h"
+
+/* Default values */
+#define BENCH_ECHO_CHARS    20000
+#define BENCH_BULK_BYTES    (256 << 10)
+
+/* Stand-in SoC runner */
+typedef struct {
+    vu_soc_t soc;
+    int use_process;
+    pthread_t thread;
+    pid_t pid;
+    int result;
+} soc_runner_t;
+
+static void * soc_thread_function ( void * arg )
+{
+    soc_runner_t * runner = (soc_runner_t *) arg;
+    runner->result = vu_soc_run(&runner->soc);
+    return NULL;
+}
+
+static int soc_start ( soc_runner_t * runner, vu_soc_workload_t workload, uint64_t num_bytes, int burst )
+{
+    vu_model_reset(runner->soc.model);
+    runner->soc.workload  = workload;
+    runner->soc.num_bytes = num_bytes;
+    runner->soc.burst     = burst;
+
+    if ( runner->use_process ) {
+        /* The model mapping is MAP_SHARED, it is shared with the child */
+        runner->pid = fork();
+        if ( runner->pid == 0 )
+            _exit(vu_soc_run(&runner->soc) == 0 ? 0 : 1);
+        return runner->pid > 0 ? 0 : -1;
+    }
+
+    return pthread_create(&runner->thread, NULL, soc_thread_function, (void *) runner);
+}
+
+/* Wait for the SoC, return the number of errors */
+static int soc_join ( soc_runner_t * runner )
+{
+    int status;
+
+    if ( runner->use_process ) {
+        waitpid(runner->pid, &status, 0);
+        return ( WIFEXITED(status) && WEXITSTATUS(status) == 0 ) ? 0 : 1;
+    }
+
+    pthread_join(runner->thread, NULL);
+    return runner->result;
+}
+
+static int cmp_u64 ( const void * a, const void * b )
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return ( x > y ) - ( x < y );
+}
+
+static double percentile_us ( uint64_t * sorted, uint64_t n, double p )
+{
+    uint64_t i = (uint64_t) ( p * ( n - 1 ) / 100.0 + 0.5 );
+    return sorted[i] / 1e3;
+}
+
+static int bench_echo ( virtual_uart_t * uart, soc_runner_t * runner, const poll_policy_t * policy, uint64_t n )
+{
+    uint64_t * latency = (uint64_t *) malloc(n * sizeof(uint64_t));
+    uint64_t t_start;
+    int errors = 0;
+    char c;
+
+    if ( latency == NULL || soc_start(runner, VU_SOC_ECHO, n, 1) != 0 ) {
+        printf("ERROR: Cannot start the echo benchmark\n");
+        free(latency);
+        return 1;
+    }
+
+    for ( uint64_t i = 0; i < n; i++ ) {
+        t_start = stats_now_ns();
+        virtual_uart_tx_char(uart, vu_soc_pattern(i), policy, NULL);
+        c = virtual_uart_rx_char(uart, policy, NULL);
+        latency[i] = stats_now_ns() - t_start;
+        errors += ( c != vu_soc_pattern(i) );
+    }
+    errors += soc_join(runner);
+
+    qsort(latency, n, sizeof(uint64_t), cmp_u64);
+    printf("%-8s %10lu %10.2f %10.2f %10.2f %10.2f %10.2f %8d\n", "echo", n,
+            percentile_us(latency, n, 50),
+            percentile_us(latency, n, 90),
+            percentile_us(latency, n, 99),
+            percentile_us(latency, n, 99.9),
+            latency[n - 1] / 1e3,
+            errors
+        );
+
+    free(latency);
+    return errors;
+}
+
+static int bench_bulk ( virtual_uart_t * uart, soc_runner_t * runner, const poll_policy_t * policy, vu_soc_workload_t workload, uint64_t n, int burst )
+{
+    char buf [VU_MODEL_FIFO_DEPTH];
+    uint64_t t_start;
+    size_t chunk;
+    double secs;
+    int errors = 0;
+
+    if ( soc_start(runner, workload, n, burst) != 0 ) {
+        printf("ERROR: Cannot start the bulk benchmark\n");
+        return 1;
+    }
+
+    t_start = stats_now_ns();
+    for ( uint64_t i = 0; i < n; i += chunk ) {
+        chunk = burst ? ( n - i < sizeof(buf) ? n - i : sizeof(buf) ) : 1;
+        if ( workload == VU_SOC_PRINT ) {
+            chunk = virtual_uart_rx(uart, buf, chunk, policy, NULL);
+            for ( size_t j = 0; j < chunk; j++ )
+                errors += ( buf[j] != vu_soc_pattern(i + j) );
+        }
+        else {
+            for ( size_t j = 0; j < chunk; j++ )
+                buf[j] = vu_soc_pattern(i + j);
+            virtual_uart_tx(uart, buf, chunk, policy, NULL);
+        }
+    }
+    /* The SoC is done when it got the last char */
+    errors += soc_join(runner);
+    secs = ( stats_now_ns() - t_start ) / 1e9;
+
+    printf("%-8s %-6s %10lu %10.3f %12.1f %8d\n", workload == VU_SOC_PRINT ? "print" : "sink", burst ? "burst" : "char",
+            n, secs, n / secs, errors);
+    return errors;
+}
+
+static void help ( char * ex_name )
+{
+    printf("Usage: %s [-p policy] [-P] [-e echo_chars] [-b bulk_bytes]\n", ex_name);
+    printf("    -p policy     : Polling policy, for both the host and the SoC: sleep, spin or adaptive, default adaptive\n");
+    printf("    -P            : Run the stand-in SoC in a separate process instead of a thread\n");
+    printf("    -e echo_chars : Round trips of the echo benchmark, default %d\n", BENCH_ECHO_CHARS);
+    printf("    -b bulk_bytes : Bytes of the print/sink benchmarks, default %d\n", BENCH_BULK_BYTES);
+}
+
+int main ( int argc, char *argv[] )
+{
+    poll_policy_type_t policy_type = POLL_POLICY_ADAPTIVE;
+    poll_policy_t policy;
+    virtual_uart_t uart;
+    soc_runner_t runner;
+    uint64_t echo_chars = BENCH_ECHO_CHARS;
+    uint64_t bulk_bytes = BENCH_BULK_BYTES;
+    int errors = 0;
+    int opt;
+
+    runner.use_process = 0;
+    runner.soc.stop    = NULL;
+
+    while ( ( opt = getopt(argc, argv, "p:Pe:b:h") ) != -1 ) {
+        switch ( opt ) {
+            case 'p':
+                if ( poll_policy_parse(optarg, &policy_type) != 0 ) {
+                    printf("ERROR: Unknown polling policy %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'P': runner.use_process = 1;               break;
+            case 'e': echo_chars = strtoull(optarg, NULL, 0); break;
+            case 'b': bulk_bytes = strtoull(optarg, NULL, 0); break;
+            default:
+                help(argv[0]);
+                return -1;
+        }
+    }
+
+    if ( echo_chars == 0 || bulk_bytes == 0 ) {
+        help(argv[0]);
+        return -1;
+    }
+
+    /* In-process model, shared with the SoC thread/process */
+    if ( virtual_uart_open(&uart, MMIO_BACKEND_SHM, NULL, 0, 0) != 0 )
+        return -1;
+    runner.soc.model = uart.mmio.model;
+
+    poll_policy_init(&policy, policy_type, 0);
+    runner.soc.policy = &policy;
+    poll_policy_thread_init();
+
+    printf("SoC in a %s, %s polling (%u us)\n", runner.use_process ? "process" : "thread",
+            policy_type == POLL_POLICY_SLEEP ? "sleep" : policy_type == POLL_POLICY_SPIN ? "spin" : "adaptive", policy.sleep_us);
+
+    printf("%-8s %10s %10s %10s %10s %10s %10s %8s\n", "", "chars", "p50[us]", "p90[us]", "p99[us]", "p99.9[us]", "max[us]", "errors");
+    errors += bench_echo(&uart, &runner, &policy, echo_chars);
+
+    printf("%-8s %-6s %10s %10s %12s %8s\n", "", "access", "bytes", "time[s]", "bytes/s", "errors");
+    for ( int burst = 0; burst <= 1; burst++ ) {
+        errors += bench_bulk(&uart, &runner, &policy, VU_SOC_PRINT, bulk_bytes, burst);
+        errors += bench_bulk(&uart, &runner, &policy, VU_SOC_SINK, bulk_bytes, burst);
+    }
+
+    virtual_uart_close(&uart);
+
+    if ( errors )
+        printf("Test failed :(\n");
+    return errors ? 1 : 0;
+}
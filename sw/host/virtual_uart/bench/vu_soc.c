@@ -0,0 +1,155 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart stand-in SoC workloads
+//              The SoC side of the software model, driving the CSR block through the same
+//              RX valid/TX full handshake as the software running on the real SoC or, in burst
+//              mode, through the FIFO level and burst registers.
+
+#include <stdint.h>
+#include <string.h>
+#include "vu_soc.h"
+
+int vu_soc_parse ( const char * name, vu_soc_workload_t * workload )
+{
+    if      ( strcmp(name, "echo")  == 0 ) *workload = VU_SOC_ECHO;
+    else if ( strcmp(name, "print") == 0 ) *workload = VU_SOC_PRINT;
+    else if ( strcmp(name, "sink")  == 0 ) *workload = VU_SOC_SINK;
+    else return -1;
+
+    return 0;
+}
+
+static int stopped ( vu_soc_t * soc )
+{
+    return soc->stop && atomic_load_explicit(soc->stop, memory_order_relaxed);
+}
+
+/* Blocking getc/putc, return -1 if stopped */
+static int soc_getc ( vu_soc_t * soc, char * c )
+{
+    poll_state_t state;
+
+    poll_begin(&state, soc->policy, NULL);
+    while ( vu_model_soc_getc(soc->model, c) != 0 ) {
+        if ( stopped(soc) )
+            return -1;
+        poll_wait(&state);
+    }
+    return 0;
+}
+
+static int soc_putc ( vu_soc_t * soc, char c )
+{
+    poll_state_t state;
+
+    poll_begin(&state, soc->policy, NULL);
+    while ( vu_model_soc_putc(soc->model, c) != 0 ) {
+        if ( stopped(soc) )
+            return -1;
+        poll_wait(&state);
+    }
+    return 0;
+}
+
+/* Blocking burst read/write of up to/exactly len chars, return -1 if stopped */
+static int soc_read ( vu_soc_t * soc, char * buf, unsigned int max, unsigned int * n )
+{
+    poll_state_t state;
+
+    poll_begin(&state, soc->policy, NULL);
+    while ( ( *n = vu_model_soc_read(soc->model, buf, max) ) == 0 ) {
+        if ( stopped(soc) )
+            return -1;
+        poll_wait(&state);
+    }
+    return 0;
+}
+
+static int soc_write ( vu_soc_t * soc, const char * buf, unsigned int len )
+{
+    poll_state_t state;
+    unsigned int n;
+
+    poll_begin(&state, soc->policy, NULL);
+    while ( len > 0 ) {
+        n = vu_model_soc_write(soc->model, buf, len);
+        if ( n == 0 ) {
+            if ( stopped(soc) )
+                return -1;
+            poll_wait(&state);
+            continue;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Burst mode, chunks as large as the FIFOs */
+static int vu_soc_run_burst ( vu_soc_t * soc )
+{
+    char buf [VU_MODEL_FIFO_DEPTH];
+    uint64_t left;
+    unsigned int n;
+    int errors = 0;
+
+    for ( uint64_t i = 0; soc->num_bytes == 0 || i < soc->num_bytes; i += n ) {
+        left = soc->num_bytes - i;
+        n = ( soc->num_bytes == 0 || left > sizeof(buf) ) ? sizeof(buf) : (unsigned int) left;
+
+        switch ( soc->workload ) {
+            case VU_SOC_ECHO:
+                if ( soc_read(soc, buf, n, &n) != 0 || soc_write(soc, buf, n) != 0 )
+                    return -1;
+                break;
+
+            case VU_SOC_PRINT:
+                for ( unsigned int j = 0; j < n; j++ )
+                    buf[j] = vu_soc_pattern(i + j);
+                if ( soc_write(soc, buf, n) != 0 )
+                    return -1;
+                break;
+
+            case VU_SOC_SINK:
+                if ( soc_read(soc, buf, n, &n) != 0 )
+                    return -1;
+                for ( unsigned int j = 0; j < n; j++ )
+                    errors += ( buf[j] != vu_soc_pattern(i + j) );
+                break;
+        }
+    }
+
+    return errors;
+}
+
+int vu_soc_run ( vu_soc_t * soc )
+{
+    int errors = 0;
+    char c;
+
+    poll_policy_thread_init();
+
+    if ( soc->burst )
+        return vu_soc_run_burst(soc);
+
+    for ( uint64_t i = 0; soc->num_bytes == 0 || i < soc->num_bytes; i++ ) {
+        switch ( soc->workload ) {
+            case VU_SOC_ECHO:
+                if ( soc_getc(soc, &c) != 0 || soc_putc(soc, c) != 0 )
+                    return -1;
+                break;
+
+            case VU_SOC_PRINT:
+                if ( soc_putc(soc, vu_soc_pattern(i)) != 0 )
+                    return -1;
+                break;
+
+            case VU_SOC_SINK:
+                if ( soc_getc(soc, &c) != 0 )
+                    return -1;
+                errors += ( c != vu_soc_pattern(i) );
+                break;
+        }
+    }
+
+    return errors;
+}
@@ -0,0 +1,40 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart stand-in SoC workloads header file
+
+#ifndef VU_SOC_H__
+#define VU_SOC_H__
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "vu_model.h"
+#include "poll_policy.h"
+
+/* Workloads */
+typedef enum {
+    VU_SOC_ECHO,                /* Send back each received char */
+    VU_SOC_PRINT,               /* Print num_bytes chars of a known pattern */
+    VU_SOC_SINK                 /* Receive num_bytes chars and check the pattern */
+} vu_soc_workload_t;
+
+/* Stand-in SoC */
+typedef struct {
+    vu_model_t * model;
+    vu_soc_workload_t workload;
+    uint64_t num_bytes;         /* 0 for endless echo */
+    const poll_policy_t * policy;
+    int burst;                  /* Move up to the FIFO level per level read, instead of one char per status read */
+    _Atomic int * stop;         /* Stop request, can be NULL */
+} vu_soc_t;
+
+/* Char i of the known pattern (printable ASCII) */
+static inline char vu_soc_pattern ( uint64_t i )
+{
+    return (char) ( ' ' + ( i % 95 ) );
+}
+
+/* Parse a workload name (echo, print, sink), return 0 on success */
+int vu_soc_parse ( const char * name, vu_soc_workload_t * workload );
+/* Run the workload, return the number of errors (pattern mismatches) or -1 if stopped */
+int vu_soc_run ( vu_soc_t * soc );
+
+#endif
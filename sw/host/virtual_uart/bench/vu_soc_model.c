@@ -0,0 +1,111 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart stand-in SoC process
+//              Create the software model of the virtual uart CSR block in POSIX shared memory and
+//              run a SoC workload on it, so that the host application can be run without the board:
+//                  bin/vu_soc_model -w echo /vu0 &
+//                  bin/virtual_uart -s /vu0
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "vu_soc.h"
+
+static _Atomic int stop = 0;
+
+static void stop_handler ( int sig )
+{
+    (void) sig;
+    atomic_store(&stop, 1);
+}
+
+static void help ( char * ex_name )
+{
+    printf("Usage: %s [-w workload] [-n num_bytes] [-p policy] [-c] <shm_name>\n", ex_name);
+    printf("    shm_name     : POSIX shared memory object, e.g. /vu0\n");
+    printf("    -w workload  : echo, print or sink, default echo\n");
+    printf("    -n num_bytes : Bytes to print/receive, 0 for endless (echo only), default 0\n");
+    printf("    -p policy    : SoC side polling policy: sleep, spin or adaptive, default adaptive\n");
+    printf("    -c           : One char per access instead of bursts\n");
+}
+
+int main ( int argc, char *argv[] )
+{
+    poll_policy_type_t policy_type = POLL_POLICY_ADAPTIVE;
+    poll_policy_t policy;
+    vu_soc_t soc;
+    const char * shm_name;
+    int fd;
+    int opt;
+    int ret;
+
+    soc.workload  = VU_SOC_ECHO;
+    soc.num_bytes = 0;
+    soc.burst     = 1;
+    soc.stop      = &stop;
+
+    while ( ( opt = getopt(argc, argv, "w:n:p:ch") ) != -1 ) {
+        switch ( opt ) {
+            case 'w':
+                if ( vu_soc_parse(optarg, &soc.workload) != 0 ) {
+                    printf("ERROR: Unknown workload %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'n':
+                soc.num_bytes = strtoull(optarg, NULL, 0);
+                break;
+            case 'p':
+                if ( poll_policy_parse(optarg, &policy_type) != 0 ) {
+                    printf("ERROR: Unknown polling policy %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'c':
+                soc.burst = 0;
+                break;
+            default:
+                help(argv[0]);
+                return -1;
+        }
+    }
+
+    if ( argc - optind != 1 ) {
+        help(argv[0]);
+        return -1;
+    }
+    shm_name = argv[optind];
+
+    poll_policy_init(&policy, policy_type, 0);
+    soc.policy = &policy;
+
+    /* Create the model */
+    fd = shm_open(shm_name, O_CREAT | O_RDWR, 0600);
+    if ( fd == -1 || ftruncate(fd, sizeof(vu_model_t)) != 0 ) {
+        printf("ERROR: Cannot create shared memory %s\n", shm_name);
+        return -1;
+    }
+    soc.model = (vu_model_t *) mmap(NULL, sizeof(vu_model_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if ( soc.model == MAP_FAILED ) {
+        printf("ERROR: Map failed\n");
+        shm_unlink(shm_name);
+        return -1;
+    }
+    vu_model_reset(soc.model);
+
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+
+    /* Run until done or stopped */
+    ret = vu_soc_run(&soc);
+    if ( ret > 0 )
+        printf("ERROR: %d chars do not match the pattern\n", ret);
+
+    munmap(soc.model, sizeof(vu_model_t));
+    shm_unlink(shm_name);
+
+    return ret > 0 ? 1 : 0;
+}
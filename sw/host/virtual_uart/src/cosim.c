@@ -0,0 +1,93 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - co-simulation transport, host side
+//              The accesses are queued on the port ring of the calling thread and served by the
+//              Verilator testbench of the RTL. A write only publishes the queue head, a read also
+//              waits for the testbench to serve it, which flushes the writes queued before it.
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "cosim.h"
+
+/* Spins before yielding the CPU, the testbench serves a batch in a few microseconds */
+#define COSIM_SPINS     1024
+
+static int cosim_running ( cosim_shm_t * shm )
+{
+    return __atomic_load_n(&shm->running, __ATOMIC_ACQUIRE);
+}
+
+static void cosim_wait ( unsigned int * spins )
+{
+    if ( ++( *spins ) > COSIM_SPINS )
+        sched_yield();
+}
+
+int cosim_claim ( cosim_shm_t * shm )
+{
+    uint32_t pid = (uint32_t) getpid();
+    uint32_t owner;
+
+    for ( int i = 0; i < COSIM_NUM_PORTS; i++ ) {
+        owner = __atomic_load_n(&shm->port[i].owner, __ATOMIC_ACQUIRE);
+        /* Free, or held by a process killed before closing it */
+        if ( owner != 0 && ( kill((pid_t) owner, 0) == 0 || errno != ESRCH ) )
+            continue;
+        if ( __atomic_compare_exchange_n(&shm->port[i].owner, &owner, pid, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) )
+            return i;
+    }
+    return -1;
+}
+
+void cosim_release ( cosim_shm_t * shm, int port )
+{
+    __atomic_store_n(&shm->port[port].owner, 0, __ATOMIC_RELEASE);
+}
+
+/* Queue an access, return its sequence number or -1 if the testbench stopped */
+static int64_t cosim_queue ( cosim_shm_t * shm, cosim_port_t * port, uint8_t op, uint32_t offset, uint32_t value, uint8_t strb )
+{
+    uint32_t head = __atomic_load_n(&port->head, __ATOMIC_RELAXED);
+    unsigned int spins = 0;
+    cosim_req_t * req;
+
+    while ( head - __atomic_load_n(&port->tail, __ATOMIC_ACQUIRE) == COSIM_QUEUE_LEN ) {
+        if ( !cosim_running(shm) )
+            return -1;
+        cosim_wait(&spins);
+    }
+
+    req = &port->req[head % COSIM_QUEUE_LEN];
+    req->op     = op;
+    req->strb   = strb;
+    req->offset = (uint16_t) offset;
+    req->data   = value;
+    __atomic_store_n(&port->head, head + 1, __ATOMIC_RELEASE);
+
+    return head;
+}
+
+uint32_t cosim_read ( cosim_shm_t * shm, int port, uint32_t offset )
+{
+    cosim_port_t * p = &shm->port[port];
+    uint32_t reads = __atomic_load_n(&p->reads, __ATOMIC_ACQUIRE);
+    unsigned int spins = 0;
+
+    if ( cosim_queue(shm, p, COSIM_OP_READ, offset, 0, 0) < 0 )
+        return COSIM_READ_STOPPED;
+
+    /* One read in flight per port: the next served read is this one */
+    while ( __atomic_load_n(&p->reads, __ATOMIC_ACQUIRE) == reads ) {
+        if ( !cosim_running(shm) )
+            return COSIM_READ_STOPPED;
+        cosim_wait(&spins);
+    }
+    return p->rdata;
+}
+
+void cosim_write ( cosim_shm_t * shm, int port, uint32_t offset, uint32_t value, uint8_t strb )
+{
+    cosim_queue(shm, &shm->port[port], COSIM_OP_WRITE, offset, value, strb);
+}
@@ -0,0 +1,63 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart co-simulation transport header file
+//              Shared between the COSIM MMIO backend of the host application (cosim.c) and the Verilator
+//              testbench of hw/xilinx/rtl/virtual_uart.sv (hw/units/sim/virtual_uart.prj), which creates the
+//              POSIX shared memory object and replays the accesses on the AXI-lite slave of the RTL.
+//              Each host thread claims a port, a single-producer/single-consumer ring of accesses.
+//              Writes are posted: the host queues them and goes on, as on PCIe. Reads wait for their data.
+//              The testbench drains all the queued accesses of all the ports in one batch, so that it
+//              never stops the simulation for a single host access.
+
+#ifndef COSIM_H__
+#define COSIM_H__
+
+#include <stdint.h>
+
+/* Transport layout */
+#define COSIM_MAGIC         0x56554353  /* "VUCS", written last by the testbench */
+#define COSIM_NUM_PORTS     4           /* Host threads (or server instances) at once */
+#define COSIM_QUEUE_LEN     256         /* Accesses per port, power of 2 */
+#define COSIM_LINE          64
+
+/* Access opcodes */
+#define COSIM_OP_READ       0
+#define COSIM_OP_WRITE      1
+
+/* Reads once the testbench stopped: the FIFOs look empty, the host application idles */
+#define COSIM_READ_STOPPED  0
+
+typedef struct {
+    uint8_t  op;
+    uint8_t  strb;              /* Write byte lanes */
+    uint16_t offset;            /* Register offset */
+    uint32_t data;              /* Write data */
+} cosim_req_t;
+
+/* Host and testbench indexes are free-running, on separate cache lines */
+typedef struct {
+    uint32_t owner __attribute__((aligned(COSIM_LINE)));    /* PID of the host process, 0 if free */
+    uint32_t head;              /* Queued accesses, written by the host only */
+    uint32_t tail __attribute__((aligned(COSIM_LINE)));     /* Served accesses, written by the testbench only */
+    uint32_t reads;             /* Served reads, written by the testbench only */
+    uint32_t rdata;             /* Data of the last served read */
+    cosim_req_t req [COSIM_QUEUE_LEN] __attribute__((aligned(COSIM_LINE)));
+} cosim_port_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t running;           /* Cleared by the testbench on exit */
+    uint64_t cycles;            /* Simulated cycles, updated after each batch */
+    cosim_port_t port [COSIM_NUM_PORTS];
+} cosim_shm_t;
+
+/* Host side, see cosim.c */
+
+/* Claim a free port of the testbench (or one left by a dead process), return its index or -1 */
+int      cosim_claim   ( cosim_shm_t * shm );
+void     cosim_release ( cosim_shm_t * shm, int port );
+/* Queue a read and wait for its data, COSIM_READ_STOPPED if the testbench stopped */
+uint32_t cosim_read    ( cosim_shm_t * shm, int port, uint32_t offset );
+/* Queue a posted write, wait only if the queue is full */
+void     cosim_write   ( cosim_shm_t * shm, int port, uint32_t offset, uint32_t value, uint8_t strb );
+
+#endif
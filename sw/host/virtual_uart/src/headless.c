@@ -0,0 +1,419 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - headless mode, for automated regressions
+//              The input thread feeds the SoC from a raw file/pipe at full link rate, or runs an expect script:
+//                  send <text>         send the text, C escapes allowed (\n, \r, \t, \\, \xHH)
+//                  sendline <text>     send the text and a newline
+//                  sendfile <path>     send the file as is
+//                  expect <regex>      wait for the SoC output to match, then discard the output up to the match
+//                  timeout <s>         timeout of the following expects, default HEADLESS_DEFAULT_TIMEOUT_S
+//                  sleep <ms>          wait
+//              one command per line, # for comments.
+//              The capture thread drains the SoC output into the log and matches each line
+//              against the pass/fail patterns. The first of pass, fail, expect timeout or error
+//              sets the exit status and wakes up the main thread. With pass_on_quiet (-Q, or a script without
+//              a pass pattern), the run also passes once the input is sent and the output stays quiet for
+//              HEADLESS_QUIET_MS.
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "headless.h"
+#include "poll_policy.h"
+
+/******************/
+/* Status and log */
+/******************/
+
+static void headless_finish_locked ( headless_t * headless, headless_status_t status )
+{
+    if ( headless->status != HEADLESS_RUNNING )
+        return;
+    headless->status = status;
+    pthread_cond_broadcast(&headless->cond);
+    kill(getpid(), SIGTERM);
+}
+
+void headless_finish ( headless_t * headless, headless_status_t status )
+{
+    pthread_mutex_lock(&headless->lock);
+    headless_finish_locked(headless, status);
+    pthread_mutex_unlock(&headless->lock);
+}
+
+/* Match the current line against the fail, then pass pattern */
+static void headless_match_line ( headless_t * headless )
+{
+    headless->line[headless->line_len] = '\0';
+    if ( headless->has_fail && regexec(&headless->fail, headless->line, 0, NULL, 0) == 0 )
+        headless_finish_locked(headless, HEADLESS_FAIL);
+    else if ( headless->has_pass && regexec(&headless->pass, headless->line, 0, NULL, 0) == 0 )
+        headless_finish_locked(headless, HEADLESS_PASS);
+}
+
+/* Log a chunk of SoC output and feed it to the matchers, with the lock held */
+static void headless_capture ( headless_t * headless, const char * buf, size_t len )
+{
+    log_write(&headless->log, buf, len);
+
+    for ( size_t i = 0; i < len; i++ ) {
+        /* NULs would end the strings early */
+        if ( buf[i] == '\0' )
+            continue;
+
+        /* Pending output, drop the oldest half when full */
+        if ( headless->pending_len == HEADLESS_PENDING_SIZE ) {
+            memmove(headless->pending, headless->pending + HEADLESS_PENDING_SIZE / 2, HEADLESS_PENDING_SIZE / 2);
+            headless->pending_len = HEADLESS_PENDING_SIZE / 2;
+        }
+        headless->pending[headless->pending_len++] = buf[i];
+
+        /* Pass/fail lines, the tail of a long line is not matched */
+        if ( buf[i] == '\n' ) {
+            headless_match_line(headless);
+            headless->line_len = 0;
+        }
+        else if ( headless->line_len < HEADLESS_LINE_SIZE ) {
+            headless->line[headless->line_len++] = buf[i];
+        }
+    }
+    headless->pending[headless->pending_len] = '\0';
+
+    /* Prompts do not end with a newline */
+    if ( headless->line_len > 0 )
+        headless_match_line(headless);
+
+    pthread_cond_broadcast(&headless->cond);
+}
+
+static void * capture_thread_function ( void * arg )
+{
+    headless_t * headless = (headless_t *) arg;
+    const struct timespec quiet = { HEADLESS_QUIET_MS / 1000, ( HEADLESS_QUIET_MS % 1000 ) * 1000000L };
+    struct iovec iov [2];
+    int iovcnt;
+    size_t n;
+    int drained = 0;
+
+    poll_policy_thread_init();
+
+    while (1) {
+        n = ring_readable(headless->output, iov, &iovcnt);
+        if ( n == 0 ) {
+            if ( !headless->pass_on_quiet ) {
+                ring_wait_readable(headless->output, NULL);
+                continue;
+            }
+            /* Pass on quiet: the input is sent to the SoC and its trailing output is captured */
+            ring_wait_readable(headless->output, &quiet);
+            if ( ring_readable(headless->output, iov, &iovcnt) != 0 || !ring_drained(headless->input) )
+                continue;
+            /* The window in which the input drained may be too short for the reply: wait a whole one */
+            if ( drained )
+                headless_finish(headless, HEADLESS_PASS);
+            drained = 1;
+            continue;
+        }
+
+        pthread_mutex_lock(&headless->lock);
+        if ( !headless->closed ) {
+            for ( int i = 0; i < iovcnt; i++ )
+                headless_capture(headless, (const char *) iov[i].iov_base, iov[i].iov_len);
+        }
+        pthread_mutex_unlock(&headless->lock);
+        ring_consume(headless->output, n);
+    }
+
+    return NULL;
+}
+
+/*********/
+/* Input */
+/*********/
+
+/* Push a buffer into the input ring, blocking */
+static void headless_send ( headless_t * headless, const char * buf, size_t len )
+{
+    struct iovec iov [2];
+    int iovcnt;
+    size_t n;
+
+    while ( len > 0 ) {
+        if ( ring_writable(headless->input, iov, &iovcnt) == 0 ) {
+            ring_wait_writable(headless->input);
+            continue;
+        }
+        for ( int i = 0; i < iovcnt && len > 0; i++ ) {
+            n = len < iov[i].iov_len ? len : iov[i].iov_len;
+            memcpy(iov[i].iov_base, buf, n);
+            ring_produce(headless->input, n);
+            buf += n;
+            len -= n;
+        }
+    }
+}
+
+/* Stream a file into the input ring, straight from read(), return 0 on success */
+static int headless_send_fd ( headless_t * headless, int fd )
+{
+    struct iovec iov [2];
+    int iovcnt;
+    ssize_t n;
+
+    while (1) {
+        if ( ring_writable(headless->input, iov, &iovcnt) == 0 ) {
+            ring_wait_writable(headless->input);
+            continue;
+        }
+        n = readv(fd, iov, iovcnt);
+        if ( n == 0 )
+            return 0;
+        if ( n < 0 ) {
+            if ( errno == EINTR )
+                continue;
+            return -1;
+        }
+        ring_produce(headless->input, n);
+    }
+}
+
+/* Wait for the pending output to match, return 0 on match */
+static int headless_expect ( headless_t * headless, const char * pattern, unsigned int timeout_s )
+{
+    regex_t regex;
+    regmatch_t match;
+    struct timespec deadline;
+    int ret = -1;
+
+    if ( regcomp(&regex, pattern, REG_EXTENDED | REG_NEWLINE) != 0 ) {
+        fprintf(stderr, "ERROR: Invalid expect pattern %s\n", pattern);
+        headless_finish(headless, HEADLESS_ERROR);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_s;
+
+    pthread_mutex_lock(&headless->lock);
+    while ( headless->status == HEADLESS_RUNNING ) {
+        if ( regexec(&regex, headless->pending, 1, &match, 0) == 0 ) {
+            /* Consume the output up to the end of the match */
+            headless->pending_len -= match.rm_eo;
+            memmove(headless->pending, headless->pending + match.rm_eo, headless->pending_len + 1);
+            ret = 0;
+            break;
+        }
+        if ( pthread_cond_timedwait(&headless->cond, &headless->lock, &deadline) == ETIMEDOUT ) {
+            fprintf(stderr, "[HEADLESS] Timeout on expect %s\n", pattern);
+            headless_finish_locked(headless, HEADLESS_TIMEOUT);
+        }
+    }
+    pthread_mutex_unlock(&headless->lock);
+
+    regfree(&regex);
+    return ret;
+}
+
+/* Replace the C escapes in place, return the length */
+static size_t unescape ( char * str )
+{
+    char * src = str;
+    char * dst = str;
+    char hex [3] = { 0 };
+
+    while ( *src ) {
+        if ( *src != '\\' || src[1] == '\0' ) {
+            *dst++ = *src++;
+            continue;
+        }
+        src++;
+        switch ( *src ) {
+            case 'n': *dst++ = '\n'; break;
+            case 'r': *dst++ = '\r'; break;
+            case 't': *dst++ = '\t'; break;
+            case 'e': *dst++ = '\033'; break;
+            case 'x':
+                if ( isxdigit((unsigned char) src[1]) && isxdigit((unsigned char) src[2]) ) {
+                    hex[0] = src[1];
+                    hex[1] = src[2];
+                    *dst++ = (char) strtol(hex, NULL, 16);
+                    src += 2;
+                    break;
+                }
+                /* fallthrough */
+            default: *dst++ = *src; break;
+        }
+        src++;
+    }
+
+    *dst = '\0';
+    return dst - str;
+}
+
+/* Run the expect script, return 0 on success */
+static int headless_run_script ( headless_t * headless )
+{
+    FILE * fp;
+    char * line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    char * cmd;
+    char * arg;
+    unsigned int timeout_s = HEADLESS_DEFAULT_TIMEOUT_S;
+    unsigned int lineno = 0;
+    struct timespec delay;
+    int fd;
+    int ret = 0;
+
+    fp = fopen(headless->script_path, "r");
+    if ( fp == NULL ) {
+        fprintf(stderr, "ERROR: Cannot open script %s\n", headless->script_path);
+        return -1;
+    }
+
+    while ( ret == 0 && ( len = getline(&line, &line_size, fp) ) != -1 ) {
+        lineno++;
+        if ( len > 0 && line[len - 1] == '\n' )
+            line[--len] = '\0';
+
+        /* Split the command from the argument, the argument is taken verbatim */
+        cmd = line;
+        while ( isspace((unsigned char) *cmd) )
+            cmd++;
+        if ( *cmd == '\0' || *cmd == '#' )
+            continue;
+        arg = cmd;
+        while ( *arg && !isspace((unsigned char) *arg) )
+            arg++;
+        if ( *arg )
+            *arg++ = '\0';
+
+        if ( strcmp(cmd, "send") == 0 ) {
+            headless_send(headless, arg, unescape(arg));
+        }
+        else if ( strcmp(cmd, "sendline") == 0 ) {
+            headless_send(headless, arg, unescape(arg));
+            headless_send(headless, "\n", 1);
+        }
+        else if ( strcmp(cmd, "sendfile") == 0 ) {
+            fd = open(arg, O_RDONLY);
+            if ( fd == -1 || headless_send_fd(headless, fd) != 0 ) {
+                fprintf(stderr, "ERROR: Cannot send file %s\n", arg);
+                ret = -1;
+            }
+            if ( fd != -1 )
+                close(fd);
+        }
+        else if ( strcmp(cmd, "expect") == 0 ) {
+            ret = headless_expect(headless, arg, timeout_s);
+        }
+        else if ( strcmp(cmd, "timeout") == 0 ) {
+            timeout_s = atoi(arg);
+        }
+        else if ( strcmp(cmd, "sleep") == 0 ) {
+            delay.tv_sec  = atoi(arg) / 1000;
+            delay.tv_nsec = ( atoi(arg) % 1000 ) * 1000000L;
+            nanosleep(&delay, NULL);
+        }
+        else {
+            fprintf(stderr, "ERROR: %s:%u: Unknown command %s\n", headless->script_path, lineno, cmd);
+            ret = -1;
+        }
+    }
+
+    free(line);
+    fclose(fp);
+    return ret;
+}
+
+static void * input_thread_function ( void * arg )
+{
+    headless_t * headless = (headless_t *) arg;
+    int ret = 0;
+
+    if ( headless->script_path )
+        ret = headless_run_script(headless);
+    else if ( headless->input_fd != -1 )
+        ret = headless_send_fd(headless, headless->input_fd);
+
+    /* Let the write thread drain the ring and exit, the capture thread decides on the pass */
+    ring_close(headless->input);
+
+    if ( ret != 0 )
+        headless_finish(headless, HEADLESS_ERROR);
+
+    return NULL;
+}
+
+/*******/
+/* API */
+/*******/
+
+int headless_init ( headless_t * headless, ring_t * input, ring_t * output, int input_fd, const char * script_path,
+                    const char * log_path, const char * pass, const char * fail, int pass_on_quiet, uint64_t t_start )
+{
+    pthread_condattr_t attr;
+
+    headless->input       = input;
+    headless->output      = output;
+    headless->input_fd    = input_fd;
+    headless->script_path = script_path;
+    headless->has_pass    = pass != NULL;
+    headless->has_fail    = fail != NULL;
+    headless->pass_on_quiet = pass_on_quiet;
+    headless->pending[0]  = '\0';
+    headless->pending_len = 0;
+    headless->line_len    = 0;
+    headless->status      = HEADLESS_RUNNING;
+    headless->closed      = 0;
+
+    if ( pass && regcomp(&headless->pass, pass, REG_EXTENDED | REG_NOSUB) != 0 ) {
+        printf("ERROR: Invalid pass pattern %s\n", pass);
+        return -1;
+    }
+    if ( fail && regcomp(&headless->fail, fail, REG_EXTENDED | REG_NOSUB) != 0 ) {
+        printf("ERROR: Invalid fail pattern %s\n", fail);
+        return -1;
+    }
+
+    /* Expect deadlines on the monotonic clock */
+    pthread_mutex_init(&headless->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&headless->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    return log_open(&headless->log, log_path, STDOUT_FILENO, t_start);
+}
+
+int headless_start ( headless_t * headless )
+{
+    if ( pthread_create(&headless->capture_thread, NULL, capture_thread_function, (void *) headless) != 0 ||
+         pthread_create(&headless->script_thread, NULL, input_thread_function, (void *) headless) != 0 ) {
+        printf("ERROR: pthread_create failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+headless_status_t headless_close ( headless_t * headless )
+{
+    headless_status_t status;
+
+    /* Interrupted, or a uart thread failed */
+    pthread_mutex_lock(&headless->lock);
+    if ( headless->status == HEADLESS_RUNNING )
+        headless->status = HEADLESS_ERROR;
+    status = headless->status;
+    headless->closed = 1;
+    log_close(&headless->log);
+    pthread_mutex_unlock(&headless->lock);
+
+    return status;
+}
@@ -0,0 +1,67 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart headless (scripted/capture) mode header file
+
+#ifndef HEADLESS_H__
+#define HEADLESS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <regex.h>
+#include <pthread.h>
+#include "ring.h"
+#include "log.h"
+
+/* Default values */
+#define HEADLESS_PENDING_SIZE       (64 << 10)  /* SoC output not yet consumed by an expect */
+#define HEADLESS_LINE_SIZE          1024        /* Longest line matched against the pass/fail patterns */
+#define HEADLESS_DEFAULT_TIMEOUT_S  10          /* Script expect timeout */
+#define HEADLESS_QUIET_MS           100         /* Output silence after the input, to pass on quiet */
+
+/* Exit status of the run */
+typedef enum {
+    HEADLESS_RUNNING = -1,
+    HEADLESS_PASS    = 0,
+    HEADLESS_FAIL    = 1,
+    HEADLESS_TIMEOUT = 2,
+    HEADLESS_ERROR   = 3
+} headless_status_t;
+
+typedef struct {
+    /* Configuration */
+    ring_t * input;                 /* Chars to the SoC */
+    ring_t * output;                /* Chars from the SoC */
+    int input_fd;                   /* Raw input, -1 for none */
+    const char * script_path;       /* Expect script, NULL for none */
+    int has_pass;
+    int has_fail;
+    int pass_on_quiet;              /* Pass once the input is sent and the output is quiet */
+    regex_t pass;                   /* Any output line matching ends the run */
+    regex_t fail;
+
+    /* Runtime */
+    log_t log;
+    pthread_t capture_thread;
+    pthread_t script_thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;            /* New output, or end of run */
+    char pending [HEADLESS_PENDING_SIZE + 1];
+    size_t pending_len;
+    char line [HEADLESS_LINE_SIZE + 1];
+    size_t line_len;
+    headless_status_t status;
+    int closed;                     /* The log is closed */
+} headless_t;
+
+/* Compile the patterns (POSIX extended regex, NULL for none) and open the log (NULL for stdout).
+ * Return 0 on success. */
+int  headless_init   ( headless_t * headless, ring_t * input, ring_t * output, int input_fd, const char * script_path,
+                       const char * log_path, const char * pass, const char * fail, int pass_on_quiet,
+                       uint64_t t_start );
+/* Start the capture thread, draining the output ring, and the input thread, filling the input ring */
+int  headless_start  ( headless_t * headless );
+/* Set the exit status, if not set yet, and wake up the main thread */
+void headless_finish ( headless_t * headless, headless_status_t status );
+/* Close the log, return the exit status (HEADLESS_ERROR if still running) */
+headless_status_t headless_close ( headless_t * headless );
+
+#endif
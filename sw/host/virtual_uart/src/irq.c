@@ -0,0 +1,77 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - interrupt (wake-up) sources
+//              The XDMA driver exposes each user interrupt as an event device: it gets readable
+//              when the interrupt fires, and a read() returns the (4-bytes) event count.
+//              The eventfd stand-in behaves the same, with an 8-bytes counter, so that the
+//              interrupt-driven mode can run against an emulated SoC.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "irq.h"
+
+int irq_source_open ( irq_source_t * irq, irq_source_type_t type, const char * path )
+{
+    irq->type = type;
+
+    if ( type == IRQ_SOURCE_XDMA )
+        irq->fd = open(path, O_RDONLY);
+    else
+        irq->fd = eventfd(0, EFD_NONBLOCK);
+
+    if ( irq->fd == -1 ) {
+        printf("ERROR: Cannot open interrupt source %s\n", type == IRQ_SOURCE_XDMA ? path : "eventfd");
+        return -1;
+    }
+
+    return 0;
+}
+
+int irq_source_wait ( irq_source_t * irq, int timeout_ms )
+{
+    struct pollfd pfd = { .fd = irq->fd, .events = POLLIN };
+    uint64_t count = 0;
+    ssize_t ret;
+
+    /* Sleep until the interrupt fires */
+    do {
+        ret = poll(&pfd, 1, timeout_ms);
+    } while ( ret == -1 && errno == EINTR );
+
+    if ( ret <= 0 )
+        return ret;
+
+    /* Consume the event(s) */
+    if ( irq->type == IRQ_SOURCE_XDMA ) {
+        uint32_t events = 0;
+        ret = read(irq->fd, &events, sizeof(events));
+        count = events;
+    } else {
+        ret = read(irq->fd, &count, sizeof(count));
+        /* Someone else consumed it */
+        if ( ret == -1 && errno == EAGAIN )
+            return 0;
+    }
+
+    return ret < 0 ? -1 : (int) count;
+}
+
+int irq_source_notify ( irq_source_t * irq )
+{
+    uint64_t one = 1;
+
+    if ( irq->type != IRQ_SOURCE_EVENTFD )
+        return -1;
+
+    return write(irq->fd, &one, sizeof(one)) == sizeof(one) ? 0 : -1;
+}
+
+void irq_source_close ( irq_source_t * irq )
+{
+    if ( irq->fd != -1 )
+        close(irq->fd);
+    irq->fd = -1;
+}
@@ -0,0 +1,29 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart interrupt (wake-up) sources header file
+
+#ifndef IRQ_H__
+#define IRQ_H__
+
+#include <stdint.h>
+
+/* Wake-up source types */
+typedef enum {
+    IRQ_SOURCE_XDMA,            /* XDMA user interrupt event device, e.g. /dev/xdma0_events_0 */
+    IRQ_SOURCE_EVENTFD          /* eventfd stand-in, notified by an emulated SoC */
+} irq_source_type_t;
+
+/* Wake-up source */
+typedef struct {
+    irq_source_type_t type;
+    int fd;
+} irq_source_t;
+
+/* Open an event device (XDMA) or create an eventfd (path == NULL), return 0 on success */
+int  irq_source_open   ( irq_source_t * irq, irq_source_type_t type, const char * path );
+/* Block until an event (or timeout_ms, -1 for infinite), consume it and return the number of events, 0 on timeout, -1 on error */
+int  irq_source_wait   ( irq_source_t * irq, int timeout_ms );
+/* Raise an event, stand-in sources only */
+int  irq_source_notify ( irq_source_t * irq );
+void irq_source_close  ( irq_source_t * irq );
+
+#endif
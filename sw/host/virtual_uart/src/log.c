@@ -0,0 +1,129 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - capture log
+//              The SoC output is appended to a memory-mapped file, which grows by LOG_CHUNK_SIZE and
+//              is trimmed on close: no write() per line and no stdio buffering in the way, the page
+//              cache takes care of the write-back. Each line starts with the time since start, in seconds.
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "log.h"
+#include "stats.h"
+
+/* Make room for len more bytes, return 0 on success */
+static int log_reserve ( log_t * log, size_t len )
+{
+    size_t size = log->size;
+    char * map;
+
+    if ( log->len + len <= log->size )
+        return 0;
+
+    while ( size < log->len + len )
+        size += LOG_CHUNK_SIZE;
+    if ( ftruncate(log->fd, size) != 0 )
+        return -1;
+
+    map = (char *) mremap(log->map, log->size, size, MREMAP_MAYMOVE);
+    if ( map == MAP_FAILED )
+        return -1;
+    log->map  = map;
+    log->size = size;
+    return 0;
+}
+
+static void log_append ( log_t * log, const char * buf, size_t len )
+{
+    if ( log->map == NULL ) {
+        while ( len > 0 ) {
+            ssize_t n = write(log->fd, buf, len);
+            if ( n <= 0 )
+                return;
+            buf += n;
+            len -= n;
+        }
+        return;
+    }
+
+    if ( log_reserve(log, len) != 0 ) {
+        fprintf(stderr, "[WARNING] Cannot grow the log, dropping %lu bytes\n", len);
+        return;
+    }
+    memcpy(log->map + log->len, buf, len);
+    log->len += len;
+}
+
+int log_open ( log_t * log, const char * path, int fd, uint64_t t_start )
+{
+    log->map        = NULL;
+    log->size       = 0;
+    log->len        = 0;
+    log->line_start = 1;
+    log->t_start    = t_start;
+    log->fd         = fd;
+
+    if ( path == NULL )
+        return 0;
+
+    log->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if ( log->fd == -1 ) {
+        printf("ERROR: Cannot open log file %s\n", path);
+        return -1;
+    }
+
+    log->size = LOG_CHUNK_SIZE;
+    if ( ftruncate(log->fd, log->size) != 0 ||
+         ( log->map = (char *) mmap(NULL, log->size, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0) ) == MAP_FAILED ) {
+        printf("ERROR: Cannot map log file %s\n", path);
+        close(log->fd);
+        log->map = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+void log_write ( log_t * log, const char * buf, size_t len )
+{
+    char stamp [32];
+    const char * eol;
+    size_t n;
+    int stamp_len;
+
+    /* Plain descriptor, as is */
+    if ( log->map == NULL ) {
+        log_append(log, buf, len);
+        return;
+    }
+
+    while ( len > 0 ) {
+        if ( log->line_start ) {
+            stamp_len = snprintf(stamp, sizeof(stamp), "[%12.6f] ", ( stats_now_ns() - log->t_start ) / 1e9);
+            log_append(log, stamp, stamp_len);
+            log->line_start = 0;
+        }
+
+        /* Up to the end of the line, included */
+        eol = (const char *) memchr(buf, '\n', len);
+        n = eol ? (size_t) ( eol - buf ) + 1 : len;
+        log_append(log, buf, n);
+        log->line_start = ( eol != NULL );
+        buf += n;
+        len -= n;
+    }
+}
+
+void log_close ( log_t * log )
+{
+    if ( log->map == NULL )
+        return;
+
+    munmap(log->map, log->size);
+    if ( ftruncate(log->fd, log->len) != 0 )
+        fprintf(stderr, "[WARNING] Cannot trim the log file\n");
+    close(log->fd);
+    log->map = NULL;
+}
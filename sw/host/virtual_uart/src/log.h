@@ -0,0 +1,30 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart capture log header file
+
+#ifndef LOG_H__
+#define LOG_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Default values */
+#define LOG_CHUNK_SIZE  (64 << 20)  /* The log file grows by this much at a time */
+
+/* Capture log: a memory-mapped file, with a timestamp at the start of each line,
+ * or a plain file descriptor (e.g. stdout) without timestamps */
+typedef struct {
+    int fd;
+    char * map;                 /* NULL for the plain descriptor */
+    size_t size;                /* Mapped size */
+    size_t len;                 /* Bytes written */
+    int line_start;             /* Next byte starts a line */
+    uint64_t t_start;           /* Timestamps origin */
+} log_t;
+
+/* Open the log at path, or on fd if path is NULL. Return 0 on success. */
+int  log_open  ( log_t * log, const char * path, int fd, uint64_t t_start );
+void log_write ( log_t * log, const char * buf, size_t len );
+/* Trim the file to the written bytes */
+void log_close ( log_t * log );
+
+#endif
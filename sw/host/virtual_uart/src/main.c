@@ -1,54 +1,236 @@
 // Author: Manuel Maddaluno <manuel.maddaluno@unina.it>
 // Description: Virtual Uart host application - main
-//              This is a two-posix-thread application.
+//              This is a four-posix-thread application.
 //              The write_thread writes on the RX uart register (writes to the core)
-//              The read_thread reads on the TX uart register (reads from the host) polling with u_poll_period microseconds
+//              The read_thread reads on the TX uart register (reads from the host) according to the polling policy,
+//              or sleeping on the XDMA user interrupt if an event device is given
+//              The stdin_thread and output_thread move the chars between the terminal and the uart threads
+//              through lock-free rings, in large chunks.
+//              The main thread waits for SIGINT/SIGTERM, then prints the throughput, latency and CPU time figures.
+//              In headless mode (any of -I, -E, -o, -P, -F, -T) the console threads are replaced by the
+//              input and capture threads (see headless.c), and the exit status reports pass/fail/timeout.
 
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
 #include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
 #include "utils.h"
+#include "virtual_uart.h"
 #include "threads.h"
+#include "headless.h"
 
 int main ( int argc, char *argv[] )
 {
 
     pthread_t read_thread;
     pthread_t write_thread;
+    pthread_t stdin_thread;
+    pthread_t output_thread;
 
     write_thread_arg_t * write_thread_arg = (write_thread_arg_t *) malloc (sizeof(write_thread_arg_t));
     read_thread_arg_t * read_thread_arg = (read_thread_arg_t *) malloc (sizeof(read_thread_arg_t));
+    console_thread_arg_t stdin_thread_arg;
+    console_thread_arg_t output_thread_arg;
 
-    if ( argc < 2 ) {
-        help(argv[0]);
+    char * prog_name = argv[0];
+    int opt;
+    int nargs;
+    poll_policy_type_t policy_type = POLL_POLICY_ADAPTIVE;
+    poll_policy_t policy;
+    poll_stats_t rx_stats;
+    poll_stats_t tx_stats;
+    stats_rate_t rx_rate;
+    stats_rate_t tx_rate;
+    ring_t stdin_ring;
+    ring_t output_ring;
+    int print_stats = 1;
+    sigset_t sigset;
+    int sig;
+    struct timespec timeout;
+    int headless_mode = 0;
+    headless_t * headless = NULL;
+    headless_status_t status = HEADLESS_PASS;
+    const char * input_path  = NULL;
+    const char * script_path = NULL;
+    const char * log_path    = NULL;
+    const char * pass        = NULL;
+    const char * fail        = NULL;
+    unsigned int timeout_s   = 0;
+    int pass_on_quiet = 0;
+    int input_fd = -1;
+
+    /* Get the options */
+    read_thread_arg->irq_path    = NULL;
+    read_thread_arg->backend     = MMIO_BACKEND_DEVMEM;
+    read_thread_arg->dev_path    = NULL;
+    read_thread_arg->cpu         = -1;
+    read_thread_arg->rt_priority = 0;
+    output_thread_arg.flush_us   = OUTPUT_DEFAULT_FLUSH_US;
+    while ( ( opt = getopt(argc, argv, "i:p:a:r:f:s:c:nI:E:o:P:F:QT:h") ) != -1 ) {
+        switch ( opt ) {
+            case 'i':
+                /* Interrupt-driven RX */
+                read_thread_arg->irq_path = optarg;
+                break;
+            case 'p':
+                /* Polling policy */
+                if ( poll_policy_parse(optarg, &policy_type) != 0 ) {
+                    printf("ERROR: Unknown polling policy %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'a':
+                /* Read thread CPU affinity */
+                read_thread_arg->cpu = atoi(optarg);
+                break;
+            case 'r':
+                /* Read thread SCHED_FIFO priority */
+                read_thread_arg->rt_priority = atoi(optarg);
+                break;
+            case 'f':
+                /* Output flush deadline */
+                output_thread_arg.flush_us = atoi(optarg);
+                break;
+            case 's':
+                /* Software model in shared memory instead of the PCIe BAR */
+                read_thread_arg->backend  = MMIO_BACKEND_SHM;
+                read_thread_arg->dev_path = optarg;
+                break;
+            case 'c':
+                /* Verilator model of the RTL, through the co-simulation transport */
+                read_thread_arg->backend  = MMIO_BACKEND_COSIM;
+                read_thread_arg->dev_path = optarg;
+                break;
+            case 'n':
+                /* No statistics */
+                print_stats = 0;
+                break;
+            case 'I':
+                /* Headless: raw input file, - for stdin */
+                input_path = optarg;
+                headless_mode = 1;
+                break;
+            case 'E':
+                /* Headless: expect script */
+                script_path = optarg;
+                headless_mode = 1;
+                break;
+            case 'o':
+                /* Headless: capture log */
+                log_path = optarg;
+                headless_mode = 1;
+                break;
+            case 'P':
+                /* Headless: pass pattern */
+                pass = optarg;
+                headless_mode = 1;
+                break;
+            case 'F':
+                /* Headless: fail pattern */
+                fail = optarg;
+                headless_mode = 1;
+                break;
+            case 'Q':
+                /* Headless: pass once the input is sent and the output is quiet */
+                pass_on_quiet = 1;
+                headless_mode = 1;
+                break;
+            case 'T':
+                /* Headless: overall timeout */
+                timeout_s = atoi(optarg);
+                headless_mode = 1;
+                break;
+            default:
+                help(prog_name);
+                return -1;
+        }
+    }
+
+    /* Positional arguments */
+    nargs = argc - optind;
+    argv += optind;
+
+    if ( input_path && script_path ) {
+        printf("ERROR: -I and -E are mutually exclusive\n");
+        return -1;
+    }
+
+    /* The uart physical address is meaningless for the software model and the co-simulation */
+    if ( nargs < 1 && read_thread_arg->backend == MMIO_BACKEND_DEVMEM ) {
+        help(prog_name);
         return -1;
     }
 
     /* Get the virtual uart physical address */
-    write_thread_arg->paddr = (uint64_t)strtol(argv[1], NULL, 0);
-    read_thread_arg->paddr = (uint64_t)strtol(argv[1], NULL, 0);
+    write_thread_arg->backend  = read_thread_arg->backend;
+    write_thread_arg->dev_path = read_thread_arg->dev_path;
+    write_thread_arg->paddr = nargs >= 1 ? (uint64_t)strtol(argv[0], NULL, 0) : 0;
+    read_thread_arg->paddr  = write_thread_arg->paddr;
 
     /* Get the mapping length */
-    if ( argc >= 3 ) {
-        write_thread_arg->length = atoi(argv[2]);
-        read_thread_arg->length = atoi(argv[2]);
+    if ( nargs >= 2 ) {
+        write_thread_arg->length = atoi(argv[1]);
+        read_thread_arg->length = atoi(argv[1]);
     } else {
-        write_thread_arg->length = 20;
-        read_thread_arg->length = 20;
+        write_thread_arg->length = VIRTUAL_UART_DEFAULT_LENGTH;
+        read_thread_arg->length = VIRTUAL_UART_DEFAULT_LENGTH;
     }
 
-    /* Get the poll period */
-    if ( argc >= 4 ) {
-        read_thread_arg->u_poll_period = atoi(argv[3]);
-    } else {
-        read_thread_arg->u_poll_period = 10;
+    /* Get the poll period (sleep) or the backoff cap (adaptive), 0 for the policy default */
+    poll_policy_init(&policy, policy_type, nargs >= 3 ? atoi(argv[2]) : 0);
+    write_thread_arg->policy = &policy;
+    read_thread_arg->policy  = &policy;
+
+    /* Statistics */
+    poll_stats_init(&rx_stats);
+    poll_stats_init(&tx_stats);
+    write_thread_arg->stats = print_stats ? &tx_stats : NULL;
+    read_thread_arg->stats  = print_stats ? &rx_stats : NULL;
+    stats_rate_init(&rx_rate);
+    stats_rate_init(&tx_rate);
+    write_thread_arg->rate = &tx_rate;
+    read_thread_arg->rate  = &rx_rate;
+
+    /* Console rings */
+    if ( ring_init(&stdin_ring, RING_DEFAULT_SIZE) != 0 || ring_init(&output_ring, RING_DEFAULT_SIZE) != 0 )
+        return -1;
+    stdin_thread_arg.ring   = &stdin_ring;
+    write_thread_arg->ring  = &stdin_ring;
+    read_thread_arg->ring   = &output_ring;
+    output_thread_arg.ring  = &output_ring;
+
+    /* Headless mode: input from a file or a script, output to the log */
+    if ( headless_mode ) {
+        if ( input_path )
+            input_fd = strcmp(input_path, "-") == 0 ? STDIN_FILENO : open(input_path, O_RDONLY);
+        if ( input_path && input_fd == -1 ) {
+            printf("ERROR: Cannot open input file %s\n", input_path);
+            return HEADLESS_ERROR;
+        }
+        /* A script checks the output with its expects: without a pass pattern, its end and the quiet output pass the run.
+         * A raw input checks nothing: it passes on quiet only if asked, not to cut off a slow test and mark it passing. */
+        if ( script_path && !pass )
+            pass_on_quiet = 1;
+        headless = (headless_t *) malloc (sizeof(headless_t));
+        if ( headless_init(headless, &stdin_ring, &output_ring, input_fd, script_path, log_path, pass, fail, pass_on_quiet,
+                           stats_now_ns()) != 0 )
+            return HEADLESS_ERROR;
     }
 
-    /* Disable stdin buffering*/
-    disable_buffering();
-    setbuf(stdin, NULL);
-    /* Disable stdout buffering */
+    /* Block the termination signals in all threads, the main thread waits for them */
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGINT);
+    sigaddset(&sigset, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+    /* Disable stdin line buffering, the console threads use read()/writev() directly */
+    if ( !headless_mode )
+        disable_buffering();
+    /* Disable stdout buffering, for the error messages */
     setbuf(stdout, NULL);
 
     if ( pthread_create(&write_thread, NULL, write_thread_function, (void *) write_thread_arg ) != 0 ) {
@@ -64,11 +246,48 @@ int main ( int argc, char *argv[] )
         return -1;
     }
 
+    if ( headless_mode ) {
+        if ( headless_start(headless) != 0 )
+            return HEADLESS_ERROR;
+    }
+    else if ( pthread_create(&stdin_thread, NULL, stdin_thread_function, (void *) &stdin_thread_arg) != 0 ||
+              pthread_create(&output_thread, NULL, output_thread_function, (void *) &output_thread_arg) != 0 ) {
+        printf("ERROR: pthread_create failed\n");
+        enable_buffering();
+        return -1;
+    }
 
-    pthread_join(write_thread, NULL);
-    pthread_join(read_thread, NULL);
 
-    enable_buffering();
+    /* Wait for Ctrl-C, for a thread to fail or, in headless mode, for the end of the run */
+    if ( timeout_s > 0 ) {
+        timeout.tv_sec  = timeout_s;
+        timeout.tv_nsec = 0;
+        if ( sigtimedwait(&sigset, NULL, &timeout) == -1 ) {
+            fprintf(stderr, "[HEADLESS] Timeout after %u s\n", timeout_s);
+            headless_finish(headless, HEADLESS_TIMEOUT);
+        }
+    }
+    else {
+        sigwait(&sigset, &sig);
+    }
+
+    if ( headless_mode ) {
+        status = headless_close(headless);
+        fprintf(stderr, "[HEADLESS] %s\n", status == HEADLESS_PASS ? "PASS" : status == HEADLESS_FAIL ? "FAIL" :
+                                           status == HEADLESS_TIMEOUT ? "TIMEOUT" : "ERROR");
+    }
+    else {
+        enable_buffering();
+    }
+
+    /* The threads are still running, the figures are a snapshot */
+    fprintf(stderr, "\n");
+    stats_rate_print(stderr, &rx_rate, "RX throughput");
+    stats_rate_print(stderr, &tx_rate, "TX throughput");
+    if ( print_stats ) {
+        poll_stats_print(stderr, &rx_stats, "RX");
+        poll_stats_print(stderr, &tx_stats, "TX");
+    }
 
-    return 0;
+    return status;
 }
\ No newline at end of file
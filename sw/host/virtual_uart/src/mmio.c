@@ -0,0 +1,125 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - MMIO backends
+//              The DEVMEM backend maps the PCIe BAR window of the peripheral.
+//              The SHM backend maps the state of the software model (vu_model.c), so that the host
+//              application can run, and be measured, against a stand-in SoC thread or process.
+//              The COSIM backend maps the transport of the Verilator testbench of the RTL (cosim.c), so that
+//              the application runs against the simulated peripheral before building a bitstream.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "mmio.h"
+
+int mmio_open ( mmio_dev_t * dev, mmio_backend_t backend, const char * path, uint64_t paddr, size_t length )
+{
+    off_t pa_offset;                    /* page aligned offset */
+    int fd = -1;
+
+    dev->backend = backend;
+    dev->regs    = NULL;
+    dev->model   = NULL;
+    dev->cosim   = NULL;
+    dev->cosim_port = -1;
+    dev->map     = MAP_FAILED;
+
+    if ( backend == MMIO_BACKEND_DEVMEM ) {
+        if ( path == NULL )
+            path = MMIO_DEFAULT_DEVICE;
+
+        /* Open the /dev/mem file */
+        fd = open(path, O_RDWR | O_SYNC);
+        if ( fd == -1 ) {
+            printf("ERROR: Cannot open device file %s\n", path);
+            return -1;
+        }
+
+        /* Compute the page aligned offset */
+        pa_offset = paddr & ~(sysconf(_SC_PAGE_SIZE) - 1);
+
+        /* Get the virtual address */
+        dev->map_length = length + paddr - pa_offset;
+        dev->map = mmap(NULL, dev->map_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, pa_offset);
+        dev->regs = (volatile uint32_t *) ( (uint8_t *) dev->map + ( paddr - pa_offset ) );
+    }
+    else if ( backend == MMIO_BACKEND_COSIM ) {
+        dev->map_length = sizeof(cosim_shm_t);
+
+        /* Transport owned by the testbench */
+        fd = shm_open(path, O_RDWR, 0);
+        if ( fd == -1 ) {
+            printf("ERROR: Cannot open shared memory %s, is the testbench running?\n", path);
+            return -1;
+        }
+        dev->map = mmap(NULL, dev->map_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        fd = -1;
+        if ( dev->map == MAP_FAILED ) {
+            printf("ERROR: Map failed\n");
+            return -1;
+        }
+
+        dev->cosim = (cosim_shm_t *) dev->map;
+        if ( __atomic_load_n(&dev->cosim->magic, __ATOMIC_ACQUIRE) != COSIM_MAGIC || !dev->cosim->running ) {
+            printf("ERROR: %s is not a running co-simulation\n", path);
+            mmio_close(dev);
+            return -1;
+        }
+        dev->cosim_port = cosim_claim(dev->cosim);
+        if ( dev->cosim_port < 0 ) {
+            printf("ERROR: No free port in %s, max %d host threads\n", path, COSIM_NUM_PORTS);
+            mmio_close(dev);
+            return -1;
+        }
+    }
+    else {
+        dev->map_length = sizeof(vu_model_t);
+
+        if ( path == NULL ) {
+            /* In-process model */
+            dev->map = mmap(NULL, dev->map_length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if ( dev->map != MAP_FAILED )
+                vu_model_reset((vu_model_t *) dev->map);
+        }
+        else {
+            /* Model owned by another process */
+            fd = shm_open(path, O_RDWR, 0);
+            if ( fd == -1 ) {
+                printf("ERROR: Cannot open shared memory %s, is the model running?\n", path);
+                return -1;
+            }
+            dev->map = mmap(NULL, dev->map_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        dev->model = (vu_model_t *) dev->map;
+    }
+
+    if ( fd != -1 )
+        close(fd);
+
+    if ( dev->map == MAP_FAILED ) {
+        printf("ERROR: Map failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+void mmio_close ( mmio_dev_t * dev )
+{
+    if ( dev->cosim != NULL && dev->cosim_port >= 0 )
+        cosim_release(dev->cosim, dev->cosim_port);
+    dev->cosim_port = -1;
+    if ( dev->map != MAP_FAILED )
+        munmap(dev->map, dev->map_length);
+    dev->map = MAP_FAILED;
+}
+
+void mmio_view ( mmio_dev_t * view, const mmio_dev_t * parent, size_t offset )
+{
+    *view = *parent;
+    view->regs = (volatile uint32_t *) ( (volatile uint8_t *) parent->regs + offset );
+    view->map  = MAP_FAILED;
+    view->map_length = 0;
+}
@@ -0,0 +1,78 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart MMIO backends header file
+
+#ifndef MMIO_H__
+#define MMIO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vu_model.h"
+#include "cosim.h"
+
+/* Default values */
+#define MMIO_DEFAULT_DEVICE "/dev/mem"
+
+/* MMIO backends */
+typedef enum {
+    MMIO_BACKEND_DEVMEM,        /* PCIe BAR mapped through /dev/mem */
+    MMIO_BACKEND_SHM,           /* Software model of the CSR block in shared memory */
+    MMIO_BACKEND_COSIM          /* Verilator model of the RTL, through the co-simulation transport */
+} mmio_backend_t;
+
+/* MMIO device handle */
+typedef struct {
+    mmio_backend_t backend;
+    volatile uint32_t * regs;   /* DEVMEM: registers base */
+    vu_model_t * model;         /* SHM: model state */
+    cosim_shm_t * cosim;        /* COSIM: transport */
+    int cosim_port;             /* COSIM: port claimed by this device */
+    void * map;                 /* Page-aligned mapping */
+    size_t map_length;
+} mmio_dev_t;
+
+/* DEVMEM: map length bytes at paddr of path (/dev/mem if NULL).
+ * SHM: map the POSIX shared memory object path, created by the model, or an anonymous
+ *      in-process model if NULL.
+ * COSIM: map the POSIX shared memory object path, created by the testbench, and claim a port.
+ * Return 0 on success. */
+int  mmio_open  ( mmio_dev_t * dev, mmio_backend_t backend, const char * path, uint64_t paddr, size_t length );
+void mmio_close ( mmio_dev_t * dev );
+/* Device at offset bytes into the mapping of parent (DEVMEM), which keeps owning it */
+void mmio_view  ( mmio_dev_t * view, const mmio_dev_t * parent, size_t offset );
+
+/* Register accessors, the hardware path is a plain volatile access */
+static inline uint32_t mmio_read32 ( mmio_dev_t * dev, uint32_t offset )
+{
+    if ( dev->backend == MMIO_BACKEND_DEVMEM )
+        return dev->regs[offset >> 2];
+    if ( dev->backend == MMIO_BACKEND_COSIM )
+        return cosim_read(dev->cosim, dev->cosim_port, offset);
+    return vu_model_read(dev->model, offset);
+}
+
+static inline void mmio_write32 ( mmio_dev_t * dev, uint32_t offset, uint32_t value )
+{
+    if ( dev->backend == MMIO_BACKEND_DEVMEM )
+        dev->regs[offset >> 2] = value;
+    else if ( dev->backend == MMIO_BACKEND_COSIM )
+        cosim_write(dev->cosim, dev->cosim_port, offset, value, 0xF);
+    else
+        vu_model_write(dev->model, offset, value);
+}
+
+/* Narrow write of the first nbytes (1, 2 or 4) byte lanes at a word-aligned offset */
+static inline void mmio_write_lanes ( mmio_dev_t * dev, uint32_t offset, uint32_t value, unsigned int nbytes )
+{
+    if ( dev->backend == MMIO_BACKEND_SHM )
+        vu_model_write_lanes(dev->model, offset, value, nbytes);
+    else if ( dev->backend == MMIO_BACKEND_COSIM )
+        cosim_write(dev->cosim, dev->cosim_port, offset, value, ( 1 << nbytes ) - 1);
+    else if ( nbytes == 1 )
+        *(volatile uint8_t *) &dev->regs[offset >> 2] = (uint8_t) value;
+    else if ( nbytes == 2 )
+        *(volatile uint16_t *) &dev->regs[offset >> 2] = (uint16_t) value;
+    else
+        dev->regs[offset >> 2] = value;
+}
+
+#endif
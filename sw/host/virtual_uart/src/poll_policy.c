@@ -0,0 +1,162 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - polling policies
+//              A fixed poll period is either slow (long sleeps) or expensive (short sleeps).
+//              The adaptive policy spins for a short while, so that back-to-back chars are caught
+//              immediately, then yields the CPU and finally sleeps, doubling the period up to a cap.
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/prctl.h>
+#include "poll_policy.h"
+
+/* Spin-loop hint */
+static inline void cpu_relax ()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile ( "yield" ::: "memory" );
+#else
+    __asm__ volatile ( "" ::: "memory" );
+#endif
+}
+
+static void sleep_us ( unsigned int us )
+{
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = ( us % 1000000 ) * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+void poll_policy_init ( poll_policy_t * policy, poll_policy_type_t type, unsigned int sleep_us )
+{
+    policy->type        = type;
+    policy->spin_iters  = POLL_DEFAULT_SPIN_ITERS;
+    policy->yield_iters = POLL_DEFAULT_YIELD_ITERS;
+    if ( sleep_us != 0 )
+        policy->sleep_us = sleep_us;
+    else
+        policy->sleep_us = type == POLL_POLICY_ADAPTIVE ? POLL_DEFAULT_MAX_SLEEP_US : POLL_DEFAULT_SLEEP_US;
+}
+
+int poll_policy_parse ( const char * name, poll_policy_type_t * type )
+{
+    if      ( strcmp(name, "sleep")    == 0 ) *type = POLL_POLICY_SLEEP;
+    else if ( strcmp(name, "spin")     == 0 ) *type = POLL_POLICY_SPIN;
+    else if ( strcmp(name, "adaptive") == 0 ) *type = POLL_POLICY_ADAPTIVE;
+    else return -1;
+
+    return 0;
+}
+
+void poll_policy_thread_init ()
+{
+    /* The default 50us timer slack would dominate short sleeps */
+    prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+}
+
+void poll_begin ( poll_state_t * state, const poll_policy_t * policy, poll_stats_t * stats )
+{
+    state->policy   = policy;
+    state->stats    = stats;
+    state->iter     = 0;
+    state->sleep_us = 1;
+    state->t_check  = 0;
+    if ( stats )
+        state->cpu_start = stats_cpu_ns();
+}
+
+void poll_wait ( poll_state_t * state )
+{
+    const poll_policy_t * policy = state->policy;
+
+    if ( state->stats )
+        state->t_check = stats_now_ns();
+
+    switch ( policy->type ) {
+        case POLL_POLICY_SLEEP:
+            sleep_us(policy->sleep_us);
+            break;
+
+        case POLL_POLICY_SPIN:
+            cpu_relax();
+            break;
+
+        case POLL_POLICY_ADAPTIVE:
+            if ( state->iter < policy->spin_iters ) {
+                cpu_relax();
+            }
+            else if ( state->iter < policy->spin_iters + policy->yield_iters ) {
+                sched_yield();
+            }
+            else {
+                sleep_us(state->sleep_us);
+                if ( state->sleep_us < policy->sleep_us ) {
+                    state->sleep_us <<= 1;
+                    if ( state->sleep_us > policy->sleep_us )
+                        state->sleep_us = policy->sleep_us;
+                }
+            }
+            break;
+    }
+
+    state->iter++;
+}
+
+/* Event-loop flavour of poll_wait(): return how long to block for, 0 to check again right away */
+unsigned int poll_next_timeout_us ( poll_state_t * state )
+{
+    const poll_policy_t * policy = state->policy;
+    unsigned int timeout_us = 0;
+
+    switch ( policy->type ) {
+        case POLL_POLICY_SLEEP:
+            timeout_us = policy->sleep_us;
+            break;
+
+        case POLL_POLICY_SPIN:
+            break;
+
+        case POLL_POLICY_ADAPTIVE:
+            /* No spinning nor yielding here: the event loop itself is the busy phase */
+            if ( state->iter >= policy->yield_iters ) {
+                timeout_us = state->sleep_us;
+                if ( state->sleep_us < policy->sleep_us ) {
+                    state->sleep_us <<= 1;
+                    if ( state->sleep_us > policy->sleep_us )
+                        state->sleep_us = policy->sleep_us;
+                }
+            }
+            break;
+    }
+
+    state->iter++;
+    return timeout_us;
+}
+
+void poll_end ( poll_state_t * state )
+{
+    if ( state->stats == NULL )
+        return;
+
+    /* Data found at the first check: no detection delay */
+    stats_hist_add(&state->stats->latency, state->t_check ? stats_now_ns() - state->t_check : 0);
+    stats_hist_add(&state->stats->cpu, stats_cpu_ns() - state->cpu_start);
+}
+
+void poll_stats_init ( poll_stats_t * stats )
+{
+    stats_hist_init(&stats->latency);
+    stats_hist_init(&stats->cpu);
+}
+
+void poll_stats_print ( FILE * fp, const poll_stats_t * stats, const char * name )
+{
+    char title [64];
+
+    snprintf(title, sizeof(title), "%s latency", name);
+    stats_hist_print(fp, &stats->latency, title);
+    snprintf(title, sizeof(title), "%s CPU time", name);
+    stats_hist_print(fp, &stats->cpu, title);
+}
@@ -0,0 +1,64 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart polling policies header file
+
+#ifndef POLL_POLICY_H__
+#define POLL_POLICY_H__
+
+#include <stdint.h>
+#include "stats.h"
+
+/* Default values */
+#define POLL_DEFAULT_SPIN_ITERS     256     /* Adaptive: busy-wait iterations before yielding */
+#define POLL_DEFAULT_YIELD_ITERS    16      /* Adaptive: sched_yield() iterations before sleeping */
+#define POLL_DEFAULT_SLEEP_US       10      /* Sleep: poll period */
+#define POLL_DEFAULT_MAX_SLEEP_US   1000    /* Adaptive: exponential backoff cap */
+
+/* Policies */
+typedef enum {
+    POLL_POLICY_SLEEP,          /* Fixed period sleep between two checks */
+    POLL_POLICY_SPIN,           /* Busy-wait, lowest latency, burns a whole CPU */
+    POLL_POLICY_ADAPTIVE        /* Spin, then yield, then sleep with exponential backoff */
+} poll_policy_type_t;
+
+/* Policy configuration */
+typedef struct {
+    poll_policy_type_t type;
+    unsigned int spin_iters;
+    unsigned int yield_iters;
+    unsigned int sleep_us;      /* Sleep: poll period. Adaptive: backoff cap */
+} poll_policy_t;
+
+/* Per-direction statistics */
+typedef struct {
+    stats_hist_t latency;       /* Upper bound of the detection latency: time since the last failed check */
+    stats_hist_t cpu;           /* CPU time per char */
+} poll_stats_t;
+
+/* State of a single wait */
+typedef struct {
+    const poll_policy_t * policy;
+    poll_stats_t * stats;       /* NULL if no statistics */
+    unsigned int iter;
+    unsigned int sleep_us;
+    uint64_t t_check;           /* Time of the last failed check, 0 if none */
+    uint64_t cpu_start;
+} poll_state_t;
+
+/* Init a policy with the default values, sleep_us == 0 selects the policy default */
+void poll_policy_init   ( poll_policy_t * policy, poll_policy_type_t type, unsigned int sleep_us );
+/* Parse a policy name (sleep, spin, adaptive), return 0 on success */
+int  poll_policy_parse  ( const char * name, poll_policy_type_t * type );
+/* Per-thread setup for short sleeps */
+void poll_policy_thread_init ();
+
+/* Wait loop: poll_begin(); while ( !ready ) poll_wait(); poll_end(); */
+void poll_begin ( poll_state_t * state, const poll_policy_t * policy, poll_stats_t * stats );
+void poll_wait  ( poll_state_t * state );
+void poll_end   ( poll_state_t * state );
+/* Event loops: next timeout instead of waiting in place, restart with poll_begin() on activity */
+unsigned int poll_next_timeout_us ( poll_state_t * state );
+
+void poll_stats_init  ( poll_stats_t * stats );
+void poll_stats_print ( FILE * fp, const poll_stats_t * stats, const char * name );
+
+#endif
@@ -0,0 +1,164 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - single-producer/single-consumer byte ring
+//              head and tail are free-running counters, each written by one side only.
+//              A side going to sleep first raises its waiting flag, then checks the ring again;
+//              the other side first publishes its index, then checks the flag. With sequentially
+//              consistent accesses on both sides, at least one of them sees the other: no lost wake-ups.
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "ring.h"
+
+int ring_init ( ring_t * ring, size_t size )
+{
+    /* Power of 2 sizes only, to wrap with a mask */
+    if ( size == 0 || ( size & ( size - 1 ) ) != 0 ) {
+        printf("ERROR: Ring size %lu is not a power of 2\n", size);
+        return -1;
+    }
+
+    ring->buf = (uint8_t *) malloc(size);
+    ring->size = size;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->producer_waiting, 0);
+    atomic_init(&ring->consumer_waiting, 0);
+    atomic_init(&ring->closed, 0);
+    ring->producer_fd = eventfd(0, EFD_NONBLOCK);
+    ring->consumer_fd = eventfd(0, EFD_NONBLOCK);
+
+    if ( ring->buf == NULL || ring->producer_fd == -1 || ring->consumer_fd == -1 ) {
+        printf("ERROR: Cannot allocate the ring\n");
+        ring_destroy(ring);
+        return -1;
+    }
+
+    return 0;
+}
+
+void ring_destroy ( ring_t * ring )
+{
+    free(ring->buf);
+    ring->buf = NULL;
+    if ( ring->producer_fd != -1 )
+        close(ring->producer_fd);
+    if ( ring->consumer_fd != -1 )
+        close(ring->consumer_fd);
+    ring->producer_fd = ring->consumer_fd = -1;
+}
+
+/* Split [start, start + len) into up to two contiguous regions */
+static size_t ring_regions ( ring_t * ring, size_t start, size_t len, struct iovec iov [2], int * iovcnt )
+{
+    size_t offset = start & ( ring->size - 1 );
+    size_t first  = ring->size - offset;
+
+    if ( first > len )
+        first = len;
+
+    iov[0].iov_base = ring->buf + offset;
+    iov[0].iov_len  = first;
+    iov[1].iov_base = ring->buf;
+    iov[1].iov_len  = len - first;
+    *iovcnt = ( len == 0 ) ? 0 : ( len > first ) ? 2 : 1;
+
+    return len;
+}
+
+/* Ring the doorbell of the other side, if it is waiting */
+static void ring_notify ( _Atomic int * waiting, int fd )
+{
+    uint64_t one = 1;
+
+    if ( atomic_load(waiting) )
+        if ( write(fd, &one, sizeof(one)) != sizeof(one) )
+            perror("ring doorbell");
+}
+
+/* Sleep on the doorbell */
+static void ring_sleep ( int fd, const struct timespec * timeout )
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    uint64_t count;
+
+    if ( ppoll(&pfd, 1, timeout, NULL) > 0 )
+        if ( read(fd, &count, sizeof(count)) < 0 )
+            return;
+}
+
+size_t ring_writable ( ring_t * ring, struct iovec iov [2], int * iovcnt )
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    return ring_regions(ring, head, ring->size - ( head - tail ), iov, iovcnt);
+}
+
+void ring_produce ( ring_t * ring, size_t n )
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    atomic_store(&ring->head, head + n);
+    ring_notify(&ring->consumer_waiting, ring->consumer_fd);
+}
+
+int ring_push ( ring_t * ring, uint8_t c )
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if ( head - tail == ring->size )
+        return -1;
+
+    ring->buf[head & ( ring->size - 1 )] = c;
+    ring_produce(ring, 1);
+    return 0;
+}
+
+void ring_close ( ring_t * ring )
+{
+    atomic_store(&ring->closed, 1);
+    ring_notify(&ring->consumer_waiting, ring->consumer_fd);
+}
+
+size_t ring_readable ( ring_t * ring, struct iovec iov [2], int * iovcnt )
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return ring_regions(ring, tail, head - tail, iov, iovcnt);
+}
+
+void ring_consume ( ring_t * ring, size_t n )
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store(&ring->tail, tail + n);
+    ring_notify(&ring->producer_waiting, ring->producer_fd);
+}
+
+int ring_drained ( ring_t * ring )
+{
+    return atomic_load(&ring->closed) && atomic_load(&ring->head) == atomic_load(&ring->tail);
+}
+
+void ring_wait_readable ( ring_t * ring, const struct timespec * timeout )
+{
+    atomic_store(&ring->consumer_waiting, 1);
+    if ( atomic_load(&ring->head) == atomic_load(&ring->tail) && !atomic_load(&ring->closed) )
+        ring_sleep(ring->consumer_fd, timeout);
+    atomic_store(&ring->consumer_waiting, 0);
+}
+
+void ring_wait_writable ( ring_t * ring )
+{
+    atomic_store(&ring->producer_waiting, 1);
+    if ( atomic_load(&ring->head) - atomic_load(&ring->tail) == ring->size )
+        ring_sleep(ring->producer_fd, NULL);
+    atomic_store(&ring->producer_waiting, 0);
+}
@@ -0,0 +1,56 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart single-producer/single-consumer byte ring header file
+
+#ifndef RING_H__
+#define RING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/uio.h>
+
+/* Default values */
+#define RING_DEFAULT_SIZE   (64 << 10)  /* 64 KiB, must be a power of 2 */
+#define RING_CACHE_LINE     64
+
+/* Lock-free SPSC ring. Each side only blocks (on an eventfd) when the ring is empty/full,
+ * and the other side only rings the doorbell when someone is actually waiting. */
+typedef struct {
+    /* Producer side */
+    _Alignas(RING_CACHE_LINE) _Atomic size_t head;
+    _Atomic int producer_waiting;
+    int producer_fd;
+    /* Consumer side */
+    _Alignas(RING_CACHE_LINE) _Atomic size_t tail;
+    _Atomic int consumer_waiting;
+    int consumer_fd;
+    /* Shared, read-only after init */
+    _Alignas(RING_CACHE_LINE) uint8_t * buf;
+    size_t size;
+    _Atomic int closed;         /* The producer will not produce anymore */
+} ring_t;
+
+int  ring_init    ( ring_t * ring, size_t size );
+void ring_destroy ( ring_t * ring );
+
+/* Producer: get up to two contiguous free regions, fill them, then publish n bytes */
+size_t ring_writable ( ring_t * ring, struct iovec iov [2], int * iovcnt );
+void   ring_produce  ( ring_t * ring, size_t n );
+/* Producer: push a single byte, return 0 on success, -1 if full */
+int    ring_push     ( ring_t * ring, uint8_t c );
+/* Producer: mark the end of the stream */
+void   ring_close    ( ring_t * ring );
+
+/* Consumer: get up to two contiguous data regions, use them, then release n bytes */
+size_t ring_readable ( ring_t * ring, struct iovec iov [2], int * iovcnt );
+void   ring_consume  ( ring_t * ring, size_t n );
+/* Consumer: end of stream and nothing left */
+int    ring_drained  ( ring_t * ring );
+
+/* Block until data (or end of stream) is available, timeout NULL for infinite */
+void ring_wait_readable ( ring_t * ring, const struct timespec * timeout );
+/* Block until free space is available */
+void ring_wait_writable ( ring_t * ring );
+
+#endif
@@ -0,0 +1,505 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - multi-instance server
+//              A single process serves many virtual uart instances, each exported on its own pseudo-terminal.
+//              DEVMEM instances in the same BAR region share one mapping of /dev/mem.
+//              Each worker runs an epoll loop over the terminals and XDMA event devices of its instances.
+//              The instances without an event device are polled in the loop itself, with the idle backoff
+//              of the polling policy: a busy instance keeps the loop spinning, an idle server sleeps up to
+//              the policy cap, whatever the number of instances. With interrupts only, it blocks in epoll.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include "server.h"
+
+/* epoll tags: instance index * 2 + 1 for the event device, all ones for the stop eventfd */
+#define TAG_STOP            UINT64_MAX
+#define TAG_PTY(i)          ( (uint64_t) (i) << 1 )
+#define TAG_IRQ(i)          ( ( (uint64_t) (i) << 1 ) | 1 )
+#define WORKER_MAX_EVENTS   64
+
+/**************
+ * Buffers    *
+ **************/
+
+static size_t buf_len ( const server_buf_t * buf )
+{
+    return buf->head - buf->tail;
+}
+
+/* Free space at the head, compacting if needed */
+static size_t buf_room ( server_buf_t * buf )
+{
+    if ( buf->tail == buf->head ) {
+        buf->tail = 0;
+        buf->head = 0;
+    }
+    else if ( buf->head == SERVER_BUF_SIZE && buf->tail > 0 ) {
+        memmove(buf->buf, buf->buf + buf->tail, buf_len(buf));
+        buf->head -= buf->tail;
+        buf->tail = 0;
+    }
+    return SERVER_BUF_SIZE - buf->head;
+}
+
+/**************
+ * Config     *
+ **************/
+
+int server_load_config ( server_t * server, const char * path )
+{
+    server_instance_t parsed;
+    server_instance_t * inst = &parsed;
+    char line [2 * PATH_MAX];
+    char address [PATH_MAX];
+    char length [32];
+    char * hash;
+    int lineno = 0;
+    int fields;
+    FILE * fp;
+
+    fp = fopen(path, "r");
+    if ( fp == NULL ) {
+        printf("ERROR: Cannot open config file %s\n", path);
+        return -1;
+    }
+
+    server->num_instances = 0;
+    while ( fgets(line, sizeof(line), fp) != NULL ) {
+        lineno++;
+        if ( ( hash = strchr(line, '#') ) != NULL )
+            *hash = '\0';
+
+        /* Parsed locally, copied into the table after the checks */
+        memset(inst, 0, sizeof(server_instance_t));
+        fields = sscanf(line, "%31s %4095s %31s %4095s", inst->name, address, length, inst->irq_path);
+        if ( fields <= 0 )
+            continue;
+        if ( fields < 2 ) {
+            printf("ERROR: %s:%d: missing address\n", path, lineno);
+            goto error;
+        }
+        if ( server->num_instances == SERVER_MAX_INSTANCES ) {
+            printf("ERROR: %s:%d: too many instances, max %d\n", path, lineno, SERVER_MAX_INSTANCES);
+            goto error;
+        }
+
+        /* Address: physical address in the BAR or software model */
+        if ( strncmp(address, "shm:", 4) == 0 ) {
+            inst->backend = MMIO_BACKEND_SHM;
+            strcpy(inst->dev_path, address + 4);
+        }
+        else if ( strncmp(address, "cosim:", 6) == 0 ) {
+            inst->backend = MMIO_BACKEND_COSIM;
+            strcpy(inst->dev_path, address + 6);
+        }
+        else {
+            inst->backend = MMIO_BACKEND_DEVMEM;
+            inst->paddr = strtoull(address, NULL, 0);
+        }
+        inst->length = ( fields >= 3 ) ? strtoul(length, NULL, 0) : SERVER_DEFAULT_LENGTH;
+        if ( inst->length == 0 )
+            inst->length = SERVER_DEFAULT_LENGTH;
+
+        for ( int i = 0; i < server->num_instances; i++ ) {
+            if ( strcmp(server->instances[i].name, inst->name) == 0 ) {
+                printf("ERROR: %s:%d: duplicate instance %s\n", path, lineno, inst->name);
+                goto error;
+            }
+        }
+        server->instances[server->num_instances++] = *inst;
+    }
+
+    fclose(fp);
+    if ( server->num_instances == 0 ) {
+        printf("ERROR: No instances in %s\n", path);
+        return -1;
+    }
+    return 0;
+
+    error:
+        fclose(fp);
+        return -1;
+}
+
+/**************
+ * Setup      *
+ **************/
+
+static int cmp_paddr ( const void * a, const void * b )
+{
+    const server_instance_t * x = *(server_instance_t * const *) a;
+    const server_instance_t * y = *(server_instance_t * const *) b;
+    return ( x->paddr > y->paddr ) - ( x->paddr < y->paddr );
+}
+
+/* One mapping per group of DEVMEM instances whose windows overlap or touch, the instances are views into it.
+ * Instances further apart are mapped separately, not to expose the unrelated physical memory between them. */
+static int server_map ( server_t * server )
+{
+    server_instance_t * sorted [SERVER_MAX_INSTANCES];
+    server_map_t * map = NULL;
+    uint64_t page_mask = sysconf(_SC_PAGE_SIZE) - 1;
+    int num = 0;
+    int first = 0;
+
+    for ( int i = 0; i < server->num_instances; i++ )
+        if ( server->instances[i].backend == MMIO_BACKEND_DEVMEM )
+            sorted[num++] = &server->instances[i];
+    qsort(sorted, num, sizeof(server_instance_t *), cmp_paddr);
+
+    server->num_maps = 0;
+    for ( int i = 0; i <= num; i++ ) {
+        /* Extend the current region, if the window starts in or right after its last page */
+        if ( i < num && map != NULL &&
+             ( sorted[i]->paddr & ~page_mask ) <= ( ( map->paddr + map->length + page_mask ) & ~page_mask ) ) {
+            if ( sorted[i]->paddr + sorted[i]->length > map->paddr + map->length )
+                map->length = sorted[i]->paddr + sorted[i]->length - map->paddr;
+            continue;
+        }
+
+        /* Map the current region and carve the instances out of it */
+        if ( map != NULL ) {
+            if ( mmio_open(&map->mmio, MMIO_BACKEND_DEVMEM, server->mem_path, map->paddr, map->length) != 0 )
+                return -1;
+            server->num_maps++;
+            for ( int j = first; j < i; j++ ) {
+                mmio_view(&sorted[j]->uart.mmio, &map->mmio, sorted[j]->paddr - map->paddr);
+                virtual_uart_probe(&sorted[j]->uart);
+            }
+        }
+
+        /* Start a new region */
+        if ( i < num ) {
+            map = &server->maps[server->num_maps];
+            map->paddr  = sorted[i]->paddr;
+            map->length = sorted[i]->length;
+            first = i;
+        }
+    }
+
+    return 0;
+}
+
+static int open_pty ( server_t * server, server_instance_t * inst )
+{
+    struct termios t;
+
+    inst->pty_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if ( inst->pty_fd == -1 || grantpt(inst->pty_fd) != 0 || unlockpt(inst->pty_fd) != 0 ||
+         ptsname_r(inst->pty_fd, inst->pty_path, sizeof(inst->pty_path)) != 0 ) {
+        printf("ERROR: Cannot create a pseudo-terminal for %s\n", inst->name);
+        return -1;
+    }
+
+    inst->pty_slave_fd = open(inst->pty_path, O_RDWR | O_NOCTTY);
+    if ( inst->pty_slave_fd == -1 ) {
+        printf("ERROR: Cannot open %s\n", inst->pty_path);
+        return -1;
+    }
+
+    /* A raw serial line: no echo, no line editing, no CR/LF translation */
+    tcgetattr(inst->pty_slave_fd, &t);
+    cfmakeraw(&t);
+    tcsetattr(inst->pty_slave_fd, TCSANOW, &t);
+
+    if ( server->link_dir != NULL ) {
+        snprintf(inst->link_path, sizeof(inst->link_path), "%s/%s", server->link_dir, inst->name);
+        unlink(inst->link_path);
+        if ( symlink(inst->pty_path, inst->link_path) != 0 ) {
+            fprintf(stderr, "[WARNING] Cannot create %s\n", inst->link_path);
+            inst->link_path[0] = '\0';
+        }
+    }
+
+    return 0;
+}
+
+int server_open ( server_t * server )
+{
+    server_instance_t * inst;
+
+    server->num_maps = 0;
+    server->stop_fd = eventfd(0, EFD_NONBLOCK);
+    for ( int i = 0; i < server->num_instances; i++ ) {
+        server->instances[i].pty_fd       = -1;
+        server->instances[i].pty_slave_fd = -1;
+        server->instances[i].irq.fd       = -1;
+        server->instances[i].uart.mmio.map = MAP_FAILED;
+    }
+    if ( server->stop_fd == -1 || server_map(server) != 0 )
+        return -1;
+
+    for ( int i = 0; i < server->num_instances; i++ ) {
+        inst = &server->instances[i];
+
+        if ( inst->backend != MMIO_BACKEND_DEVMEM &&
+             virtual_uart_open(&inst->uart, inst->backend, inst->dev_path, 0, 0) != 0 )
+            return -1;
+
+        if ( inst->irq_path[0] != '\0' && irq_source_open(&inst->irq, IRQ_SOURCE_XDMA, inst->irq_path) != 0 )
+            return -1;
+
+        if ( open_pty(server, inst) != 0 )
+            return -1;
+
+        /* Chars may already be there, before the first interrupt */
+        inst->rx_pending = 1;
+        virtual_uart_init(&inst->uart);
+    }
+
+    return 0;
+}
+
+void server_close ( server_t * server )
+{
+    server_instance_t * inst;
+
+    for ( int i = 0; i < server->num_instances; i++ ) {
+        inst = &server->instances[i];
+        if ( inst->link_path[0] != '\0' )
+            unlink(inst->link_path);
+        if ( inst->pty_slave_fd != -1 )
+            close(inst->pty_slave_fd);
+        if ( inst->pty_fd != -1 )
+            close(inst->pty_fd);
+        irq_source_close(&inst->irq);
+        /* No-op for the views into the shared mappings */
+        virtual_uart_close(&inst->uart);
+    }
+
+    for ( int i = 0; i < server->num_maps; i++ )
+        mmio_close(&server->maps[i].mmio);
+
+    if ( server->stop_fd != -1 )
+        close(server->stop_fd);
+}
+
+/**************
+ * Event loop *
+ **************/
+
+/* Move the chars available in both directions, return non-zero on progress */
+static int instance_service ( server_instance_t * inst )
+{
+    int progress = 0;
+    size_t room;
+    ssize_t n;
+
+    /* Terminal to SoC */
+    if ( inst->pty_readable && ( room = buf_room(&inst->to_soc) ) > 0 ) {
+        n = read(inst->pty_fd, inst->to_soc.buf + inst->to_soc.head, room);
+        if ( n > 0 ) {
+            inst->to_soc.head += n;
+            progress = 1;
+        }
+        inst->pty_readable = 0;
+    }
+    if ( buf_len(&inst->to_soc) > 0 ) {
+        n = virtual_uart_try_tx(&inst->uart, inst->to_soc.buf + inst->to_soc.tail, buf_len(&inst->to_soc));
+        inst->to_soc.tail += n;
+        inst->bytes_to_soc += n;
+        progress |= ( n > 0 );
+    }
+
+    /* SoC to terminal */
+    if ( ( inst->irq.fd == -1 || inst->rx_pending ) && ( room = buf_room(&inst->to_pty) ) > 0 ) {
+        n = virtual_uart_try_rx(&inst->uart, inst->to_pty.buf + inst->to_pty.head, room);
+        inst->to_pty.head += n;
+        inst->bytes_to_pty += n;
+        /* Interrupt-driven: the ACK came before this level read, later chars raise a new interrupt */
+        inst->rx_pending = ( n > 0 );
+        progress |= ( n > 0 );
+    }
+    if ( buf_len(&inst->to_pty) > 0 && !inst->pty_blocked ) {
+        n = write(inst->pty_fd, inst->to_pty.buf + inst->to_pty.tail, buf_len(&inst->to_pty));
+        if ( n > 0 )
+            inst->to_pty.tail += n;
+        else if ( n == -1 && errno == EAGAIN )
+            /* Nobody is reading the terminal: hold the chars, and the SoC with them */
+            inst->pty_blocked = 1;
+    }
+
+    return progress;
+}
+
+/* The instance needs the loop to poll it */
+static int instance_needs_poll ( server_instance_t * inst )
+{
+    /* Waiting for room in the RX FIFO, or polling the TX FIFO */
+    return buf_len(&inst->to_soc) > 0 ||
+           ( inst->irq.fd == -1 && buf_room(&inst->to_pty) > 0 );
+}
+
+/* Keep the epoll interest on the terminal in line with the buffers */
+static void instance_update_events ( int epfd, server_instance_t * inst, int index )
+{
+    struct epoll_event ev;
+    uint32_t events = 0;
+
+    if ( buf_room(&inst->to_soc) > 0 && !inst->pty_readable )
+        events |= EPOLLIN;
+    if ( inst->pty_blocked )
+        events |= EPOLLOUT;
+
+    if ( events != inst->events ) {
+        ev.events   = events;
+        ev.data.u64 = TAG_PTY(index);
+        epoll_ctl(epfd, EPOLL_CTL_MOD, inst->pty_fd, &ev);
+        inst->events = events;
+    }
+}
+
+static void * worker_function ( void * arg )
+{
+    server_worker_t * worker = (server_worker_t *) arg;
+    server_t * server = worker->server;
+    struct epoll_event events [WORKER_MAX_EVENTS];
+    struct epoll_event ev;
+    struct timespec timeout;
+    server_instance_t * inst;
+    poll_state_t idle;
+    unsigned int timeout_us;
+    int progress;
+    int need_poll;
+    int stop = 0;
+    int epfd;
+    int n;
+
+    poll_policy_thread_init();
+
+    epfd = epoll_create1(0);
+    if ( epfd == -1 ) {
+        printf("ERROR: Cannot create the event loop of worker %d\n", worker->id);
+        return NULL;
+    }
+
+    ev.events   = EPOLLIN;
+    ev.data.u64 = TAG_STOP;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, server->stop_fd, &ev);
+    for ( int i = worker->id; i < server->num_instances; i += server->num_workers ) {
+        inst = &server->instances[i];
+        ev.events   = EPOLLIN;
+        ev.data.u64 = TAG_PTY(i);
+        epoll_ctl(epfd, EPOLL_CTL_ADD, inst->pty_fd, &ev);
+        inst->events = EPOLLIN;
+        if ( inst->irq.fd != -1 ) {
+            ev.data.u64 = TAG_IRQ(i);
+            epoll_ctl(epfd, EPOLL_CTL_ADD, inst->irq.fd, &ev);
+        }
+    }
+
+    poll_begin(&idle, &server->policy, NULL);
+    while ( !stop ) {
+        /* Service all the instances */
+        progress  = 0;
+        need_poll = 0;
+        for ( int i = worker->id; i < server->num_instances; i += server->num_workers ) {
+            inst = &server->instances[i];
+            progress  |= instance_service(inst);
+            need_poll |= instance_needs_poll(inst);
+            instance_update_events(epfd, inst, i);
+        }
+        worker->passes++;
+
+        /* Any activity restarts the backoff */
+        if ( progress )
+            poll_begin(&idle, &server->policy, NULL);
+        timeout_us = progress ? 0 : poll_next_timeout_us(&idle);
+        timeout.tv_sec  = timeout_us / 1000000;
+        timeout.tv_nsec = ( timeout_us % 1000000 ) * 1000L;
+
+        /* Block on the terminals and event devices, until the next poll if any */
+        n = epoll_pwait2(epfd, events, WORKER_MAX_EVENTS, need_poll ? &timeout : NULL, NULL);
+        for ( int e = 0; e < n; e++ ) {
+            if ( events[e].data.u64 == TAG_STOP ) {
+                stop = 1;
+                continue;
+            }
+            inst = &server->instances[events[e].data.u64 >> 1];
+            if ( events[e].data.u64 & 1 ) {
+                /* Consume the event and ACK the interrupt, the level is read after the ACK */
+                irq_source_wait(&inst->irq, 0);
+                mmio_write32(&inst->uart.mmio, INT_ACK_REG_OFFSET, INT_ACK_VALUE);
+                inst->rx_pending = 1;
+            }
+            else {
+                if ( events[e].events & ( EPOLLIN | EPOLLHUP ) )
+                    inst->pty_readable = 1;
+                if ( events[e].events & EPOLLOUT )
+                    inst->pty_blocked = 0;
+            }
+        }
+    }
+
+    worker->cpu_ns = stats_cpu_ns();
+    close(epfd);
+    return NULL;
+}
+
+int server_start ( server_t * server )
+{
+    if ( server->num_workers > server->num_instances )
+        server->num_workers = server->num_instances;
+    if ( server->num_workers < 1 )
+        server->num_workers = 1;
+
+    server->t_start = stats_now_ns();
+    for ( int w = 0; w < server->num_workers; w++ ) {
+        server->workers[w].server        = server;
+        server->workers[w].id            = w;
+        server->workers[w].passes        = 0;
+        server->workers[w].cpu_ns        = 0;
+        server->workers[w].num_instances = ( server->num_instances - w + server->num_workers - 1 ) / server->num_workers;
+        if ( pthread_create(&server->workers[w].thread, NULL, worker_function, (void *) &server->workers[w]) != 0 ) {
+            printf("ERROR: Cannot start worker %d\n", w);
+            server->num_workers = w;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void server_stop ( server_t * server )
+{
+    uint64_t one = 1;
+
+    /* Never consumed, wakes up all the workers */
+    if ( write(server->stop_fd, &one, sizeof(one)) != sizeof(one) )
+        fprintf(stderr, "[WARNING] Cannot stop the workers\n");
+}
+
+void server_join ( server_t * server )
+{
+    for ( int w = 0; w < server->num_workers; w++ )
+        pthread_join(server->workers[w].thread, NULL);
+}
+
+void server_print_stats ( FILE * fp, server_t * server )
+{
+    double secs = ( stats_now_ns() - server->t_start ) / 1e9;
+    server_instance_t * inst;
+
+    fprintf(fp, "%-16s %-16s %-6s %12s %12s\n", "instance", "pty", "rx", "to SoC [B]", "to host [B]");
+    for ( int i = 0; i < server->num_instances; i++ ) {
+        inst = &server->instances[i];
+        fprintf(fp, "%-16s %-16s %-6s %12lu %12lu\n", inst->name, inst->pty_path,
+                inst->irq.fd != -1 ? "irq" : "poll", inst->bytes_to_soc, inst->bytes_to_pty);
+    }
+
+    fprintf(fp, "%-8s %10s %12s %12s %8s\n", "worker", "instances", "passes", "cpu [ms]", "cpu [%]");
+    for ( int w = 0; w < server->num_workers; w++ ) {
+        fprintf(fp, "%-8d %10d %12lu %12.1f %8.2f\n", w, server->workers[w].num_instances, server->workers[w].passes,
+                server->workers[w].cpu_ns / 1e6, secs > 0 ? 100.0 * server->workers[w].cpu_ns / 1e9 / secs : 0.0);
+    }
+}
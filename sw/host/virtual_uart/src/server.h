@@ -0,0 +1,99 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart multi-instance server header file
+
+#ifndef SERVER_H__
+#define SERVER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include "virtual_uart.h"
+
+/* Default values */
+#define SERVER_MAX_INSTANCES    64
+#define SERVER_MAX_WORKERS      16
+#define SERVER_NAME_LEN         32
+#define SERVER_BUF_SIZE         4096        /* Per-instance, per-direction buffer */
+#define SERVER_DEFAULT_LENGTH   VIRTUAL_UART_DEFAULT_LENGTH
+
+/* Linear buffer, data in [tail, head) */
+typedef struct {
+    char buf [SERVER_BUF_SIZE];
+    size_t head;
+    size_t tail;
+} server_buf_t;
+
+/* Virtual uart instance, exported on a pseudo-terminal */
+typedef struct {
+    /* Configuration */
+    char name [SERVER_NAME_LEN];
+    mmio_backend_t backend;
+    char dev_path [PATH_MAX];       /* SHM, COSIM: shared memory object */
+    uint64_t paddr;                 /* DEVMEM: physical address in the PCIe BAR */
+    size_t length;
+    char irq_path [PATH_MAX];       /* XDMA user interrupt event device, empty to poll */
+
+    /* Runtime */
+    virtual_uart_t uart;
+    irq_source_t irq;
+    int pty_fd;                     /* Master side */
+    int pty_slave_fd;               /* Kept open, so that the master never reads EIO without clients */
+    char pty_path [64];
+    char link_path [PATH_MAX];      /* Symlink to pty_path, empty if none */
+    int pty_readable;               /* Input ready on the terminal */
+    int pty_blocked;                /* Terminal full, wait for it to drain */
+    int rx_pending;                 /* Interrupt-driven: chars may be waiting in the TX FIFO */
+    uint32_t events;                /* Current epoll interest on pty_fd */
+    server_buf_t to_soc;
+    server_buf_t to_pty;
+    uint64_t bytes_to_soc;
+    uint64_t bytes_to_pty;
+} server_instance_t;
+
+/* Shared DEVMEM mapping */
+typedef struct {
+    mmio_dev_t mmio;
+    uint64_t paddr;
+    size_t length;
+} server_map_t;
+
+struct server;
+
+/* Event loop worker */
+typedef struct {
+    struct server * server;
+    int id;
+    pthread_t thread;
+    int num_instances;
+    uint64_t passes;                /* Loop iterations */
+    uint64_t cpu_ns;                /* Thread CPU time, at exit */
+} server_worker_t;
+
+typedef struct server {
+    server_instance_t instances [SERVER_MAX_INSTANCES];
+    int num_instances;
+    server_map_t maps [SERVER_MAX_INSTANCES];
+    int num_maps;
+    server_worker_t workers [SERVER_MAX_WORKERS];
+    int num_workers;
+    const char * mem_path;          /* DEVMEM device, /dev/mem if NULL */
+    const char * link_dir;          /* Directory for the <name> -> pty symlinks, NULL for none */
+    poll_policy_t policy;           /* Idle backoff of the polled instances */
+    int stop_fd;                    /* eventfd, readable when stopping */
+    uint64_t t_start;
+} server_t;
+
+/* Parse the instances list, one per line: <name> <paddr | shm:/object | cosim:/object> [length] [event_dev].
+ * Return 0 on success. */
+int  server_load_config ( server_t * server, const char * path );
+/* Map the CSR blocks, once per BAR region, and create the pseudo-terminals. Return 0 on success. */
+int  server_open        ( server_t * server );
+/* Start/stop/join the event loop workers, instance i is served by worker i % num_workers */
+int  server_start       ( server_t * server );
+void server_stop        ( server_t * server );
+void server_join        ( server_t * server );
+void server_close       ( server_t * server );
+void server_print_stats ( FILE * fp, server_t * server );
+
+#endif
@@ -0,0 +1,121 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - statistics
+//              Fixed-size log2 histograms and throughput counters, cheap enough to be updated once per char.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+/* Width of the histogram bars */
+#define STATS_BAR_WIDTH 40
+
+void stats_hist_init ( stats_hist_t * hist )
+{
+    memset(hist, 0, sizeof(stats_hist_t));
+    hist->min = UINT64_MAX;
+}
+
+void stats_hist_add ( stats_hist_t * hist, uint64_t value_ns )
+{
+    unsigned int bucket = value_ns == 0 ? 0 : 64 - __builtin_clzll(value_ns);
+
+    if ( bucket >= STATS_NUM_BUCKETS )
+        bucket = STATS_NUM_BUCKETS - 1;
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum += value_ns;
+    if ( value_ns < hist->min ) hist->min = value_ns;
+    if ( value_ns > hist->max ) hist->max = value_ns;
+}
+
+/* Print a duration with a readable unit */
+static void format_ns ( char * buf, size_t len, uint64_t ns )
+{
+    if ( ns < 1000UL )
+        snprintf(buf, len, "%lu ns", ns);
+    else if ( ns < 1000000UL )
+        snprintf(buf, len, "%.1f us", ns / 1e3);
+    else if ( ns < 1000000000UL )
+        snprintf(buf, len, "%.1f ms", ns / 1e6);
+    else
+        snprintf(buf, len, "%.1f s", ns / 1e9);
+}
+
+void stats_hist_print ( FILE * fp, const stats_hist_t * hist, const char * name )
+{
+    char lo [16], hi [16], avg [16], min [16], max [16];
+    uint64_t peak = 0;
+
+    fprintf(fp, "%s: ", name);
+    if ( hist->count == 0 ) {
+        fprintf(fp, "no samples\n");
+        return;
+    }
+
+    format_ns(avg, sizeof(avg), hist->sum / hist->count);
+    format_ns(min, sizeof(min), hist->min);
+    format_ns(max, sizeof(max), hist->max);
+    fprintf(fp, "%lu samples, avg %s, min %s, max %s\n", hist->count, avg, min, max);
+
+    for ( unsigned int i = 0; i < STATS_NUM_BUCKETS; i++ )
+        if ( hist->buckets[i] > peak )
+            peak = hist->buckets[i];
+
+    for ( unsigned int i = 0; i < STATS_NUM_BUCKETS; i++ ) {
+        if ( hist->buckets[i] == 0 )
+            continue;
+
+        format_ns(lo, sizeof(lo), i == 0 ? 0 : 1UL << ( i - 1 ));
+        format_ns(hi, sizeof(hi), i == 0 ? 1 : 1UL << i);
+        fprintf(fp, "  [%9s, %9s) %10lu %5.1f%% ", lo, hi,
+                hist->buckets[i], 100.0 * hist->buckets[i] / hist->count);
+        for ( unsigned int j = 0; j < ( hist->buckets[i] * STATS_BAR_WIDTH + peak - 1 ) / peak; j++ )
+            fputc('#', fp);
+        fputc('\n', fp);
+    }
+}
+
+void stats_rate_init ( stats_rate_t * rate )
+{
+    atomic_init(&rate->bytes, 0);
+    atomic_init(&rate->t_first, 0);
+    atomic_init(&rate->t_last, 0);
+}
+
+void stats_rate_add ( stats_rate_t * rate, uint64_t bytes )
+{
+    uint64_t now = stats_now_ns();
+
+    if ( atomic_load_explicit(&rate->t_first, memory_order_relaxed) == 0 )
+        atomic_store_explicit(&rate->t_first, now, memory_order_relaxed);
+    atomic_store_explicit(&rate->t_last, now, memory_order_relaxed);
+    atomic_fetch_add_explicit(&rate->bytes, bytes, memory_order_relaxed);
+}
+
+void stats_rate_print ( FILE * fp, stats_rate_t * rate, const char * name )
+{
+    uint64_t bytes = atomic_load(&rate->bytes);
+    double secs = ( atomic_load(&rate->t_last) - atomic_load(&rate->t_first) ) / 1e9;
+
+    fprintf(fp, "%s: %lu bytes", name, bytes);
+    if ( secs > 0 )
+        fprintf(fp, " in %.3f s, %.1f bytes/s", secs, bytes / secs);
+    fprintf(fp, "\n");
+}
+
+uint64_t stats_now_ns ()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+uint64_t stats_cpu_ns ()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
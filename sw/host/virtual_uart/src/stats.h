@@ -0,0 +1,43 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart statistics (log2 histograms and throughput) header file
+
+#ifndef STATS_H__
+#define STATS_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+/* Bucket 0 holds zeros, bucket i holds [2^(i-1), 2^i) */
+#define STATS_NUM_BUCKETS 64
+
+/* Histogram of nanoseconds */
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets [STATS_NUM_BUCKETS];
+} stats_hist_t;
+
+void stats_hist_init  ( stats_hist_t * hist );
+void stats_hist_add   ( stats_hist_t * hist, uint64_t value_ns );
+void stats_hist_print ( FILE * fp, const stats_hist_t * hist, const char * name );
+
+/* Throughput counter, updated by a single thread */
+typedef struct {
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t t_first;   /* Time of the first update */
+    _Atomic uint64_t t_last;    /* Time of the last update */
+} stats_rate_t;
+
+void stats_rate_init  ( stats_rate_t * rate );
+void stats_rate_add   ( stats_rate_t * rate, uint64_t bytes );
+/* Print bytes and bytes/s over the active time (first to last update) */
+void stats_rate_print ( FILE * fp, stats_rate_t * rate, const char * name );
+
+/* Monotonic time and calling thread CPU time in nanoseconds */
+uint64_t stats_now_ns ();
+uint64_t stats_cpu_ns ();
+
+#endif
@@ -1,122 +1,205 @@
 // Author: Manuel Maddaluno <manuel.maddaluno@unina.it>
 // Description: Virtual Uart host application - threads
-//              This is a two-posix-thread application.
 //              The write_thread writes on the RX uart register (writes to the core)
-//              The read_thread reads on the TX uart register (reads from the host) polling with u_poll_period microseconds
-
-#include <fcntl.h>
+//              The read_thread reads on the TX uart register (reads from the host), polling according to the
+//              polling policy or sleeping on the XDMA user interrupt.
+//              The console threads decouple them from the terminal through SPSC rings: the stdin_thread reads
+//              stdin in large chunks, the output_thread coalesces the received chars in few writev() calls.
+//              On errors, the threads raise SIGTERM to wake up the main thread.
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <pthread.h>
-#include <sys/mman.h>
 #include <stdint.h>
 #include "virtual_uart.h"
 #include "threads.h"
 
+/* Pin the calling thread and/or move it to the realtime scheduler */
+static void set_thread_scheduling ( int cpu, int rt_priority )
+{
+    cpu_set_t cpuset;
+    struct sched_param param;
+
+    if ( cpu >= 0 ) {
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        if ( pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0 )
+            fprintf(stderr, "[WARNING] Cannot pin the read thread to CPU %d\n", cpu);
+    }
+
+    if ( rt_priority > 0 ) {
+        param.sched_priority = rt_priority;
+        if ( pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0 )
+            fprintf(stderr, "[WARNING] Cannot set SCHED_FIFO priority %d on the read thread\n", rt_priority);
+    }
+}
+
 void * write_thread_function(void * arg)
 {
-    int fd;
-    uint64_t paddr;
-    size_t length;
-    off_t pa_offset;                    /* page aligned offset */
-    virtual_uart_t * virtual_uart;      /* virtual address from mmap */
+    virtual_uart_t virtual_uart;        /* uart behind the MMIO backend */
 
-    char c;                             /* Char to send when write on the console */
+    struct iovec iov [2];               /* Chars to send, from the stdin ring */
+    int iovcnt;
+    size_t n;
 
     /* Get the arguments */
     write_thread_arg_t * thread_arg = (write_thread_arg_t *) arg;
-    paddr  = thread_arg->paddr;
-    length = thread_arg->length;
-
-    /* Open the /dev/mem file */
-    fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if (fd == -1) {
-	    printf("ERROR: Cannot open device file\n");
-	    goto end;
-    }
 
-    /* Compute the page aligned offset  */
-    pa_offset = paddr & ~(sysconf(_SC_PAGE_SIZE) - 1);
-
-    /* Get the virtual address */
-    virtual_uart = (virtual_uart_t *) mmap(NULL, length + paddr - pa_offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, pa_offset);
-    if (virtual_uart == MAP_FAILED) {
-        printf("ERROR: Map failed\n");
-        goto end;
+    /* Map the uart registers */
+    if ( virtual_uart_open(&virtual_uart, thread_arg->backend, thread_arg->dev_path, thread_arg->paddr, thread_arg->length) != 0 ) {
+        kill(getpid(), SIGTERM);
+        return NULL;
     }
 
-    close(fd);
-
+    poll_policy_thread_init();
 
     while(1) {
-        /* Get the char from the console - blocking function */
-        c = getchar();
-        /* Transmit the char - blocking function */
-        virtual_uart_tx_char( virtual_uart, c );
+        /* Get the chars from the console - blocking */
+        n = ring_readable(thread_arg->ring, iov, &iovcnt);
+        if ( n == 0 ) {
+            if ( ring_drained(thread_arg->ring) )
+                break;
+            ring_wait_readable(thread_arg->ring, NULL);
+            continue;
+        }
+
+        /* Transmit the chars - blocking function */
+        for ( int i = 0; i < iovcnt; i++ )
+            virtual_uart_tx( &virtual_uart, (const char *) iov[i].iov_base, iov[i].iov_len, thread_arg->policy, thread_arg->stats );
+        ring_consume(thread_arg->ring, n);
+        stats_rate_add(thread_arg->rate, n);
     }
 
-    end:
-        if(virtual_uart)
-            munmap((void *)virtual_uart, length + paddr - pa_offset);
-        if (fd)
-            close(fd);
-        return NULL;
+    /* End of stdin, keep the SoC output running */
+    virtual_uart_close(&virtual_uart);
+    return NULL;
 }
 
 
 void * read_thread_function( void * arg )
 {
-    int fd;
-    uint64_t paddr;
-    size_t length;
-    off_t pa_offset;                       /* page aligned offset */
-    virtual_uart_t * virtual_uart;         /* virtual address from mmap */
-    unsigned int u_poll_period;
+    virtual_uart_t virtual_uart;           /* uart behind the MMIO backend */
+    irq_source_t irq;                      /* Interrupt source for the event-driven mode */
 
-    char c;                                /* Char to send when write on the console */
+    struct iovec iov [2];                  /* Room for the chars to print on the console */
+    int iovcnt;
+    size_t n;
 
     /* Get the arguments */
     read_thread_arg_t * thread_arg = (read_thread_arg_t *) arg;
-    paddr         = thread_arg->paddr;
-    length        = thread_arg->length;
-    u_poll_period = thread_arg->u_poll_period;
-
-    /* Open the /dev/mem file */
-    fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if (fd == -1) {
-	    printf("ERROR: Cannot open device file\n");
-	    goto end;
-    }
+    irq.fd = -1;
 
-    /* Compute the page aligned offset  */
-    pa_offset = paddr & ~(sysconf(_SC_PAGE_SIZE) - 1);
+    set_thread_scheduling(thread_arg->cpu, thread_arg->rt_priority);
+    poll_policy_thread_init();
 
-    /* Get the virtual address */
-    virtual_uart = (virtual_uart_t *) mmap(NULL, length + paddr - pa_offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, pa_offset);
-    if (virtual_uart == MAP_FAILED) {
-        printf("ERROR: Map failed\n");
-        goto end;
+    /* Map the uart registers */
+    if ( virtual_uart_open(&virtual_uart, thread_arg->backend, thread_arg->dev_path, thread_arg->paddr, thread_arg->length) != 0 ) {
+        kill(getpid(), SIGTERM);
+        return NULL;
     }
 
+    /* Open the interrupt source, if any */
+    if ( thread_arg->irq_path && irq_source_open(&irq, IRQ_SOURCE_XDMA, thread_arg->irq_path) != 0 )
+        goto end;
+
     /* Virtual uart init - simply ack the SoC we are here waiting for it */
-    virtual_uart_init (virtual_uart);
+    virtual_uart_init (&virtual_uart);
 
     while (1) {
-        /* Receive the char - blocking function */
-        c = virtual_uart_rx_char(virtual_uart, u_poll_period);
-        /* Print the char on the console */
-        putchar(c);
-
-        /* ACK the interrupt */
-        // virtual_uart->int_ack_reg = 0x000000FF;
+        /* Wait for room in the console ring */
+        while ( ring_writable(thread_arg->ring, iov, &iovcnt) == 0 )
+            ring_wait_writable(thread_arg->ring);
+
+        /* Receive the chars straight into the ring - blocking function */
+        if ( irq.fd != -1 )
+            n = virtual_uart_rx_irq(&virtual_uart, (char *) iov[0].iov_base, iov[0].iov_len, &irq, thread_arg->stats);
+        else
+            n = virtual_uart_rx(&virtual_uart, (char *) iov[0].iov_base, iov[0].iov_len, thread_arg->policy, thread_arg->stats);
+        ring_produce(thread_arg->ring, n);
+        stats_rate_add(thread_arg->rate, n);
     }
 
     end:
-        if(virtual_uart)
-            munmap((void *)virtual_uart, length + paddr - pa_offset);
-        if (fd)
-            close(fd);
+        virtual_uart_close(&virtual_uart);
+        irq_source_close(&irq);
+        kill(getpid(), SIGTERM);
         return NULL;
 }
+
+
+void * stdin_thread_function( void * arg )
+{
+    console_thread_arg_t * thread_arg = (console_thread_arg_t *) arg;
+    ring_t * ring = thread_arg->ring;
+    struct iovec iov [2];
+    int iovcnt;
+    ssize_t n;
+
+    while (1) {
+        /* Wait for free space */
+        if ( ring_writable(ring, iov, &iovcnt) == 0 ) {
+            ring_wait_writable(ring);
+            continue;
+        }
+
+        /* Read whatever is available, straight into the ring */
+        n = readv(STDIN_FILENO, iov, iovcnt);
+        if ( n <= 0 )
+            break;
+        ring_produce(ring, n);
+    }
+
+    /* End of stdin */
+    ring_close(ring);
+    return NULL;
+}
+
+
+void * output_thread_function( void * arg )
+{
+    console_thread_arg_t * thread_arg = (console_thread_arg_t *) arg;
+    ring_t * ring = thread_arg->ring;
+    struct timespec deadline;
+    struct iovec iov [2];
+    int iovcnt;
+    int backlog = 0;
+    ssize_t n;
+
+    deadline.tv_sec  = thread_arg->flush_us / 1000000;
+    deadline.tv_nsec = ( thread_arg->flush_us % 1000000 ) * 1000L;
+
+    poll_policy_thread_init();
+
+    while (1) {
+        /* Wait for the first char */
+        if ( ring_readable(ring, iov, &iovcnt) == 0 ) {
+            backlog = 0;
+            ring_wait_readable(ring, NULL);
+            continue;
+        }
+
+        /* More chars came in during the last write: a burst, let the following ones pile up,
+         * at most for the flush deadline. A char after an idle ring (interactive echo) goes out at once. */
+        if ( backlog && thread_arg->flush_us != 0 ) {
+            nanosleep(&deadline, NULL);
+            ring_readable(ring, iov, &iovcnt);
+        }
+
+        /* Write them all at once, straight from the ring */
+        n = writev(STDOUT_FILENO, iov, iovcnt);
+        if ( n < 0 ) {
+            fprintf(stderr, "ERROR: Cannot write to stdout\n");
+            kill(getpid(), SIGTERM);
+            return NULL;
+        }
+        ring_consume(ring, n);
+        backlog = 1;
+    }
+
+    return NULL;
+}
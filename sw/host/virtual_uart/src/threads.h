@@ -4,21 +4,49 @@
 #ifndef THREADS_H__
 #define THREADS_H__
 
+#include "poll_policy.h"
+#include "ring.h"
+#include "mmio.h"
+
+/* Default values */
+#define OUTPUT_DEFAULT_FLUSH_US 50    /* Max time a received char waits in the output ring */
+
 /* Threads arguments */
 typedef struct {
+    mmio_backend_t backend;       /* /dev/mem or software model  */
+    const char * dev_path;        /* Device file or shm object   */
     uint64_t paddr;               /* PCIe BAR of the uart device */
     size_t length;                /* The length of the mapping   */
+    const poll_policy_t * policy; /* Polling policy on RX full   */
+    poll_stats_t * stats;         /* TX statistics, can be NULL  */
+    ring_t * ring;                /* Chars from stdin            */
+    stats_rate_t * rate;          /* TX throughput               */
 } write_thread_arg_t;
 
 typedef struct {
+    mmio_backend_t backend;       /* /dev/mem or software model  */
+    const char * dev_path;        /* Device file or shm object   */
     uint64_t paddr;               /* PCIe BAR of the uart device */
     size_t length;                /* The length of the mapping   */
-    unsigned int u_poll_period;   /* Poll period in microseconds */
+    const poll_policy_t * policy; /* Polling policy on TX full   */
+    poll_stats_t * stats;         /* RX statistics, can be NULL  */
+    ring_t * ring;                /* Chars to stdout             */
+    stats_rate_t * rate;          /* RX throughput               */
+    const char * irq_path;        /* XDMA user interrupt event device, poll if NULL */
+    int cpu;                      /* CPU to pin the thread to, -1 for none */
+    int rt_priority;              /* SCHED_FIFO priority, 0 for the default scheduler */
 } read_thread_arg_t;
 
+typedef struct {
+    ring_t * ring;                /* Ring to fill (stdin) or to drain (stdout) */
+    unsigned int flush_us;        /* Output only: flush deadline during bursts, 0 to flush as soon as possible */
+} console_thread_arg_t;
+
 /* Threads functions */
 void * write_thread_function(void * arg);
 void * read_thread_function(void * arg);
+void * stdin_thread_function(void * arg);
+void * output_thread_function(void * arg);
 
 
 #endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include <termios.h>
 #include "utils.h"
+#include "virtual_uart.h"
 
 /* Disable stdin buffering */
 void disable_buffering ()
@@ -30,9 +31,27 @@ void enable_buffering ()
 void help (char * ex_name)
 {
     printf("------------------------------ VIRTUAL UART ------------------------------------- \n");
-    printf("Usage: %s <uart_paddr> [uart_length] [u_poll_period]\n", ex_name);
+    printf("Usage: %s [options] <uart_paddr> [uart_length] [u_poll_period]\n", ex_name);
     printf("    uart_paddr    : UART physical address in hex 0x... (PCIe BAR)\n");
-    printf("    uart_length   : UART total registers length in byte (decimal), default 20\n");
-    printf("    u_poll_period : Poll period in microseconds, default 10\n");
+    printf("    uart_length   : UART total registers length in byte (decimal), default %d\n", VIRTUAL_UART_DEFAULT_LENGTH);
+    printf("    u_poll_period : Poll period (sleep) or backoff cap (adaptive) in microseconds, default 10 (sleep) or 1000 (adaptive)\n");
+    printf("Options:\n");
+    printf("    -i event_dev  : Sleep on the XDMA user interrupt instead of polling (e.g. /dev/xdma0_events_0)\n");
+    printf("    -p policy     : Polling policy: sleep, spin or adaptive (spin, then yield, then exponential backoff), default adaptive\n");
+    printf("    -a cpu        : Pin the read thread to a CPU\n");
+    printf("    -r priority   : Run the read thread with SCHED_FIFO priority (1-99), beware of spin with realtime priority\n");
+    printf("    -f flush_us   : Max time in microseconds a char of a burst waits to be coalesced with the following ones, default 50, 0 to disable\n");
+    printf("    -s shm_name   : Use the software model of the uart (bin/vu_soc_model) instead of the PCIe BAR, uart_paddr is ignored\n");
+    printf("    -c shm_name   : Co-simulate with the Verilator testbench of the RTL (hw/units/sim/virtual_uart.prj), uart_paddr is ignored\n");
+    printf("    -n            : Do not collect/print the latency and CPU time histograms on exit\n");
+    printf("Headless mode, for automated runs (any of the following):\n");
+    printf("    -I input      : Send a file (- for stdin) at full link rate instead of the terminal input\n");
+    printf("    -E script     : Run an expect script (send, sendline, sendfile, expect, timeout, sleep), exclusive with -I\n");
+    printf("    -o log        : Capture the SoC output in a memory-mapped log, each line timestamped, default stdout\n");
+    printf("    -P regex      : Pass on the first output line matching, default pass at the end of the script (-E)\n");
+    printf("    -F regex      : Fail on the first output line matching\n");
+    printf("    -Q            : Pass once the input is sent and the output is quiet for 100 ms, without -P\n");
+    printf("    -T timeout_s  : Overall timeout in seconds\n");
+    printf("    Exit status: 0 pass, 1 fail, 2 timeout, 3 error or interrupted\n");
     printf("--------------------------------------------------------------------------------- \n");
 }
\ No newline at end of file
@@ -1,37 +1,217 @@
 // Author: Manuel Maddaluno <manuel.maddaluno@unina.it>
 // Description: Virtual Uart host application - virtual uart driver functions
+//              With the FIFO peripheral, each side reads the FIFO level once and then moves up to
+//              VU_BURST_LEN chars per access through the burst registers. Each access is a PCIe
+//              round trip, so this is where the throughput comes from. The single-register
+//              peripheral (FIFO depth reads 0) falls back to a status read and a data access per char.
 
 #include <stdint.h>
 #include <unistd.h>
 #include "virtual_uart.h"
 
+/* Largest sane FIFO depth, the level fields are 16 bits wide */
+#define FIFO_MAX_DEPTH  0x8000
+
+int virtual_uart_open (virtual_uart_t * virtual_uart, mmio_backend_t backend, const char * path, uint64_t paddr, size_t length)
+{
+    if ( mmio_open(&virtual_uart->mmio, backend, path, paddr, length) != 0 )
+        return -1;
+
+    virtual_uart_probe(virtual_uart);
+    return 0;
+}
+
+void virtual_uart_probe (virtual_uart_t * virtual_uart)
+{
+    uint32_t depth;
+
+    /* Older bitstreams read anything out of their four registers, only trust a power of 2 */
+    depth = mmio_read32(&virtual_uart->mmio, FIFO_DEPTH_REG_OFFSET);
+    if ( depth == 0 || depth > FIFO_MAX_DEPTH || ( depth & ( depth - 1 ) ) != 0 )
+        depth = 0;
+    virtual_uart->fifo_depth = depth;
+}
+
+void virtual_uart_close (virtual_uart_t * virtual_uart)
+{
+    mmio_close(&virtual_uart->mmio);
+}
+
+/* Chars in the TX FIFO (core to host), 0 or 1 on the single-register peripheral */
+static uint32_t tx_level (virtual_uart_t * virtual_uart)
+{
+    if ( virtual_uart->fifo_depth == 0 )
+        return ( mmio_read32(&virtual_uart->mmio, STS_REG_OFFSET) & TX_FULL_BIT_MASK ) ? 1 : 0;
+    return mmio_read32(&virtual_uart->mmio, FIFO_LEVEL_REG_OFFSET) >> 16;
+}
+
+/* Free slots in the RX FIFO (host to core), 0 or 1 on the single-register peripheral */
+static uint32_t rx_space (virtual_uart_t * virtual_uart)
+{
+    if ( virtual_uart->fifo_depth == 0 )
+        return ( mmio_read32(&virtual_uart->mmio, STS_REG_OFFSET) & RX_FULL_BIT_MASK ) ? 0 : 1;
+    return virtual_uart->fifo_depth - ( mmio_read32(&virtual_uart->mmio, FIFO_LEVEL_REG_OFFSET) & 0xFFFF );
+}
+
+/* Pop n chars, known to be in the TX FIFO */
+static void drain (virtual_uart_t * virtual_uart, char * buf, size_t n)
+{
+    uint32_t word;
+    size_t k;
+
+    if ( virtual_uart->fifo_depth == 0 ) {
+        buf[0] = (char) mmio_read32(&virtual_uart->mmio, TX_REG_OFFSET);
+        return;
+    }
+
+    for ( size_t i = 0; i < n; i += k ) {
+        k = n - i < VU_BURST_LEN ? n - i : VU_BURST_LEN;
+        word = mmio_read32(&virtual_uart->mmio, TX_BURST_R_OFFSET(k));
+        for ( size_t j = 0; j < k; j++ )
+            buf[i + j] = (char) ( word >> ( 8 * j ) );
+    }
+}
+
+/* Push n chars, known to fit in the RX FIFO */
+static void fill (virtual_uart_t * virtual_uart, const char * buf, size_t n)
+{
+    uint32_t word;
+    size_t k;
+
+    if ( virtual_uart->fifo_depth == 0 ) {
+        mmio_write32(&virtual_uart->mmio, RX_REG_OFFSET, (uint32_t) buf[0]);
+        return;
+    }
+
+    /* The burst register takes the chars from lane 0 on: 4, 2 or 1 lanes per store */
+    for ( size_t i = 0; i < n; i += k ) {
+        k = n - i >= 4 ? 4 : n - i >= 2 ? 2 : 1;
+        word = 0;
+        for ( size_t j = 0; j < k; j++ )
+            word |= (uint32_t) (uint8_t) buf[i + j] << ( 8 * j );
+        mmio_write_lanes(&virtual_uart->mmio, RX_BURST_W_OFFSET, word, k);
+    }
+}
+
+/* Push as many of the len chars as fit, with a single level read */
+size_t virtual_uart_try_tx (virtual_uart_t * virtual_uart, const char * buf, size_t len)
+{
+    size_t space = rx_space(virtual_uart);
+
+    if ( space > len )
+        space = len;
+    if ( space > 0 )
+        fill(virtual_uart, buf, space);
+    return space;
+}
+
+/* Pop up to max chars, with a single level read */
+size_t virtual_uart_try_rx (virtual_uart_t * virtual_uart, char * buf, size_t max)
+{
+    size_t n = tx_level(virtual_uart);
+
+    if ( n > max )
+        n = max;
+    if ( n > 0 )
+        drain(virtual_uart, buf, n);
+    return n;
+}
+
+/* Transmit len chars through the virtual uart peripheral */
+void virtual_uart_tx (virtual_uart_t * virtual_uart, const char * buf, size_t len, const poll_policy_t * policy, poll_stats_t * stats)
+{
+    poll_state_t state;
+    size_t n;
+
+    while ( len > 0 ) {
+        /* Wait for room in the RX FIFO - the core popped the previous chars */
+        poll_begin(&state, policy, stats);
+        while ( ( n = virtual_uart_try_tx(virtual_uart, buf, len) ) == 0 )
+            poll_wait(&state);
+        poll_end(&state);
+
+        buf += n;
+        len -= n;
+    }
+}
+
+/* Receive up to max chars from the virtual uart peripheral */
+size_t virtual_uart_rx (virtual_uart_t * virtual_uart, char * buf, size_t max, const poll_policy_t * policy, poll_stats_t * stats)
+{
+    poll_state_t state;
+    size_t n;
+
+    /* Poll on the TX FIFO level - waiting for the chars */
+    poll_begin(&state, policy, stats);
+    while ( ( n = virtual_uart_try_rx(virtual_uart, buf, max) ) == 0 )
+        poll_wait(&state);
+    poll_end(&state);
+
+    return n;
+}
+
+/* Receive up to max chars from the virtual uart peripheral - sleep on the interrupt instead of polling */
+size_t virtual_uart_rx_irq (virtual_uart_t * virtual_uart, char * buf, size_t max, irq_source_t * irq, poll_stats_t * stats)
+{
+    uint64_t cpu_start = 0;
+    size_t n;
+
+    if ( stats )
+        cpu_start = stats_cpu_ns();
+
+    /* The interrupt rises on each push into the TX FIFO and stays high until the ACK.
+     * Check the level before sleeping, and again after each ACK, so that chars pushed
+     * between a wake-up and its ACK are never missed. */
+    while ( ( n = tx_level(virtual_uart) ) == 0 ) {
+        if ( irq_source_wait(irq, -1) < 0 )
+            break;
+        /* ACK the interrupt */
+        mmio_write32(&virtual_uart->mmio, INT_ACK_REG_OFFSET, INT_ACK_VALUE);
+    }
+
+    /* Pop the chars - on errors, keep the single-char behaviour of a blind read */
+    if ( n == 0 )
+        n = 1;
+    if ( n > max )
+        n = max;
+    drain(virtual_uart, buf, n);
+
+    /* The detection latency is not observable from here, only the CPU time */
+    if ( stats )
+        stats_hist_add(&stats->cpu, stats_cpu_ns() - cpu_start);
+
+    return virtual_uart->fifo_depth == 0 ? 1 : n;
+}
 
 /* Transmit a char through the virtual uart peripheral */
-void virtual_uart_tx_char (virtual_uart_t * virtual_uart, char c)
+void virtual_uart_tx_char (virtual_uart_t * virtual_uart, char c, const poll_policy_t * policy, poll_stats_t * stats)
 {
-    /* Wait for the RX full bit is 0 - the core read the previous char */
-    while ( ( (virtual_uart->sts_reg) & RX_FULL_BIT_MASK) >> 1 == 1);
-    virtual_uart->rx_reg = (uint32_t) c;
-    return;
+    virtual_uart_tx(virtual_uart, &c, 1, policy, stats);
 }
 
 /* Receive a char from the virtual uart peripheral */
-char virtual_uart_rx_char (virtual_uart_t * virtual_uart, unsigned int u_poll_period)
+char virtual_uart_rx_char (virtual_uart_t * virtual_uart, const poll_policy_t * policy, poll_stats_t * stats)
 {
-    /* Poll on the status flag TX full - waiting for the char */
-    uint8_t status_tx_full = (((uint8_t)virtual_uart->sts_reg & TX_FULL_BIT_MASK) >> 3);
-    while( !status_tx_full ) {
-        usleep(u_poll_period);
-        status_tx_full = (((uint8_t)virtual_uart->sts_reg & TX_FULL_BIT_MASK) >> 3);
-    }
+    char c;
+
+    virtual_uart_rx(virtual_uart, &c, 1, policy, stats);
+    return c;
+}
+
+/* Receive a char from the virtual uart peripheral - sleep on the interrupt instead of polling */
+char virtual_uart_rx_char_irq (virtual_uart_t * virtual_uart, irq_source_t * irq, poll_stats_t * stats)
+{
+    char c;
 
-    /* Read the data in the TX register - get the char */
-    return ((char) virtual_uart->tx_reg);
+    virtual_uart_rx_irq(virtual_uart, &c, 1, irq, stats);
+    return c;
 }
 
-/* Read to start the communication - the SoC waits for the first read to starts sending chars */
+/* Read to start the communication - the SoC waits for the first read to starts sending chars.
+ * The FIFO peripheral buffers the chars until the host shows up, a read would drop one. */
 void virtual_uart_init (virtual_uart_t * virtual_uart)
 {
-    char c = (char) virtual_uart->tx_reg;
+    if ( virtual_uart->fifo_depth == 0 )
+        mmio_read32(&virtual_uart->mmio, TX_REG_OFFSET);
     return;
-}
\ No newline at end of file
+}
@@ -4,22 +4,46 @@
 #ifndef VIRTUAL_UART_H__
 #define VIRTUAL_UART_H__
 
-/* Masks */
-#define RX_FULL_BIT_MASK 0x00000002
-#define TX_FULL_BIT_MASK 0b00001000
-
-/* Virtual Uart struct */
-typedef volatile struct {
-    uint32_t rx_reg;            /* RX register - host to core   */
-    uint32_t tx_reg;            /* TX register - core to host   */
-    uint32_t sts_reg;           /* Status register              */
-    uint32_t ctrl_reg;          /* Control register             */
-    uint32_t int_ack_reg;       /* Interrupt ack - host to XDMA */
+#include <stddef.h>
+#include "irq.h"
+#include "poll_policy.h"
+#include "mmio.h"
+
+/* Register offsets and masks are shared with the software model, see vu_model.h */
+
+/* Any write to the interrupt ack register lowers the interrupt to the XDMA */
+#define INT_ACK_VALUE    0x000000FF
+
+/* Mapping length of the CSR block */
+#define VIRTUAL_UART_DEFAULT_LENGTH  0x80
+
+/* Virtual Uart handle - the CSR block behind an MMIO backend */
+typedef struct {
+    mmio_dev_t mmio;
+    uint32_t fifo_depth;        /* 0 for the single-register peripheral, one char per access */
 } virtual_uart_t;
 
+/* Map the CSR block (see mmio_open()) and probe the FIFOs, return 0 on success */
+int  virtual_uart_open  (virtual_uart_t * virtual_uart, mmio_backend_t backend, const char * path, uint64_t paddr, size_t length);
+void virtual_uart_close (virtual_uart_t * virtual_uart);
+/* Probe the FIFOs of an already mapped CSR block */
+void virtual_uart_probe (virtual_uart_t * virtual_uart);
+
+/* Non-blocking multi-char tx/rx: a single level read, return the number of chars moved */
+size_t virtual_uart_try_tx (virtual_uart_t * virtual_uart, const char * buf, size_t len);
+size_t virtual_uart_try_rx (virtual_uart_t * virtual_uart, char * buf, size_t max);
+
+/* Blocking multi-char tx/rx, stats can be NULL.
+ * tx returns when all the len chars are in the RX FIFO, rx returns at least one char and at most max.
+ * Each wait is one sample in the stats, covering as many chars as the FIFOs hold. */
+void   virtual_uart_tx (virtual_uart_t * virtual_uart, const char * buf, size_t len, const poll_policy_t * policy, poll_stats_t * stats);
+size_t virtual_uart_rx (virtual_uart_t * virtual_uart, char * buf, size_t max, const poll_policy_t * policy, poll_stats_t * stats);
+size_t virtual_uart_rx_irq (virtual_uart_t * virtual_uart, char * buf, size_t max, irq_source_t * irq, poll_stats_t * stats);
 
-void virtual_uart_tx_char (virtual_uart_t * virtual_uart, char c);
-char virtual_uart_rx_char (virtual_uart_t * virtual_uart, unsigned int u_poll_period);
+/* Blocking single-char tx/rx, stats can be NULL */
+void virtual_uart_tx_char (virtual_uart_t * virtual_uart, char c, const poll_policy_t * policy, poll_stats_t * stats);
+char virtual_uart_rx_char (virtual_uart_t * virtual_uart, const poll_policy_t * policy, poll_stats_t * stats);
+char virtual_uart_rx_char_irq (virtual_uart_t * virtual_uart, irq_source_t * irq, poll_stats_t * stats);
 void virtual_uart_init (virtual_uart_t * virtual_uart);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,182 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart host application - software model of the virtual uart CSR block
+//              It mirrors hw/xilinx/rtl/virtual_uart.sv:
+//              - the RX (host to core) and TX (core to host) registers are FIFOs
+//              - writes to RX/TX push, reads from RX/TX pop, the status register reflects the FIFO levels
+//              - burst registers push the written byte lanes or pop up to VU_BURST_LEN chars at once
+//              - a push into TX raises the interrupt to the XDMA, a write to the ACK register lowers it
+//              The state can live in memory shared between processes: each FIFO has a single
+//              producer and a single consumer, and the data is published before the indexes.
+
+#include <stdint.h>
+#include <string.h>
+#include "vu_model.h"
+
+/* FIFO primitives */
+static uint32_t fifo_level ( vu_fifo_t * fifo )
+{
+    return __atomic_load_n(&fifo->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&fifo->tail, __ATOMIC_ACQUIRE);
+}
+
+/* Push the first n chars of value, drop the ones exceeding the depth */
+static void fifo_push ( vu_fifo_t * fifo, uint32_t value, unsigned int n )
+{
+    uint32_t head = __atomic_load_n(&fifo->head, __ATOMIC_RELAXED);
+    uint32_t space = VU_MODEL_FIFO_DEPTH - fifo_level(fifo);
+
+    if ( n > space )
+        n = space;
+    for ( unsigned int i = 0; i < n; i++ )
+        fifo->buf[( head + i ) % VU_MODEL_FIFO_DEPTH] = ( value >> ( 8 * i ) ) & 0xFF;
+    __atomic_store_n(&fifo->head, head + n, __ATOMIC_RELEASE);
+}
+
+/* Pop up to n chars, packed from byte 0 */
+static uint32_t fifo_pop ( vu_fifo_t * fifo, unsigned int n )
+{
+    uint32_t tail = __atomic_load_n(&fifo->tail, __ATOMIC_RELAXED);
+    uint32_t level = fifo_level(fifo);
+    uint32_t value = 0;
+
+    if ( n > level )
+        n = level;
+    for ( unsigned int i = 0; i < n; i++ )
+        value |= (uint32_t) fifo->buf[( tail + i ) % VU_MODEL_FIFO_DEPTH] << ( 8 * i );
+    __atomic_store_n(&fifo->tail, tail + n, __ATOMIC_RELEASE);
+
+    return value;
+}
+
+static void fifo_reset ( vu_fifo_t * fifo )
+{
+    __atomic_store_n(&fifo->tail, __atomic_load_n(&fifo->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+
+void vu_model_reset ( vu_model_t * model )
+{
+    memset(model, 0, sizeof(vu_model_t));
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+uint32_t vu_model_read ( vu_model_t * model, uint32_t offset )
+{
+    uint32_t rx_level = fifo_level(&model->rx);
+    uint32_t tx_level = fifo_level(&model->tx);
+    uint32_t value = 0;
+
+    if ( offset >= RX_BURST_R_OFFSET(1) && offset <= RX_BURST_R_OFFSET(VU_BURST_LEN) )
+        return fifo_pop(&model->rx, ( ( offset - RX_BURST_R_OFFSET(1) ) >> 2 ) + 1);
+    if ( offset >= TX_BURST_R_OFFSET(1) && offset <= TX_BURST_R_OFFSET(VU_BURST_LEN) )
+        return fifo_pop(&model->tx, ( ( offset - TX_BURST_R_OFFSET(1) ) >> 2 ) + 1);
+
+    switch ( offset ) {
+        case RX_REG_OFFSET:
+            return fifo_pop(&model->rx, 1);
+        case TX_REG_OFFSET:
+            return fifo_pop(&model->tx, 1);
+        case STS_REG_OFFSET:
+            if ( rx_level != 0 )                    value |= RX_VALID_BIT_MASK;
+            if ( rx_level == VU_MODEL_FIFO_DEPTH )  value |= RX_FULL_BIT_MASK;
+            if ( tx_level == 0 )                    value |= TX_EMPTY_BIT_MASK;
+            if ( tx_level == VU_MODEL_FIFO_DEPTH )  value |= TX_FULL_BIT_MASK;
+            return value | ( __atomic_load_n(&model->ctrl, __ATOMIC_RELAXED) & INT_BIT_MASK );
+        case CTRL_REG_OFFSET:
+            return __atomic_load_n(&model->ctrl, __ATOMIC_RELAXED);
+        case FIFO_LEVEL_REG_OFFSET:
+            return rx_level | ( tx_level << 16 );
+        case FIFO_DEPTH_REG_OFFSET:
+            return VU_MODEL_FIFO_DEPTH;
+        default:
+            return 0;
+    }
+}
+
+void vu_model_write_lanes ( vu_model_t * model, uint32_t offset, uint32_t value, unsigned int nbytes )
+{
+    switch ( offset ) {
+        case RX_REG_OFFSET:
+            fifo_push(&model->rx, value, 1);
+            break;
+        case TX_REG_OFFSET:
+            fifo_push(&model->tx, value, 1);
+            __atomic_store_n(&model->int_xdma, 1, __ATOMIC_RELEASE);
+            break;
+        case RX_BURST_W_OFFSET:
+            fifo_push(&model->rx, value, nbytes);
+            break;
+        case TX_BURST_W_OFFSET:
+            fifo_push(&model->tx, value, nbytes);
+            __atomic_store_n(&model->int_xdma, 1, __ATOMIC_RELEASE);
+            break;
+        case CTRL_REG_OFFSET:
+            if ( value & CTRL_RST_RX_BIT_MASK )
+                fifo_reset(&model->rx);
+            if ( value & CTRL_RST_TX_BIT_MASK )
+                fifo_reset(&model->tx);
+            __atomic_store_n(&model->ctrl, value, __ATOMIC_RELAXED);
+            break;
+        case INT_ACK_REG_OFFSET:
+            __atomic_store_n(&model->int_xdma, 0, __ATOMIC_RELEASE);
+            break;
+        default:
+            /* Read-only */
+            break;
+    }
+}
+
+void vu_model_write ( vu_model_t * model, uint32_t offset, uint32_t value )
+{
+    vu_model_write_lanes(model, offset, value, 4);
+}
+
+int vu_model_soc_getc ( vu_model_t * model, char * c )
+{
+    if ( ( vu_model_read(model, STS_REG_OFFSET) & RX_VALID_BIT_MASK ) == 0 )
+        return -1;
+
+    *c = (char) vu_model_read(model, RX_REG_OFFSET);
+    return 0;
+}
+
+int vu_model_soc_putc ( vu_model_t * model, char c )
+{
+    if ( vu_model_read(model, STS_REG_OFFSET) & TX_FULL_BIT_MASK )
+        return -1;
+
+    vu_model_write(model, TX_REG_OFFSET, (uint8_t) c);
+    return 0;
+}
+
+unsigned int vu_model_soc_read ( vu_model_t * model, char * buf, unsigned int max )
+{
+    unsigned int level = vu_model_read(model, FIFO_LEVEL_REG_OFFSET) & 0xFFFF;
+    unsigned int n = level < max ? level : max;
+    uint32_t word;
+
+    /* One level read, then up to VU_BURST_LEN chars per access */
+    for ( unsigned int i = 0; i < n; i += VU_BURST_LEN ) {
+        unsigned int k = n - i < VU_BURST_LEN ? n - i : VU_BURST_LEN;
+        word = vu_model_read(model, RX_BURST_R_OFFSET(k));
+        for ( unsigned int j = 0; j < k; j++ )
+            buf[i + j] = (char) ( word >> ( 8 * j ) );
+    }
+
+    return n;
+}
+
+unsigned int vu_model_soc_write ( vu_model_t * model, const char * buf, unsigned int len )
+{
+    unsigned int space = VU_MODEL_FIFO_DEPTH - ( vu_model_read(model, FIFO_LEVEL_REG_OFFSET) >> 16 );
+    unsigned int n = space < len ? space : len;
+    uint32_t word;
+
+    for ( unsigned int i = 0; i < n; i += VU_BURST_LEN ) {
+        unsigned int k = n - i < VU_BURST_LEN ? n - i : VU_BURST_LEN;
+        word = 0;
+        for ( unsigned int j = 0; j < k; j++ )
+            word |= (uint32_t) (uint8_t) buf[i + j] << ( 8 * j );
+        vu_model_write_lanes(model, TX_BURST_W_OFFSET, word, k);
+    }
+
+    return n;
+}
@@ -0,0 +1,65 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual uart CSR block software model header file
+
+#ifndef VU_MODEL_H__
+#define VU_MODEL_H__
+
+#include <stdint.h>
+
+/* Register offsets, see hw/xilinx/rtl/virtual_uart.sv */
+#define RX_REG_OFFSET           0x00    /* RX register - host to core   */
+#define TX_REG_OFFSET           0x04    /* TX register - core to host   */
+#define STS_REG_OFFSET          0x08    /* Status register              */
+#define CTRL_REG_OFFSET         0x0C    /* Control register             */
+#define INT_ACK_REG_OFFSET      0x10    /* Interrupt ack - host to XDMA */
+#define FIFO_LEVEL_REG_OFFSET   0x14    /* [15:0] RX level, [31:16] TX level */
+#define FIFO_DEPTH_REG_OFFSET   0x18    /* FIFOs depth, 0 on the single-register peripheral */
+#define RX_BURST_W_OFFSET       0x20    /* Push the chars in the written byte lanes (from lane 0) */
+#define TX_BURST_W_OFFSET       0x24
+#define RX_BURST_R_OFFSET(n)    ( 0x40 + 4 * ( (n) - 1 ) )  /* Pop n chars, packed from byte 0 */
+#define TX_BURST_R_OFFSET(n)    ( 0x60 + 4 * ( (n) - 1 ) )
+#define VU_BURST_LEN            4       /* Chars per burst access on the 32-bit peripheral bus */
+
+/* Status/control masks */
+#define RX_VALID_BIT_MASK   0x00000001  /* RX FIFO not empty */
+#define RX_FULL_BIT_MASK    0x00000002
+#define TX_EMPTY_BIT_MASK   0x00000004
+#define TX_FULL_BIT_MASK    0x00000008
+#define INT_BIT_MASK        0x00000010  /* Control and status - interrupt enable */
+#define CTRL_RST_TX_BIT_MASK 0x00000001 /* Control - reset the TX FIFO */
+#define CTRL_RST_RX_BIT_MASK 0x00000002 /* Control - reset the RX FIFO */
+
+/* Model FIFOs depth, as the RTL default */
+#define VU_MODEL_FIFO_DEPTH 32
+
+/* Single-producer/single-consumer FIFO, head and tail are free-running */
+typedef struct {
+    uint32_t head;              /* Written by the producer only */
+    uint32_t tail;              /* Written by the consumer only */
+    uint8_t buf [VU_MODEL_FIFO_DEPTH];
+} vu_fifo_t;
+
+/* Model state, lives in (shared) memory.
+ * Both the host and the SoC side access it through vu_model_read()/vu_model_write(),
+ * which apply the same read/write side effects as the RTL. */
+typedef struct {
+    vu_fifo_t rx;               /* Host to core */
+    vu_fifo_t tx;               /* Core to host */
+    uint32_t ctrl;
+    uint32_t int_xdma;          /* Interrupt line to the XDMA */
+} vu_model_t;
+
+void     vu_model_reset ( vu_model_t * model );
+uint32_t vu_model_read  ( vu_model_t * model, uint32_t offset );
+void     vu_model_write ( vu_model_t * model, uint32_t offset, uint32_t value );
+/* Write of the first nbytes byte lanes only, as a narrow store */
+void     vu_model_write_lanes ( vu_model_t * model, uint32_t offset, uint32_t value, unsigned int nbytes );
+
+/* SoC side, non-blocking: return 0 on success, -1 if the FIFO is empty/full */
+int vu_model_soc_getc ( vu_model_t * model, char * c );
+int vu_model_soc_putc ( vu_model_t * model, char c );
+/* SoC side bursts, non-blocking: return the number of chars moved */
+unsigned int vu_model_soc_read  ( vu_model_t * model, char * buf, unsigned int max );
+unsigned int vu_model_soc_write ( vu_model_t * model, const char * buf, unsigned int len );
+
+#endif
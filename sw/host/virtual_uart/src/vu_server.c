@@ -0,0 +1,103 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: Virtual Uart server - main
+//              Serve all the virtual uart instances listed in a config file from a single process,
+//              each on its own pseudo-terminal, e.g.:
+//                  # name   address        [length]  [event_dev]
+//                  soc0     0x20000        0x80      /dev/xdma0_events_0
+//                  soc1     0x120000
+//                  model    shm:/vu0
+//                  rtl      cosim:/vu_cosim
+//              Attach to an instance with any serial terminal, e.g. picocom /dev/pts/N.
+//              The main thread waits for SIGINT/SIGTERM, then prints the per-instance and per-worker figures.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include "server.h"
+
+/* Too large for the stack */
+static server_t server;
+
+static void help ( char * ex_name )
+{
+    printf("------------------------------ VIRTUAL UART SERVER ------------------------------ \n");
+    printf("Usage: %s [options] <config_file>\n", ex_name);
+    printf("    config_file   : One instance per line: <name> <paddr | shm:/object | cosim:/object> [length] [event_dev]\n");
+    printf("                    length defaults to 0x%x, instances without event_dev are polled\n", SERVER_DEFAULT_LENGTH);
+    printf("Options:\n");
+    printf("    -p policy     : Idle backoff of the polled instances: sleep, spin or adaptive, default adaptive\n");
+    printf("    -t period     : Poll period (sleep) or backoff cap (adaptive) in microseconds\n");
+    printf("    -w workers    : Event loop threads, default 1, max %d\n", SERVER_MAX_WORKERS);
+    printf("    -d link_dir   : Create <link_dir>/<name> symlinks to the pseudo-terminals\n");
+    printf("    -m mem_dev    : Physical memory device, default %s\n", MMIO_DEFAULT_DEVICE);
+    printf("--------------------------------------------------------------------------------- \n");
+}
+
+int main ( int argc, char *argv[] )
+{
+    poll_policy_type_t policy_type = POLL_POLICY_ADAPTIVE;
+    unsigned int period_us = 0;
+    sigset_t sigset;
+    int sig;
+    int opt;
+    int ret = 0;
+
+    server.num_workers = 1;
+    server.link_dir    = NULL;
+    server.mem_path    = NULL;
+    while ( ( opt = getopt(argc, argv, "p:t:w:d:m:h") ) != -1 ) {
+        switch ( opt ) {
+            case 'p':
+                if ( poll_policy_parse(optarg, &policy_type) != 0 ) {
+                    printf("ERROR: Unknown polling policy %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case 't': period_us          = atoi(optarg); break;
+            case 'w': server.num_workers = atoi(optarg); break;
+            case 'd': server.link_dir    = optarg;       break;
+            case 'm': server.mem_path    = optarg;       break;
+            default:
+                help(argv[0]);
+                return -1;
+        }
+    }
+
+    if ( argc - optind != 1 || server.num_workers < 1 || server.num_workers > SERVER_MAX_WORKERS ) {
+        help(argv[0]);
+        return -1;
+    }
+    poll_policy_init(&server.policy, policy_type, period_us);
+
+    if ( server_load_config(&server, argv[optind]) != 0 )
+        return -1;
+
+    /* Block the termination signals in all threads, the main thread waits for them */
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGINT);
+    sigaddset(&sigset, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+    setbuf(stdout, NULL);
+
+    if ( server_open(&server) != 0 || server_start(&server) != 0 ) {
+        ret = -1;
+        goto end;
+    }
+
+    for ( int i = 0; i < server.num_instances; i++ )
+        printf("%s: %s%s%s\n", server.instances[i].name, server.instances[i].pty_path,
+                server.instances[i].link_path[0] ? " <- " : "", server.instances[i].link_path);
+
+    /* Wait for Ctrl-C */
+    sigwait(&sigset, &sig);
+    server_stop(&server);
+    server_join(&server);
+
+    fprintf(stderr, "\n");
+    server_print_stats(stderr, &server);
+
+    end:
+        server_close(&server);
+        return ret;
+}
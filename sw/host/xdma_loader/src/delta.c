@@ -0,0 +1,296 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader - delta reload
+//              Reloads of nearly identical images only write the pages that changed: the page hashes of the
+//              last image loaded on each board and base address are cached in a file, and the new image is
+//              diffed against them. Consecutive dirty pages are merged into a single transfer.
+//              As the SoC may have written its memory since the last load (e.g. .data and .bss), the clean
+//              pages can be read back and checked against the cache before trusting it.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "delta.h"
+#include "utils.h"
+
+/* Cache file header, followed by num_pages 8-bytes hashes */
+typedef struct {
+    uint64_t magic;
+    uint64_t page_size;
+    uint64_t length;
+    uint64_t num_pages;
+} delta_header_t;
+
+/* Length of page i, the last one might be shorter */
+static size_t page_length ( delta_t * delta, size_t i )
+{
+    size_t offset = i * DELTA_PAGE_SIZE;
+    return delta->length - offset < DELTA_PAGE_SIZE ? delta->length - offset : DELTA_PAGE_SIZE;
+}
+
+/* Find the next run of pages with dirty == state from *page, at most max_pages long.
+ * Return the run length, 0 when there are no more, and move *page to its start. */
+static size_t next_run ( delta_t * delta, size_t * page, uint8_t state, size_t max_pages )
+{
+    size_t start = *page;
+    size_t end;
+
+    while ( start < delta->num_pages && delta->dirty[start] != state )
+        start++;
+    for ( end = start; end < delta->num_pages && delta->dirty[end] == state && end - start < max_pages; end++ );
+
+    *page = start;
+    return end - start;
+}
+
+/* Byte length of the run of num pages from page */
+static size_t run_length ( delta_t * delta, size_t page, size_t num )
+{
+    return ( num - 1 ) * DELTA_PAGE_SIZE + page_length(delta, page + num - 1);
+}
+
+/* Read the previous hashes, return their number, 0 if there is no valid cache */
+static size_t read_cache ( delta_t * delta, uint64_t ** hashes )
+{
+    delta_header_t header;
+    FILE * fp;
+
+    *hashes = NULL;
+    fp = fopen(delta->cache_path, "rb");
+    if ( fp == NULL )
+        return 0;
+
+    if ( fread(&header, sizeof(header), 1, fp) != 1 || header.magic != DELTA_MAGIC || header.page_size != DELTA_PAGE_SIZE ) {
+        fprintf(stderr, "[WARNING] Ignoring invalid cache file %s\n", delta->cache_path);
+        fclose(fp);
+        return 0;
+    }
+
+    *hashes = (uint64_t *) malloc(header.num_pages * sizeof(uint64_t));
+    if ( *hashes == NULL || fread(*hashes, sizeof(uint64_t), header.num_pages, fp) != header.num_pages ) {
+        fprintf(stderr, "[WARNING] Ignoring truncated cache file %s\n", delta->cache_path);
+        free(*hashes);
+        *hashes = NULL;
+        header.num_pages = 0;
+    }
+
+    fclose(fp);
+    return header.num_pages;
+}
+
+int delta_open ( delta_t * delta, const char * file_name, const char * cache_dir, const char * key, uint64_t base_address )
+{
+    struct stat st;
+    uint64_t * cached_hashes;
+    size_t num_cached;
+    size_t i;
+    int fd;
+
+    memset(delta, 0, sizeof(delta_t));
+    mkdir(cache_dir, 0755);
+    snprintf(delta->cache_path, sizeof(delta->cache_path), "%s/%s_0x%lx.hash", cache_dir, key, base_address);
+
+    /* Read the whole image, zero-padded */
+    fd = open(file_name, O_RDONLY);
+    if ( fd == -1 || fstat(fd, &st) != 0 ) {
+        printf("ERROR: Cannot open input file %s\n", file_name);
+        if ( fd != -1 )
+            close(fd);
+        return -1;
+    }
+    delta->length    = ( st.st_size + LOADER_WORD_SIZE - 1 ) & ~( (size_t) LOADER_WORD_SIZE - 1 );
+    delta->num_pages = ( delta->length + DELTA_PAGE_SIZE - 1 ) / DELTA_PAGE_SIZE;
+    if ( posix_memalign((void **) &delta->image, 4096, delta->num_pages * DELTA_PAGE_SIZE) != 0 ) {
+        printf("ERROR: Cannot allocate the image buffer\n");
+        close(fd);
+        return -1;
+    }
+    memset(delta->image + st.st_size, 0, delta->num_pages * DELTA_PAGE_SIZE - st.st_size);
+    for ( off_t done = 0; done < st.st_size; ) {
+        ssize_t ret = read(fd, delta->image + done, st.st_size - done);
+        if ( ret <= 0 ) {
+            printf("ERROR: Cannot read input file %s\n", file_name);
+            close(fd);
+            return -1;
+        }
+        done += ret;
+    }
+    close(fd);
+
+    /* Hash the pages */
+    delta->hashes = (uint64_t *) malloc(delta->num_pages * sizeof(uint64_t));
+    delta->dirty  = (uint8_t *)  malloc(delta->num_pages);
+    if ( delta->hashes == NULL || delta->dirty == NULL ) {
+        printf("ERROR: Cannot allocate the page hashes\n");
+        return -1;
+    }
+    for ( i = 0; i < delta->num_pages; i++ )
+        delta->hashes[i] = checksum64(delta->image + i * DELTA_PAGE_SIZE, page_length(delta, i), CHECKSUM_SEED);
+
+    /* Diff against the cache, the pages beyond the previous image are dirty */
+    num_cached = read_cache(delta, &cached_hashes);
+    delta->cached = cached_hashes != NULL;
+    for ( i = 0; i < delta->num_pages; i++ ) {
+        delta->dirty[i] = i >= num_cached || cached_hashes[i] != delta->hashes[i];
+        delta->num_dirty += delta->dirty[i];
+    }
+    free(cached_hashes);
+
+    return 0;
+}
+
+int64_t delta_verify ( delta_t * delta, loader_t * loader, size_t chunk_size )
+{
+    uint8_t * readback;
+    size_t max_pages = chunk_size / DELTA_PAGE_SIZE > 0 ? chunk_size / DELTA_PAGE_SIZE : 1;
+    size_t page = 0;
+    size_t num;
+    size_t i;
+    int64_t drifted = 0;
+
+    if ( posix_memalign((void **) &readback, 4096, max_pages * DELTA_PAGE_SIZE) != 0 ) {
+        printf("ERROR: Cannot allocate read-back buffer\n");
+        return -1;
+    }
+
+    /* Clean pages only, mark the drifted ones dirty as we go */
+    while ( ( num = next_run(delta, &page, 0, max_pages) ) > 0 ) {
+        if ( loader_read(loader, page * DELTA_PAGE_SIZE, readback, run_length(delta, page, num)) != 0 ) {
+            printf("ERROR: Read failed at offset 0x%lx\n", page * DELTA_PAGE_SIZE);
+            free(readback);
+            return -1;
+        }
+        for ( i = 0; i < num; i++ ) {
+            if ( checksum64(readback + i * DELTA_PAGE_SIZE, page_length(delta, page + i), CHECKSUM_SEED) != delta->hashes[page + i] ) {
+                delta->dirty[page + i] = 1;
+                drifted++;
+            }
+        }
+        page += num;
+    }
+
+    delta->num_dirty += drifted;
+    free(readback);
+    return drifted;
+}
+
+int64_t delta_load ( delta_t * delta, loader_t * loader, size_t chunk_size )
+{
+    size_t max_pages = chunk_size / DELTA_PAGE_SIZE > 0 ? chunk_size / DELTA_PAGE_SIZE : 1;
+    size_t page = 0;
+    size_t num;
+    size_t len;
+    int64_t written = 0;
+
+    while ( ( num = next_run(delta, &page, 1, max_pages) ) > 0 ) {
+        len = run_length(delta, page, num);
+        if ( loader_write(loader, page * DELTA_PAGE_SIZE, delta->image + page * DELTA_PAGE_SIZE, len) != 0 ) {
+            printf("ERROR: Write failed at offset 0x%lx\n", page * DELTA_PAGE_SIZE);
+            return -1;
+        }
+        written += len;
+        page += num;
+    }
+
+    return written;
+}
+
+int delta_write_plan ( delta_t * delta, const char * plan_path )
+{
+    FILE * fp;
+    size_t page = 0;
+    size_t num;
+
+    fp = fopen(plan_path, "w");
+    if ( fp == NULL ) {
+        printf("ERROR: Cannot open plan file %s\n", plan_path);
+        return -1;
+    }
+
+    /* No limit on the run length, the writes are word by word anyway */
+    while ( ( num = next_run(delta, &page, 1, delta->num_pages) ) > 0 ) {
+        fprintf(fp, "0x%lx 0x%lx\n", page * DELTA_PAGE_SIZE, run_length(delta, page, num));
+        page += num;
+    }
+
+    fclose(fp);
+    return 0;
+}
+
+int delta_commit ( delta_t * delta, const char * suffix )
+{
+    char path [PATH_MAX + 16];
+    delta_header_t header;
+    FILE * fp;
+
+    header.magic     = DELTA_MAGIC;
+    header.page_size = DELTA_PAGE_SIZE;
+    header.length    = delta->length;
+    header.num_pages = delta->num_pages;
+
+    snprintf(path, sizeof(path), "%s%s", delta->cache_path, suffix);
+    fp = fopen(path, "wb");
+    if ( fp == NULL ||
+         fwrite(&header, sizeof(header), 1, fp) != 1 ||
+         fwrite(delta->hashes, sizeof(uint64_t), delta->num_pages, fp) != delta->num_pages ) {
+        printf("ERROR: Cannot write cache file %s\n", path);
+        if ( fp )
+            fclose(fp);
+        return -1;
+    }
+
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+int delta_invalidate ( delta_t * delta )
+{
+    if ( unlink(delta->cache_path) != 0 && errno != ENOENT ) {
+        printf("ERROR: Cannot remove cache file %s\n", delta->cache_path);
+        return -1;
+    }
+    return 0;
+}
+
+int delta_commit_pending ( const char * cache_dir, const char * key, uint64_t base_address )
+{
+    char path [PATH_MAX];
+    char pending [PATH_MAX + 16];
+
+    snprintf(path, sizeof(path), "%s/%s_0x%lx.hash", cache_dir, key, base_address);
+    snprintf(pending, sizeof(pending), "%s%s", path, DELTA_PENDING_SUFFIX);
+    if ( rename(pending, path) != 0 ) {
+        printf("ERROR: No pending cache file %s\n", pending);
+        return -1;
+    }
+    return 0;
+}
+
+void delta_print ( delta_t * delta )
+{
+    size_t page = 0;
+    size_t num;
+    uint64_t dirty_bytes = 0;
+
+    while ( ( num = next_run(delta, &page, 1, delta->num_pages) ) > 0 ) {
+        dirty_bytes += run_length(delta, page, num);
+        page += num;
+    }
+
+    printf("Delta: %lu/%lu pages dirty%s, %lu bytes to write, %lu bytes skipped (%.2f%%)\n",
+            delta->num_dirty, delta->num_pages, delta->cached ? "" : " (no cache)",
+            dirty_bytes, delta->length - dirty_bytes,
+            delta->length > 0 ? 100.0 * ( delta->length - dirty_bytes ) / delta->length : 0.0);
+}
+
+void delta_close ( delta_t * delta )
+{
+    free(delta->image);
+    free(delta->hashes);
+    free(delta->dirty);
+    delta->image  = NULL;
+    delta->hashes = NULL;
+    delta->dirty  = NULL;
+}
@@ -0,0 +1,47 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader - delta reload header file
+
+#ifndef DELTA_H__
+#define DELTA_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include "loader.h"
+
+/* Default values */
+#define DELTA_PAGE_SIZE     4096            /* Hashing granularity */
+#define DELTA_DEFAULT_KEY   "default"       /* Board name in the cache file name */
+#define DELTA_MAGIC         0x31414c4458UL  /* "XDLA1" */
+#define DELTA_PENDING_SUFFIX ".new"         /* Cache of a plan, until the external flow loads it */
+
+/* Page hashes of an image, against the ones of the last image loaded at the same board and address */
+typedef struct {
+    char cache_path [PATH_MAX];
+    uint8_t * image;            /* Whole image, zero-padded to LOADER_WORD_SIZE */
+    size_t length;              /* Padded length */
+    size_t num_pages;
+    uint64_t * hashes;          /* Page hashes of the image */
+    uint8_t * dirty;            /* Pages to write */
+    size_t num_dirty;
+    int cached;                 /* A cache file was found */
+} delta_t;
+
+/* Read the image and hash it, then diff against <cache_dir>/<key>_<base_address>.hash. Return 0 on success. */
+int  delta_open    ( delta_t * delta, const char * file_name, const char * cache_dir, const char * key, uint64_t base_address );
+/* Read back the clean pages and mark the ones that drifted from the cache as dirty, return their number or -1 */
+int64_t delta_verify ( delta_t * delta, loader_t * loader, size_t chunk_size );
+/* Write the dirty pages, merged into runs of at most chunk_size, return the number of bytes written or -1 */
+int64_t delta_load   ( delta_t * delta, loader_t * loader, size_t chunk_size );
+/* Write the dirty runs as "<offset> <length>" lines, for the jtag2axi flow. Return 0 on success. */
+int  delta_write_plan ( delta_t * delta, const char * plan_path );
+/* Save the image hashes as the new cache, at cache_path + suffix. Return 0 on success. */
+int  delta_commit  ( delta_t * delta, const char * suffix );
+/* Remove the cache before touching the device, so that a failed load is never trusted */
+int  delta_invalidate ( delta_t * delta );
+/* Promote the cache saved with DELTA_PENDING_SUFFIX, once the plan has been loaded. Return 0 on success. */
+int  delta_commit_pending ( const char * cache_dir, const char * key, uint64_t base_address );
+void delta_print   ( delta_t * delta );
+void delta_close   ( delta_t * delta );
+
+#endif
@@ -0,0 +1,378 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader - ELF segment loader
+//              The PT_LOAD segments are written straight at their physical address, so that the gaps
+//              between memories (e.g. BRAM and DDR) are never transferred, unlike with a flat binary.
+//              The zero-filled tail of a segment (.bss) is written from a zero buffer, or skipped.
+//              The segments are split into chunk-sized tasks, taken by one worker per device access path
+//              (e.g. one per XDMA H2C channel), each with its own window on the whole address range.
+//              The 8-bytes words shared with a neighbouring segment are read, merged and written back
+//              under a lock, so that concurrent workers never clobber each other.
+
+#include <elf.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "elf_loader.h"
+#include "utils.h"
+
+#define WORD_MASK   ( (uint64_t) LOADER_WORD_SIZE - 1 )
+
+///////////////
+// ELF files //
+///////////////
+
+int elf_is_elf ( const char * file_name )
+{
+    unsigned char ident [SELFMAG];
+    int fd;
+    int ret;
+
+    fd = open(file_name, O_RDONLY);
+    if ( fd == -1 )
+        return 0;
+    ret = read(fd, ident, SELFMAG) == SELFMAG && memcmp(ident, ELFMAG, SELFMAG) == 0;
+    close(fd);
+    return ret;
+}
+
+/* Append a PT_LOAD segment, return 0 on success */
+static int elf_add_segment ( elf_image_t * image, uint64_t paddr, uint64_t offset, uint64_t filesz, uint64_t memsz )
+{
+    elf_segment_t * segment;
+
+    if ( memsz == 0 )
+        return 0;
+    if ( image->num_segments == ELF_MAX_SEGMENTS || offset + filesz > image->file_size || filesz > memsz ) {
+        printf("ERROR: Invalid or too many PT_LOAD segments\n");
+        return -1;
+    }
+
+    segment = &image->segments[image->num_segments++];
+    segment->paddr  = paddr;
+    segment->offset = offset;
+    segment->filesz = filesz;
+    segment->memsz  = memsz;
+    return 0;
+}
+
+int elf_open ( elf_image_t * image, const char * file_name )
+{
+    struct stat st;
+    const Elf32_Ehdr * ehdr32;
+    const Elf64_Ehdr * ehdr64;
+    const Elf32_Phdr * phdr32;
+    const Elf64_Phdr * phdr64;
+    int fd;
+    int i;
+
+    memset(image, 0, sizeof(elf_image_t));
+
+    fd = open(file_name, O_RDONLY);
+    if ( fd == -1 || fstat(fd, &st) != 0 ) {
+        printf("ERROR: Cannot open input file %s\n", file_name);
+        if ( fd != -1 )
+            close(fd);
+        return -1;
+    }
+    image->file_size = st.st_size;
+    image->file = (const uint8_t *) mmap(NULL, image->file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ( image->file == MAP_FAILED ) {
+        printf("ERROR: Cannot map input file %s\n", file_name);
+        image->file = NULL;
+        return -1;
+    }
+
+    /* Little-endian RISC-V only, 32 or 64 bits */
+    ehdr32 = (const Elf32_Ehdr *) image->file;
+    if ( image->file_size < sizeof(Elf32_Ehdr) || memcmp(ehdr32->e_ident, ELFMAG, SELFMAG) != 0 ||
+         ehdr32->e_ident[EI_DATA] != ELFDATA2LSB ) {
+        printf("ERROR: %s is not a little-endian ELF file\n", file_name);
+        return -1;
+    }
+
+    if ( ehdr32->e_ident[EI_CLASS] == ELFCLASS32 ) {
+        if ( ehdr32->e_phoff + (uint64_t) ehdr32->e_phnum * sizeof(Elf32_Phdr) > image->file_size )
+            goto truncated;
+        image->entry = ehdr32->e_entry;
+        phdr32 = (const Elf32_Phdr *) ( image->file + ehdr32->e_phoff );
+        for ( i = 0; i < ehdr32->e_phnum; i++ ) {
+            if ( phdr32[i].p_type == PT_LOAD &&
+                 elf_add_segment(image, phdr32[i].p_paddr, phdr32[i].p_offset, phdr32[i].p_filesz, phdr32[i].p_memsz) != 0 )
+                return -1;
+        }
+    }
+    else {
+        ehdr64 = (const Elf64_Ehdr *) image->file;
+        if ( image->file_size < sizeof(Elf64_Ehdr) ||
+             ehdr64->e_phoff + (uint64_t) ehdr64->e_phnum * sizeof(Elf64_Phdr) > image->file_size )
+            goto truncated;
+        image->entry = ehdr64->e_entry;
+        phdr64 = (const Elf64_Phdr *) ( image->file + ehdr64->e_phoff );
+        for ( i = 0; i < ehdr64->e_phnum; i++ ) {
+            if ( phdr64[i].p_type == PT_LOAD &&
+                 elf_add_segment(image, phdr64[i].p_paddr, phdr64[i].p_offset, phdr64[i].p_filesz, phdr64[i].p_memsz) != 0 )
+                return -1;
+        }
+    }
+
+    return 0;
+
+    truncated:
+        printf("ERROR: Truncated ELF file %s\n", file_name);
+        return -1;
+}
+
+void elf_close ( elf_image_t * image )
+{
+    if ( image->file )
+        munmap((void *) image->file, image->file_size);
+    image->file = NULL;
+}
+
+/* Bytes to write for a segment */
+static uint64_t segment_span ( const elf_segment_t * segment, int clear_bss )
+{
+    return clear_bss ? segment->memsz : segment->filesz;
+}
+
+/* Fill buf with the expected content of [address, address + len) of the segment */
+static void segment_copy ( const elf_image_t * image, const elf_segment_t * segment, uint8_t * buf, uint64_t address, size_t len )
+{
+    uint64_t offset = address - segment->paddr;
+    size_t file_len = 0;
+
+    if ( offset < segment->filesz )
+        file_len = segment->filesz - offset < len ? segment->filesz - offset : len;
+    memcpy(buf, image->file + segment->offset + offset, file_len);
+    memset(buf + file_len, 0, len - file_len);
+}
+
+/* Address range [start, end) covered by the segments, word-aligned */
+static void segments_range ( const elf_image_t * image, int clear_bss, uint64_t * start, uint64_t * end )
+{
+    *start = UINT64_MAX;
+    *end   = 0;
+    for ( int i = 0; i < image->num_segments; i++ ) {
+        const elf_segment_t * segment = &image->segments[i];
+        if ( segment->paddr < *start )
+            *start = segment->paddr;
+        if ( segment->paddr + segment_span(segment, clear_bss) > *end )
+            *end = segment->paddr + segment_span(segment, clear_bss);
+    }
+    *start &= ~WORD_MASK;
+    *end    = ( *end + WORD_MASK ) & ~WORD_MASK;
+}
+
+/////////////
+// Workers //
+/////////////
+
+/* A piece of a segment, [address, address + len) */
+typedef struct {
+    const elf_segment_t * segment;
+    uint64_t address;
+    size_t len;
+} elf_task_t;
+
+typedef struct {
+    elf_image_t * image;
+    elf_task_t * tasks;
+    size_t num_tasks;
+    _Atomic size_t next_task;
+    size_t chunk_size;
+    uint64_t window_start;
+    uint64_t window_end;
+    pthread_mutex_t edge_lock;      /* Read-merge-write of the words shared between segments */
+    _Atomic int error;
+    _Atomic uint64_t written;
+} elf_job_t;
+
+typedef struct {
+    elf_job_t * job;
+    const loader_cfg_t * cfg;
+    pthread_t thread;
+} elf_worker_t;
+
+/* Write a task, through buf (chunk_size + 2 words) */
+static int elf_write_task ( elf_job_t * job, loader_t * loader, const elf_task_t * task, uint8_t * buf )
+{
+    uint64_t start = task->address & ~WORD_MASK;
+    uint64_t end   = ( task->address + task->len + WORD_MASK ) & ~WORD_MASK;
+    uint64_t offset = start - job->window_start;
+    size_t head = task->address - start;
+    int edge = head != 0 || end != task->address + task->len;
+    int ret = 0;
+
+    if ( edge ) {
+        /* Keep the bytes of the shared words which are not ours */
+        pthread_mutex_lock(&job->edge_lock);
+        if ( loader_read(loader, offset, buf, LOADER_WORD_SIZE) != 0 ||
+             loader_read(loader, end - LOADER_WORD_SIZE - job->window_start, buf + ( end - start ) - LOADER_WORD_SIZE, LOADER_WORD_SIZE) != 0 ) {
+            printf("ERROR: Segment edge at 0x%lx is not %d-bytes aligned and cannot be read back (-X)\n", task->address, LOADER_WORD_SIZE);
+            pthread_mutex_unlock(&job->edge_lock);
+            return -1;
+        }
+    }
+
+    segment_copy(job->image, task->segment, buf + head, task->address, task->len);
+    if ( loader_write(loader, offset, buf, end - start) != 0 ) {
+        printf("ERROR: Write failed at address 0x%lx\n", start);
+        ret = -1;
+    }
+
+    if ( edge )
+        pthread_mutex_unlock(&job->edge_lock);
+
+    atomic_fetch_add(&job->written, end - start);
+    return ret;
+}
+
+static void * elf_worker_function ( void * arg )
+{
+    elf_worker_t * worker = (elf_worker_t *) arg;
+    elf_job_t * job = worker->job;
+    loader_t loader;
+    uint8_t * buf = NULL;
+    size_t i;
+
+    if ( loader_open(&loader, worker->cfg, job->window_start, job->window_end - job->window_start) != 0 ||
+         posix_memalign((void **) &buf, 4096, job->chunk_size + 2 * LOADER_WORD_SIZE) != 0 ) {
+        atomic_store(&job->error, 1);
+        goto end;
+    }
+
+    /* Take the tasks in order, until none is left or someone failed */
+    while ( !atomic_load(&job->error) && ( i = atomic_fetch_add(&job->next_task, 1) ) < job->num_tasks ) {
+        if ( elf_write_task(job, &loader, &job->tasks[i], buf) != 0 )
+            atomic_store(&job->error, 1);
+    }
+
+    end:
+        free(buf);
+        loader_close(&loader);
+        return NULL;
+}
+
+int64_t elf_load ( elf_image_t * image, const loader_cfg_t * cfgs, int num_workers, size_t chunk_size, int clear_bss )
+{
+    elf_job_t job;
+    elf_worker_t workers [ELF_MAX_WORKERS];
+    elf_task_t * task;
+    uint64_t address;
+    uint64_t end;
+    uint64_t boundary;
+    size_t max_tasks = 0;
+    int i;
+
+    memset(&job, 0, sizeof(elf_job_t));
+    job.image      = image;
+    job.chunk_size = chunk_size;
+    segments_range(image, clear_bss, &job.window_start, &job.window_end);
+    pthread_mutex_init(&job.edge_lock, NULL);
+
+    /* Split the segments in chunks, with word-aligned boundaries inside a segment */
+    for ( i = 0; i < image->num_segments; i++ )
+        max_tasks += segment_span(&image->segments[i], clear_bss) / chunk_size + 2;
+    job.tasks = (elf_task_t *) malloc(max_tasks * sizeof(elf_task_t));
+    if ( job.tasks == NULL ) {
+        printf("ERROR: Cannot allocate the tasks\n");
+        return -1;
+    }
+    for ( i = 0; i < image->num_segments; i++ ) {
+        address = image->segments[i].paddr;
+        end = address + segment_span(&image->segments[i], clear_bss);
+        while ( address < end ) {
+            boundary = ( ( address & ~WORD_MASK ) + chunk_size ) & ~WORD_MASK;
+            task = &job.tasks[job.num_tasks++];
+            task->segment = &image->segments[i];
+            task->address = address;
+            task->len     = ( boundary < end ? boundary : end ) - address;
+            address += task->len;
+        }
+    }
+
+    /* Go */
+    if ( num_workers > ELF_MAX_WORKERS )
+        num_workers = ELF_MAX_WORKERS;
+    for ( i = 0; i < num_workers; i++ ) {
+        workers[i].job = &job;
+        workers[i].cfg = &cfgs[i];
+        if ( pthread_create(&workers[i].thread, NULL, elf_worker_function, (void *) &workers[i]) != 0 ) {
+            printf("ERROR: pthread_create failed\n");
+            atomic_store(&job.error, 1);
+            break;
+        }
+    }
+    while ( --i >= 0 )
+        pthread_join(workers[i].thread, NULL);
+
+    free(job.tasks);
+    pthread_mutex_destroy(&job.edge_lock);
+
+    return atomic_load(&job.error) ? -1 : (int64_t) atomic_load(&job.written);
+}
+
+///////////////
+// Read-back //
+///////////////
+
+int elf_check ( elf_image_t * image, const loader_cfg_t * cfg, size_t chunk_size, int clear_bss )
+{
+    loader_t loader;
+    uint8_t * golden = NULL;
+    uint8_t * readback = NULL;
+    uint64_t window_start;
+    uint64_t window_end;
+    uint64_t address;
+    uint64_t end;
+    uint64_t start;
+    size_t len;
+    size_t head;
+    size_t i;
+    int mismatch = 0;
+
+    segments_range(image, clear_bss, &window_start, &window_end);
+    if ( loader_open(&loader, cfg, window_start, window_end - window_start) != 0 ||
+         posix_memalign((void **) &golden, 4096, chunk_size + 2 * LOADER_WORD_SIZE) != 0 ||
+         posix_memalign((void **) &readback, 4096, chunk_size + 2 * LOADER_WORD_SIZE) != 0 ) {
+        mismatch = -1;
+        goto end;
+    }
+
+    for ( int s = 0; s < image->num_segments && mismatch == 0; s++ ) {
+        address = image->segments[s].paddr;
+        end = address + segment_span(&image->segments[s], clear_bss);
+        while ( address < end && mismatch == 0 ) {
+            len   = end - address < chunk_size ? end - address : chunk_size;
+            start = address & ~WORD_MASK;
+            head  = address - start;
+            if ( loader_read(&loader, start - window_start, readback, ( head + len + WORD_MASK ) & ~WORD_MASK) != 0 ) {
+                printf("ERROR: Read failed at address 0x%lx\n", start);
+                mismatch = -1;
+                break;
+            }
+            segment_copy(image, &image->segments[s], golden, address, len);
+            if ( memcmp(golden, readback + head, len) != 0 ) {
+                for ( i = 0; golden[i] == readback[head + i]; i++ );
+                printf("First mismatch at address 0x%lx: expected 0x%02x, read 0x%02x\n",
+                        address + i, golden[i], readback[head + i]);
+                mismatch = 1;
+            }
+            address += len;
+        }
+    }
+
+    end:
+        free(golden);
+        free(readback);
+        loader_close(&loader);
+
+    return mismatch;
+}
@@ -0,0 +1,43 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader - ELF segment loader header file
+
+#ifndef ELF_LOADER_H__
+#define ELF_LOADER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "loader.h"
+
+/* Default values */
+#define ELF_MAX_SEGMENTS    64
+#define ELF_MAX_WORKERS     LOADER_MAX_CHANNELS
+
+/* A PT_LOAD segment */
+typedef struct {
+    uint64_t paddr;
+    uint64_t offset;            /* In the file */
+    uint64_t filesz;
+    uint64_t memsz;             /* Bytes past filesz are zero (e.g. .bss) */
+} elf_segment_t;
+
+typedef struct {
+    const uint8_t * file;       /* Whole file, mapped */
+    size_t file_size;
+    elf_segment_t segments [ELF_MAX_SEGMENTS];
+    int num_segments;
+    uint64_t entry;
+} elf_image_t;
+
+/* Return 1 if the file starts with the ELF magic */
+int  elf_is_elf   ( const char * file_name );
+/* Map the file and list its PT_LOAD segments, return 0 on success */
+int  elf_open     ( elf_image_t * image, const char * file_name );
+void elf_close    ( elf_image_t * image );
+/* Write the segments at their physical address, with one worker per cfgs entry (e.g. one per H2C channel).
+ * Segments are split across the workers in chunk_size pieces. With clear_bss, the bytes past filesz are zeroed.
+ * Return the number of bytes written or -1. */
+int64_t elf_load  ( elf_image_t * image, const loader_cfg_t * cfgs, int num_workers, size_t chunk_size, int clear_bss );
+/* Read back the segments through cfg and compare, return 0 if they match */
+int     elf_check ( elf_image_t * image, const loader_cfg_t * cfg, size_t chunk_size, int clear_bss );
+
+#endif
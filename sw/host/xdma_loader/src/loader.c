@@ -0,0 +1,440 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader - device access backends
+//              BAR backend:  the window is mmap()-ed once from /dev/mem (or from any file standing in for the BAR)
+//                            and written with 8-bytes stores.
+//              H2C backend:  the window is accessed with pwrite()/pread() on the XDMA character devices,
+//                            where the file offset is the SoC (AXI) address.
+//              The input file is streamed through a pipeline of chunks: a reader thread fills the next
+//              chunks while the current one is being written to the device.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "loader.h"
+#include "utils.h"
+
+/////////////////
+// BAR backend //
+/////////////////
+
+/* Copy with 8-bytes stores, len and the addresses must be 8-bytes aligned */
+static void bar_copy_to ( volatile uint8_t * dst, const uint8_t * src, size_t len )
+{
+    volatile uint64_t * d = (volatile uint64_t *) dst;
+    const uint64_t * s = (const uint64_t *) src;
+    size_t num_words = len / LOADER_WORD_SIZE;
+    size_t i = 0;
+
+    /* Unrolled, to keep the stream of posted writes busy */
+    for ( ; i + 4 <= num_words; i += 4 ) {
+        d[i+0] = s[i+0];
+        d[i+1] = s[i+1];
+        d[i+2] = s[i+2];
+        d[i+3] = s[i+3];
+    }
+    for ( ; i < num_words; i++ )
+        d[i] = s[i];
+}
+
+/* Copy with 8-bytes loads, len and the addresses must be 8-bytes aligned */
+static void bar_copy_from ( uint8_t * dst, const volatile uint8_t * src, size_t len )
+{
+    uint64_t * d = (uint64_t *) dst;
+    const volatile uint64_t * s = (const volatile uint64_t *) src;
+    size_t num_words = len / LOADER_WORD_SIZE;
+    size_t i = 0;
+
+    for ( ; i + 4 <= num_words; i += 4 ) {
+        d[i+0] = s[i+0];
+        d[i+1] = s[i+1];
+        d[i+2] = s[i+2];
+        d[i+3] = s[i+3];
+    }
+    for ( ; i < num_words; i++ )
+        d[i] = s[i];
+}
+
+static int bar_open ( loader_t * loader, const loader_cfg_t * cfg )
+{
+    struct stat st;
+    uint64_t paddr;
+    off_t pa_offset;                    /* page aligned offset */
+
+    /* Open the device file, O_SYNC for /dev/mem */
+    loader->wr_fd = open(cfg->dev_path, O_RDWR | O_SYNC);
+    if ( loader->wr_fd == -1 ) {
+        printf("ERROR: Cannot open device file %s\n", cfg->dev_path);
+        return -1;
+    }
+    loader->rd_fd = loader->wr_fd;
+
+    /* Compute the page aligned offset */
+    paddr = cfg->bar_address + loader->base_address;
+    pa_offset = paddr & ~(sysconf(_SC_PAGE_SIZE) - 1);
+    loader->map_length = loader->length + paddr - pa_offset;
+
+    /* Stand-in files must back the whole mapping, they are not resized (make bench sizes its own) */
+    if ( fstat(loader->wr_fd, &st) == 0 && S_ISREG(st.st_mode) && (uint64_t) st.st_size < pa_offset + loader->map_length ) {
+        printf("ERROR: Stand-in file %s is smaller than 0x%lx bytes\n", cfg->dev_path, (uint64_t) pa_offset + loader->map_length);
+        return -1;
+    }
+
+    /* Map the BAR once */
+    loader->map = mmap(NULL, loader->map_length, PROT_READ | PROT_WRITE, MAP_SHARED, loader->wr_fd, pa_offset);
+    if ( loader->map == MAP_FAILED ) {
+        printf("ERROR: Map failed\n");
+        loader->map = NULL;
+        return -1;
+    }
+    loader->window = (volatile uint8_t *) loader->map + (paddr - pa_offset);
+
+    return 0;
+}
+
+/////////////////
+// H2C backend //
+/////////////////
+
+static int h2c_open ( loader_t * loader, const loader_cfg_t * cfg )
+{
+    loader->wr_fd = open(cfg->dev_path, O_WRONLY);
+    if ( loader->wr_fd == -1 ) {
+        printf("ERROR: Cannot open H2C device file %s\n", cfg->dev_path);
+        return -1;
+    }
+
+    loader->rd_fd = -1;
+    if ( cfg->c2h_path ) {
+        loader->rd_fd = open(cfg->c2h_path, O_RDONLY);
+        if ( loader->rd_fd == -1 ) {
+            printf("ERROR: Cannot open C2H device file %s\n", cfg->c2h_path);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* pwrite()/pread() until completion, the DMA engine might split large requests */
+static int h2c_transfer ( int fd, uint64_t address, void * buf, size_t len, int is_write )
+{
+    uint8_t * ptr = (uint8_t *) buf;
+    ssize_t ret;
+
+    while ( len > 0 ) {
+        if ( is_write )
+            ret = pwrite(fd, ptr, len, address);
+        else
+            ret = pread(fd, ptr, len, address);
+
+        if ( ret <= 0 ) {
+            printf("ERROR: %s failed at address 0x%lx\n", is_write ? "H2C write" : "C2H read", address);
+            return -1;
+        }
+
+        ptr     += ret;
+        address += ret;
+        len     -= ret;
+    }
+
+    return 0;
+}
+
+/////////////////////
+// Generic wrapper //
+/////////////////////
+
+int loader_open ( loader_t * loader, const loader_cfg_t * cfg, uint64_t base_address, size_t length )
+{
+    memset(loader, 0, sizeof(loader_t));
+    loader->backend      = cfg->backend;
+    loader->wr_fd        = -1;
+    loader->rd_fd        = -1;
+    loader->base_address = base_address;
+    loader->length       = length;
+
+    if ( ( base_address % LOADER_WORD_SIZE ) != 0 ) {
+        printf("ERROR: Base address 0x%lx is not %d-bytes aligned\n", base_address, LOADER_WORD_SIZE);
+        return -1;
+    }
+
+    if ( cfg->backend == LOADER_BACKEND_H2C )
+        return h2c_open(loader, cfg);
+
+    return bar_open(loader, cfg);
+}
+
+int loader_write ( loader_t * loader, uint64_t offset, const void * buf, size_t len )
+{
+    if ( offset + len > loader->length || ( offset | len ) % LOADER_WORD_SIZE != 0 )
+        return -1;
+
+    if ( loader->backend == LOADER_BACKEND_H2C )
+        return h2c_transfer(loader->wr_fd, loader->base_address + offset, (void *) buf, len, 1);
+
+    bar_copy_to(loader->window + offset, (const uint8_t *) buf, len);
+    return 0;
+}
+
+int loader_read ( loader_t * loader, uint64_t offset, void * buf, size_t len )
+{
+    if ( offset + len > loader->length || ( offset | len ) % LOADER_WORD_SIZE != 0 )
+        return -1;
+
+    if ( loader->backend == LOADER_BACKEND_H2C ) {
+        if ( loader->rd_fd == -1 ) {
+            printf("ERROR: No C2H device for read-back\n");
+            return -1;
+        }
+        return h2c_transfer(loader->rd_fd, loader->base_address + offset, buf, len, 0);
+    }
+
+    bar_copy_from((uint8_t *) buf, loader->window + offset, len);
+    return 0;
+}
+
+void loader_close ( loader_t * loader )
+{
+    if ( loader->map )
+        munmap(loader->map, loader->map_length);
+    if ( loader->rd_fd != -1 && loader->rd_fd != loader->wr_fd )
+        close(loader->rd_fd);
+    if ( loader->wr_fd != -1 )
+        close(loader->wr_fd);
+    loader->map = NULL;
+    loader->wr_fd = -1;
+    loader->rd_fd = -1;
+}
+
+//////////////
+// Pipeline //
+//////////////
+
+/* A chunk of the input file, len == 0 marks the end of file */
+typedef struct {
+    uint8_t * buf;
+    size_t len;
+} chunk_t;
+
+/* Single-producer (file reader) single-consumer (device writer) queue of chunks */
+typedef struct {
+    int fd;
+    size_t chunk_size;
+    chunk_t chunks[LOADER_NUM_CHUNKS];
+    unsigned int head;          /* Number of chunks produced */
+    unsigned int tail;          /* Number of chunks consumed */
+    int error;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} pipeline_t;
+
+/* Read until len bytes or end of file, return the number of bytes read or -1 */
+static ssize_t read_full ( int fd, uint8_t * buf, size_t len )
+{
+    size_t done = 0;
+    ssize_t ret;
+
+    while ( done < len ) {
+        ret = read(fd, buf + done, len - done);
+        if ( ret < 0 )
+            return -1;
+        if ( ret == 0 )
+            break;
+        done += ret;
+    }
+
+    return done;
+}
+
+static void * reader_thread_function ( void * arg )
+{
+    pipeline_t * pipeline = (pipeline_t *) arg;
+    chunk_t * chunk;
+    ssize_t len;
+    int error;
+
+    do {
+        /* Wait for a free chunk */
+        pthread_mutex_lock(&pipeline->mutex);
+        while ( pipeline->head - pipeline->tail == LOADER_NUM_CHUNKS && !pipeline->error )
+            pthread_cond_wait(&pipeline->cond, &pipeline->mutex);
+        chunk = &pipeline->chunks[pipeline->head % LOADER_NUM_CHUNKS];
+        error = pipeline->error;
+        pthread_mutex_unlock(&pipeline->mutex);
+
+        if ( error )
+            break;
+
+        /* Fill it without holding the lock */
+        len = read_full(pipeline->fd, chunk->buf, pipeline->chunk_size);
+
+        pthread_mutex_lock(&pipeline->mutex);
+        if ( len < 0 ) {
+            printf("ERROR: Cannot read input file\n");
+            pipeline->error = 1;
+            len = 0;
+        }
+        chunk->len = len;
+        pipeline->head++;
+        pthread_cond_broadcast(&pipeline->cond);
+        pthread_mutex_unlock(&pipeline->mutex);
+    } while ( len > 0 );
+
+    return NULL;
+}
+
+int64_t loader_load_file ( loader_t * loader, const char * file_name, size_t chunk_size )
+{
+    pipeline_t pipeline;
+    pthread_t reader_thread;
+    chunk_t * chunk;
+    uint64_t offset = 0;
+    size_t len;
+    size_t pad_size;
+    int i;
+
+    memset(&pipeline, 0, sizeof(pipeline_t));
+    pipeline.chunk_size = chunk_size;
+    pthread_mutex_init(&pipeline.mutex, NULL);
+    pthread_cond_init(&pipeline.cond, NULL);
+
+    pipeline.fd = open(file_name, O_RDONLY);
+    if ( pipeline.fd == -1 ) {
+        printf("ERROR: Cannot open input file %s\n", file_name);
+        return -1;
+    }
+    posix_fadvise(pipeline.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    /* Chunk buffers, aligned for 8-bytes copies and DMA */
+    for ( i = 0; i < LOADER_NUM_CHUNKS; i++ ) {
+        if ( posix_memalign((void **) &pipeline.chunks[i].buf, 4096, chunk_size) != 0 ) {
+            printf("ERROR: Cannot allocate chunk buffers\n");
+            pipeline.error = 1;
+            goto end;
+        }
+    }
+
+    if ( pthread_create(&reader_thread, NULL, reader_thread_function, (void *) &pipeline) != 0 ) {
+        printf("ERROR: pthread_create failed\n");
+        pipeline.error = 1;
+        goto end;
+    }
+
+    while ( 1 ) {
+        /* Wait for a full chunk */
+        pthread_mutex_lock(&pipeline.mutex);
+        while ( pipeline.tail == pipeline.head )
+            pthread_cond_wait(&pipeline.cond, &pipeline.mutex);
+        chunk = &pipeline.chunks[pipeline.tail % LOADER_NUM_CHUNKS];
+        pthread_mutex_unlock(&pipeline.mutex);
+
+        len = chunk->len;
+        if ( len == 0 )
+            break;
+
+        /* Pad the tail of the file with zero-bytes */
+        pad_size = ( LOADER_WORD_SIZE - len % LOADER_WORD_SIZE ) % LOADER_WORD_SIZE;
+        if ( pad_size != 0 ) {
+            fprintf(stderr, "[WARNING] Binary has non %d-aligned size, padding with %lu zero-bytes\n", LOADER_WORD_SIZE, pad_size);
+            memset(chunk->buf + len, 0, pad_size);
+        }
+
+        if ( loader_write(loader, offset, chunk->buf, len + pad_size) != 0 ) {
+            printf("ERROR: Write failed at offset 0x%lx\n", offset);
+            pthread_mutex_lock(&pipeline.mutex);
+            pipeline.error = 1;
+            pthread_cond_broadcast(&pipeline.cond);
+            pthread_mutex_unlock(&pipeline.mutex);
+            break;
+        }
+        offset += len;
+
+        /* Release the chunk to the reader */
+        pthread_mutex_lock(&pipeline.mutex);
+        pipeline.tail++;
+        pthread_cond_broadcast(&pipeline.cond);
+        pthread_mutex_unlock(&pipeline.mutex);
+    }
+
+    pthread_join(reader_thread, NULL);
+
+    end:
+        for ( i = 0; i < LOADER_NUM_CHUNKS; i++ )
+            free(pipeline.chunks[i].buf);
+        close(pipeline.fd);
+        pthread_mutex_destroy(&pipeline.mutex);
+        pthread_cond_destroy(&pipeline.cond);
+
+    return pipeline.error ? -1 : (int64_t) offset;
+}
+
+///////////////
+// Read-back //
+///////////////
+
+int loader_check_file ( loader_t * loader, const char * file_name, size_t chunk_size )
+{
+    uint8_t * golden = NULL;
+    uint8_t * readback = NULL;
+    uint64_t golden_checksum = CHECKSUM_SEED;
+    uint64_t readback_checksum = CHECKSUM_SEED;
+    uint64_t offset = 0;
+    ssize_t len;
+    size_t padded_len;
+    size_t i;
+    int mismatch = 0;
+    int fd;
+
+    fd = open(file_name, O_RDONLY);
+    if ( fd == -1 ) {
+        printf("ERROR: Cannot open input file %s\n", file_name);
+        return -1;
+    }
+
+    if ( posix_memalign((void **) &golden, 4096, chunk_size) != 0 ||
+         posix_memalign((void **) &readback, 4096, chunk_size) != 0 ) {
+        printf("ERROR: Cannot allocate read-back buffers\n");
+        mismatch = -1;
+        goto end;
+    }
+
+    while ( ( len = read_full(fd, golden, chunk_size) ) > 0 ) {
+        /* Zero-padding is expected on the device */
+        padded_len = ( len + LOADER_WORD_SIZE - 1 ) & ~( (size_t) LOADER_WORD_SIZE - 1 );
+        memset(golden + len, 0, padded_len - len);
+
+        if ( loader_read(loader, offset, readback, padded_len) != 0 ) {
+            printf("ERROR: Read failed at offset 0x%lx\n", offset);
+            mismatch = -1;
+            goto end;
+        }
+
+        golden_checksum   = checksum64(golden, padded_len, golden_checksum);
+        readback_checksum = checksum64(readback, padded_len, readback_checksum);
+
+        /* Locate the first mismatch only on the slow path */
+        if ( !mismatch && memcmp(golden, readback, padded_len) != 0 ) {
+            for ( i = 0; golden[i] == readback[i]; i++ );
+            printf("First mismatch at address 0x%lx: expected 0x%02x, read 0x%02x\n",
+                    loader->base_address + offset + i, golden[i], readback[i]);
+            mismatch = 1;
+        }
+
+        offset += len;
+    }
+
+    printf("Golden checksum:    0x%016lx\n", golden_checksum);
+    printf("Read-back checksum: 0x%016lx\n", readback_checksum);
+
+    end:
+        free(golden);
+        free(readback);
+        close(fd);
+
+    return mismatch;
+}
@@ -0,0 +1,56 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader - device access backends header file
+
+#ifndef LOADER_H__
+#define LOADER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Default values */
+#define LOADER_DEFAULT_DEVICE     "/dev/mem"
+#define LOADER_DEFAULT_CHUNK_SIZE (1 << 20)     /* 1 MiB */
+#define LOADER_NUM_CHUNKS         4             /* Depth of the read/write pipeline */
+#define LOADER_WORD_SIZE          8             /* Host-side BAR space supports 8-bytes transactions */
+#define LOADER_MAX_CHANNELS       4             /* XDMA H2C channels */
+
+/* Device access backends */
+typedef enum {
+    LOADER_BACKEND_BAR,         /* mmap() the BAR (or any file standing in for it) once */
+    LOADER_BACKEND_H2C          /* XDMA H2C/C2H character devices */
+} loader_backend_t;
+
+/* Loader configuration */
+typedef struct {
+    loader_backend_t backend;
+    const char * dev_path;      /* BAR mode: /dev/mem or a stand-in file. H2C mode: H2C device */
+    const char * c2h_path;      /* H2C mode only: C2H device for read-back */
+    uint64_t bar_address;       /* BAR mode only: host physical address of SoC address 0x0 */
+    size_t chunk_size;          /* Transfer chunk size in bytes */
+} loader_cfg_t;
+
+/* Loader handle */
+typedef struct {
+    loader_backend_t backend;
+    int wr_fd;                  /* Device file descriptor for writes */
+    int rd_fd;                  /* Device file descriptor for reads */
+    uint64_t base_address;      /* SoC address of the window */
+    size_t length;              /* Window length in bytes */
+    void * map;                 /* BAR mode: page-aligned mapping */
+    size_t map_length;          /* BAR mode: length of the mapping */
+    volatile uint8_t * window;  /* BAR mode: virtual address of base_address */
+} loader_t;
+
+/* Open the device window [base_address, base_address + length) */
+int  loader_open  ( loader_t * loader, const loader_cfg_t * cfg, uint64_t base_address, size_t length );
+/* Write/read len bytes at offset from the window base, return 0 on success */
+int  loader_write ( loader_t * loader, uint64_t offset, const void * buf, size_t len );
+int  loader_read  ( loader_t * loader, uint64_t offset, void * buf, size_t len );
+void loader_close ( loader_t * loader );
+
+/* Stream a file into the device through a pipeline of chunks, return the number of bytes written or -1 */
+int64_t loader_load_file ( loader_t * loader, const char * file_name, size_t chunk_size );
+/* Read back the device and compare against the file, return 0 if they match */
+int     loader_check_file ( loader_t * loader, const char * file_name, size_t chunk_size );
+
+#endif
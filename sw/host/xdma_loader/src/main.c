@@ -0,0 +1,255 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader host application - main
+//              Load a binary into the SoC memory through the XDMA and PCIe, either mapping the BAR once
+//              or using the XDMA H2C character device. It replaces the per-word devmem flow.
+//              With a cache directory, only the pages that changed since the last load are written (see delta.c).
+//              ELF files are loaded segment by segment, in parallel across the H2C channels (see elf_loader.c).
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "loader.h"
+#include "delta.h"
+#include "elf_loader.h"
+#include "utils.h"
+
+/* Load the PT_LOAD segments of an ELF file, one worker per entry of cfgs, return 0 on success */
+static int load_elf ( const char * file_name, loader_cfg_t * cfgs, int num_workers, int clear_bss, int read_back )
+{
+    elf_image_t image;
+    elf_segment_t * segment;
+    uint64_t memsz = 0;
+    uint64_t filesz = 0;
+    int64_t written;
+    double start;
+    int ret = -1;
+    int i;
+
+    if ( elf_open(&image, file_name) != 0 )
+        goto end;
+
+    for ( i = 0; i < image.num_segments; i++ ) {
+        segment = &image.segments[i];
+        printf("Segment %d: 0x%08lx-0x%08lx, %lu bytes from file, %lu bytes zero%s\n", i,
+                segment->paddr, segment->paddr + segment->memsz, segment->filesz, segment->memsz - segment->filesz,
+                clear_bss ? "" : " (skipped)");
+        filesz += segment->filesz;
+        memsz  += segment->memsz;
+    }
+
+    /* Write the segments */
+    printf("Start writing %s (%d segments, %d workers)...\n", file_name, image.num_segments, num_workers);
+    start = time_now();
+    written = elf_load(&image, cfgs, num_workers, cfgs[0].chunk_size, clear_bss);
+    if ( written < 0 )
+        goto end;
+    print_throughput("Write complete! Wrote", written, time_now() - start);
+    printf("Entry point: 0x%lx, %lu bytes from file, %lu bytes zero-filled\n", image.entry, filesz, clear_bss ? memsz - filesz : 0);
+
+    /* Read-back */
+    ret = 0;
+    if ( read_back ) {
+        printf("Start readback...\n");
+        start = time_now();
+        ret = elf_check(&image, &cfgs[0], cfgs[0].chunk_size, clear_bss);
+        print_throughput("Readback complete! Read", clear_bss ? memsz : filesz, time_now() - start);
+
+        if ( ret == 0 )
+            printf("Test passed :)\n");
+        else
+            printf("Test failed :(\n");
+    }
+
+    end:
+        elf_close(&image);
+
+    return ret;
+}
+
+int main ( int argc, char *argv[] )
+{
+    loader_cfg_t cfg;
+    loader_t loader;
+    delta_t delta;
+    struct stat st;
+    const char * file_name;
+    uint64_t base_address;
+    size_t length;
+    int64_t written;
+    int read_back = 0;
+    const char * cache_dir = NULL;
+    const char * cache_key = DELTA_DEFAULT_KEY;
+    const char * plan_path = NULL;
+    int verify = 0;
+    int commit = 0;
+    int64_t drifted;
+    const char * h2c_paths [LOADER_MAX_CHANNELS];
+    loader_cfg_t worker_cfgs [LOADER_MAX_CHANNELS];
+    int num_channels = 0;
+    int num_workers = 1;
+    int clear_bss = 1;
+    int ret = -1;
+    double start;
+    int opt;
+
+    /* Defaults */
+    cfg.backend     = LOADER_BACKEND_BAR;
+    cfg.dev_path    = LOADER_DEFAULT_DEVICE;
+    cfg.c2h_path    = NULL;
+    cfg.bar_address = 0;
+    cfg.chunk_size  = LOADER_DEFAULT_CHUNK_SIZE;
+
+    /* Parse options */
+    while ( ( opt = getopt(argc, argv, "b:d:x:X:c:rk:K:vp:Cj:zh") ) != -1 ) {
+        switch ( opt ) {
+            case 'b': cfg.bar_address = strtoull(optarg, NULL, 0);                          break;
+            case 'd': cfg.dev_path = optarg;                                                break;
+            case 'x':
+                /* One more H2C channel */
+                if ( num_channels == LOADER_MAX_CHANNELS ) {
+                    printf("ERROR: At most %d H2C channels\n", LOADER_MAX_CHANNELS);
+                    return -1;
+                }
+                h2c_paths[num_channels++] = optarg;
+                cfg.dev_path = h2c_paths[0];
+                cfg.backend = LOADER_BACKEND_H2C;
+                break;
+            case 'X': cfg.c2h_path = optarg;                                                break;
+            case 'c': cfg.chunk_size = strtoull(optarg, NULL, 0);                           break;
+            case 'r': read_back = 1;                                                        break;
+            case 'k': cache_dir = optarg;                                                   break;
+            case 'K': cache_key = optarg;                                                   break;
+            case 'v': verify = 1;                                                           break;
+            case 'p': plan_path = optarg;                                                   break;
+            case 'C': commit = 1;                                                           break;
+            case 'j': num_workers = atoi(optarg);                                           break;
+            case 'z': clear_bss = 0;                                                        break;
+            default:
+                help(argv[0]);
+                return -1;
+        }
+    }
+
+    /* The base address is only needed for flat binaries */
+    if ( argc - optind != 2 && !( argc - optind == 1 && elf_is_elf(argv[optind]) ) ) {
+        help(argv[0]);
+        return -1;
+    }
+
+    /* Get the args */
+    file_name    = argv[optind];
+    base_address = argc - optind == 2 ? strtoull(argv[optind + 1], NULL, 0) : 0;
+
+    if ( ( plan_path || commit || verify ) && cache_dir == NULL ) {
+        printf("ERROR: -p, -C and -v require a cache directory (-k)\n");
+        return -1;
+    }
+
+    /* The external flow loaded the plan, trust the pending cache */
+    if ( commit )
+        return delta_commit_pending(cache_dir, cache_key, base_address);
+
+    /* Chunks must hold whole 8-bytes words */
+    cfg.chunk_size &= ~( (size_t) LOADER_WORD_SIZE - 1 );
+    if ( cfg.chunk_size == 0 ) {
+        printf("ERROR: Invalid chunk size\n");
+        return -1;
+    }
+
+    /* ELF files: one worker per H2C channel, or -j workers on the BAR */
+    if ( elf_is_elf(file_name) ) {
+        if ( cache_dir ) {
+            printf("ERROR: Delta reload (-k) is for flat binaries only\n");
+            return -1;
+        }
+        if ( cfg.backend == LOADER_BACKEND_H2C )
+            num_workers = num_channels;
+        if ( num_workers < 1 || num_workers > LOADER_MAX_CHANNELS ) {
+            printf("ERROR: Invalid number of workers, 1 to %d\n", LOADER_MAX_CHANNELS);
+            return -1;
+        }
+        for ( int i = 0; i < num_workers; i++ ) {
+            worker_cfgs[i] = cfg;
+            if ( cfg.backend == LOADER_BACKEND_H2C )
+                worker_cfgs[i].dev_path = h2c_paths[i];
+        }
+        return load_elf(file_name, worker_cfgs, num_workers, clear_bss, read_back);
+    }
+
+    /* Get the file size in bytes, the window covers the zero-padding to 8 bytes */
+    if ( stat(file_name, &st) != 0 ) {
+        printf("ERROR: Cannot stat input file %s\n", file_name);
+        return -1;
+    }
+    length = ( st.st_size + LOADER_WORD_SIZE - 1 ) & ~( (size_t) LOADER_WORD_SIZE - 1 );
+
+    /* Diff against the last image loaded at this address */
+    if ( cache_dir && delta_open(&delta, file_name, cache_dir, cache_key, base_address) != 0 ) {
+        delta_close(&delta);
+        return -1;
+    }
+
+    /* Plan only, for the jtag2axi flow: the cache is pending until the plan is loaded */
+    if ( plan_path ) {
+        ret = delta_write_plan(&delta, plan_path);
+        if ( ret == 0 )
+            ret = delta_invalidate(&delta);
+        if ( ret == 0 )
+            ret = delta_commit(&delta, DELTA_PENDING_SUFFIX);
+        delta_print(&delta);
+        delta_close(&delta);
+        return ret;
+    }
+
+    /* Open the device window */
+    if ( loader_open(&loader, &cfg, base_address, length) != 0 )
+        goto end;
+
+    /* Write the binary */
+    printf("Start writing %s at 0x%lx (%s)...\n", file_name, base_address, cfg.dev_path);
+    start = time_now();
+    if ( cache_dir ) {
+        /* Check the pages we are about to skip */
+        if ( verify && delta.cached ) {
+            drifted = delta_verify(&delta, &loader, cfg.chunk_size);
+            if ( drifted < 0 )
+                goto end;
+            printf("Verify: %ld pages drifted from the cache\n", drifted);
+        }
+        if ( delta_invalidate(&delta) != 0 )
+            goto end;
+        written = delta_load(&delta, &loader, cfg.chunk_size);
+        if ( written < 0 || delta_commit(&delta, "") != 0 )
+            goto end;
+        delta_print(&delta);
+    }
+    else {
+        written = loader_load_file(&loader, file_name, cfg.chunk_size);
+        if ( written < 0 )
+            goto end;
+    }
+    print_throughput("Write complete! Wrote", written, time_now() - start);
+
+    /* Read-back */
+    ret = 0;
+    if ( read_back ) {
+        printf("Start readback...\n");
+        start = time_now();
+        ret = loader_check_file(&loader, file_name, cfg.chunk_size);
+        print_throughput("Readback complete! Read", length, time_now() - start);
+
+        if ( ret == 0 )
+            printf("Test passed :)\n");
+        else
+            printf("Test failed :(\n");
+    }
+
+    end:
+        loader_close(&loader);
+        if ( cache_dir )
+            delta_close(&delta);
+
+    return ret;
+}
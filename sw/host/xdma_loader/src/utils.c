@@ -0,0 +1,68 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader - utility functions
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "utils.h"
+#include "loader.h"
+#include "delta.h"
+
+/* FNV-1a over 8-bytes words, len is expected to be 8-bytes aligned */
+uint64_t checksum64 (const void * buf, size_t len, uint64_t seed)
+{
+    const uint8_t * ptr = (const uint8_t *) buf;
+    uint64_t hash = seed;
+    uint64_t word;
+    size_t i;
+
+    for ( i = 0; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t) ) {
+        memcpy(&word, ptr + i, sizeof(uint64_t));
+        hash ^= word;
+        hash *= 0x100000001b3UL;
+    }
+
+    return hash;
+}
+
+/* Monotonic time in seconds */
+double time_now ()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Print bytes, time and throughput in MB/s */
+void print_throughput (const char * what, uint64_t bytes, double seconds)
+{
+    printf("%s %lu bytes in %.3f ms (%.2f MB/s)\n", what, bytes, seconds * 1e3, seconds > 0 ? bytes / seconds / 1e6 : 0.0);
+}
+
+/* Help function */
+void help (char * ex_name)
+{
+    printf("------------------------------ XDMA LOADER -------------------------------------- \n");
+    printf("Usage: %s [options] <binary_file> <base_address>\n", ex_name);
+    printf("       %s [options] <elf_file>\n", ex_name);
+    printf("    binary_file   : path to bin file to transfer\n");
+    printf("    base_address  : SoC address to load the binary at, in hex 0x...\n");
+    printf("    elf_file      : path to elf file, the PT_LOAD segments are written at their physical address\n");
+    printf("Options:\n");
+    printf("    -b <address>  : BAR mode, host physical address of SoC address 0x0, default 0x0\n");
+    printf("    -d <device>   : BAR mode, file to map, default %s\n", LOADER_DEFAULT_DEVICE);
+    printf("                    Any other file (e.g. /dev/shm/bar) acts as a stand-in for the BAR\n");
+    printf("    -x <device>   : H2C mode, XDMA H2C device to write to (e.g. /dev/xdma0_h2c_0)\n");
+    printf("                    Repeat for up to %d channels, ELF segments are written in parallel across them\n", LOADER_MAX_CHANNELS);
+    printf("    -X <device>   : H2C mode, XDMA C2H device to read-back from (e.g. /dev/xdma0_c2h_0)\n");
+    printf("    -c <bytes>    : transfer chunk size, default %d\n", LOADER_DEFAULT_CHUNK_SIZE);
+    printf("    -r            : read-back and check the loaded binary\n");
+    printf("    -j <workers>  : BAR mode, ELF segments are written by this many threads, default 1\n");
+    printf("    -z            : ELF only, do not clear the zero-filled tail of the segments (.bss)\n");
+    printf("    -k <dir>      : delta reload, only write the %d-bytes pages changed since the last load, cached in dir\n", DELTA_PAGE_SIZE);
+    printf("    -K <key>      : board name in the cache file name, default %s\n", DELTA_DEFAULT_KEY);
+    printf("    -v            : delta reload, read back the pages to skip and write them anyway if they drifted\n");
+    printf("    -p <file>     : delta reload, do not access the device, write the ranges to load to file (jtag2axi flow)\n");
+    printf("    -C            : delta reload, the ranges of the last -p have been loaded, commit the cache\n");
+    printf("--------------------------------------------------------------------------------- \n");
+}
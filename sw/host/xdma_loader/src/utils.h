@@ -0,0 +1,19 @@
+// Author: Vincenzo Maisto <vincenzo.maisto2@unina.it>
+// Description: XDMA binary loader utility functions header file
+
+#ifndef UTILS_H__
+#define UTILS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* FNV-1a 64-bits offset basis */
+#define CHECKSUM_SEED 0xcbf29ce484222325UL
+
+/* Utility functions */
+uint64_t checksum64(const void * buf, size_t len, uint64_t seed);
+double time_now();
+void print_throughput(const char * what, uint64_t bytes, double seconds);
+void help(char * ex_name);
+
+#endif